@@ -4,13 +4,28 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
-../app.c 
+../app.c \
+../audit_log.c \
+../protocol.c \
+../scheduler.c \
+../users.c \
+../password_log.c 
 
 OBJS += \
-./app.o 
+./app.o \
+./audit_log.o \
+./protocol.o \
+./scheduler.o \
+./users.o \
+./password_log.o 
 
 C_DEPS += \
-./app.d 
+./app.d \
+./audit_log.d \
+./protocol.d \
+./scheduler.d \
+./users.d \
+./password_log.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -1,46 +1,46 @@
-/******************************************************************************
- *
- * Module: Buzzer
- *
- * File Name: buzzer.C
- *
- * Description: Source file for the Buzzer driver
- *
- * Author: Omar Muhammad
- *
- *******************************************************************************/
-
-#include "buzzer.h"
-#include "../MCAL/gpio.h"
-
-/*******************************************************************************
- *                      Functions Definitions                                  *
- *******************************************************************************/
-
-/*
- * Description :
- * Setup the direction for the buzzer pin as output pin through the GPIO driver.
- * Turn off the buzzer through the GPIO.*/
-void Buzzer_init()
-{
-	/* Setting up the direction of the buzzer pin as output*/
-	GPIO_setupPinDirection(BUZZER_PORT_ID, BUZZER_PIN_ID, PIN_OUTPUT);
-	GPIO_writePin(BUZZER_PORT_ID, BUZZER_PIN_ID, LOGIC_LOW);
-}
-
-/*
- * Description :
- * Function to enable the Buzzer through the GPIO.*/
-void Buzzer_on(void)
-{
-	GPIO_writePin(BUZZER_PORT_ID, BUZZER_PIN_ID, LOGIC_HIGH);
-}
-
-/*
- * Description :
- * Function to disable the Buzzer through the GPIO.*/
-void Buzzer_off(void)
-{
-	GPIO_writePin(BUZZER_PORT_ID, BUZZER_PIN_ID, LOGIC_LOW);
-}
-
+/******************************************************************************
+ *
+ * Module: Buzzer
+ *
+ * File Name: buzzer.C
+ *
+ * Description: Source file for the Buzzer driver
+ *
+ * Author: Omar Muhammad
+ *
+ *******************************************************************************/
+
+#include "buzzer.h"
+#include "../MCAL/gpio.h"
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Setup the direction for the buzzer pin as output pin through the GPIO driver.
+ * Turn off the buzzer through the GPIO.*/
+void Buzzer_init()
+{
+	/* Setting up the direction of the buzzer pin as output*/
+	GPIO_setupPinDirection(BUZZER_PORT_ID, BUZZER_PIN_ID, PIN_OUTPUT);
+	GPIO_writePin(BUZZER_PORT_ID, BUZZER_PIN_ID, LOGIC_LOW);
+}
+
+/*
+ * Description :
+ * Function to enable the Buzzer through the GPIO.*/
+void Buzzer_on(void)
+{
+	GPIO_writePin(BUZZER_PORT_ID, BUZZER_PIN_ID, LOGIC_HIGH);
+}
+
+/*
+ * Description :
+ * Function to disable the Buzzer through the GPIO.*/
+void Buzzer_off(void)
+{
+	GPIO_writePin(BUZZER_PORT_ID, BUZZER_PIN_ID, LOGIC_LOW);
+}
+
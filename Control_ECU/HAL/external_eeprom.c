@@ -1,82 +1,296 @@
- /******************************************************************************
- *
- * Module: External EEPROM
- *
- * File Name: external_eeprom.c
- *
- * Description: Source file for the External EEPROM Memory
- *
- * Author: Mohamed Tarek
- *
- *******************************************************************************/
-#include "external_eeprom.h"
-#include "..\MCAL\twi.h"
-
-uint8 EEPROM_writeByte(uint16 u16addr, uint8 u8data)
-{
-	/* Send the Start Bit */
-    TWI_start();
-    if (TWI_getStatus() != TWI_START)
-        return ERROR;
-		
-    /* Send the device address, we need to get A8 A9 A10 address bits from the
-     * memory location address and R/W=0 (write) */
-    TWI_writeByte((uint8)(0xA0 | ((u16addr & 0x0700)>>7)));
-    if (TWI_getStatus() != TWI_MT_SLA_W_ACK)
-        return ERROR; 
-		 
-    /* Send the required memory location address */
-    TWI_writeByte((uint8)(u16addr));
-    if (TWI_getStatus() != TWI_MT_DATA_ACK)
-        return ERROR;
-		
-    /* write byte to eeprom */
-    TWI_writeByte(u8data);
-    if (TWI_getStatus() != TWI_MT_DATA_ACK)
-        return ERROR;
-
-    /* Send the Stop Bit */
-    TWI_stop();
-	
-    return SUCCESS;
-}
-
-uint8 EEPROM_readByte(uint16 u16addr, uint8 *u8data)
-{
-	/* Send the Start Bit */
-    TWI_start();
-    if (TWI_getStatus() != TWI_START)
-        return ERROR;
-		
-    /* Send the device address, we need to get A8 A9 A10 address bits from the
-     * memory location address and R/W=0 (write) */
-    TWI_writeByte((uint8)((0xA0) | ((u16addr & 0x0700)>>7)));
-    if (TWI_getStatus() != TWI_MT_SLA_W_ACK)
-        return ERROR;
-		
-    /* Send the required memory location address */
-    TWI_writeByte((uint8)(u16addr));
-    if (TWI_getStatus() != TWI_MT_DATA_ACK)
-        return ERROR;
-		
-    /* Send the Repeated Start Bit */
-    TWI_start();
-    if (TWI_getStatus() != TWI_REP_START)
-        return ERROR;
-		
-    /* Send the device address, we need to get A8 A9 A10 address bits from the
-     * memory location address and R/W=1 (Read) */
-    TWI_writeByte((uint8)((0xA0) | ((u16addr & 0x0700)>>7) | 1));
-    if (TWI_getStatus() != TWI_MT_SLA_R_ACK)
-        return ERROR;
-
-    /* Read Byte from Memory without send ACK */
-    *u8data = TWI_readByteWithNACK();
-    if (TWI_getStatus() != TWI_MR_DATA_NACK)
-        return ERROR;
-
-    /* Send the Stop Bit */
-    TWI_stop();
-
-    return SUCCESS;
-}
+ /******************************************************************************
+ *
+ * Module: External EEPROM
+ *
+ * File Name: external_eeprom.c
+ *
+ * Description: Source file for the External EEPROM Memory
+ *
+ * Author: Mohamed Tarek
+ *
+ *******************************************************************************/
+#include "external_eeprom.h"
+
+/* Send the device address, we need to get A8 A9 A10 address bits from the
+ * memory location address and R/W=0 (write), the driver sets R/W=1 for the reads */
+#define EEPROM_DEVICE_ADDRESS(u16addr) ((uint8)(0xA0 | (((u16addr) & 0x0700)>>7)))
+
+/* Period of the TWI watchdog, shared by all the requests */
+static Timer1_SoftTimerType g_eepromWatchdog;
+
+/*
+ * Description :
+ * Queue the next attempt of a request from its beginning.
+ */
+static void EEPROM_submit(EEPROM_RequestType *request_Ptr)
+{
+    TWI_TransactionType *transaction_Ptr = &request_Ptr->transaction;
+
+    /* Nothing to write nor to read is an acknowledge poll, only the device address is sent */
+    if ((request_Ptr->writeLength == 0) && (transaction_Ptr->readLength == 0))
+        transaction_Ptr->headerLength = 0;
+    else
+        transaction_Ptr->headerLength = 1;
+    transaction_Ptr->writeLength = request_Ptr->writeLength;
+    request_Ptr->polls = 0;
+    request_Ptr->attempts++;
+
+    if (TWI_submit(transaction_Ptr) == FALSE)
+        request_Ptr->result = ERROR;
+}
+
+/*
+ * Description :
+ * A bus attempt failed: NACK, bus error or bus cleared by the watchdog.
+ * The Stop Bit is already sent, retry later if attempts are left.
+ */
+static void EEPROM_attemptFailed(EEPROM_RequestType *request_Ptr)
+{
+    if (request_Ptr->attempts < EEPROM_MAX_ATTEMPTS)
+        request_Ptr->retry = TRUE;
+    else
+        request_Ptr->result = ERROR;
+}
+
+/*
+ * Description :
+ * TWI callback of the reads and the writes without polling.
+ */
+static void EEPROM_transferDone(TWI_TransactionType *transaction_Ptr)
+{
+    EEPROM_RequestType *request_Ptr = (EEPROM_RequestType *)transaction_Ptr;
+
+    if (transaction_Ptr->result == TWI_DONE)
+        request_Ptr->result = SUCCESS;
+    else
+        EEPROM_attemptFailed(request_Ptr);
+}
+
+/*
+ * Description :
+ * TWI callback of the page writes: once the page is sent the same transaction is
+ * queued again with the device address only until the memory ACKs it (acknowledge polling).
+ */
+static void EEPROM_writeDone(TWI_TransactionType *transaction_Ptr)
+{
+    EEPROM_RequestType *request_Ptr = (EEPROM_RequestType *)transaction_Ptr;
+
+    if (transaction_Ptr->headerLength != 0)
+    {
+        /* End of the page write, the write cycle starts with its Stop Bit */
+        if (transaction_Ptr->result != TWI_DONE)
+        {
+            EEPROM_attemptFailed(request_Ptr);
+            return;
+        }
+        transaction_Ptr->headerLength = 0;
+        transaction_Ptr->writeLength = 0;
+    }
+    else if (transaction_Ptr->result == TWI_DONE)
+    {
+        request_Ptr->result = SUCCESS;
+        return;
+    }
+    else if (transaction_Ptr->status != TWI_MT_SLA_W_NACK)
+    {
+        /* The bus failed while polling, the page is written again */
+        EEPROM_attemptFailed(request_Ptr);
+        return;
+    }
+    else if (++request_Ptr->polls >= EEPROM_ACK_POLL_MAX_RETRIES)
+    {
+        request_Ptr->result = TIMEOUT;
+        return;
+    }
+
+    if (TWI_submit(transaction_Ptr) == FALSE)
+        request_Ptr->result = ERROR;
+}
+
+/*
+ * Description :
+ * Fill the transaction of the request and queue it: the memory location address,
+ * then writeLength bytes written and readLength bytes read.
+ */
+static uint8 EEPROM_start(EEPROM_RequestType *request_Ptr, uint16 u16addr,
+        const uint8 *write_Ptr, uint8 writeLength, uint8 *read_Ptr, uint16 readLength,
+        void (*callback_Ptr)(TWI_TransactionType *transaction_Ptr))
+{
+    TWI_TransactionType *transaction_Ptr = &request_Ptr->transaction;
+
+    transaction_Ptr->slave = EEPROM_DEVICE_ADDRESS(u16addr);
+    transaction_Ptr->header[0] = (uint8)(u16addr);
+    transaction_Ptr->write_Ptr = write_Ptr;
+    transaction_Ptr->read_Ptr = read_Ptr;
+    transaction_Ptr->readLength = readLength;
+    transaction_Ptr->callback_Ptr = callback_Ptr;
+    request_Ptr->writeLength = writeLength;
+    request_Ptr->attempts = 0;
+    request_Ptr->retry = FALSE;
+    Timer1_stopSoftTimer(&request_Ptr->backoff);
+    request_Ptr->result = EEPROM_BUSY;
+
+    EEPROM_submit(request_Ptr);
+    return (request_Ptr->result == ERROR) ? ERROR : SUCCESS;
+}
+
+/*
+ * Description :
+ * Wait for the end of a request, used by the blocking functions.
+ */
+static uint8 EEPROM_wait(EEPROM_RequestType *request_Ptr)
+{
+    uint8 result;
+
+    do
+    {
+        result = EEPROM_poll(request_Ptr);
+    } while (result == EEPROM_BUSY);
+
+    return result;
+}
+
+
+uint8 EEPROM_writeByte(uint16 u16addr, uint8 u8data)
+{
+    EEPROM_RequestType request;
+
+    /* Start, device address, memory location address, the byte then Stop */
+    EEPROM_start(&request, u16addr, &u8data, 1, NULL_PTR, 0, EEPROM_transferDone);
+    return EEPROM_wait(&request);
+}
+
+uint8 EEPROM_readByte(uint16 u16addr, uint8 *u8data)
+{
+    EEPROM_RequestType request;
+
+    /* Start, device address, memory location address, Repeated Start, device address
+     * for reading, the byte without ACK then Stop */
+    EEPROM_start(&request, u16addr, NULL_PTR, 0, u8data, 1, EEPROM_transferDone);
+    return EEPROM_wait(&request);
+}
+
+/*
+ * Description :
+ * Write up to EEPROM_PAGE_SIZE bytes in one bus transaction using the page buffer.
+ * The bytes must not cross a page boundary otherwise nothing is written and ERROR is returned.
+ */
+uint8 EEPROM_writePage(uint16 u16addr, const uint8 *u8data, uint8 length)
+{
+    EEPROM_RequestType request;
+
+    /* The page address wraps inside the page so crossing its end overwrites its start */
+    if ((length == 0) || (((u16addr & (EEPROM_PAGE_SIZE - 1)) + length) > EEPROM_PAGE_SIZE))
+        return ERROR;
+
+    /* The memory fills its page buffer and writes it all after the Stop Bit */
+    EEPROM_start(&request, u16addr, u8data, length, NULL_PTR, 0, EEPROM_transferDone);
+    return EEPROM_wait(&request);
+}
+
+/*
+ * Description :
+ * Read length consecutive bytes in one bus transaction using the sequential read.
+ */
+uint8 EEPROM_readBlock(uint16 u16addr, uint8 *u8data, uint16 length)
+{
+    EEPROM_RequestType request;
+
+    if (length == 0)
+        return ERROR;
+
+    /* All the bytes except the last one are read with ACK to keep the memory sending */
+    EEPROM_start(&request, u16addr, NULL_PTR, 0, u8data, length, EEPROM_transferDone);
+    return EEPROM_wait(&request);
+}
+
+/*
+ * Description :
+ * Wait for the end of the internal write cycle by acknowledge polling, the memory
+ * does not ACK its address until the cycle is finished.
+ * Returns SUCCESS as soon as the memory ACKs, TIMEOUT after EEPROM_ACK_POLL_MAX_RETRIES polls
+ * or ERROR if the bus failed.
+ * If pollCount_Ptr is not NULL_PTR the number of NACKed polls is stored in it
+ * to measure the real write cycle time of the device.
+ */
+uint8 EEPROM_waitWriteComplete(uint16 *pollCount_Ptr)
+{
+    EEPROM_RequestType request;
+    uint8 result;
+
+    /* Only the device address with R/W=0 (write), it is ACKed only when the memory is ready */
+    EEPROM_start(&request, 0, NULL_PTR, 0, NULL_PTR, 0, EEPROM_writeDone);
+    result = EEPROM_wait(&request);
+
+    if (pollCount_Ptr != NULL_PTR)
+        *pollCount_Ptr = request.polls;
+
+    return result;
+}
+
+/*
+ * Description :
+ * Start writing a page like EEPROM_writePage followed by the acknowledge polling of
+ * EEPROM_waitWriteComplete, all of it in the background.
+ * Returns ERROR if the access could not be started, else the result of the request
+ * becomes SUCCESS once the memory has finished its write cycle.
+ * The request and the data must stay valid until the result is not EEPROM_BUSY.
+ */
+uint8 EEPROM_startWritePage(EEPROM_RequestType *request_Ptr, uint16 u16addr, const uint8 *u8data, uint8 length)
+{
+    if ((length == 0) || (((u16addr & (EEPROM_PAGE_SIZE - 1)) + length) > EEPROM_PAGE_SIZE))
+    {
+        request_Ptr->result = ERROR;
+        return ERROR;
+    }
+
+    return EEPROM_start(request_Ptr, u16addr, u8data, length, NULL_PTR, 0, EEPROM_writeDone);
+}
+
+/*
+ * Description :
+ * Start reading a block like EEPROM_readBlock in the background.
+ * Returns ERROR if the access could not be started, else the result of the request
+ * becomes SUCCESS once the bytes are in u8data.
+ * The request and the buffer must stay valid until the result is not EEPROM_BUSY.
+ */
+uint8 EEPROM_startReadBlock(EEPROM_RequestType *request_Ptr, uint16 u16addr, uint8 *u8data, uint16 length)
+{
+    if (length == 0)
+    {
+        request_Ptr->result = ERROR;
+        return ERROR;
+    }
+
+    return EEPROM_start(request_Ptr, u16addr, NULL_PTR, 0, u8data, length, EEPROM_transferDone);
+}
+
+/*
+ * Description :
+ * Go on with a background access: serve the TWI watchdog and start the retry
+ * of a failed attempt once its backoff is over. Returns the result of the request.
+ */
+uint8 EEPROM_poll(EEPROM_RequestType *request_Ptr)
+{
+    TWI_poll();
+
+    if ((g_eepromWatchdog.running == FALSE) || (Timer1_softTimerExpired(&g_eepromWatchdog) == TRUE))
+    {
+        TWI_watchdog();
+        Timer1_startSoftTimer(&g_eepromWatchdog, EEPROM_WATCHDOG_MS);
+    }
+
+    if (request_Ptr->retry == TRUE)
+    {
+        /* 2, 4, 8 ... ms so a busy or disturbed bus gets time to settle */
+        request_Ptr->retry = FALSE;
+        Timer1_startSoftTimer(&request_Ptr->backoff,
+                (uint32)EEPROM_RETRY_BACKOFF_MS << (request_Ptr->attempts - 1));
+    }
+    else if (Timer1_softTimerExpired(&request_Ptr->backoff) == TRUE)
+    {
+        EEPROM_submit(request_Ptr);
+    }
+
+    return request_Ptr->result;
+}
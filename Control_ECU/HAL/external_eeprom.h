@@ -1,32 +1,129 @@
- /******************************************************************************
- *
- * Module: External EEPROM
- *
- * File Name: external_eeprom.h
- *
- * Description: Header file for the External EEPROM Memory
- *
- * Author: Mohamed Tarek
- *
- *******************************************************************************/
-
-
-#ifndef EXTERNAL_EEPROM_H_
-#define EXTERNAL_EEPROM_H_
-
-#include "..\MCAL\std_types.h"
-
-/*******************************************************************************
- *                      Preprocessor Macros                                    *
- *******************************************************************************/
-#define ERROR 0
-#define SUCCESS 1
-
-/*******************************************************************************
- *                      Functions Prototypes                                   *
- *******************************************************************************/
-
-uint8 EEPROM_writeByte(uint16 u16addr,uint8 u8data);
-uint8 EEPROM_readByte(uint16 u16addr,uint8 *u8data);
- 
-#endif /* EXTERNAL_EEPROM_H_ */
+ /******************************************************************************
+ *
+ * Module: External EEPROM
+ *
+ * File Name: external_eeprom.h
+ *
+ * Description: Header file for the External EEPROM Memory
+ *
+ * Author: Mohamed Tarek
+ *
+ *******************************************************************************/
+
+
+#ifndef EXTERNAL_EEPROM_H_
+#define EXTERNAL_EEPROM_H_
+
+#include "../MCAL/std_types.h"
+#include "../MCAL/twi.h"
+#include "../MCAL/timer.h"
+
+/*******************************************************************************
+ *                      Preprocessor Macros                                    *
+ *******************************************************************************/
+#define ERROR 0
+#define SUCCESS 1
+#define TIMEOUT 2
+#define EEPROM_BUSY 3 /* Result of a background access not finished yet */
+
+/* Maximum number of SLA+W polls while waiting for the internal write cycle,
+ * one poll takes about 30 us at 400 Kb/s so this bounds the wait to about 30 ms */
+#define EEPROM_ACK_POLL_MAX_RETRIES 1000
+
+/* Size of the internal page write buffer of the 24C16 */
+#define EEPROM_PAGE_SIZE 16
+
+/* Bus attempts of an access before it fails with ERROR, the wait before
+ * every retry doubles starting from EEPROM_RETRY_BACKOFF_MS */
+#define EEPROM_MAX_ATTEMPTS 3
+#define EEPROM_RETRY_BACKOFF_MS 2
+
+/* Period of the TWI watchdog while an access is running, a stuck bus is cleared after 2 periods at most */
+#define EEPROM_WATCHDOG_MS 2
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Background access run by the TWI ISR, result is EEPROM_BUSY until it ends
+ * with SUCCESS, ERROR or TIMEOUT.
+ */
+typedef struct
+{
+	TWI_TransactionType transaction; /* First member, the TWI callback gets its address */
+	uint8 writeLength;               /* Bytes written, kept to send them again on a retry */
+	uint8 attempts;
+	volatile boolean retry;          /* The last attempt failed, the next one waits for the backoff */
+	Timer1_SoftTimerType backoff;
+	uint16 polls;                    /* NACKed acknowledge polls of the write cycle */
+	volatile uint8 result;
+}EEPROM_RequestType;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+uint8 EEPROM_writeByte(uint16 u16addr,uint8 u8data);
+uint8 EEPROM_readByte(uint16 u16addr,uint8 *u8data);
+
+/*
+ * Description :
+ * Write up to EEPROM_PAGE_SIZE bytes in one bus transaction using the page buffer.
+ * The bytes must not cross a page boundary otherwise nothing is written and ERROR is returned.
+ */
+uint8 EEPROM_writePage(uint16 u16addr,const uint8 *u8data,uint8 length);
+
+/*
+ * Description :
+ * Read length consecutive bytes in one bus transaction using the sequential read.
+ */
+uint8 EEPROM_readBlock(uint16 u16addr,uint8 *u8data,uint16 length);
+
+/*
+ * Description :
+ * Wait for the end of the internal write cycle by acknowledge polling, the memory
+ * does not ACK its address until the cycle is finished.
+ * Returns SUCCESS as soon as the memory ACKs, TIMEOUT after EEPROM_ACK_POLL_MAX_RETRIES polls
+ * or ERROR if the bus failed.
+ * If pollCount_Ptr is not NULL_PTR the number of NACKed polls is stored in it
+ * to measure the real write cycle time of the device.
+ */
+uint8 EEPROM_waitWriteComplete(uint16 *pollCount_Ptr);
+
+/*
+ * Description :
+ * The functions below run the access in the background and EEPROM_poll must be called until the result
+ * of the request is not EEPROM_BUSY. A failed bus attempt is retried up to EEPROM_MAX_ATTEMPTS times,
+ * the retries and the TWI watchdog are timed by the Timer1 system tick which must be running.
+ * The blocking functions above are built on them.
+ */
+
+/*
+ * Description :
+ * Start writing a page like EEPROM_writePage followed by the acknowledge polling of
+ * EEPROM_waitWriteComplete, all of it in the background.
+ * Returns ERROR if the access could not be started, else the result of the request
+ * becomes SUCCESS once the memory has finished its write cycle.
+ * The request and the data must stay valid until the result is not EEPROM_BUSY.
+ */
+uint8 EEPROM_startWritePage(EEPROM_RequestType *request_Ptr,uint16 u16addr,const uint8 *u8data,uint8 length);
+
+/*
+ * Description :
+ * Start reading a block like EEPROM_readBlock in the background.
+ * Returns ERROR if the access could not be started, else the result of the request
+ * becomes SUCCESS once the bytes are in u8data.
+ * The request and the buffer must stay valid until the result is not EEPROM_BUSY.
+ */
+uint8 EEPROM_startReadBlock(EEPROM_RequestType *request_Ptr,uint16 u16addr,uint8 *u8data,uint16 length);
+
+/*
+ * Description :
+ * Go on with a background access: serve the TWI watchdog and start the retry
+ * of a failed attempt once its backoff is over. Returns the result of the request.
+ */
+uint8 EEPROM_poll(EEPROM_RequestType *request_Ptr);
+ 
+#endif /* EXTERNAL_EEPROM_H_ */
@@ -1,102 +1,247 @@
- /******************************************************************************
- *
- * Module: GPIO
- *
- * File Name: gpio.h
- *
- * Description: Header file for the AVR GPIO driver
- *
- * Author: Mohamed Tarek
- *
- *******************************************************************************/
-
-#ifndef GPIO_H_
-#define GPIO_H_
-
-#include "std_types.h"
-
-/*******************************************************************************
- *                                Definitions                                  *
- *******************************************************************************/
-#define NUM_OF_PORTS           4
-#define NUM_OF_PINS_PER_PORT   8
-
-#define PORTA_ID               0
-#define PORTB_ID               1
-#define PORTC_ID               2
-#define PORTD_ID               3
-
-#define PIN0_ID                0
-#define PIN1_ID                1
-#define PIN2_ID                2
-#define PIN3_ID                3
-#define PIN4_ID                4
-#define PIN5_ID                5
-#define PIN6_ID                6
-#define PIN7_ID                7
-
-/*******************************************************************************
- *                               Types Declaration                             *
- *******************************************************************************/
-typedef enum
-{
-	PIN_INPUT,PIN_OUTPUT
-}GPIO_PinDirectionType;
-
-typedef enum
-{
-	PORT_INPUT,PORT_OUTPUT=0xFF
-}GPIO_PortDirectionType;
-
-/*******************************************************************************
- *                              Functions Prototypes                           *
- *******************************************************************************/
-
-/*
- * Description :
- * Setup the direction of the required pin input/output.
- * If the input port number or pin number are not correct, The function will not handle the request.
- */
-void GPIO_setupPinDirection(uint8 port_num, uint8 pin_num, GPIO_PinDirectionType direction);
-
-/*
- * Description :
- * Write the value Logic High or Logic Low on the required pin.
- * If the input port number or pin number are not correct, The function will not handle the request.
- * If the pin is input, this function will enable/disable the internal pull-up resistor.
- */
-void GPIO_writePin(uint8 port_num, uint8 pin_num, uint8 value);
-
-/*
- * Description :
- * Read and return the value for the required pin, it should be Logic High or Logic Low.
- * If the input port number or pin number are not correct, The function will return Logic Low.
- */
-uint8 GPIO_readPin(uint8 port_num, uint8 pin_num);
-
-/*
- * Description :
- * Setup the direction of the required port all pins input/output.
- * If the direction value is PORT_INPUT all pins in this port should be input pins.
- * If the direction value is PORT_OUTPUT all pins in this port should be output pins.
- * If the input port number is not correct, The function will not handle the request.
- */
-void GPIO_setupPortDirection(uint8 port_num, uint8 direction);
-
-/*
- * Description :
- * Write the value on the required port.
- * If any pin in the port is output pin the value will be written.
- * If any pin in the port is input pin this will activate/deactivate the internal pull-up resistor.
- * If the input port number is not correct, The function will not handle the request.
- */
-void GPIO_writePort(uint8 port_num, uint8 value);
-
-/*
- * Description :
- * Read and return the value of the required port.
- * If the input port number is not correct, The function will return ZERO value.
- */
-uint8 GPIO_readPort(uint8 port_num);
-
-#endif /* GPIO_H_ */
+ /******************************************************************************
+ *
+ * Module: GPIO
+ *
+ * File Name: gpio.h
+ *
+ * Description: Header file for the AVR GPIO driver
+ *
+ * Author: Mohamed Tarek
+ *
+ *******************************************************************************/
+
+#ifndef GPIO_H_
+#define GPIO_H_
+
+#include "std_types.h"
+#include "common_macros.h" /* To use the macros like SET_BIT */
+#include "avr/io.h" /* To use the IO Ports Registers */
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define NUM_OF_PORTS           4
+#define NUM_OF_PINS_PER_PORT   8
+
+#define PORTA_ID               0
+#define PORTB_ID               1
+#define PORTC_ID               2
+#define PORTD_ID               3
+
+#define PIN0_ID                0
+#define PIN1_ID                1
+#define PIN2_ID                2
+#define PIN3_ID                3
+#define PIN4_ID                4
+#define PIN5_ID                5
+#define PIN6_ID                6
+#define PIN7_ID                7
+
+/*
+ * The GPIO functions are replaced by inline code when their port and pin numbers are compile time
+ * constants, like all the pins of the HAL drivers configurations, so every access is folded into a
+ * single sbi/cbi/sbis/out/in instruction. The functions of gpio.c are kept for the pins known at
+ * run time only. Define GPIO_NO_INLINE before including this file (or with -D) to always call them.
+ */
+#define GPIO_INLINE            static inline __attribute__((always_inline))
+
+/* Registers of a port, the port number should be a constant to be folded into one address */
+#define GPIO_DDR_REG(port_num)  (*(((port_num) == PORTA_ID) ? &DDRA : ((port_num) == PORTB_ID) ? &DDRB : \
+                                   ((port_num) == PORTC_ID) ? &DDRC : &DDRD))
+#define GPIO_PORT_REG(port_num) (*(((port_num) == PORTA_ID) ? &PORTA : ((port_num) == PORTB_ID) ? &PORTB : \
+                                   ((port_num) == PORTC_ID) ? &PORTC : &PORTD))
+#define GPIO_PIN_REG(port_num)  (*(((port_num) == PORTA_ID) ? &PINA : ((port_num) == PORTB_ID) ? &PINB : \
+                                   ((port_num) == PORTC_ID) ? &PINC : &PIND))
+
+/*******************************************************************************
+ *                               Types Declaration                             *
+ *******************************************************************************/
+typedef enum
+{
+	PIN_INPUT,PIN_OUTPUT
+}GPIO_PinDirectionType;
+
+typedef enum
+{
+	PORT_INPUT,PORT_OUTPUT=0xFF
+}GPIO_PortDirectionType;
+
+/*******************************************************************************
+ *                              Functions Prototypes                           *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Setup the direction of the required pin input/output.
+ * If the input port number or pin number are not correct, The function will not handle the request.
+ */
+void GPIO_setupPinDirection(uint8 port_num, uint8 pin_num, GPIO_PinDirectionType direction);
+
+/*
+ * Description :
+ * Write the value Logic High or Logic Low on the required pin.
+ * If the input port number or pin number are not correct, The function will not handle the request.
+ * If the pin is input, this function will enable/disable the internal pull-up resistor.
+ */
+void GPIO_writePin(uint8 port_num, uint8 pin_num, uint8 value);
+
+/*
+ * Description :
+ * Read and return the value for the required pin, it should be Logic High or Logic Low.
+ * If the input port number or pin number are not correct, The function will return Logic Low.
+ */
+uint8 GPIO_readPin(uint8 port_num, uint8 pin_num);
+
+/*
+ * Description :
+ * Setup the direction of the required port all pins input/output.
+ * If the direction value is PORT_INPUT all pins in this port should be input pins.
+ * If the direction value is PORT_OUTPUT all pins in this port should be output pins.
+ * If the input port number is not correct, The function will not handle the request.
+ */
+void GPIO_setupPortDirection(uint8 port_num, uint8 direction);
+
+/*
+ * Description :
+ * Write the value on the required port.
+ * If any pin in the port is output pin the value will be written.
+ * If any pin in the port is input pin this will activate/deactivate the internal pull-up resistor.
+ * If the input port number is not correct, The function will not handle the request.
+ */
+void GPIO_writePort(uint8 port_num, uint8 value);
+
+/*
+ * Description :
+ * Read and return the value of the required port.
+ * If the input port number is not correct, The function will return ZERO value.
+ */
+uint8 GPIO_readPort(uint8 port_num);
+
+/*******************************************************************************
+ *                     Inline Functions (constant pins)                        *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Same as GPIO_setupPinDirection for a constant port and pin.
+ */
+GPIO_INLINE void GPIO_setupPinDirectionInline(uint8 port_num, uint8 pin_num, GPIO_PinDirectionType direction)
+{
+	if((pin_num < NUM_OF_PINS_PER_PORT) && (port_num < NUM_OF_PORTS))
+	{
+		if(direction == PIN_OUTPUT)
+		{
+			SET_BIT(GPIO_DDR_REG(port_num),pin_num);
+		}
+		else
+		{
+			CLEAR_BIT(GPIO_DDR_REG(port_num),pin_num);
+		}
+	}
+}
+
+/*
+ * Description :
+ * Same as GPIO_writePin for a constant port and pin.
+ */
+GPIO_INLINE void GPIO_writePinInline(uint8 port_num, uint8 pin_num, uint8 value)
+{
+	if((pin_num < NUM_OF_PINS_PER_PORT) && (port_num < NUM_OF_PORTS))
+	{
+		if(value == LOGIC_HIGH)
+		{
+			SET_BIT(GPIO_PORT_REG(port_num),pin_num);
+		}
+		else
+		{
+			CLEAR_BIT(GPIO_PORT_REG(port_num),pin_num);
+		}
+	}
+}
+
+/*
+ * Description :
+ * Same as GPIO_readPin for a constant port and pin.
+ */
+GPIO_INLINE uint8 GPIO_readPinInline(uint8 port_num, uint8 pin_num)
+{
+	uint8 pin_value = LOGIC_LOW;
+
+	if((pin_num < NUM_OF_PINS_PER_PORT) && (port_num < NUM_OF_PORTS) && BIT_IS_SET(GPIO_PIN_REG(port_num),pin_num))
+	{
+		pin_value = LOGIC_HIGH;
+	}
+	return pin_value;
+}
+
+/*
+ * Description :
+ * Same as GPIO_setupPortDirection for a constant port.
+ */
+GPIO_INLINE void GPIO_setupPortDirectionInline(uint8 port_num, uint8 direction)
+{
+	if(port_num < NUM_OF_PORTS)
+	{
+		GPIO_DDR_REG(port_num) = direction;
+	}
+}
+
+/*
+ * Description :
+ * Same as GPIO_writePort for a constant port.
+ */
+GPIO_INLINE void GPIO_writePortInline(uint8 port_num, uint8 value)
+{
+	if(port_num < NUM_OF_PORTS)
+	{
+		GPIO_PORT_REG(port_num) = value;
+	}
+}
+
+/*
+ * Description :
+ * Same as GPIO_readPort for a constant port.
+ */
+GPIO_INLINE uint8 GPIO_readPortInline(uint8 port_num)
+{
+	uint8 value = LOGIC_LOW;
+
+	if(port_num < NUM_OF_PORTS)
+	{
+		value = GPIO_PIN_REG(port_num);
+	}
+	return value;
+}
+
+#ifndef GPIO_NO_INLINE
+
+/* Select the inline code if the port and pin numbers are constants, else call the function */
+#define GPIO_IS_CONSTANT(port_num, pin_num)   (__builtin_constant_p(port_num) && __builtin_constant_p(pin_num))
+
+#define GPIO_setupPinDirection(port_num, pin_num, direction) \
+	(GPIO_IS_CONSTANT(port_num, pin_num) ? GPIO_setupPinDirectionInline(port_num, pin_num, direction) : \
+	                                       (GPIO_setupPinDirection)(port_num, pin_num, direction))
+
+#define GPIO_writePin(port_num, pin_num, value) \
+	(GPIO_IS_CONSTANT(port_num, pin_num) ? GPIO_writePinInline(port_num, pin_num, value) : \
+	                                       (GPIO_writePin)(port_num, pin_num, value))
+
+#define GPIO_readPin(port_num, pin_num) \
+	(GPIO_IS_CONSTANT(port_num, pin_num) ? GPIO_readPinInline(port_num, pin_num) : \
+	                                       (GPIO_readPin)(port_num, pin_num))
+
+#define GPIO_setupPortDirection(port_num, direction) \
+	(__builtin_constant_p(port_num) ? GPIO_setupPortDirectionInline(port_num, direction) : \
+	                                  (GPIO_setupPortDirection)(port_num, direction))
+
+#define GPIO_writePort(port_num, value) \
+	(__builtin_constant_p(port_num) ? GPIO_writePortInline(port_num, value) : \
+	                                  (GPIO_writePort)(port_num, value))
+
+#define GPIO_readPort(port_num) \
+	(__builtin_constant_p(port_num) ? GPIO_readPortInline(port_num) : \
+	                                  (GPIO_readPort)(port_num))
+
+#endif /* GPIO_NO_INLINE */
+
+#endif /* GPIO_H_ */
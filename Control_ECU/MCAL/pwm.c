@@ -1,51 +1,51 @@
- /******************************************************************************
- *
- * Module: PWM
- *
- * File Name: pwm.c
- *
- * Description: header file for the PWM driver
- *
- * Author: Omar Muhammad
- *
- *******************************************************************************/
-
-#include <avr/io.h>
-#include"gpio.h"
-
-
-/*******************************************************************************
- *                      Functions Definitions                                  *
- *******************************************************************************/
-/*
- * Description:
- * Generate a PWM signal with frequency 500Hz
- * Timer0 will be used with pre-scaler F_CPU/8
- * F_PWM=(F_CPU)/(256*N) = (10^6)/(256*8) = 500Hz
- * Duty Cycle can be changed by updating the value
- * in The Compare Register
- *
- * [Args] :
- * a_uint8 a_duty_cycle:
- *    This Arg shall indicate duty cycle percentage of the generated PWM signal.
- *    Its value should be from 0 → 100
- */
-
-void PWM_Timer0_Start(uint8 duty_cycle)
-{
-
-	TCNT0 = 0; /*Set Timer Initial value*/
-
-	OCR0  = (duty_cycle * 255) / 100; /* Set Compare Value */
-
-	/* set PB3/OC0 as output pin --> pin where the PWM signal is generated from  MC. */
-	GPIO_setupPinDirection(PORTB_ID, PIN3_ID, PIN_OUTPUT);
-
-	/* Configure timer control register
-	 * 1. Fast PWM mode FOC0=0
-	 * 2. Fast PWM Mode WGM01=1 & WGM00=1
-	 * 3. Clear OC0 when match occurs (non inverted mode) COM00=0 & COM01=1
-	 * 4. clock = F_CPU/8 CS00=0 CS01=1 CS02=0
-	 */
-	TCCR0 = (1<<WGM00) | (1<<WGM01) | (1<<COM01) | (1<<CS01);
-}
+ /******************************************************************************
+ *
+ * Module: PWM
+ *
+ * File Name: pwm.c
+ *
+ * Description: header file for the PWM driver
+ *
+ * Author: Omar Muhammad
+ *
+ *******************************************************************************/
+
+#include <avr/io.h>
+#include"gpio.h"
+
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+/*
+ * Description:
+ * Generate a PWM signal with frequency 500Hz
+ * Timer0 will be used with pre-scaler F_CPU/8
+ * F_PWM=(F_CPU)/(256*N) = (10^6)/(256*8) = 500Hz
+ * Duty Cycle can be changed by updating the value
+ * in The Compare Register
+ *
+ * [Args] :
+ * a_uint8 a_duty_cycle:
+ *    This Arg shall indicate duty cycle percentage of the generated PWM signal.
+ *    Its value should be from 0 → 100
+ */
+
+void PWM_Timer0_Start(uint8 duty_cycle)
+{
+
+	TCNT0 = 0; /*Set Timer Initial value*/
+
+	OCR0  = (duty_cycle * 255) / 100; /* Set Compare Value */
+
+	/* set PB3/OC0 as output pin --> pin where the PWM signal is generated from  MC. */
+	GPIO_setupPinDirection(PORTB_ID, PIN3_ID, PIN_OUTPUT);
+
+	/* Configure timer control register
+	 * 1. Fast PWM mode FOC0=0
+	 * 2. Fast PWM Mode WGM01=1 & WGM00=1
+	 * 3. Clear OC0 when match occurs (non inverted mode) COM00=0 & COM01=1
+	 * 4. clock = F_CPU/8 CS00=0 CS01=1 CS02=0
+	 */
+	TCCR0 = (1<<WGM00) | (1<<WGM01) | (1<<COM01) | (1<<CS01);
+}
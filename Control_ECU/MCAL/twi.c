@@ -1,164 +1,475 @@
-/******************************************************************************
- *
- * Module: TWI(I2C)
- *
- * File Name: twi.c
- *
- * Description: Source file for the TWI(I2C) AVR driver
- *
- * Author: Omar Muhammad
- *
- *******************************************************************************/
-
-#include "twi.h"
-#include "common_macros.h"
-#include <avr/io.h>
-
-
-/*******************************************************************************
- *                      Functions Definitions                                  *
- *******************************************************************************/
-
-/*
- *Description :
- *    Initialize I2C (TWI) Interface
- */
-void TWI_init(const TWI_ConfigType * Config_Ptr)
-{
-	/* Bit Rate:using zero pre-scaler TWPS=00 and F_CPU=8Mhz */
-	TWSR = 0x00;
-	switch(Config_Ptr->bit_rate)
-	{
-	/*Bit Rate: 100 Kb/s*/
-	case NORMALMODE:
-#if(F_CPU == 8000000ul)
-		TWBR = 0x20;
-#endif
-
-#if(F_CPU == 16000000ul)
-		TWBR = 0x48;
-#endif
-		break;
-
-		/*Bit Rate: 400 Kb/s*/
-	case FAST_MODE:
-#if(F_CPU == 8000000ul)
-		TWBR = 0x02;
-#endif
-#if(F_CPU == 16000000ul)
-		TWBR = 0x0C;
-#endif
-		break;
-
-		/*Bit Rate: 1 Mb/s*/
-		/*Cannot be achieved by 8 MHz F_CPU*/
-#if(F_CPU == 16000000ul)
-
-	case FAST_MODE_PLUS:
-		TWBR = 0x00
-		break;
-#endif
-	}
-
-	/* Two Wire Bus address my address if any master device want to call me: 0x1 (used in case this MC is a slave device)
-       General Call Recognition: Off */
-	TWAR = Config_Ptr->address; // my address
-
-
-	TWCR = (1<<TWEN); /* enable TWI */
-}
-
-/*
- *Description :
- *    Send the Start bit
- */
-void TWI_start(void)
-{
-	/*
-	 * Clear the TWINT flag before sending the start bit TWINT=1
-	 * send the start bit by TWSTA=1
-	 * Enable TWI Module TWEN=1 
-	 */
-	TWCR = (1 << TWINT) | (1 << TWSTA) | (1 << TWEN);
-
-	/* Wait for TWINT flag set in TWCR Register (start bit is send successfully) */
-	while(BIT_IS_CLEAR(TWCR,TWINT));
-}
-
-/*
- *Description :
- *    Send the Stop bit
- */
-void TWI_stop(void)
-{
-	/*
-	 * Clear the TWINT flag before sending the stop bit TWINT=1
-	 * send the stop bit by TWSTO=1
-	 * Enable TWI Module TWEN=1 
-	 */
-	TWCR = (1 << TWINT) | (1 << TWSTO) | (1 << TWEN);
-}
-
-/*
- *Description :
- *    Send the Start bit
- */
-void TWI_writeByte(uint8 data)
-{
-	/* Put data On TWI data Register */
-	TWDR = data;
-	/*
-	 * Clear the TWINT flag before sending the data TWINT=1
-	 * Enable TWI Module TWEN=1 
-	 */ 
-	TWCR = (1 << TWINT) | (1 << TWEN);
-	/* Wait for TWINT flag set in TWCR Register(data is send successfully) */
-	while(BIT_IS_CLEAR(TWCR,TWINT));
-}
-
-/*
- *Description :
- *    Reads the byte received with ACK bit sent to Continue receiving
- */
-uint8 TWI_readByteWithACK(void)
-{
-	/* 
-	 * Clear the TWINT flag before reading the data TWINT=1
-	 * Enable sending ACK after reading or receiving data TWEA=1
-	 * Enable TWI Module TWEN=1 
-	 */ 
-	TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWEA);
-	/* Wait for TWINT flag set in TWCR Register (data received successfully) */
-	while(BIT_IS_CLEAR(TWCR,TWINT));
-	/* Read Data */
-	return TWDR;
-}
-
-/*
- *Description :
- *    Reads the byte received with NACK bit sent to Stop receiving
- */
-uint8 TWI_readByteWithNACK(void)
-{
-	/* 
-	 * Clear the TWINT flag before reading the data TWINT=1
-	 * Enable TWI Module TWEN=1 
-	 */
-	TWCR = (1 << TWINT) | (1 << TWEN);
-	/* Wait for TWINT flag set in TWCR Register (data received successfully) */
-	while(BIT_IS_CLEAR(TWCR,TWINT));
-	/* Read Data */
-	return TWDR;
-}
-
-/*
- *Description :
- *    Send the Start bit
- */
-uint8 TWI_getStatus(void)
-{
-	uint8 status;
-	/* masking to eliminate first 3 bits and get the last 5 bits (status bits) */
-	status = TWSR & 0xF8;
-	return status;
-}
+/******************************************************************************
+ *
+ * Module: TWI(I2C)
+ *
+ * File Name: twi.c
+ *
+ * Description: Source file for the TWI(I2C) AVR driver
+ *
+ * Author: Omar Muhammad
+ *
+ *******************************************************************************/
+
+#include "twi.h"
+#include "common_macros.h"
+#include <avr/io.h>
+#include <avr/interrupt.h> /* For the TWI ISR */
+#include <util/delay.h> /* For the SCL pulses of the bus clear */
+
+/*******************************************************************************
+ *                      Preprocessor Macros                                    *
+ *******************************************************************************/
+
+/* TWCR written by the ISR to go on with the transaction, the TWI interrupt stays enabled */
+#define TWI_CONTINUE      ((1 << TWINT) | (1 << TWEN) | (1 << TWIE))
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+/*
+ * Queue of the transactions, the one at g_twiHead is on the bus.
+ * The ISR is the only writer of g_twiHead, g_twiCount is updated with the interrupts disabled.
+ */
+static TWI_TransactionType * volatile g_twiQueue[TWI_QUEUE_SIZE];
+static volatile uint8 g_twiHead = 0;
+static volatile uint8 g_twiCount = 0;
+
+/* The bus is held by the driver from the first START until the STOP of the last queued transaction */
+static volatile boolean g_twiBusy = FALSE;
+
+/* Bytes of the running transaction already sent (header then write buffer) or received */
+static uint16 g_twiIndex;
+
+/* Counts the bus steps, the watchdog fails the transaction when it does not move between two calls */
+static volatile uint8 g_twiProgress = 0;
+static uint8 g_twiWatchedProgress = 0;
+
+/*******************************************************************************
+ *                      Functions Definitions(Private)                         *
+ *******************************************************************************/
+
+/*
+ *Description :
+ *    Wait for TWINT, at most TWI_WAIT_LOOPS checks.
+ *    TWSR reads TWI_NO_INFO while TWINT is cleared so the status check of the caller fails on a timeout.
+ */
+static void TWI_waitFlag(void)
+{
+	uint16 loops;
+
+	for(loops = 0; (loops < TWI_WAIT_LOOPS) && BIT_IS_CLEAR(TWCR,TWINT); loops++);
+}
+
+/*
+ *Description :
+ *    Wait for the end of the Stop bit, at most TWI_WAIT_LOOPS checks.
+ */
+static void TWI_waitStop(void)
+{
+	uint16 loops;
+
+	for(loops = 0; (loops < TWI_WAIT_LOOPS) && BIT_IS_SET(TWCR,TWSTO); loops++);
+}
+
+/*
+ *Description :
+ *    End the running transaction and call its callback.
+ */
+static void TWI_complete(uint8 result, uint8 status)
+{
+	TWI_TransactionType *transaction_Ptr = g_twiQueue[g_twiHead];
+
+	g_twiHead = (g_twiHead + 1) & (TWI_QUEUE_SIZE - 1);
+	g_twiCount--;
+
+	transaction_Ptr->status = status;
+	transaction_Ptr->result = result;
+	if(transaction_Ptr->callback_Ptr != NULL_PTR)
+	{
+		/* The callback may queue the next transaction, it is started by the caller */
+		transaction_Ptr->callback_Ptr(transaction_Ptr);
+	}
+}
+
+/*
+ *Description :
+ *    End the running transaction, then release the bus or send a STOP
+ *    followed by a START for the next queued transaction.
+ */
+static void TWI_finish(uint8 result, uint8 status)
+{
+	TWI_complete(result, status);
+
+	if(g_twiCount != 0)
+	{
+		TWCR = TWI_CONTINUE | (1 << TWSTO) | (1 << TWSTA);
+	}
+	else
+	{
+		TWCR = TWI_CONTINUE | (1 << TWSTO);
+		g_twiBusy = FALSE;
+	}
+}
+
+/*
+ *Description :
+ *    Go on with the running transaction after the step reported by the status in TWSR.
+ */
+static void TWI_handleEvent(void)
+{
+	TWI_TransactionType *transaction_Ptr = g_twiQueue[g_twiHead];
+	uint16 writeLength = (uint16)transaction_Ptr->headerLength + transaction_Ptr->writeLength;
+	uint8 status = TWI_getStatus();
+
+	g_twiProgress++;
+	switch(status)
+	{
+	case TWI_START:
+		/* Write first, a transaction that only reads addresses the slave for reading at once */
+		g_twiIndex = 0;
+		if((writeLength == 0) && (transaction_Ptr->readLength != 0))
+			TWDR = transaction_Ptr->slave | 1;
+		else
+			TWDR = transaction_Ptr->slave;
+		TWCR = TWI_CONTINUE;
+		break;
+
+	case TWI_REP_START:
+		/* Read part after the write part */
+		g_twiIndex = 0;
+		TWDR = transaction_Ptr->slave | 1;
+		TWCR = TWI_CONTINUE;
+		break;
+
+	case TWI_MT_SLA_W_ACK:
+	case TWI_MT_DATA_ACK:
+		if(g_twiIndex < writeLength)
+		{
+			if(g_twiIndex < transaction_Ptr->headerLength)
+				TWDR = transaction_Ptr->header[g_twiIndex];
+			else
+				TWDR = transaction_Ptr->write_Ptr[g_twiIndex - transaction_Ptr->headerLength];
+			g_twiIndex++;
+			TWCR = TWI_CONTINUE;
+		}
+		else if(transaction_Ptr->readLength != 0)
+		{
+			TWCR = TWI_CONTINUE | (1 << TWSTA);
+		}
+		else
+		{
+			TWI_finish(TWI_DONE, status);
+		}
+		break;
+
+	case TWI_MT_SLA_R_ACK:
+		/* ACK all the bytes except the last one to keep the slave sending */
+		if(transaction_Ptr->readLength > 1)
+			TWCR = TWI_CONTINUE | (1 << TWEA);
+		else
+			TWCR = TWI_CONTINUE;
+		break;
+
+	case TWI_MR_DATA_ACK:
+		transaction_Ptr->read_Ptr[g_twiIndex] = TWDR;
+		g_twiIndex++;
+		if((g_twiIndex + 1) < transaction_Ptr->readLength)
+			TWCR = TWI_CONTINUE | (1 << TWEA);
+		else
+			TWCR = TWI_CONTINUE;
+		break;
+
+	case TWI_MR_DATA_NACK:
+		transaction_Ptr->read_Ptr[g_twiIndex] = TWDR;
+		TWI_finish(TWI_DONE, status);
+		break;
+
+	default:
+		/* NACK from the slave, arbitration lost or bus error: release the bus */
+		TWI_finish(TWI_FAILED, status);
+		break;
+	}
+}
+
+/*******************************************************************************
+ *                       Interrupt Service Routines                            *
+ *******************************************************************************/
+
+ISR(TWI_vect)
+{
+	TWI_handleEvent();
+}
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ *Description :
+ *    Initialize I2C (TWI) Interface
+ */
+void TWI_init(const TWI_ConfigType * Config_Ptr)
+{
+	/* Bit Rate:using zero pre-scaler TWPS=00 and F_CPU=8Mhz */
+	TWSR = 0x00;
+	switch(Config_Ptr->bit_rate)
+	{
+	/*Bit Rate: 100 Kb/s*/
+	case NORMALMODE:
+#if(F_CPU == 8000000ul)
+		TWBR = 0x20;
+#endif
+
+#if(F_CPU == 16000000ul)
+		TWBR = 0x48;
+#endif
+		break;
+
+		/*Bit Rate: 400 Kb/s*/
+	case FAST_MODE:
+#if(F_CPU == 8000000ul)
+		TWBR = 0x02;
+#endif
+#if(F_CPU == 16000000ul)
+		TWBR = 0x0C;
+#endif
+		break;
+
+		/*Bit Rate: 1 Mb/s*/
+		/*Cannot be achieved by 8 MHz F_CPU*/
+#if(F_CPU == 16000000ul)
+
+	case FAST_MODE_PLUS:
+		TWBR = 0x00
+		break;
+#endif
+	}
+
+	/* Two Wire Bus address my address if any master device want to call me: 0x1 (used in case this MC is a slave device)
+       General Call Recognition: Off */
+	TWAR = Config_Ptr->address; // my address
+
+
+	/* Drop the queued transactions */
+	g_twiHead = 0;
+	g_twiCount = 0;
+	g_twiBusy = FALSE;
+
+	TWCR = (1<<TWEN); /* enable TWI */
+}
+
+/*
+ *Description :
+ *    Send the Start bit
+ */
+void TWI_start(void)
+{
+	/*
+	 * Clear the TWINT flag before sending the start bit TWINT=1
+	 * send the start bit by TWSTA=1
+	 * Enable TWI Module TWEN=1 
+	 */
+	TWCR = (1 << TWINT) | (1 << TWSTA) | (1 << TWEN);
+
+	/* Wait for TWINT flag set in TWCR Register (start bit is send successfully) */
+	TWI_waitFlag();
+}
+
+/*
+ *Description :
+ *    Send the Stop bit
+ */
+void TWI_stop(void)
+{
+	/*
+	 * Clear the TWINT flag before sending the stop bit TWINT=1
+	 * send the stop bit by TWSTO=1
+	 * Enable TWI Module TWEN=1 
+	 */
+	TWCR = (1 << TWINT) | (1 << TWSTO) | (1 << TWEN);
+
+	/* The next Start bit must not be sent before the Stop bit */
+	TWI_waitStop();
+}
+
+/*
+ *Description :
+ *    Send the Start bit
+ */
+void TWI_writeByte(uint8 data)
+{
+	/* Put data On TWI data Register */
+	TWDR = data;
+	/*
+	 * Clear the TWINT flag before sending the data TWINT=1
+	 * Enable TWI Module TWEN=1 
+	 */ 
+	TWCR = (1 << TWINT) | (1 << TWEN);
+	/* Wait for TWINT flag set in TWCR Register(data is send successfully) */
+	TWI_waitFlag();
+}
+
+/*
+ *Description :
+ *    Reads the byte received with ACK bit sent to Continue receiving
+ */
+uint8 TWI_readByteWithACK(void)
+{
+	/* 
+	 * Clear the TWINT flag before reading the data TWINT=1
+	 * Enable sending ACK after reading or receiving data TWEA=1
+	 * Enable TWI Module TWEN=1 
+	 */ 
+	TWCR = (1 << TWINT) | (1 << TWEN) | (1 << TWEA);
+	/* Wait for TWINT flag set in TWCR Register (data received successfully) */
+	TWI_waitFlag();
+	/* Read Data */
+	return TWDR;
+}
+
+/*
+ *Description :
+ *    Reads the byte received with NACK bit sent to Stop receiving
+ */
+uint8 TWI_readByteWithNACK(void)
+{
+	/* 
+	 * Clear the TWINT flag before reading the data TWINT=1
+	 * Enable TWI Module TWEN=1 
+	 */
+	TWCR = (1 << TWINT) | (1 << TWEN);
+	/* Wait for TWINT flag set in TWCR Register (data received successfully) */
+	TWI_waitFlag();
+	/* Read Data */
+	return TWDR;
+}
+
+/*
+ *Description :
+ *    Send the Start bit
+ */
+uint8 TWI_getStatus(void)
+{
+	uint8 status;
+	/* masking to eliminate first 3 bits and get the last 5 bits (status bits) */
+	status = TWSR & 0xF8;
+	return status;
+}
+
+/*
+ *Description :
+ *    Queue a transaction, the bus is taken at once if it is free.
+ *    The transaction is then run by the TWI ISR while the CPU does other work.
+ *    Can be called from a callback to chain the next transaction.
+ *    Returns FALSE if the queue is full.
+ *    The polled functions above must not be used while a transaction is queued.
+ */
+boolean TWI_submit(TWI_TransactionType *transaction_Ptr)
+{
+	boolean queued = FALSE;
+	/* Called from the application and from the callbacks in the ISR */
+	uint8 sreg = SREG;
+
+	cli();
+	if(g_twiCount < TWI_QUEUE_SIZE)
+	{
+		transaction_Ptr->result = TWI_PENDING;
+		g_twiQueue[(g_twiHead + g_twiCount) & (TWI_QUEUE_SIZE - 1)] = transaction_Ptr;
+		g_twiCount++;
+		queued = TRUE;
+
+		if(g_twiBusy == FALSE)
+		{
+			/* The STOP ending the last transaction must be on the bus before the START */
+			TWI_waitStop();
+			g_twiBusy = TRUE;
+			g_twiProgress++;
+			TWCR = TWI_CONTINUE | (1 << TWSTA);
+		}
+	}
+	SREG = sreg;
+
+	return queued;
+}
+
+/*
+ *Description :
+ *    Serve the TWI by polling when the I-bit is cleared and the ISR cannot run,
+ *    to be called in the loops waiting for the result of a transaction.
+ */
+void TWI_poll(void)
+{
+	if(BIT_IS_CLEAR(SREG,7) && (g_twiBusy == TRUE) && BIT_IS_SET(TWCR,TWINT))
+	{
+		TWI_handleEvent();
+	}
+}
+
+/*
+ *Description :
+ *    Fail the running transaction if the bus made no progress since the previous call,
+ *    the bus is cleared then the next queued transaction starts.
+ *    To be called periodically, the period must be longer than one byte on the bus.
+ */
+void TWI_watchdog(void)
+{
+	uint8 sreg = SREG;
+
+	cli();
+	if((g_twiBusy == TRUE) && (g_twiProgress == g_twiWatchedProgress))
+	{
+		/* No TWI interrupt since the last call, a slave holds the bus or the TWI is stuck */
+		TWI_recover();
+		TWI_complete(TWI_FAILED, TWI_NO_INFO);
+
+		if(g_twiCount != 0)
+		{
+			g_twiProgress++;
+			TWCR = TWI_CONTINUE | (1 << TWSTA);
+		}
+		else
+		{
+			g_twiBusy = FALSE;
+		}
+	}
+	g_twiWatchedProgress = g_twiProgress;
+	SREG = sreg;
+}
+
+/*
+ *Description :
+ *    Free a bus held by a slave in the middle of a byte: disable the TWI, pulse SCL
+ *    up to TWI_CLEAR_PULSES times until the slave releases SDA, send a STOP then enable the TWI again.
+ */
+void TWI_recover(void)
+{
+	uint8 pulse;
+
+	/* The pins go back to PORTC, they are driven open drain: output low or input pulled up by the bus */
+	TWCR = 0;
+	CLEAR_BIT(PORTC,TWI_SCL_PIN);
+	CLEAR_BIT(PORTC,TWI_SDA_PIN);
+	CLEAR_BIT(DDRC,TWI_SDA_PIN);
+	CLEAR_BIT(DDRC,TWI_SCL_PIN);
+
+	/* Every clock lets the slave shift out one more bit until it releases SDA at the end of its byte */
+	for(pulse = 0; (pulse < TWI_CLEAR_PULSES) && BIT_IS_CLEAR(PINC,TWI_SDA_PIN); pulse++)
+	{
+		SET_BIT(DDRC,TWI_SCL_PIN);
+		_delay_us(5);
+		CLEAR_BIT(DDRC,TWI_SCL_PIN);
+		_delay_us(5);
+	}
+
+	/* STOP: SDA rises while SCL is high */
+	SET_BIT(DDRC,TWI_SCL_PIN);
+	SET_BIT(DDRC,TWI_SDA_PIN);
+	_delay_us(5);
+	CLEAR_BIT(DDRC,TWI_SCL_PIN);
+	_delay_us(5);
+	CLEAR_BIT(DDRC,TWI_SDA_PIN);
+	_delay_us(5);
+
+	TWCR = (1<<TWEN);
+}
@@ -1,110 +1,192 @@
-/******************************************************************************
- *
- * Module: TWI(I2C)
- *
- * File Name: twi.h
- *
- * Description: Header file for the TWI(I2C) AVR driver
- *
- * Author: Omar Muhammad
- *
- *******************************************************************************/ 
-
-#ifndef TWI_H_
-#define TWI_H_
-
-#include "std_types.h"
-
-/*******************************************************************************
- *                      Preprocessor Macros                                    *
- *******************************************************************************/
-
-/* I2C Status Bits in the TWSR Register */
-#define TWI_START         0x08 /* start has been sent */
-#define TWI_REP_START     0x10 /* repeated start */
-#define TWI_MT_SLA_W_ACK  0x18 /* Master transmit ( slave address + Write request ) to slave + ACK received from slave. */
-#define TWI_MT_SLA_R_ACK  0x40 /* Master transmit ( slave address + Read request ) to slave + ACK received from slave. */
-#define TWI_MT_DATA_ACK   0x28 /* Master transmit data and ACK has been received from Slave. */
-#define TWI_MR_DATA_ACK   0x50 /* Master received data and send ACK to slave. */
-#define TWI_MR_DATA_NACK  0x58 /* Master received data but doesn't send ACK to slave. */
-
-/*******************************************************************************
- *                         Types Declaration                                   *
- *******************************************************************************/
-
-/*Description:
- * Normal mode : 100Kb/s
- * Fast mode: 400 kb/s
- * Fast mode Plus 1 Mb/s
- * High speed mode 3.4 Mb/s
- * */
-typedef enum
-{
-	NORMALMODE, FAST_MODE
-#if(F_CPU == 16000000ul)
-	,FAST_MODE_PLUS
-
-	/*Cannot be achieved by either 8 MHz or 16 MHz F_CPU*/
-	/*Bit Rate: 3.4 Mb/s*/
-	/*, HIGH_SPEED_MODE*/
-#endif
-}TWI_BaudRate;
-
-
-typedef struct{
-
-	uint8 address;
-	TWI_BaudRate bit_rate;
-
-}TWI_ConfigType;
-
-
-/*******************************************************************************
- *                      Functions Prototypes                                   *
- *******************************************************************************/
-
-
-/*
- *Description :
- *    Initialize I2C (TWI) Interface
- */
-void TWI_init(const TWI_ConfigType * Config_Ptr);
-
-/*
- *Description :
- *    Send the Start bit
- */
-void TWI_start(void);
-
-/*
- *Description :
- *    Send the Stop bit
- */
-void TWI_stop(void);
-
-/*
- *Description :
- *    Send the Start bit
- */
-void TWI_writeByte(uint8 data);
-
-/*
- *Description :
- *    Reads the byte received with ACK bit sent to Continue receiving
- */
-uint8 TWI_readByteWithACK(void);
-
-/*
- *Description :
- *    Reads the byte received with NACK bit sent to Stop receiving
- */
-uint8 TWI_readByteWithNACK(void);
-
-/*
- *Description :
- *    Send the Start bit
- */
-uint8 TWI_getStatus(void);
-
-
-#endif /* TWI_H_ */
+/******************************************************************************
+ *
+ * Module: TWI(I2C)
+ *
+ * File Name: twi.h
+ *
+ * Description: Header file for the TWI(I2C) AVR driver
+ *
+ * Author: Omar Muhammad
+ *
+ *******************************************************************************/ 
+
+#ifndef TWI_H_
+#define TWI_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                      Preprocessor Macros                                    *
+ *******************************************************************************/
+
+/* I2C Status Bits in the TWSR Register */
+#define TWI_START         0x08 /* start has been sent */
+#define TWI_REP_START     0x10 /* repeated start */
+#define TWI_MT_SLA_W_ACK  0x18 /* Master transmit ( slave address + Write request ) to slave + ACK received from slave. */
+#define TWI_MT_SLA_W_NACK 0x20 /* Master transmit ( slave address + Write request ) to slave + NACK received from slave. */
+#define TWI_MT_SLA_R_ACK  0x40 /* Master transmit ( slave address + Read request ) to slave + ACK received from slave. */
+#define TWI_MT_DATA_ACK   0x28 /* Master transmit data and ACK has been received from Slave. */
+#define TWI_MR_DATA_ACK   0x50 /* Master received data and send ACK to slave. */
+#define TWI_MR_DATA_NACK  0x58 /* Master received data but doesn't send ACK to slave. */
+#define TWI_MT_DATA_NACK  0x30 /* Master transmit data and NACK has been received from Slave. */
+#define TWI_ARB_LOST      0x38 /* Arbitration lost in SLA+R/W or data bytes. */
+#define TWI_MR_SLA_R_NACK 0x48 /* Master transmit ( slave address + Read request ) to slave + NACK received from slave. */
+#define TWI_BUS_ERROR     0x00 /* Illegal START or STOP condition. */
+#define TWI_NO_INFO       0xF8 /* No relevant state, TWINT is not set: the step did not end in time. */
+
+/* Results of a queued transaction */
+#define TWI_PENDING       0
+#define TWI_DONE          1
+#define TWI_FAILED        2
+
+/* Number of transactions waiting for the bus, must be a power of two */
+#define TWI_QUEUE_SIZE    4
+
+/* Bytes sent before the write buffer, like the memory location address */
+#define TWI_HEADER_SIZE   2
+
+/* Checks of TWINT or TWSTO before a polled step gives up, about 1 ms at 8 MHz
+ * while one byte takes 90 us at 100 Kb/s */
+#define TWI_WAIT_LOOPS    1000U
+
+/* SCL and SDA pins on PORTC, driven as GPIO by the bus clear */
+#define TWI_SCL_PIN       0
+#define TWI_SDA_PIN       1
+#define TWI_CLEAR_PULSES  9
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+/*Description:
+ * Normal mode : 100Kb/s
+ * Fast mode: 400 kb/s
+ * Fast mode Plus 1 Mb/s
+ * High speed mode 3.4 Mb/s
+ * */
+typedef enum
+{
+	NORMALMODE, FAST_MODE
+#if(F_CPU == 16000000ul)
+	,FAST_MODE_PLUS
+
+	/*Cannot be achieved by either 8 MHz or 16 MHz F_CPU*/
+	/*Bit Rate: 3.4 Mb/s*/
+	/*, HIGH_SPEED_MODE*/
+#endif
+}TWI_BaudRate;
+
+
+typedef struct{
+
+	uint8 address;
+	TWI_BaudRate bit_rate;
+
+}TWI_ConfigType;
+
+/*Description:
+ * One transaction of the interrupt driven master:
+ * START, SLA+W, the header bytes and the write buffer, then if bytes are to be read
+ * a repeated START, SLA+R and the read buffer, then STOP.
+ * Without bytes to write nor to read only the slave address is sent, it tells if the slave ACKs.
+ * The transaction and its buffers must stay valid until the result is not TWI_PENDING.
+ * */
+typedef struct TWI_Transaction
+{
+	uint8 slave;                     /* Slave address with R/W=0 (write) */
+	uint8 header[TWI_HEADER_SIZE];
+	uint8 headerLength;
+	const uint8 *write_Ptr;
+	uint8 writeLength;
+	uint8 *read_Ptr;
+	uint16 readLength;
+	/* Called from the TWI ISR at the end of the transaction, NULL_PTR if not needed */
+	void (*callback_Ptr)(struct TWI_Transaction *transaction_Ptr);
+	volatile uint8 result;           /* TWI_PENDING, TWI_DONE or TWI_FAILED */
+	volatile uint8 status;           /* TWSR status of the last step, the failed one for TWI_FAILED */
+}TWI_TransactionType;
+
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+
+/*
+ *Description :
+ *    Initialize I2C (TWI) Interface
+ */
+void TWI_init(const TWI_ConfigType * Config_Ptr);
+
+/*
+ *Description :
+ *    Send the Start bit
+ *    Like all the polled steps it waits TWI_WAIT_LOOPS checks at most,
+ *    after a timeout TWI_getStatus returns TWI_NO_INFO
+ */
+void TWI_start(void);
+
+/*
+ *Description :
+ *    Send the Stop bit and wait until it is on the bus
+ */
+void TWI_stop(void);
+
+/*
+ *Description :
+ *    Send the Start bit
+ */
+void TWI_writeByte(uint8 data);
+
+/*
+ *Description :
+ *    Reads the byte received with ACK bit sent to Continue receiving
+ */
+uint8 TWI_readByteWithACK(void);
+
+/*
+ *Description :
+ *    Reads the byte received with NACK bit sent to Stop receiving
+ */
+uint8 TWI_readByteWithNACK(void);
+
+/*
+ *Description :
+ *    Send the Start bit
+ */
+uint8 TWI_getStatus(void);
+
+/*
+ *Description :
+ *    Queue a transaction, the bus is taken at once if it is free.
+ *    The transaction is then run by the TWI ISR while the CPU does other work.
+ *    Can be called from a callback to chain the next transaction.
+ *    Returns FALSE if the queue is full.
+ *    The polled functions above must not be used while a transaction is queued.
+ */
+boolean TWI_submit(TWI_TransactionType *transaction_Ptr);
+
+/*
+ *Description :
+ *    Serve the TWI by polling when the I-bit is cleared and the ISR cannot run,
+ *    to be called in the loops waiting for the result of a transaction.
+ */
+void TWI_poll(void);
+
+/*
+ *Description :
+ *    Fail the running transaction if the bus made no progress since the previous call,
+ *    the bus is cleared then the next queued transaction starts.
+ *    To be called periodically, the period must be longer than one byte on the bus.
+ */
+void TWI_watchdog(void);
+
+/*
+ *Description :
+ *    Free a bus held by a slave in the middle of a byte: disable the TWI, pulse SCL
+ *    up to TWI_CLEAR_PULSES times until the slave releases SDA, send a STOP then enable the TWI again.
+ */
+void TWI_recover(void);
+
+
+#endif /* TWI_H_ */
@@ -0,0 +1,30 @@
+################################################################################
+# Automatically-generated file. Do not edit!
+################################################################################
+
+# Add inputs and outputs from these tool invocations to the build variables 
+C_SRCS += \
+../HAL/buzzer.c \
+../HAL/dcmotor.c \
+../HAL/external_eeprom.c 
+
+OBJS += \
+./HAL/buzzer.o \
+./HAL/dcmotor.o \
+./HAL/external_eeprom.o 
+
+C_DEPS += \
+./HAL/buzzer.d \
+./HAL/dcmotor.d \
+./HAL/external_eeprom.d 
+
+
+# Each subdirectory must supply rules for building sources it contributes
+HAL/%.o: ../HAL/%.c HAL/subdir.mk
+	@echo 'Building file: $<'
+	@echo 'Invoking: AVR Compiler'
+	avr-gcc -Wall -g2 -Os -flto -fpack-struct -fshort-enums -ffunction-sections -fdata-sections -std=gnu99 -funsigned-char -funsigned-bitfields -mmcu=atmega32 -DF_CPU=8000000UL -MMD -MP -MF"$(@:%.o=%.d)" -MT"$@" -c -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
+
@@ -0,0 +1,39 @@
+################################################################################
+# Automatically-generated file. Do not edit!
+################################################################################
+
+# Add inputs and outputs from these tool invocations to the build variables 
+C_SRCS += \
+../app.c \
+../audit_log.c \
+../protocol.c \
+../scheduler.c \
+../users.c \
+../password_log.c 
+
+OBJS += \
+./app.o \
+./audit_log.o \
+./protocol.o \
+./scheduler.o \
+./users.o \
+./password_log.o 
+
+C_DEPS += \
+./app.d \
+./audit_log.d \
+./protocol.d \
+./scheduler.d \
+./users.d \
+./password_log.d 
+
+
+# Each subdirectory must supply rules for building sources it contributes
+%.o: ../%.c subdir.mk
+	@echo 'Building file: $<'
+	@echo 'Invoking: AVR Compiler'
+	avr-gcc -Wall -g2 -Os -flto -fpack-struct -fshort-enums -ffunction-sections -fdata-sections -std=gnu99 -funsigned-char -funsigned-bitfields -mmcu=atmega32 -DF_CPU=8000000UL -MMD -MP -MF"$(@:%.o=%.d)" -MT"$@" -c -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
+
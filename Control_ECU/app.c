@@ -1,318 +1,833 @@
-/*
- ================================================================================================
- File Name: app.c
- Name        : Door Locker Security System
- Author      : Omar Muhammad
- Description : Source file of Control_ECU CONTROL_ECU is responsible for all the processing and decisions in the system
-               like password checking, open the door and activate the system alarm.
- Date        : 26/10/2022
- ================================================================================================
- */
-
-#include "app.h"
-#include "MCAL/timer.h"
-#include "HAL/buzzer.h"
-#include "HAL/dcmotor.h"
-#include "MCAL/uart.h"
-#include "MCAL/twi.h"
-#include "HAL/external_eeprom.h"
-#include <util/delay.h>
-#include <avr/io.h> /* To enable I- bit*/
-
-/********************************************************************
- *                           Global variables
- ********************************************************************/
-/*Two global arrays to hold the values of the received password from HMI_ECU*/
-uint8 g_password[PASSWORD_SIZE], g_confirmpass[PASSWORD_SIZE];
-
-uint8 commandReceiver;            /* Global variable to store the command of the action that is needed to be taken*/
-system_state g_systemState;       /* Global variable to keep system state*/
-uint8 g_seconds;                  /* Global variable to count seconds*/
-
-/* Main function*/
-int main(void)
-{
-	UART_ConfigType UART_Config = {EIGHT_BIT,PARITY_OFF,ONEBIT,UART_BAUDRATE};
-	TWI_ConfigType  TWI_Config = {FAST_MODE, MEMORY_ADDRESS};
-
-	Buzzer_init();           /* Initialize the buzzer Module*/
-	DCMOTOR_init();          /* Initialize the DC-Motor Module*/
-	UART_init(&UART_Config); /* Initialize the UART Module*/
-	TWI_init(&TWI_Config);   /* Initialize the I2C Module*/
-
-	SREG |= (1<<7);       /* Enable I-Bit for Interrupts */
-
-	systemUsage();
-
-	/*Set status*/
-	setSystemState ();
-
-	while(1)
-	{
-		/*Receive command from HME_ECU*/
-		receiveCommand();
-
-		/* calling functions from the array of functions */
-		(*ptr_states[commandReceiver])();
-	}
-
-	return 0;
-}
-
-
-/*******************************************************************************
- *                      Functions Definitions                                  *
- *******************************************************************************/
-
-/*
- * Description :
- * 1. Check if the system was used previously or not
- * 2. Set the system state based on the saved status in EEPROM memory*/
-void systemUsage (void)
-{
-	/* Variable used to read in it if there is a password saved or not*/
-	uint8 PasswordFlag;
-
-	/* Read password saved status from EEPROM */
-	EEPROM_readByte(PASSWORD_ADDRESS_IN_EEPROM - 1, &PasswordFlag);
-
-	if(PasswordFlag == SAVED_PASSWORD)
-		/* Set the system state to the main options menu*/
-		g_systemState = STARTUP;
-	else
-		/* Set the system state to create password option*/
-		g_systemState = SETUP;
-}
-
-/*
- * * Description :
- *    Set the state of the system whether to create password (as for the first time
- *    or to repeat the creating process as the password wasn't matched)
- *    or to move to main options
- */
-void setSystemState (void)
-{
-	/*Sync the two micro-controllers */
-	syncMicroCOntrollers();
-	/*----------------------------------------
-	 *  Set the state of the system
-	 *  --------------------------------------*/
-	while(UART_recieveByte() != STATE){}
-	UART_sendByte(SENDING);
-	UART_sendByte(g_systemState);
-}
-
-/*
- * Description :
- * 1. Receive two entered password from the user
- * 2. Check if the two passwords are matched and save one
- *    in the EEPROM memory
- * 3. If passwords not matched set repeat Creation flag
- */
-void createSystemPassword(void)
-{
-	uint8 matchedFlag = 1;
-	uint8 counter;
-	/*Receive the first password from the HMI_ECU*/
-	receivePassword (g_password);
-	/*Receive the second password from the HMI_ECU*/
-	receivePassword (g_confirmpass);
-
-	/*Check if the two received passwords are the matched*/
-	for(counter = 0; counter <= (PASSWORD_SIZE-1); counter++)
-	{
-		if(g_password[counter] != g_confirmpass[counter])
-		{
-			matchedFlag = 0;
-			break;
-		}
-	}
-
-	if(matchedFlag == 1)
-	{
-		/*Save password in memory*/
-		for(counter = 0; counter <= (PASSWORD_SIZE-1); counter++)
-		{
-			/* Write each digit in the external EEPROM */
-			EEPROM_writeByte((PASSWORD_ADDRESS_IN_EEPROM + counter), g_password[counter]);
-			_delay_ms(10);
-		}
-
-		/*Save a certain value in the memory to check if there is a saved
-		 * password or not*/
-		EEPROM_writeByte((PASSWORD_ADDRESS_IN_EEPROM - 1), SAVED_PASSWORD);
-		_delay_ms(10);
-		/*Set system state to main options*/
-		g_systemState = STARTUP;
-
-	}
-	else
-	{
-		/*Set system state to create password from the beginning*/
-		g_systemState = SETUP;
-	}
-	setSystemState ();
-}
-
-/*
- * Description :
- * Receive the password from the HMI_ECU through UART
- */
-void receivePassword (uint8 *password_Ptr)
-{
-	uint8 counter;
-	//syncMicroCOntrollers();
-	for(counter = 0; counter <= (PASSWORD_SIZE-1); counter++)
-	{
-		password_Ptr [counter] = UART_recieveByte();
-	}
-	UART_sendByte(RECEIVED);
-}
-
-/*
- * Description :
- * 1. Receive the password from the HMI_ECU through UART
- * 2. Check if the received password matches to that in the memory
- * 3. commands the HMI_ECU what to do next
- */
-void mainOptions (void)
-{
-	uint8 errorTrials = 0;      /* variable to count number of false trials for entering the password*/
-	uint8 passwordState;        /* variable used as a flag to send read again command or not*/
-	uint8 counter;
-
-	do{
-		receivePassword (g_password);
-		passwordState = MATCHED;
-
-		/*compare received password with the saved one*/
-		for(counter = 0; counter <= PASSWORD_SIZE-1; counter++)
-		{
-			uint8 readByte;
-			EEPROM_readByte(PASSWORD_ADDRESS_IN_EEPROM + counter, &readByte);
-
-			if(g_password[counter] != readByte)
-			{
-				errorTrials++;
-				passwordState = READ_AGAIN;
-				break;
-			}
-		}
-
-		/*Send check flag value*/
-		if(errorTrials <= ERRORTRIALS-1)
-			UART_sendByte(passwordState);
-		else
-		{
-			passwordState = ERRORSYSTEM;
-			UART_sendByte(passwordState);
-			g_systemState = ERRORSYSTEM;
-
-		}
-	}while(passwordState == READ_AGAIN);
-
-
-	receiveCommand();
-	if(errorTrials == ERRORTRIALS)
-	{
-		setSystemState ();
-		return;
-	}
-	else if (commandReceiver == CHANGE)
-	{
-		g_systemState = SETUP;
-		setSystemState ();
-	}
-	else
-	{
-		g_systemState = OPEN_DOOR;
-		setSystemState ();
-		openDoor();
-		g_systemState = STARTUP;
-		setSystemState ();
-	}
-}
-
-/*
- * Description :
- * open and close the motor
- */
-void openDoor(void)
-{
-	DcMotor_Rotate(CW, MAX_SPEED);
-	delaySeconds(15);
-
-	/* Hold the door for 3 sec */
-	DcMotor_Rotate(STOP, ZERO_SPEED);
-	delaySeconds(3);
-
-	/* lock the door for 15 sec */
-	DcMotor_Rotate(A_CW, MAX_SPEED);
-	delaySeconds(15);
-
-	/* Stop the motor */
-	DcMotor_Rotate(STOP, ZERO_SPEED);
-}
-
-/*
- * Description :
- * Callback function of the timer
- */
-void countSec(void)
-{
-	g_seconds++;
-}
-
-/*
- * Description :
- * Delay function by seconds operates with Timer1
- */
-void delaySeconds(uint8 sec)
-{
-	/* setting the callBack function to count seconds */
-	Timer1_setCallBack(countSec);
-
-	/* timer1 configurations to count sec per interrupt */
-	Timer1_ConfigType timer1Config = {0,31250,F_CPU_256,CTC};
-
-	Timer1_init(&timer1Config);
-
-	while(g_seconds < sec){}
-	g_seconds = 0;
-
-	Timer1_deInit();
-}
-
-/*
- * Description :
- * Activate the buzzer for a one minute
- */
-void errorState (void)
-{
-	Buzzer_on();
-
-	delaySeconds(DELAY_MINUTE);
-
-	Buzzer_off();
-}
-
-/*
- * Description :
- * Receive the password from the HMI_ECU through UART
- */
-void receiveCommand(void)
-{
-	commandReceiver = UART_recieveByte();
-	UART_sendByte(FINISHED);
-}
-
-/*
- * Description :
- * Sync the two micro-controllers
- */
-void syncMicroCOntrollers(void)
-{
-	/*Sync the two micro-controllers */
-	while(UART_recieveByte() != GET_READY){}
-	UART_sendByte(READY);
-}
+/*
+ ================================================================================================
+ File Name: app.c
+ Name        : Door Locker Security System
+ Author      : Omar Muhammad
+ Description : Source file of Control_ECU CONTROL_ECU is responsible for all the processing and decisions in the system
+               like password checking, open the door and activate the system alarm.
+ Date        : 26/10/2022
+ ================================================================================================
+ */
+
+#include "app.h"
+#include "scheduler.h"
+#include "MCAL/timer.h"
+#include "HAL/buzzer.h"
+#include "HAL/dcmotor.h"
+#include "MCAL/uart.h"
+#include "MCAL/twi.h"
+#include "HAL/external_eeprom.h"
+#include "users.h"
+#include "password_log.h"
+#include "audit_log.h"
+#include <avr/io.h> /* To enable I- bit*/
+#include <avr/pgmspace.h> /* To keep the transitions table in flash*/
+
+/********************************************************************
+ *                           Global variables
+ ********************************************************************/
+PROTOCOL_Frame g_request;         /* Global variable to keep the last request frame received from HMI_ECU*/
+uint8 g_passwordCache[PASSWORD_SIZE]; /* RAM copy of the saved password loaded at boot and written through on change*/
+
+control_state g_controlState;     /* Global variable to keep the state machine state*/
+uint8 g_errorTrials;              /* Global variable to count the consecutive false passwords*/
+Timer1_SoftTimerType g_actionTimer; /* Global software timer to time the door and alarm steps*/
+
+/* Password saving, the EEPROM accesses run in the background and their end is posted as g_eepromEvent*/
+EEPROM_RequestType g_eepromRequest;
+boolean g_eepromPending;          /* g_eepromRequest was started and its end is not posted yet*/
+uint8 g_eepromEvent;
+uint8 g_passwordRecord[PASSWORD_LOG_RECORD_SIZE];   /* The password log record being saved*/
+uint8 g_passwordReadBack[PASSWORD_LOG_RECORD_SIZE]; /* The same record read back from the EEPROM*/
+
+/* Password streamed digit by digit by the HMI_ECU, only the verdict is kept*/
+uint8 g_entryDigits = ENTRY_INVALID; /* Digits received in order since the first one*/
+boolean g_entryMatch;             /* All the received digits match their reference*/
+uint32 g_entryCode;               /* Value of the received digits, looked up in the user codes table*/
+uint8 g_entryLastDigit;           /* The last received digit, to tell a re-sent digit from a new entry*/
+
+uint32 g_lastRequestTick;         /* Tick of the last request frame, the audit log is written when the link is quiet*/
+
+/* Queue of the events waiting for the state machine */
+uint8 g_events[EVENT_QUEUE_SIZE];
+uint8 g_eventsHead;
+uint8 g_eventsTail;
+
+/* Transitions table kept in flash, the rows are searched in order so the CTRL_ANY rows come last */
+static const transition g_transitions[] PROGMEM =
+{
+	/* state                event                action                next state */
+	{CTRL_SETUP,          EV_PASSWORD_DIGIT,   ACT_CHECK_DIGIT,      CTRL_ANY},
+	{CTRL_SETUP,          EV_CREATE_PASSWORD,  ACT_CREATE_PASSWORD,  CTRL_SAVING},
+	{CTRL_SAVING,         EV_PASSWORD_WRITTEN, ACT_READ_BACK,        CTRL_ANY},
+	{CTRL_SAVING,         EV_PASSWORD_READ,    ACT_CACHE_PASSWORD,   CTRL_ANY},
+	{CTRL_SAVING,         EV_PASSWORD_SAVED,   ACT_SEND_STATE,       CTRL_READY},
+	{CTRL_SAVING,         EV_SAVE_FAILED,      ACT_SEND_STATE,       CTRL_SETUP},
+	{CTRL_SAVING,         EV_STORAGE_ERROR,    ACT_MEMORY_ERROR,     CTRL_SETUP},
+	{CTRL_MEMORY_FAULT,   EV_GET_STATE,        ACT_LOAD_PASSWORD,    CTRL_ANY},
+	{CTRL_READY,          EV_PASSWORD_DIGIT,   ACT_CHECK_DIGIT,      CTRL_ANY},
+	{CTRL_READY,          EV_CHECK_PASSWORD,   ACT_CHECK_PASSWORD,   CTRL_ANY},
+	{CTRL_READY,          EV_OPEN_GRANTED,     ACT_START_DOOR,       CTRL_DOOR_UNLOCKING},
+	{CTRL_READY,          EV_CHANGE_GRANTED,   ACT_SEND_STATE,       CTRL_SETUP},
+	{CTRL_READY,          EV_USERS_GRANTED,    ACT_SEND_STATE,       CTRL_USERS},
+	{CTRL_READY,          EV_LOCKOUT,          ACT_START_ALARM,      CTRL_ALARM},
+	{CTRL_USERS,          EV_ADD_USER,         ACT_ADD_USER,         CTRL_ANY},
+	{CTRL_USERS,          EV_REMOVE_USER,      ACT_REMOVE_USER,      CTRL_ANY},
+	{CTRL_USERS,          EV_LIST_USERS,       ACT_LIST_USERS,       CTRL_ANY},
+	{CTRL_USERS,          EV_DUMP_LOG,         ACT_DUMP_LOG,         CTRL_ANY},
+	{CTRL_USERS,          EV_GET_STATE,        ACT_SEND_STATE,       CTRL_READY},
+	{CTRL_DOOR_UNLOCKING, EV_TIMER_EXPIRED,    ACT_HOLD_DOOR,        CTRL_DOOR_HOLD},
+	{CTRL_DOOR_HOLD,      EV_TIMER_EXPIRED,    ACT_LOCK_DOOR,        CTRL_DOOR_LOCKING},
+	{CTRL_DOOR_LOCKING,   EV_TIMER_EXPIRED,    ACT_STOP_DOOR,        CTRL_READY},
+	{CTRL_ALARM,          EV_TIMER_EXPIRED,    ACT_STOP_ALARM,       CTRL_READY},
+	{CTRL_ANY,            EV_GET_STATE,        ACT_SEND_STATE,       CTRL_ANY},
+};
+
+/* Array of pointers to the action functions indexed by control_action, kept in flash */
+static void (* const g_actionFunctions[])(void) PROGMEM =
+{
+	setSystemState, createSystemPassword, mainOptions, openDoor,
+	holdDoor, lockDoor, stopDoor, errorState, stopAlarm,
+	readBackPassword, cachePassword, reportMemoryError, loadPassword, checkDigit,
+	addUser, removeUser, listUsers, dumpAuditLog
+};
+
+/* Main function*/
+int main(void)
+{
+	UART_ConfigType UART_Config = {EIGHT_BIT,PARITY_OFF,ONEBIT,UART_BAUDRATE,UART_INTERRUPT_MODE};
+	TWI_ConfigType  TWI_Config = {FAST_MODE, MEMORY_ADDRESS};
+
+	Buzzer_init();           /* Initialize the buzzer Module*/
+	DCMOTOR_init();          /* Initialize the DC-Motor Module*/
+	UART_init(&UART_Config); /* Initialize the UART Module*/
+	TWI_init(&TWI_Config);   /* Initialize the I2C Module*/
+	PROTOCOL_init();         /* Initialize the frame receiver*/
+
+	SCHEDULER_init();        /* Start the 1 ms system tick*/
+
+	SREG |= (1<<7);       /* Enable I-Bit for Interrupts */
+
+	AUDIT_record(LOG_POWER_UP, LOG_OK, LOG_NO_SLOT);
+	systemUsage();
+
+	/*Turn the HMI_ECU requests into events and run the state machine on them*/
+	SCHEDULER_addTask(receiveCommand, 0);
+	SCHEDULER_addTask(stateMachineTask, 0);
+	SCHEDULER_addTask(flushAuditLog, 0);
+
+	while(1)
+	{
+		SCHEDULER_dispatch();
+	}
+
+	return 0;
+}
+
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * 1. Check if the system was used previously or not
+ * 2. Set the initial state based on the saved status in EEPROM memory
+ * 3. Keep the saved password in the RAM cache used by all the checks
+ * 4. Load the user codes table and find the end of the audit log*/
+void systemUsage (void)
+{
+	/* The user codes are looked up at every unlock, a table that cannot be read is a memory fault too*/
+	if((USERS_init() != USERS_OK) || (AUDIT_init() != SUCCESS))
+	{
+		g_controlState = CTRL_MEMORY_FAULT;
+		return;
+	}
+
+	/* Load the saved password in the RAM cache once, from the newest valid record of the password log read in
+	 * two sequential reads, a password change cut by a power loss leaves the previous password there*/
+	switch(PASSWORD_LOG_load(g_passwordCache))
+	{
+	case PASSWORD_LOG_FOUND:
+		/* Start in the main options*/
+		g_controlState = CTRL_READY;
+		break;
+	case PASSWORD_LOG_EMPTY:
+		/* Start in the create password option*/
+		g_controlState = CTRL_SETUP;
+		break;
+	default:
+		/* A saved password may be there, do not let a new one be created over it*/
+		g_controlState = CTRL_MEMORY_FAULT;
+		break;
+	}
+}
+
+/*
+ * Description :
+ * Add an event to the state machine queue, returns FALSE if the queue is full
+ */
+boolean postEvent (uint8 a_event)
+{
+	uint8 next_head = (g_eventsHead + 1) & (EVENT_QUEUE_SIZE - 1);
+
+	if(next_head == g_eventsTail)
+		return FALSE;
+
+	g_events[g_eventsHead] = a_event;
+	g_eventsHead = next_head;
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Take the next request frame from the HMI_ECU, if any, and post its event.
+ * Unknown request types are dropped without reaching the state machine.
+ */
+void receiveCommand(void)
+{
+	/* g_request is used by the actions so keep it until all the queued events are handled,
+	 * and the password saving or the audit log page write in the background is finished */
+	if((g_eventsHead != g_eventsTail) || (g_eepromPending == TRUE) || (AUDIT_busy() == TRUE))
+		return;
+
+	if(PROTOCOL_receiveFrame(&g_request) == FALSE)
+		return;
+	g_lastRequestTick = Timer1_getTicks();
+
+	switch(g_request.type)
+	{
+	case MSG_GET_STATE:
+		postEvent(EV_GET_STATE);
+		break;
+	case MSG_CREATE_PASSWORD:
+		postEvent(EV_CREATE_PASSWORD);
+		break;
+	case MSG_CHECK_PASSWORD:
+		postEvent(EV_CHECK_PASSWORD);
+		break;
+	case MSG_PASSWORD_DIGIT:
+		postEvent(EV_PASSWORD_DIGIT);
+		break;
+	case MSG_ADD_USER:
+		postEvent(EV_ADD_USER);
+		break;
+	case MSG_REMOVE_USER:
+		postEvent(EV_REMOVE_USER);
+		break;
+	case MSG_LIST_USERS:
+		postEvent(EV_LIST_USERS);
+		break;
+	case MSG_DUMP_LOG:
+		postEvent(EV_DUMP_LOG);
+		break;
+	default:
+		break;
+	}
+}
+
+/*
+ * Description :
+ * Run the transitions of all the queued events, the action timer expiry and the end
+ * of the background EEPROM access are events too
+ */
+void stateMachineTask (void)
+{
+	uint8 event;
+	uint8 result;
+
+	if(Timer1_softTimerExpired(&g_actionTimer) == TRUE)
+		postEvent(EV_TIMER_EXPIRED);
+
+	if(g_eepromPending == TRUE)
+	{
+		/* Also retries the failed bus attempts of the access*/
+		result = EEPROM_poll(&g_eepromRequest);
+		if(result != EEPROM_BUSY)
+		{
+			g_eepromPending = FALSE;
+			postEvent((result == SUCCESS) ? g_eepromEvent : EV_STORAGE_ERROR);
+		}
+	}
+
+	while(g_eventsHead != g_eventsTail)
+	{
+		event = g_events[g_eventsTail];
+		g_eventsTail = (g_eventsTail + 1) & (EVENT_QUEUE_SIZE - 1);
+		dispatchEvent(event);
+	}
+}
+
+/*
+ * Description :
+ * Write the staged audit log entries in the background while the system is idle in the main options
+ */
+void flushAuditLog (void)
+{
+	/* A started page write is always finished, a new one starts only in the main options once the HMI_ECU
+	 * was quiet for AUDIT_IDLE_MS, so the requests never wait for the log and the EEPROM is free for them*/
+	if((AUDIT_busy() == FALSE) &&
+	   ((g_controlState != CTRL_READY) || (g_entryDigits != ENTRY_INVALID) || (g_eventsHead != g_eventsTail) ||
+	    ((Timer1_getTicks() - g_lastRequestTick) < AUDIT_IDLE_MS)))
+		return;
+
+	AUDIT_flush();
+}
+
+/*
+ * Description :
+ * Find the transition of the event in the current state and run it.
+ * A request that is not expected in the current state is answered with the current state.
+ */
+void dispatchEvent (uint8 a_event)
+{
+	uint8 index;
+	uint8 state;
+	uint8 action;
+	uint8 next;
+	void (*actionFunction)(void);
+
+	for(index = 0; index < (sizeof(g_transitions) / sizeof(g_transitions[0])); index++)
+	{
+		state = pgm_read_byte(&g_transitions[index].state);
+		if((pgm_read_byte(&g_transitions[index].event) != a_event) ||
+		   ((state != g_controlState) && (state != CTRL_ANY)))
+			continue;
+
+		action = pgm_read_byte(&g_transitions[index].action);
+		next = pgm_read_byte(&g_transitions[index].next);
+
+		/* Move first so the action reports the new state to the HMI_ECU */
+		if(next != CTRL_ANY)
+			g_controlState = next;
+
+		actionFunction = (void (*)(void))pgm_read_ptr(&g_actionFunctions[action]);
+		(*actionFunction)();
+		return;
+	}
+
+	if(a_event <= EV_DUMP_LOG)
+	{
+		/* Unexpected request, the HMI_ECU is waiting for a reply so tell it where we are,
+		 * the digits are not answered */
+		setSystemState ();
+	}
+}
+
+/*
+ * * Description :
+ *    Send the state of the system to the HMI_ECU in one MSG_STATE frame
+ *    whether to create password (as for the first time or to repeat the
+ *    creating process as the password wasn't matched) or to move to main options
+ */
+void setSystemState (void)
+{
+	uint8 state;
+
+	switch(g_controlState)
+	{
+	case CTRL_SETUP:
+		state = SETUP;
+		break;
+	case CTRL_DOOR_UNLOCKING:
+	case CTRL_DOOR_HOLD:
+	case CTRL_DOOR_LOCKING:
+		state = OPEN_DOOR;
+		break;
+	case CTRL_ALARM:
+		state = ERRORSYSTEM;
+		break;
+	case CTRL_MEMORY_FAULT:
+		state = MEMORY_ERROR;
+		break;
+	case CTRL_USERS:
+		state = USERS_MENU;
+		break;
+	default:
+		state = STARTUP;
+		break;
+	}
+
+	PROTOCOL_sendFrame(MSG_STATE, &state, 1);
+}
+
+/*
+ * Description :
+ * Check one streamed digit against its reference as soon as it comes so the verdict is ready
+ * when the entry ends: the cached password in the main options, in the setup the first password
+ * is kept in the record to save and the confirmation digits are checked against it.
+ */
+void checkDigit(void)
+{
+	/*The digit index followed by the digit*/
+	uint8 index = g_request.payload[0];
+	uint8 digit = g_request.payload[1];
+	uint8 entrySize = (g_controlState == CTRL_SETUP) ? 2*PASSWORD_SIZE : PASSWORD_SIZE;
+	uint8 reference;
+
+	if((g_request.length == 2) && (g_entryDigits != ENTRY_INVALID) && ((uint8)(index + 1) == g_entryDigits) &&
+	   (digit == g_entryLastDigit))
+	{
+		/*The acknowledgement was lost and the HMI_ECU sent the digit again, it is checked already.
+		 *Another first digit is a new entry, the HMI_ECU gave up the previous one.*/
+		PROTOCOL_sendFrame(MSG_DIGIT_ACK, &index, 1);
+		return;
+	}
+
+	if(index == 0)
+	{
+		/*A new entry*/
+		g_entryDigits = 0;
+		g_entryMatch = TRUE;
+		g_entryCode = 0;
+	}
+
+	if((g_request.length != 2) || (index != g_entryDigits) || (index >= entrySize) || (digit > 9))
+	{
+		/*A digit was lost, the whole entry is refused and not acknowledged*/
+		g_entryDigits = ENTRY_INVALID;
+		return;
+	}
+	g_entryDigits++;
+	g_entryLastDigit = digit;
+	PROTOCOL_sendFrame(MSG_DIGIT_ACK, &index, 1);
+
+	if(g_controlState == CTRL_SETUP)
+	{
+		if(index < PASSWORD_SIZE)
+		{
+			/*The first password has nothing to match, keep it for the saving*/
+			g_passwordRecord[PASSWORD_LOG_DIGITS_INDEX + index] = digit;
+			return;
+		}
+		reference = g_passwordRecord[PASSWORD_LOG_DIGITS_INDEX + index - PASSWORD_SIZE];
+	}
+	else
+	{
+		reference = g_passwordCache[index];
+		g_entryCode = (g_entryCode * 10) + digit;
+	}
+
+	if(digit != reference)
+		g_entryMatch = FALSE;
+}
+
+/*
+ * Description :
+ * 1. Take the two entered passwords from the MSG_CREATE_PASSWORD frame, or the streamed ones
+ * 2. Check if the two passwords are matched and start saving one
+ *    in the EEPROM memory in the background
+ * 3. Post EV_SAVE_FAILED to ask to repeat the creation if they are not
+ */
+void createSystemPassword(void)
+{
+	uint8 counter;
+	uint8 entryDigits = g_entryDigits;
+	/*The first password followed by the confirmation one*/
+	const uint8 *password = &g_request.payload[0];
+	const uint8 *confirmPassword = &g_request.payload[PASSWORD_SIZE];
+
+	/*The next streamed entry starts from its first digit*/
+	g_entryDigits = ENTRY_INVALID;
+
+	if(g_request.length == 0)
+	{
+		/*Streamed passwords, the first one is already in the record and
+		 * the confirmation digits were checked against it as they came*/
+		if((entryDigits != 2*PASSWORD_SIZE) || (g_entryMatch == FALSE))
+		{
+			/*Stay in the setup state to create password from the beginning*/
+			postEvent(EV_SAVE_FAILED);
+			return;
+		}
+	}
+	else if(g_request.length == 2*PASSWORD_SIZE)
+	{
+		/*Check if the two received passwords are the matched*/
+		for(counter = 0; counter <= (PASSWORD_SIZE-1); counter++)
+		{
+			if(password[counter] != confirmPassword[counter])
+			{
+				/*Stay in the setup state to create password from the beginning*/
+				postEvent(EV_SAVE_FAILED);
+				return;
+			}
+		}
+		for(counter = 0; counter <= (PASSWORD_SIZE-1); counter++)
+		{
+			g_passwordRecord[PASSWORD_LOG_DIGITS_INDEX + counter] = password[counter];
+		}
+	}
+	else
+	{
+		postEvent(EV_SAVE_FAILED);
+		return;
+	}
+
+	/*Append the password to the log as a new record with the next sequence number and its CRC,
+	 * it goes to the page of the oldest record so the password changes wear all the log pages*/
+	PASSWORD_LOG_seal(g_passwordRecord);
+
+	/*Save the record in one page write, the TWI ISR sends it and polls the memory
+	 * until its write cycle is finished while the tasks keep running*/
+	if(EEPROM_startWritePage(&g_eepromRequest, PASSWORD_LOG_nextAddress(), g_passwordRecord, PASSWORD_LOG_RECORD_SIZE) != SUCCESS)
+	{
+		postEvent(EV_STORAGE_ERROR);
+		return;
+	}
+	g_eepromEvent = EV_PASSWORD_WRITTEN;
+	g_eepromPending = TRUE;
+}
+
+/*
+ * Description :
+ * Start reading the saved record back in the background once its write cycle is finished
+ */
+void readBackPassword(void)
+{
+	if(EEPROM_startReadBlock(&g_eepromRequest, PASSWORD_LOG_nextAddress(), g_passwordReadBack, PASSWORD_LOG_RECORD_SIZE) != SUCCESS)
+	{
+		postEvent(EV_STORAGE_ERROR);
+		return;
+	}
+	g_eepromEvent = EV_PASSWORD_READ;
+	g_eepromPending = TRUE;
+}
+
+/*
+ * Description :
+ * Update the password cache if the record read back is the saved one,
+ * then post EV_PASSWORD_SAVED or EV_STORAGE_ERROR
+ */
+void cachePassword(void)
+{
+	uint8 password[PASSWORD_SIZE];
+	uint8 counter;
+
+	/*The cache is updated only if the EEPROM copy is the same*/
+	if(PASSWORD_LOG_parse(g_passwordReadBack, password) == FALSE)
+	{
+		postEvent(EV_STORAGE_ERROR);
+		return;
+	}
+	for(counter = 0; counter < PASSWORD_LOG_RECORD_SIZE; counter++)
+	{
+		if(g_passwordReadBack[counter] != g_passwordRecord[counter])
+		{
+			postEvent(EV_STORAGE_ERROR);
+			return;
+		}
+	}
+
+	/*The new record is the newest one of the log, the next change goes to the page after it*/
+	PASSWORD_LOG_committed();
+
+	for(counter = 0; counter <= (PASSWORD_SIZE-1); counter++)
+	{
+		g_passwordCache[counter] = password[counter];
+	}
+	AUDIT_record(LOG_SAVE_PASSWORD, LOG_OK, LOG_NO_SLOT);
+	/*Move to main options*/
+	postEvent(EV_PASSWORD_SAVED);
+}
+
+/*
+ * Description :
+ * Tell the HMI_ECU that the password could not be saved, it asks for the state again
+ */
+void reportMemoryError(void)
+{
+	uint8 state = MEMORY_ERROR;
+
+	PROTOCOL_sendFrame(MSG_STATE, &state, 1);
+}
+
+/*
+ * Description :
+ * Try to load the saved password again after a memory fault and send the new state
+ */
+void loadPassword(void)
+{
+	systemUsage();
+	setSystemState();
+}
+
+/*
+ * Description :
+ * 1. Take the action and the password from the MSG_CHECK_PASSWORD frame
+ * 2. Check if the received password matches the cached one, or take the verdict of the streamed digits,
+ *    else look for it in the user codes table when the action is OPEN
+ * 3. Post the granted action or the lockout, or ask to read the password again
+ */
+void mainOptions (void)
+{
+	uint8 passwordState = READ_AGAIN; /* variable used to send read again command*/
+	uint8 counter;
+	boolean match;
+	boolean complete;
+	uint32 code;
+	uint16 slot = LOG_NO_SLOT;
+	uint8 entryDigits = g_entryDigits;
+	/*The action followed by the password*/
+	uint8 action = g_request.payload[0];
+	const uint8 *password = &g_request.payload[1];
+	uint8 event = (action == CHANGE) ? LOG_CHANGE : ((action == MANAGE_USERS) ? LOG_USERS : LOG_OPEN);
+
+	/*The next streamed entry starts from its first digit*/
+	g_entryDigits = ENTRY_INVALID;
+
+	if(g_request.length == 1)
+	{
+		/*Streamed password, already checked digit by digit. The HMI_ECU asks for the verdict only
+		 * once every digit is acknowledged, a missing one still is a false trial so that dropping
+		 * frames gives no free trials*/
+		complete = (entryDigits == PASSWORD_SIZE) ? TRUE : FALSE;
+		match = ((complete == TRUE) && (g_entryMatch == TRUE)) ? TRUE : FALSE;
+		code = g_entryCode;
+	}
+	else if(g_request.length == PASSWORD_SIZE + 1)
+	{
+		/*compare received password with the cached one, no EEPROM access is needed*/
+		complete = TRUE;
+		match = TRUE;
+		for(counter = 0; counter <= PASSWORD_SIZE-1; counter++)
+		{
+			if(password[counter] != g_passwordCache[counter])
+				match = FALSE;
+		}
+		code = USERS_code(password, PASSWORD_SIZE);
+	}
+	else
+	{
+		setSystemState ();
+		return;
+	}
+
+	if((match == FALSE) && (complete == TRUE) && (action == OPEN))
+	{
+		/*Not the master password, the user codes can only open the door*/
+		switch(USERS_find(code, &slot))
+		{
+		case USERS_OK:
+			match = TRUE;
+			break;
+		case USERS_ERROR:
+			/*Not a false trial, the HMI_ECU asks for the state again*/
+			reportMemoryError();
+			return;
+		default:
+			break;
+		}
+	}
+
+	if(match == FALSE)
+	{
+		g_errorTrials++;
+
+		if(g_errorTrials <= ERRORTRIALS-1)
+		{
+			/*Let the user try again*/
+			PROTOCOL_sendFrame(MSG_STATE, &passwordState, 1);
+			AUDIT_record(event, LOG_DENIED, LOG_NO_SLOT);
+		}
+		else
+		{
+			/*Too many false trials, the alarm holds the system*/
+			g_errorTrials = 0;
+			postEvent(EV_LOCKOUT);
+			AUDIT_record(event, LOG_LOCKOUT, LOG_NO_SLOT);
+		}
+		return;
+	}
+
+	/*Only staged in RAM, the verdict is not delayed by the EEPROM*/
+	AUDIT_record(event, LOG_OK, slot);
+	g_errorTrials = 0;
+	if (action == CHANGE)
+		postEvent(EV_CHANGE_GRANTED);
+	else if (action == MANAGE_USERS)
+		postEvent(EV_USERS_GRANTED);
+	else
+		postEvent(EV_OPEN_GRANTED);
+}
+
+/*
+ * Description :
+ * Add the user code of the MSG_ADD_USER frame to the table and reply MSG_USER_RESULT
+ */
+void addUser(void)
+{
+	uint8 counter;
+	uint8 result = USER_UNKNOWN;
+	uint16 slot = USER_LIST_END;
+
+	for(counter = 0; counter < g_request.length; counter++)
+	{
+		if(g_request.payload[counter] > 9)
+			break;
+	}
+
+	/*The results of the table are the ones of the protocol*/
+	if((g_request.length == PASSWORD_SIZE) && (counter == PASSWORD_SIZE))
+		result = USERS_add(USERS_code(g_request.payload, PASSWORD_SIZE), &slot);
+
+	AUDIT_record(LOG_ADD_USER, (result == USERS_OK) ? LOG_OK : LOG_FAILED, slot);
+	sendUserResult(result, slot);
+}
+
+/*
+ * Description :
+ * Remove the user code of the MSG_REMOVE_USER frame from the table and reply MSG_USER_RESULT
+ */
+void removeUser(void)
+{
+	uint8 result = USERS_NOT_FOUND;
+	uint16 slot = USER_LIST_END;
+
+	if(g_request.length == PASSWORD_SIZE)
+		result = USERS_remove(USERS_code(g_request.payload, PASSWORD_SIZE), &slot);
+
+	AUDIT_record(LOG_REMOVE_USER, (result == USERS_OK) ? LOG_OK : LOG_FAILED, slot);
+	sendUserResult((result == USERS_OK) ? USER_REMOVED : result, slot);
+}
+
+/*
+ * Description :
+ * Reply MSG_USER_LIST with the used slots from the slot of the MSG_LIST_USERS frame on
+ */
+void listUsers(void)
+{
+	uint16 slots[USER_LIST_SLOTS];
+	uint16 first = 0;
+	uint16 next;
+	uint8 count;
+	uint8 counter;
+	/*Users count, next slot then the used slots*/
+	uint8 reply[4 + 2*USER_LIST_SLOTS];
+
+	if(g_request.length == 2)
+		first = g_request.payload[0] | ((uint16)g_request.payload[1] << 8);
+
+	if(USERS_list(first, slots, USER_LIST_SLOTS, &count, &next) != USERS_OK)
+	{
+		sendUserResult(USER_MEMORY_ERROR, USER_LIST_END);
+		return;
+	}
+
+	reply[0] = (uint8)USERS_count();
+	reply[1] = (uint8)(USERS_count() >> 8);
+	reply[2] = (uint8)next;
+	reply[3] = (uint8)(next >> 8);
+	for(counter = 0; counter < count; counter++)
+	{
+		reply[4 + 2*counter] = (uint8)slots[counter];
+		reply[5 + 2*counter] = (uint8)(slots[counter] >> 8);
+	}
+	PROTOCOL_sendFrame(MSG_USER_LIST, reply, 4 + 2*count);
+}
+
+/*
+ * Description :
+ * Reply MSG_USER_RESULT with the result of a user codes table change
+ */
+void sendUserResult(uint8 a_result, uint16 a_slot)
+{
+	/*Result, slot then users count*/
+	uint8 reply[5];
+
+	reply[0] = a_result;
+	reply[1] = (uint8)a_slot;
+	reply[2] = (uint8)(a_slot >> 8);
+	reply[3] = (uint8)USERS_count();
+	reply[4] = (uint8)(USERS_count() >> 8);
+	PROTOCOL_sendFrame(MSG_USER_RESULT, reply, 5);
+}
+
+/*
+ * Description :
+ * Reply MSG_LOG_DATA with the entries of the page of the MSG_DUMP_LOG frame, page 0 is the newest.
+ * The page alone is the reply past the oldest page, so the HMI_ECU asks for one page at a time
+ * and a NACK re-sends the whole reply.
+ */
+void dumpAuditLog(void)
+{
+	/*The page followed by its entries*/
+	uint8 payload[1 + LOG_DATA_ENTRIES*LOG_ENTRY_SIZE];
+	uint8 count = 0;
+
+	payload[0] = (g_request.length == 1) ? g_request.payload[0] : 0;
+
+	/*The staged entries are written first so the whole log is in the EEPROM*/
+	if((AUDIT_sync() != SUCCESS) ||
+	   ((payload[0] < AUDIT_PAGES) && (AUDIT_readEntries(AUDIT_PAGES - 1 - payload[0], &payload[1], &count) != SUCCESS)))
+	{
+		sendUserResult(USER_MEMORY_ERROR, USER_LIST_END);
+		return;
+	}
+
+	PROTOCOL_sendFrame(MSG_LOG_DATA, payload, 1 + count*LOG_ENTRY_SIZE);
+}
+
+/*
+ * Description :
+ * Reply OPEN_DOOR and start opening the door
+ */
+void openDoor(void)
+{
+	setSystemState ();
+	DcMotor_Rotate(CW, MAX_SPEED);
+	Timer1_startSoftTimer(&g_actionTimer, DOOR_MOTION_SECONDS * 1000UL);
+}
+
+/*
+ * Description :
+ * Stop the motor and hold the door open
+ */
+void holdDoor(void)
+{
+	/* Hold the door for 3 sec */
+	DcMotor_Rotate(STOP, ZERO_SPEED);
+	Timer1_startSoftTimer(&g_actionTimer, DOOR_HOLD_SECONDS * 1000UL);
+}
+
+/*
+ * Description :
+ * Start closing the door
+ */
+void lockDoor(void)
+{
+	/* lock the door for 15 sec */
+	DcMotor_Rotate(A_CW, MAX_SPEED);
+	Timer1_startSoftTimer(&g_actionTimer, DOOR_MOTION_SECONDS * 1000UL);
+}
+
+/*
+ * Description :
+ * Stop the motor and return to the main options
+ */
+void stopDoor(void)
+{
+	DcMotor_Rotate(STOP, ZERO_SPEED);
+	setSystemState ();
+}
+
+/*
+ * Description :
+ * Reply ERRORSYSTEM and activate the buzzer for one minute
+ */
+void errorState (void)
+{
+	setSystemState ();
+	Buzzer_on();
+	Timer1_startSoftTimer(&g_actionTimer, DELAY_MINUTE * 1000UL);
+}
+
+/*
+ * Description :
+ * Turn off the buzzer and return to the main options
+ */
+void stopAlarm(void)
+{
+	Buzzer_off();
+	setSystemState ();
+}
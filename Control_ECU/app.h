@@ -1,142 +1,254 @@
-/*
- ================================================================================================
- File Name: app.h
- Name        : Door Locker Security System
- Author      : Omar Muhammad
- Description : Header file of Control_ECU CONTROL_ECU is responsible for all the processing and decisions in the system
-               like password checking, open the door and activate the system alarm.
- Date        : 26/10/2022
- ================================================================================================
- */
-
-#ifndef APP_H_
-#define APP_H_
-
-#include "MCAL/std_types.h"
-
-#define UART_BAUDRATE                    9600
-#define PASSWORD_SIZE                    5
-#define PASSWORD_ADDRESS_IN_EEPROM       0x0311
-#define MEMORY_ADDRESS                   0x01
-#define SAVED_PASSWORD                   108
-#define FUNCTIONS_ARRAY_OF_POINTERS_SIZE 3
-
-#define ERRORTRIALS                      3
-
-/*Error state*/
-#define DELAY_MINUTE                     60
-
-/*DCMotor Speeds*/
-#define MAX_SPEED                        100
-#define ZERO_SPEED                       0
-
-/*UART Commands and keywords*/
-#define GET_READY                       0x00F1
-#define READY                           0x00F2
-#define STATE                           0x00F3
-#define SENDING                         0x00F4
-#define RECEIVED                        105
-#define FINISHED                        107
-
-/*Control_ECU States codes*/
-#define CREATE_TWO_PASSWORD             0
-#define CHECK_PASSWORD                  1
-#define FalsePassword                   2
-
-#define SETUP                           109
-#define STARTUP                         110
-#define ERRORSYSTEM                     111
-#define READ_AGAIN                      114
-#define CHANGE                          115
-#define OPEN                            116
-#define MATCHED                         117
-#define OPEN_DOOR                       118
-
-/*******************************************************************************
- *                         Types Declaration                                   *
- *******************************************************************************/
-typedef enum
-{
-	CREATE_SYSTEM , MAIN_OPTION , ERROR_STATE
-}system_state;
-
-/*******************************************************************************
- *                      Functions Definitions                                  *
- *******************************************************************************/
-/*
- * Description :
- * 1. Check if the system was used previously or not
- * 2. Set the system state based on the saved status in EEPROM memory*/
-void systemUsage (void);
-
-/*
- * * Description :
- *    Set the state of the system whether to create password (as for the first time
- *    or to repeat the creating process as the password wasn't matched)
- *    or to move to main options
- */
-void setSystemState (void);
-
-/*
- * Description :
- * Receive the password from the HMI_ECU through UART
- */
-void receiveCommand (void);
-
-/*
- * Description :
- * 1. Receive two entered password from the user
- * 2. Check if the two passwords are matched and save one
- *    in the EEPROM memory
- * 3. If passwords not matched set repeat Creation flag
- */
-void createSystemPassword(void);
-
-/*
- * Description :
- * Receive the password from the HMI_ECU through UART
- */
-void receivePassword (uint8 *password_Ptr);
-
-/*
- * Description :
- * 1. Receive the password from the HMI_ECU through UART
- * 2. Check if the received password matches to that in the memory
- * 3. commands the HMI_ECU what to do next
- */
-void mainOptions (void);
-
-/*
- * Description :
- * open and close the motor
- */
-void openDoor(void);
-
-/*
- * Description :
- * Callback function of the timer
- */
-void countSec(void);
-
-/*
- * Description :
- * Delay function by seconds operates with Timer1
- */
-void delaySeconds(uint8 sec);
-
-/*
- * Description :
- * Activate the buzzer for a one minute
- */
-void errorState (void);
-
-/*
- * Description :
- * Sync the two micro-controllers
- */
-void syncMicroCOntrollers(void);
-
-/* Array of pointers to the three main function  */
-void (*ptr_states[FUNCTIONS_ARRAY_OF_POINTERS_SIZE])(void) = {createSystemPassword, mainOptions, errorState};
-
-#endif /* APP_H_ */
+/*
+ ================================================================================================
+ File Name: app.h
+ Name        : Door Locker Security System
+ Author      : Omar Muhammad
+ Description : Header file of Control_ECU CONTROL_ECU is responsible for all the processing and decisions in the system
+               like password checking, open the door and activate the system alarm.
+ Date        : 26/10/2022
+ ================================================================================================
+ */
+
+#ifndef APP_H_
+#define APP_H_
+
+#include "MCAL/std_types.h"
+#include "protocol.h"
+
+#define UART_BAUDRATE                    PROTOCOL_BASE_BAUD_RATE /* Raised by PROTOCOL_negotiateBaud */
+#define PASSWORD_SIZE                    5
+#define MEMORY_ADDRESS                   0x01
+
+#define ERRORTRIALS                      3
+
+/*Value of g_entryDigits when no streamed entry is in progress or one of its digits was lost*/
+#define ENTRY_INVALID                    0xFF
+
+/*The staged audit log entries are written once no request came for this time*/
+#define AUDIT_IDLE_MS                    1000
+
+/*Error state*/
+#define DELAY_MINUTE                     60
+
+/*Door timing in seconds*/
+#define DOOR_MOTION_SECONDS              15
+#define DOOR_HOLD_SECONDS                3
+
+/*DCMotor Speeds*/
+#define MAX_SPEED                        100
+#define ZERO_SPEED                       0
+
+/*Size of the queue of the state machine events, must be a power of two*/
+#define EVENT_QUEUE_SIZE                 8
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+/*States of the Control_ECU state machine, CTRL_ANY is a wildcard used in the transitions table*/
+typedef enum
+{
+	CTRL_SETUP, CTRL_READY, CTRL_DOOR_UNLOCKING, CTRL_DOOR_HOLD, CTRL_DOOR_LOCKING, CTRL_ALARM, CTRL_SAVING,
+	CTRL_MEMORY_FAULT, CTRL_USERS, CTRL_ANY
+}control_state;
+
+/*Events: the first seven come from the HMI_ECU requests and the next one from its streamed digits,
+ * the rest are posted by the actions, the timer and the end of the background EEPROM accesses*/
+typedef enum
+{
+	EV_GET_STATE, EV_CREATE_PASSWORD, EV_CHECK_PASSWORD, EV_ADD_USER, EV_REMOVE_USER, EV_LIST_USERS,
+	EV_DUMP_LOG, EV_PASSWORD_DIGIT,
+	EV_PASSWORD_SAVED, EV_OPEN_GRANTED, EV_CHANGE_GRANTED, EV_USERS_GRANTED, EV_LOCKOUT, EV_TIMER_EXPIRED,
+	EV_PASSWORD_WRITTEN, EV_PASSWORD_READ, EV_SAVE_FAILED, EV_STORAGE_ERROR
+}control_event;
+
+/*Actions, used as index in the array of action functions*/
+typedef enum
+{
+	ACT_SEND_STATE, ACT_CREATE_PASSWORD, ACT_CHECK_PASSWORD, ACT_START_DOOR,
+	ACT_HOLD_DOOR, ACT_LOCK_DOOR, ACT_STOP_DOOR, ACT_START_ALARM, ACT_STOP_ALARM,
+	ACT_READ_BACK, ACT_CACHE_PASSWORD, ACT_MEMORY_ERROR, ACT_LOAD_PASSWORD, ACT_CHECK_DIGIT,
+	ACT_ADD_USER, ACT_REMOVE_USER, ACT_LIST_USERS, ACT_DUMP_LOG
+}control_action;
+
+/*One row of the transitions table: in state, on event, do action then go to next state*/
+typedef struct
+{
+	uint8 state;
+	uint8 event;
+	uint8 action;
+	uint8 next;   /* CTRL_ANY keeps the current state */
+}transition;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+/*
+ * Description :
+ * 1. Check if the system was used previously or not
+ * 2. Set the initial state based on the saved status in EEPROM memory,
+ *    CTRL_MEMORY_FAULT if the memory cannot be read
+ * 3. Keep the saved password in the RAM cache used by all the checks
+ * 4. Load the user codes table and find the end of the audit log*/
+void systemUsage (void);
+
+/*
+ * Description :
+ * Add an event to the state machine queue, returns FALSE if the queue is full
+ */
+boolean postEvent (uint8 a_event);
+
+/*
+ * Description :
+ * Take the next request frame from the HMI_ECU, if any, and post its event.
+ * Unknown request types are dropped without reaching the state machine.
+ */
+void receiveCommand (void);
+
+/*
+ * Description :
+ * Run the transitions of all the queued events, the action timer expiry and the end
+ * of the background EEPROM access are events too
+ */
+void stateMachineTask (void);
+
+/*
+ * Description :
+ * Write the staged audit log entries in the background while the system is idle in the main options
+ */
+void flushAuditLog (void);
+
+/*
+ * Description :
+ * Find the transition of the event in the current state and run it.
+ * A request that is not expected in the current state is answered with the current state.
+ */
+void dispatchEvent (uint8 a_event);
+
+/*
+ * * Description :
+ *    Send the state of the system to the HMI_ECU in one MSG_STATE frame
+ *    whether to create password (as for the first time or to repeat the
+ *    creating process as the password wasn't matched) or to move to main options
+ */
+void setSystemState (void);
+
+/*
+ * Description :
+ * Check one streamed digit against its reference as soon as it comes so the verdict is ready
+ * when the entry ends: the cached password in the main options, in the setup the first password
+ * is kept in the record to save and the confirmation digits are checked against it.
+ */
+void checkDigit(void);
+
+/*
+ * Description :
+ * 1. Take the two entered passwords from the MSG_CREATE_PASSWORD frame, or the streamed ones
+ * 2. Check if the two passwords are matched and start saving one
+ *    in the EEPROM memory in the background
+ * 3. Post EV_SAVE_FAILED to ask to repeat the creation if they are not
+ */
+void createSystemPassword(void);
+
+/*
+ * Description :
+ * Start reading the saved record back in the background once its write cycle is finished
+ */
+void readBackPassword(void);
+
+/*
+ * Description :
+ * Update the password cache if the record read back is the saved one,
+ * then post EV_PASSWORD_SAVED or EV_STORAGE_ERROR
+ */
+void cachePassword(void);
+
+/*
+ * Description :
+ * Tell the HMI_ECU that the password could not be saved, it asks for the state again
+ */
+void reportMemoryError(void);
+
+/*
+ * Description :
+ * Try to load the saved password again after a memory fault and send the new state
+ */
+void loadPassword(void);
+
+/*
+ * Description :
+ * 1. Take the action and the password from the MSG_CHECK_PASSWORD frame
+ * 2. Check if the received password matches the cached one, or take the verdict of the streamed digits,
+ *    else look for it in the user codes table when the action is OPEN
+ * 3. Post the granted action or the lockout, or ask to read the password again
+ */
+void mainOptions (void);
+
+/*
+ * Description :
+ * Add the user code of the MSG_ADD_USER frame to the table and reply MSG_USER_RESULT
+ */
+void addUser(void);
+
+/*
+ * Description :
+ * Remove the user code of the MSG_REMOVE_USER frame from the table and reply MSG_USER_RESULT
+ */
+void removeUser(void);
+
+/*
+ * Description :
+ * Reply MSG_USER_LIST with the used slots from the slot of the MSG_LIST_USERS frame on
+ */
+void listUsers(void);
+
+/*
+ * Description :
+ * Reply MSG_USER_RESULT with the result of a user codes table change
+ */
+void sendUserResult(uint8 a_result, uint16 a_slot);
+
+/*
+ * Description :
+ * Reply MSG_LOG_DATA with the entries of the page of the MSG_DUMP_LOG frame, page 0 is the newest.
+ * The page alone is the reply past the oldest page, so the HMI_ECU asks for one page at a time
+ * and a NACK re-sends the whole reply.
+ */
+void dumpAuditLog(void);
+
+/*
+ * Description :
+ * Reply OPEN_DOOR and start opening the door
+ */
+void openDoor(void);
+
+/*
+ * Description :
+ * Stop the motor and hold the door open
+ */
+void holdDoor(void);
+
+/*
+ * Description :
+ * Start closing the door
+ */
+void lockDoor(void);
+
+/*
+ * Description :
+ * Stop the motor and return to the main options
+ */
+void stopDoor(void);
+
+/*
+ * Description :
+ * Reply ERRORSYSTEM and activate the buzzer for one minute
+ */
+void errorState (void);
+
+/*
+ * Description :
+ * Turn off the buzzer and return to the main options
+ */
+void stopAlarm(void);
+
+#endif /* APP_H_ */
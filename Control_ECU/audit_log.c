@@ -0,0 +1,296 @@
+/*
+ ================================================================================================
+ File Name: audit_log.c
+ Name        : Door Locker Security System
+ Author      : Omar Muhammad
+ Description : Source file of the audit log of the Control_ECU kept in the external EEPROM.
+ Date        : 17/10/2026
+ ================================================================================================
+ */
+
+#include "audit_log.h"
+#include "MCAL/timer.h"
+#include "HAL/external_eeprom.h"
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+static boolean g_ready = FALSE;             /* The current page is known */
+static uint8 g_currentPage;
+static uint8 g_page[AUDIT_PAGE_SIZE];       /* Copy of the current page, ahead of the EEPROM while g_pageDirty */
+static boolean g_pageDirty = FALSE;
+static uint8 g_bootCount = 0;               /* Known once the ring is read, written in the entries by AUDIT_flush */
+
+static uint8 g_staged[AUDIT_STAGED_ENTRIES][AUDIT_ENTRY_SIZE];
+static uint8 g_stagedFirst = 0;
+static uint8 g_stagedCount = 0;
+
+static EEPROM_RequestType g_auditRequest;
+static boolean g_writing = FALSE;
+static Timer1_SoftTimerType g_retryTimer;
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Sequence number of the page written after the one with the given sequence, never AUDIT_ERASED
+ */
+static uint8 AUDIT_nextSequence(uint8 sequence)
+{
+	return (sequence >= (AUDIT_ERASED - 1)) ? 0 : (sequence + 1);
+}
+
+/*
+ * Description :
+ * Start the given page of the ring with no entries
+ */
+static void AUDIT_newPage(uint8 page, uint8 sequence)
+{
+	uint8 index;
+
+	g_currentPage = page;
+	for(index = 0; index < AUDIT_PAGE_SIZE; index++)
+	{
+		g_page[index] = AUDIT_ERASED;
+	}
+	g_page[AUDIT_SEQUENCE_INDEX] = sequence;
+}
+
+/*
+ * Description :
+ * Return the first empty entry of the current page, AUDIT_ENTRIES_PER_PAGE if it is full
+ */
+static uint8 AUDIT_freeEntry(void)
+{
+	uint8 index;
+
+	for(index = 0; index < AUDIT_ENTRIES_PER_PAGE; index++)
+	{
+		if(g_page[AUDIT_ENTRIES_INDEX + (index * AUDIT_ENTRY_SIZE)] == AUDIT_ERASED)
+			break;
+	}
+	return index;
+}
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Find the current page of the ring by reading the sequence numbers and the boot count of the
+ * newest entry, once after the power up. Returns SUCCESS or ERROR if the EEPROM access failed.
+ */
+uint8 AUDIT_init(void)
+{
+	uint8 sequences[AUDIT_PAGES];
+	uint8 page;
+	uint8 index;
+
+	/* Called again after a memory fault, the staged entries are kept */
+	if(g_ready == TRUE)
+		return SUCCESS;
+
+	for(page = 0; page < AUDIT_PAGES; page++)
+	{
+		if(EEPROM_readByte(AUDIT_ADDRESS + (page * AUDIT_PAGE_SIZE) + AUDIT_SEQUENCE_INDEX, &sequences[page]) != SUCCESS)
+			return ERROR;
+	}
+
+	/* An erased ring starts from its first page */
+	AUDIT_newPage(0, 0);
+	for(page = 0; page < AUDIT_PAGES; page++)
+	{
+		if((sequences[page] != AUDIT_ERASED) &&
+		   (sequences[(page + 1) % AUDIT_PAGES] != AUDIT_nextSequence(sequences[page])))
+		{
+			/* The entries staged from now on go to its empty entries */
+			if(EEPROM_readBlock(AUDIT_ADDRESS + (page * AUDIT_PAGE_SIZE), g_page, AUDIT_PAGE_SIZE) != SUCCESS)
+				return ERROR;
+			g_currentPage = page;
+
+			/* The boot count before this power up is the one of the newest entry*/
+			index = AUDIT_freeEntry();
+			if(index != 0)
+				g_bootCount = g_page[AUDIT_ENTRIES_INDEX + ((index - 1) * AUDIT_ENTRY_SIZE) + AUDIT_BOOT_INDEX] + 1;
+			break;
+		}
+	}
+
+	g_ready = TRUE;
+	return SUCCESS;
+}
+
+/*
+ * Description :
+ * Stage an entry with the seconds since the power up, without any EEPROM access.
+ * Once AUDIT_STAGED_ENTRIES - 1 entries are waiting the next ones are dropped and
+ * counted in a LOG_DROPPED entry.
+ */
+void AUDIT_record(uint8 event, uint8 result, uint16 slot)
+{
+	uint8 *entry_Ptr;
+	uint32 seconds = Timer1_getTicks() / 1000;
+	uint16 dropped;
+
+	if(g_stagedCount == AUDIT_STAGED_ENTRIES)
+	{
+		/* The last staged entry is the LOG_DROPPED one, its slot counts one more entry*/
+		entry_Ptr = g_staged[(g_stagedFirst + AUDIT_STAGED_ENTRIES - 1) % AUDIT_STAGED_ENTRIES];
+		dropped = entry_Ptr[AUDIT_SLOT_INDEX] | ((uint16)entry_Ptr[AUDIT_SLOT_INDEX + 1] << 8);
+		if(dropped < AUDIT_MAX_DROPPED)
+			dropped++;
+		entry_Ptr[AUDIT_SLOT_INDEX] = (uint8)dropped;
+		entry_Ptr[AUDIT_SLOT_INDEX + 1] = (uint8)(dropped >> 8);
+		return;
+	}
+
+	if(g_stagedCount == (AUDIT_STAGED_ENTRIES - 1))
+	{
+		/* The time of the LOG_DROPPED entry is the one of the first dropped entry*/
+		event = LOG_DROPPED;
+		result = LOG_FAILED;
+		slot = 1;
+	}
+
+	/* The boot count is not known before AUDIT_init, it is written in the entry by AUDIT_flush*/
+	entry_Ptr = g_staged[(g_stagedFirst + g_stagedCount) % AUDIT_STAGED_ENTRIES];
+	entry_Ptr[AUDIT_EVENT_INDEX] = (uint8)((event << 4) | (result & 0x0F));
+	entry_Ptr[AUDIT_SLOT_INDEX] = (uint8)slot;
+	entry_Ptr[AUDIT_SLOT_INDEX + 1] = (uint8)(slot >> 8);
+	entry_Ptr[AUDIT_SECONDS_INDEX] = (uint8)seconds;
+	entry_Ptr[AUDIT_SECONDS_INDEX + 1] = (uint8)(seconds >> 8);
+	entry_Ptr[AUDIT_SECONDS_INDEX + 2] = (uint8)(seconds >> 16);
+	g_stagedCount++;
+}
+
+/*
+ * Description :
+ * Return TRUE while a page write started by AUDIT_flush is not finished
+ */
+boolean AUDIT_busy(void)
+{
+	return g_writing;
+}
+
+/*
+ * Description :
+ * Go on with writing the staged entries in the background, one page write at a time.
+ * Returns EEPROM_BUSY while a page is being written, SUCCESS once all the entries are in the EEPROM
+ * or ERROR if a page write failed, it is written again after AUDIT_RETRY_MS.
+ */
+uint8 AUDIT_flush(void)
+{
+	uint8 result;
+	uint8 index;
+	uint8 counter;
+	uint8 *entry_Ptr;
+
+	if(g_writing == TRUE)
+	{
+		/* Also retries the failed bus attempts of the write */
+		result = EEPROM_poll(&g_auditRequest);
+		if(result == EEPROM_BUSY)
+			return EEPROM_BUSY;
+
+		g_writing = FALSE;
+		if(result != SUCCESS)
+		{
+			/* The page stays dirty with its entries */
+			Timer1_startSoftTimer(&g_retryTimer, AUDIT_RETRY_MS);
+			return ERROR;
+		}
+		g_pageDirty = FALSE;
+	}
+
+	if((g_ready == FALSE) || ((g_retryTimer.running == TRUE) && (Timer1_softTimerExpired(&g_retryTimer) == FALSE)))
+		return ERROR;
+
+	/* Fill the current page, once it is full and in the EEPROM the next page of the ring takes the place of the oldest one */
+	while(g_stagedCount != 0)
+	{
+		index = AUDIT_freeEntry();
+		if(index == AUDIT_ENTRIES_PER_PAGE)
+		{
+			if(g_pageDirty == TRUE)
+				break;
+			AUDIT_newPage((g_currentPage + 1) % AUDIT_PAGES, AUDIT_nextSequence(g_page[AUDIT_SEQUENCE_INDEX]));
+			index = 0;
+		}
+
+		entry_Ptr = &g_page[AUDIT_ENTRIES_INDEX + (index * AUDIT_ENTRY_SIZE)];
+		for(counter = 0; counter < AUDIT_ENTRY_SIZE; counter++)
+		{
+			entry_Ptr[counter] = g_staged[g_stagedFirst][counter];
+		}
+		entry_Ptr[AUDIT_BOOT_INDEX] = g_bootCount;
+		g_stagedFirst = (g_stagedFirst + 1) % AUDIT_STAGED_ENTRIES;
+		g_stagedCount--;
+		g_pageDirty = TRUE;
+	}
+
+	if(g_pageDirty == FALSE)
+		return SUCCESS;
+
+	/* The whole page in one page write, the empty entries erase the ones left by the oldest page */
+	if(EEPROM_startWritePage(&g_auditRequest, AUDIT_ADDRESS + (g_currentPage * AUDIT_PAGE_SIZE), g_page, AUDIT_PAGE_SIZE) != SUCCESS)
+	{
+		Timer1_startSoftTimer(&g_retryTimer, AUDIT_RETRY_MS);
+		return ERROR;
+	}
+	g_writing = TRUE;
+	return EEPROM_BUSY;
+}
+
+/*
+ * Description :
+ * Write all the staged entries before returning, returns SUCCESS or ERROR
+ */
+uint8 AUDIT_sync(void)
+{
+	uint8 result;
+
+	do
+	{
+		result = AUDIT_flush();
+	} while(result == EEPROM_BUSY);
+
+	return result;
+}
+
+/*
+ * Description :
+ * Read one page of the ring in one sequential read, page_number 0 is the oldest page and
+ * AUDIT_PAGES - 1 the current one. Copies its used entries and their count.
+ */
+uint8 AUDIT_readEntries(uint8 page_number, uint8 *entries_Ptr, uint8 *count_Ptr)
+{
+	uint8 page[AUDIT_PAGE_SIZE];
+	uint8 index;
+	uint8 counter;
+	const uint8 *entry_Ptr;
+
+	*count_Ptr = 0;
+	if(EEPROM_readBlock(AUDIT_ADDRESS + (((g_currentPage + 1 + page_number) % AUDIT_PAGES) * AUDIT_PAGE_SIZE),
+			page, AUDIT_PAGE_SIZE) != SUCCESS)
+		return ERROR;
+
+	if(page[AUDIT_SEQUENCE_INDEX] == AUDIT_ERASED)
+		return SUCCESS;
+
+	for(index = 0; index < AUDIT_ENTRIES_PER_PAGE; index++)
+	{
+		entry_Ptr = &page[AUDIT_ENTRIES_INDEX + (index * AUDIT_ENTRY_SIZE)];
+		if(entry_Ptr[0] == AUDIT_ERASED)
+			continue;
+
+		for(counter = 0; counter < AUDIT_ENTRY_SIZE; counter++)
+		{
+			entries_Ptr[(*count_Ptr * AUDIT_ENTRY_SIZE) + counter] = entry_Ptr[counter];
+		}
+		(*count_Ptr)++;
+	}
+	return SUCCESS;
+}
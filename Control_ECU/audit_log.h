@@ -0,0 +1,102 @@
+/*
+ ================================================================================================
+ File Name: audit_log.h
+ Name        : Door Locker Security System
+ Author      : Omar Muhammad
+ Description : Header file of the audit log of the Control_ECU kept in the external EEPROM.
+               The entries (see LOG_ENTRY_SIZE in protocol.h) are staged in RAM without any bus
+               access and written later in whole pages to a ring of AUDIT_PAGES pages:
+               | sequence | entry 0 | entry 1 | unused |
+               the pages are written in turn with the next sequence number, the current page is
+               the last one before a gap in the sequence and the oldest page comes after it.
+               The boot count of the entries is the one of the newest entry at the power up plus one.
+ Date        : 17/10/2026
+ ================================================================================================
+ */
+
+#ifndef AUDIT_LOG_H_
+#define AUDIT_LOG_H_
+
+#include "MCAL/std_types.h"
+#include "protocol.h"
+#include "password_log.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define AUDIT_ADDRESS                   0x0690 /* USERS_END_ADDRESS, every page up to the password log */
+#define AUDIT_PAGES                     15
+#define AUDIT_PAGE_SIZE                 16     /* One EEPROM page */
+#define AUDIT_ENTRIES_PER_PAGE          LOG_DATA_ENTRIES
+#define AUDIT_ENTRY_SIZE                LOG_ENTRY_SIZE
+
+/*Page layout*/
+#define AUDIT_SEQUENCE_INDEX            0
+#define AUDIT_ENTRIES_INDEX             1
+#define AUDIT_ERASED                    0xFF   /* Sequence of an erased page and first byte of an empty entry */
+
+/*Entry layout*/
+#define AUDIT_EVENT_INDEX               0
+#define AUDIT_SLOT_INDEX                1
+#define AUDIT_BOOT_INDEX                3
+#define AUDIT_SECONDS_INDEX             4
+
+#define AUDIT_STAGED_ENTRIES            8      /* Entries waiting in RAM for the next page write, the last one counts the dropped ones */
+#define AUDIT_MAX_DROPPED               0xFFFE /* Below LOG_NO_SLOT */
+#define AUDIT_RETRY_MS                  1000   /* Wait before writing a page again after a failed write */
+
+#if ((AUDIT_ENTRIES_INDEX + (AUDIT_ENTRIES_PER_PAGE * AUDIT_ENTRY_SIZE)) > AUDIT_PAGE_SIZE)
+#error "The entries of LOG_DATA_ENTRIES in protocol.h should fit in one page"
+#endif
+
+#if ((AUDIT_ADDRESS + (AUDIT_PAGES * AUDIT_PAGE_SIZE)) > PASSWORD_LOG_ADDRESS)
+#error "The audit log should end before the password log"
+#endif
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Find the current page of the ring by reading the sequence numbers and the boot count of the
+ * newest entry, once after the power up. Returns SUCCESS or ERROR if the EEPROM access failed.
+ */
+uint8 AUDIT_init(void);
+
+/*
+ * Description :
+ * Stage an entry with the seconds since the power up, without any EEPROM access.
+ * Once AUDIT_STAGED_ENTRIES - 1 entries are waiting the next ones are dropped and
+ * counted in a LOG_DROPPED entry.
+ */
+void AUDIT_record(uint8 event, uint8 result, uint16 slot);
+
+/*
+ * Description :
+ * Return TRUE while a page write started by AUDIT_flush is not finished
+ */
+boolean AUDIT_busy(void);
+
+/*
+ * Description :
+ * Go on with writing the staged entries in the background, one page write at a time.
+ * Returns EEPROM_BUSY while a page is being written, SUCCESS once all the entries are in the EEPROM
+ * or ERROR if a page write failed, it is written again after AUDIT_RETRY_MS.
+ */
+uint8 AUDIT_flush(void);
+
+/*
+ * Description :
+ * Write all the staged entries before returning, returns SUCCESS or ERROR
+ */
+uint8 AUDIT_sync(void);
+
+/*
+ * Description :
+ * Read one page of the ring in one sequential read, page_number 0 is the oldest page and
+ * AUDIT_PAGES - 1 the current one. Copies its used entries and their count.
+ */
+uint8 AUDIT_readEntries(uint8 page_number, uint8 *entries_Ptr, uint8 *count_Ptr);
+
+#endif /* AUDIT_LOG_H_ */
@@ -0,0 +1,186 @@
+/*
+ ================================================================================================
+ File Name: password_log.c
+ Name        : Door Locker Security System
+ Author      : Omar Muhammad
+ Description : Source file of the saved password log kept in the external EEPROM.
+ Date        : 17/10/2026
+ ================================================================================================
+ */
+
+#include "password_log.h"
+#include "HAL/external_eeprom.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define PASSWORD_LOG_NONE               0xFF   /* No valid record in the log */
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+static uint8 g_newestSlot = PASSWORD_LOG_NONE;
+static uint16 g_newestSequence;
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * CRC-8 with the polynomial 0x07, the one of the frames
+ */
+static uint8 PASSWORD_LOG_crc8(const uint8 *data_Ptr, uint8 length)
+{
+	uint8 crc = 0;
+	uint8 bit;
+
+	while(length--)
+	{
+		crc ^= *data_Ptr++;
+		for(bit = 0; bit < 8; bit++)
+		{
+			crc = (crc & 0x80) ? (uint8)((crc << 1) ^ 0x07) : (uint8)(crc << 1);
+		}
+	}
+	return crc;
+}
+
+static uint8 PASSWORD_LOG_nextSlot(void)
+{
+	return (g_newestSlot == PASSWORD_LOG_NONE) ? 0 : ((g_newestSlot + 1) % PASSWORD_LOG_PAGES);
+}
+
+/*
+ * Description :
+ * Use the record of the older firmware, the tag followed by the password, while the log is empty
+ */
+static uint8 PASSWORD_LOG_loadLegacy(uint8 *password_Ptr)
+{
+	uint8 record[PASSWORD_LOG_DIGITS + 1];
+	uint8 counter;
+
+	if(EEPROM_readBlock(PASSWORD_LOG_LEGACY_ADDRESS, record, PASSWORD_LOG_DIGITS + 1) != SUCCESS)
+		return PASSWORD_LOG_ERROR;
+
+	if(record[0] != PASSWORD_LOG_TAG)
+		return PASSWORD_LOG_EMPTY;
+	for(counter = 0; counter < PASSWORD_LOG_DIGITS; counter++)
+	{
+		if(record[counter + 1] > 9)
+			return PASSWORD_LOG_EMPTY;
+	}
+
+	for(counter = 0; counter < PASSWORD_LOG_DIGITS; counter++)
+	{
+		password_Ptr[counter] = record[counter + 1];
+	}
+	return PASSWORD_LOG_FOUND;
+}
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Read the whole log in two sequential reads and copy the password of the newest valid record.
+ * A record that fails its CRC (a write cut by a power loss) is skipped, the one before it is kept.
+ */
+uint8 PASSWORD_LOG_load(uint8 *password_Ptr)
+{
+	uint8 records[PASSWORD_LOG_SCAN_RECORDS * PASSWORD_LOG_RECORD_SIZE];
+	const uint8 *record_Ptr;
+	uint16 sequence;
+	uint8 slot;
+
+	g_newestSlot = PASSWORD_LOG_NONE;
+
+	for(slot = 0; slot < PASSWORD_LOG_PAGES; slot++)
+	{
+		if(((slot % PASSWORD_LOG_SCAN_RECORDS) == 0) &&
+		   (EEPROM_readBlock(PASSWORD_LOG_ADDRESS + (slot * PASSWORD_LOG_RECORD_SIZE), records, sizeof(records)) != SUCCESS))
+			return PASSWORD_LOG_ERROR;
+
+		/* The sequence numbers of the ring are close to each other so the difference tells the newest even after a wrap,
+		 * the password of a record is copied only if it is valid and newer than the ones before */
+		record_Ptr = &records[(slot % PASSWORD_LOG_SCAN_RECORDS) * PASSWORD_LOG_RECORD_SIZE];
+		sequence = record_Ptr[PASSWORD_LOG_SEQUENCE_INDEX] | ((uint16)record_Ptr[PASSWORD_LOG_SEQUENCE_INDEX + 1] << 8);
+		if(((g_newestSlot == PASSWORD_LOG_NONE) || ((sint16)(sequence - g_newestSequence) > 0)) &&
+		   (PASSWORD_LOG_parse(record_Ptr, password_Ptr) == TRUE))
+		{
+			g_newestSlot = slot;
+			g_newestSequence = sequence;
+		}
+	}
+
+	if(g_newestSlot != PASSWORD_LOG_NONE)
+		return PASSWORD_LOG_FOUND;
+
+	return PASSWORD_LOG_loadLegacy(password_Ptr);
+}
+
+/*
+ * Description :
+ * Return the address of the page the next record goes to, the one after the newest record
+ */
+uint16 PASSWORD_LOG_nextAddress(void)
+{
+	return PASSWORD_LOG_ADDRESS + (PASSWORD_LOG_nextSlot() * PASSWORD_LOG_RECORD_SIZE);
+}
+
+/*
+ * Description :
+ * Complete the next record around the digits already at PASSWORD_LOG_DIGITS_INDEX:
+ * sequence number, tag, padding and CRC
+ */
+void PASSWORD_LOG_seal(uint8 *record_Ptr)
+{
+	uint16 sequence = (g_newestSlot == PASSWORD_LOG_NONE) ? 0 : (g_newestSequence + 1);
+	uint8 index;
+
+	record_Ptr[PASSWORD_LOG_SEQUENCE_INDEX] = (uint8)sequence;
+	record_Ptr[PASSWORD_LOG_SEQUENCE_INDEX + 1] = (uint8)(sequence >> 8);
+	record_Ptr[PASSWORD_LOG_TAG_INDEX] = PASSWORD_LOG_TAG;
+	for(index = PASSWORD_LOG_DIGITS_INDEX + PASSWORD_LOG_DIGITS; index < PASSWORD_LOG_CRC_INDEX; index++)
+	{
+		record_Ptr[index] = 0xFF;
+	}
+	record_Ptr[PASSWORD_LOG_CRC_INDEX] = PASSWORD_LOG_crc8(record_Ptr, PASSWORD_LOG_CRC_INDEX);
+}
+
+/*
+ * Description :
+ * Check the tag, the CRC and the digits of a record.
+ * Returns TRUE and copies the password only if the record is valid.
+ */
+boolean PASSWORD_LOG_parse(const uint8 *record_Ptr, uint8 *password_Ptr)
+{
+	uint8 counter;
+
+	if((record_Ptr[PASSWORD_LOG_TAG_INDEX] != PASSWORD_LOG_TAG) ||
+	   (record_Ptr[PASSWORD_LOG_CRC_INDEX] != PASSWORD_LOG_crc8(record_Ptr, PASSWORD_LOG_CRC_INDEX)))
+		return FALSE;
+
+	for(counter = 0; counter < PASSWORD_LOG_DIGITS; counter++)
+	{
+		if(record_Ptr[PASSWORD_LOG_DIGITS_INDEX + counter] > 9)
+			return FALSE;
+	}
+
+	for(counter = 0; counter < PASSWORD_LOG_DIGITS; counter++)
+	{
+		password_Ptr[counter] = record_Ptr[PASSWORD_LOG_DIGITS_INDEX + counter];
+	}
+	return TRUE;
+}
+
+/*
+ * Description :
+ * The sealed record is in the EEPROM, it becomes the newest one
+ */
+void PASSWORD_LOG_committed(void)
+{
+	g_newestSequence = (g_newestSlot == PASSWORD_LOG_NONE) ? 0 : (g_newestSequence + 1);
+	g_newestSlot = PASSWORD_LOG_nextSlot();
+}
@@ -0,0 +1,87 @@
+/*
+ ================================================================================================
+ File Name: password_log.h
+ Name        : Door Locker Security System
+ Author      : Omar Muhammad
+ Description : Header file of the saved password log kept in the external EEPROM.
+               Every password change is appended as one record in the next page of a ring of
+               PASSWORD_LOG_PAGES pages, so the writes are spread over the ring and the oldest
+               record is the one overwritten. A record is one page:
+               | sequence (2 bytes, LSB first) | tag | password digits | 0xFF padding | CRC-8 |
+               the CRC-8 (polynomial 0x07) covers all the bytes before it. The saved password is
+               the valid record with the newest sequence number.
+               A record is committed by one page write and never over the newest valid record,
+               so a write cut by a power loss fails its CRC and the previous password is kept.
+ Date        : 17/10/2026
+ ================================================================================================
+ */
+
+#ifndef PASSWORD_LOG_H_
+#define PASSWORD_LOG_H_
+
+#include "MCAL/std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define PASSWORD_LOG_ADDRESS            0x0780 /* The last PASSWORD_LOG_PAGES pages of the 24C16 */
+#define PASSWORD_LOG_PAGES              8
+#define PASSWORD_LOG_RECORD_SIZE        16     /* One EEPROM page */
+#define PASSWORD_LOG_DIGITS             5      /* PASSWORD_SIZE of app.h */
+
+/*Record layout*/
+#define PASSWORD_LOG_SEQUENCE_INDEX     0
+#define PASSWORD_LOG_TAG_INDEX          2
+#define PASSWORD_LOG_DIGITS_INDEX       3
+#define PASSWORD_LOG_CRC_INDEX          15
+#define PASSWORD_LOG_TAG                108
+
+/*Records read at once by the scan at boot, the log is read in two sequential reads*/
+#define PASSWORD_LOG_SCAN_RECORDS       (PASSWORD_LOG_PAGES / 2)
+
+/*Record of the older firmware: the tag followed by the password, used while the log is empty*/
+#define PASSWORD_LOG_LEGACY_ADDRESS     0x0310
+
+/*Results of PASSWORD_LOG_load*/
+#define PASSWORD_LOG_FOUND              0
+#define PASSWORD_LOG_EMPTY              1
+#define PASSWORD_LOG_ERROR              2      /* The EEPROM access failed */
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Read the whole log in two sequential reads and copy the password of the newest valid record.
+ * A record that fails its CRC (a write cut by a power loss) is skipped, the one before it is kept.
+ */
+uint8 PASSWORD_LOG_load(uint8 *password_Ptr);
+
+/*
+ * Description :
+ * Return the address of the page the next record goes to, the one after the newest record
+ */
+uint16 PASSWORD_LOG_nextAddress(void);
+
+/*
+ * Description :
+ * Complete the next record around the digits already at PASSWORD_LOG_DIGITS_INDEX:
+ * sequence number, tag, padding and CRC
+ */
+void PASSWORD_LOG_seal(uint8 *record_Ptr);
+
+/*
+ * Description :
+ * Check the tag, the CRC and the digits of a record.
+ * Returns TRUE and copies the password only if the record is valid.
+ */
+boolean PASSWORD_LOG_parse(const uint8 *record_Ptr, uint8 *password_Ptr);
+
+/*
+ * Description :
+ * The sealed record is in the EEPROM, it becomes the newest one
+ */
+void PASSWORD_LOG_committed(void);
+
+#endif /* PASSWORD_LOG_H_ */
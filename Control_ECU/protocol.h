@@ -0,0 +1,171 @@
+/*
+ ================================================================================================
+ File Name: protocol.h
+ Name        : Door Locker Security System
+ Author      : Omar Muhammad
+ Description : Header file of the framed message protocol shared by HMI_ECU and Control_ECU.
+               Frame format: | START | TYPE | LENGTH | PAYLOAD (LENGTH bytes) | CRC-8 |
+               the CRC-8 (polynomial 0x07) covers TYPE, LENGTH and the PAYLOAD.
+ Date        : 17/10/2026
+ ================================================================================================
+ */
+
+#ifndef PROTOCOL_H_
+#define PROTOCOL_H_
+
+#include "MCAL/std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define PROTOCOL_START_BYTE             0x7E
+#define PROTOCOL_MAX_PAYLOAD            16
+#define PROTOCOL_FRAME_OVERHEAD         4    /* START + TYPE + LENGTH + CRC */
+#define PROTOCOL_MAX_RETRIES            3    /* Re-sends of the last frame on NACK */
+
+/*Baud rate negotiation, see PROTOCOL_negotiateBaud*/
+#define PROTOCOL_BASE_BAUD_RATE         9600 /* Rate of both ECUs at power up */
+#define PROTOCOL_BAUD_TIMEOUT_MS        20   /* Wait for the other ECU at every negotiation step */
+#define PROTOCOL_BAUD_FALLBACK_ERRORS   3    /* Framing errors in a row that bring the link back to the base rate */
+#define PROTOCOL_TEST_PATTERN_SIZE      16
+
+/*HMI_ECU -> Control_ECU requests, turned into control_event values by receiveCommand and handled
+ * through the transitions table of the Control_ECU*/
+#define MSG_CREATE_PASSWORD             0    /* Payload: password + confirmation password, none if the digits were streamed */
+#define MSG_CHECK_PASSWORD              1    /* Payload: action (OPEN/CHANGE) + password, the action only if the digits were streamed */
+#define MSG_GET_STATE                   2    /* No payload */
+#define MSG_PASSWORD_DIGIT              3    /* Payload: digit index + digit, sent as it is typed and answered with MSG_DIGIT_ACK */
+#define MSG_ADD_USER                    4    /* Payload: user code digits, in the USERS_MENU state only */
+#define MSG_REMOVE_USER                 5    /* Payload: user code digits, in the USERS_MENU state only */
+#define MSG_LIST_USERS                  6    /* Payload: first slot (LSB first), in the USERS_MENU state only */
+#define MSG_DUMP_LOG                    7    /* Payload: page of the audit log (0 is the newest), in the USERS_MENU state only */
+
+/*Control_ECU -> HMI_ECU replies*/
+#define MSG_STATE                       0x10 /* Payload: system state */
+#define MSG_USER_RESULT                 0x11 /* Payload: result + slot (LSB first) + users count (LSB first) */
+#define MSG_USER_LIST                   0x12 /* Payload: users count + next slot + up to USER_LIST_SLOTS used slots, all LSB first */
+#define MSG_LOG_DATA                    0x13 /* Payload: the requested page + its LOG_DATA_ENTRIES entries at most, the page alone ends the log */
+#define MSG_DIGIT_ACK                   0x14 /* Payload: index of the accepted digit, the next one may be sent */
+
+/*Link control, the receiver got a corrupted frame and asks for it again*/
+#define MSG_NACK                        0x7F
+
+/*Baud rate negotiation, MSG_SET_BAUD and MSG_BAUD_TEST are answered by the protocol itself*/
+#define MSG_SET_BAUD                    0x7A /* Payload: index of the offered rate */
+#define MSG_BAUD_ACK                    0x7B /* Payload: index of the accepted rate */
+#define MSG_BAUD_TEST                   0x7C /* Payload: test pattern, sent at the new rate */
+#define MSG_BAUD_ECHO                   0x7D /* Payload: the test pattern as received */
+
+/*System states carried by MSG_STATE*/
+#define SETUP                           109
+#define STARTUP                         110
+#define ERRORSYSTEM                     111
+#define READ_AGAIN                      114
+#define OPEN_DOOR                       118
+#define MEMORY_ERROR                    119  /* The EEPROM failed, ask for the state again */
+#define USERS_MENU                      120  /* The master password opened the user codes management */
+
+/*Actions carried by MSG_CHECK_PASSWORD*/
+#define CHANGE                          115
+#define OPEN                            116
+#define MANAGE_USERS                    117
+
+/*Results carried by MSG_USER_RESULT*/
+#define USER_ADDED                      0
+#define USER_UNKNOWN                    1
+#define USER_EXISTS                     2
+#define USER_TABLE_FULL                 3
+#define USER_MEMORY_ERROR               4
+#define USER_REMOVED                    5
+
+/*MSG_USER_LIST*/
+#define USER_LIST_SLOTS                 4
+#define USER_LIST_END                   0xFFFF /* Next slot of the last page */
+
+/*Audit log entries carried by MSG_LOG_DATA, oldest first:
+ * | event << 4 | result | user slot (LSB first) | boot count | seconds since the power up (3 bytes LSB first) |
+ * the boot count goes up by one at every power up and wraps from 255 to 0 like the page sequence*/
+#define LOG_ENTRY_SIZE                  7
+#define LOG_DATA_ENTRIES                2    /* Entries of one page of the log */
+#define LOG_NO_SLOT                     0xFFFF /* The master password was used, or no user code */
+
+/*Audit log events*/
+#define LOG_POWER_UP                    0
+#define LOG_OPEN                        1
+#define LOG_CHANGE                      2
+#define LOG_USERS                       3
+#define LOG_SAVE_PASSWORD               4
+#define LOG_ADD_USER                    5
+#define LOG_REMOVE_USER                 6
+#define LOG_DROPPED                     7    /* Entries lost while the staging was full, their count in the slot */
+
+/*Audit log results*/
+#define LOG_OK                          0
+#define LOG_DENIED                      1
+#define LOG_LOCKOUT                     2
+#define LOG_FAILED                      3
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef struct
+{
+	uint8 type;
+	uint8 length;
+	uint8 payload[PROTOCOL_MAX_PAYLOAD];
+}PROTOCOL_Frame;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Reset the frame receiver and the error counter
+ */
+void PROTOCOL_init(void);
+
+/*
+ * Description :
+ * Build a frame of the given type and payload and queue it in the UART
+ */
+void PROTOCOL_sendFrame(uint8 type, const uint8 *payload_Ptr, uint8 length);
+
+/*
+ * Description :
+ * Feed the received UART bytes to the frame receiver without waiting.
+ * Returns TRUE when a complete frame with a valid CRC is stored in frame_Ptr.
+ * Corrupted frames are answered with MSG_NACK and a received MSG_NACK
+ * re-sends the last frame, both are handled here and never returned.
+ */
+boolean PROTOCOL_receiveFrame(PROTOCOL_Frame *frame_Ptr);
+
+/*
+ * Description :
+ * Wait until a complete valid frame is received
+ */
+void PROTOCOL_waitFrame(PROTOCOL_Frame *frame_Ptr);
+
+/*
+ * Description :
+ * Wait for a frame of the given type for at most timeout_ms, the other frames are dropped.
+ * Returns FALSE on the timeout.
+ */
+boolean PROTOCOL_waitReply(PROTOCOL_Frame *frame_Ptr, uint8 type, uint16 timeout_ms);
+
+/*
+ * Description :
+ * Return the number of frames dropped because of a wrong CRC or length
+ */
+uint16 PROTOCOL_getErrorCount(void);
+
+/*
+ * Description :
+ * Agree with the other ECU on the fastest rate of the negotiation table that carries the test
+ * pattern both ways, starting from PROTOCOL_BASE_BAUD_RATE. Called by one ECU only, the other
+ * answers from PROTOCOL_receiveFrame. Blocks for at most PROTOCOL_BAUD_TIMEOUT_MS per step.
+ * Returns the rate in use.
+ */
+uint32 PROTOCOL_negotiateBaud(void);
+
+#endif /* PROTOCOL_H_ */
@@ -0,0 +1,56 @@
+/*
+ ================================================================================================
+ File Name: scheduler.h
+ Name        : Door Locker Security System
+ Author      : Omar Muhammad
+ Description : Header file of the cooperative task scheduler running on the Timer1 1 ms system tick.
+               Tasks must never block, long actions are split in steps timed by software timers.
+ Date        : 17/10/2026
+ ================================================================================================
+ */
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include "MCAL/std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define SCHEDULER_MAX_TASKS             4
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef void (*SCHEDULER_TaskType)(void);
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Empty the task table and start the 1 ms system tick
+ */
+void SCHEDULER_init(void);
+
+/*
+ * Description :
+ * Add a task to be called every period_ms, a zero period calls it on every dispatch.
+ * Returns FALSE if the task table is full.
+ */
+boolean SCHEDULER_addTask(SCHEDULER_TaskType task, uint16 period_ms);
+
+/*
+ * Description :
+ * Call once every task that is due, a task that is already running is skipped
+ */
+void SCHEDULER_dispatch(void);
+
+/*
+ * Description :
+ * Wait for period_ms while keeping the other tasks running
+ */
+void SCHEDULER_delayMs(uint32 period_ms);
+
+#endif /* SCHEDULER_H_ */
@@ -0,0 +1,409 @@
+/*
+ ================================================================================================
+ File Name: users.c
+ Name        : Door Locker Security System
+ Author      : Omar Muhammad
+ Description : Source file of the user codes table kept in the external EEPROM.
+ Date        : 17/10/2026
+ ================================================================================================
+ */
+
+#include "users.h"
+#include "MCAL/common_macros.h"
+#include "HAL/external_eeprom.h"
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+static uint16 g_usersCount = 0;
+static uint8 g_bucket[USERS_BUCKET_SIZE];   /* Last bucket page read */
+
+/*******************************************************************************
+ *                      Private Functions Definitions                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Write the bytes in one page write and wait for the end of the write cycle
+ */
+static uint8 USERS_write(uint16 address, const uint8 *data_Ptr, uint8 length)
+{
+	if(EEPROM_writePage(address, data_Ptr, length) != SUCCESS)
+		return USERS_ERROR;
+
+	return (EEPROM_waitWriteComplete(NULL_PTR) == SUCCESS) ? USERS_OK : USERS_ERROR;
+}
+
+/*
+ * Description :
+ * CRC-8 with the polynomial 0x07, the one of the frames
+ */
+static uint8 USERS_crc8(const uint8 *data_Ptr, uint8 length)
+{
+	uint8 crc = 0;
+	uint8 bit;
+
+	while(length--)
+	{
+		crc ^= *data_Ptr++;
+		for(bit = 0; bit < 8; bit++)
+		{
+			crc = (crc & 0x80) ? (uint8)((crc << 1) ^ 0x07) : (uint8)(crc << 1);
+		}
+	}
+	return crc;
+}
+
+/*
+ * Description :
+ * Fill a header copy of this table geometry
+ */
+static void USERS_buildHeader(uint8 *header_Ptr)
+{
+	header_Ptr[0] = USERS_MAGIC_0;
+	header_Ptr[1] = USERS_MAGIC_1;
+	header_Ptr[2] = USERS_BUCKETS;
+	header_Ptr[3] = USERS_SLOTS_PER_BUCKET;
+	header_Ptr[USERS_HEADER_CRC_INDEX] = USERS_crc8(header_Ptr, USERS_HEADER_CRC_INDEX);
+}
+
+/*
+ * Description :
+ * Check a header copy against the one of this table geometry
+ */
+static boolean USERS_isHeader(const uint8 *header_Ptr)
+{
+	uint8 expected[USERS_HEADER_SIZE];
+	uint8 index;
+
+	USERS_buildHeader(expected);
+	for(index = 0; index < USERS_HEADER_SIZE; index++)
+	{
+		if(header_Ptr[index] != expected[index])
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Count the used slots of all the buckets from their meta bytes, *clean_Ptr tells if all the
+ * buckets are erased ones: every slot free and no code went past
+ */
+static uint8 USERS_countCodes(uint16 *count_Ptr, boolean *clean_Ptr)
+{
+	uint8 bucket;
+	uint8 index;
+	uint8 bytes[2];   /* Overflows then meta */
+
+	*count_Ptr = 0;
+	*clean_Ptr = TRUE;
+	for(bucket = 0; bucket < USERS_BUCKETS; bucket++)
+	{
+		if(EEPROM_readBlock(USERS_BUCKET_ADDRESS(bucket) + USERS_OVERFLOWS_INDEX, bytes, 2) != SUCCESS)
+			return USERS_ERROR;
+
+		for(index = 0; index < USERS_SLOTS_PER_BUCKET; index++)
+		{
+			if(BIT_IS_CLEAR(bytes[1], index))
+				(*count_Ptr)++;
+		}
+		if((bytes[0] != 0xFF) || ((bytes[1] & USERS_META_FREE_MASK) != USERS_META_FREE_MASK))
+			*clean_Ptr = FALSE;
+	}
+	return USERS_OK;
+}
+
+/*
+ * Description :
+ * Add delta (+1 or -1) to the overflow count of the bucket, the count is stored complemented
+ * and stays saturated once it reached 255
+ */
+static uint8 USERS_addOverflow(uint8 bucket, sint8 delta)
+{
+	uint16 address = USERS_BUCKET_ADDRESS(bucket) + USERS_OVERFLOWS_INDEX;
+	uint8 stored;
+
+	if(EEPROM_readByte(address, &stored) != SUCCESS)
+		return USERS_ERROR;
+
+	if((stored == USERS_OVERFLOWS_SATURATED) || ((delta < 0) && (stored == 0xFF)))
+		return USERS_OK;
+
+	stored = (uint8)(stored - delta);
+	return USERS_write(address, &stored, 1);
+}
+
+/*
+ * Description :
+ * Add delta to the overflow counts of the buckets the code went past to reach the given distance
+ */
+static uint8 USERS_updateOverflows(uint32 code, uint8 distance, sint8 delta)
+{
+	uint8 bucket = USERS_HOME_BUCKET(code);
+	uint8 step = USERS_PROBE_STEP(code);
+	uint8 probes;
+
+	for(probes = 0; probes < distance; probes++)
+	{
+		if(USERS_addOverflow(bucket, delta) != USERS_OK)
+			return USERS_ERROR;
+		bucket = (bucket + step) % USERS_BUCKETS;
+	}
+	return USERS_OK;
+}
+
+/*
+ * Description :
+ * Return the record stored in the given slot of g_bucket
+ */
+static uint16 USERS_record(uint8 index)
+{
+	const uint8 *record_Ptr = &g_bucket[index * USERS_RECORD_SIZE];
+
+	return (uint16)record_Ptr[0] | ((uint16)record_Ptr[1] << 8);
+}
+
+/*
+ * Description :
+ * Follow the probe sequence of the code reading one bucket page per step.
+ * Returns USERS_OK with the bucket (left in g_bucket), the slot and the distance of the code, or
+ * USERS_NOT_FOUND once a bucket that no code went past ends the sequence.
+ */
+static uint8 USERS_probe(uint32 code, uint8 *bucket_Ptr, uint8 *index_Ptr, uint8 *distance_Ptr)
+{
+	uint8 bucket = USERS_HOME_BUCKET(code);
+	uint8 step = USERS_PROBE_STEP(code);
+	uint8 distance;
+	uint8 index;
+
+	for(distance = 0; distance <= USERS_MAX_DISTANCE; distance++)
+	{
+		if(EEPROM_readBlock(USERS_BUCKET_ADDRESS(bucket), g_bucket, USERS_BUCKET_SIZE) != SUCCESS)
+			return USERS_ERROR;
+
+		for(index = 0; index < USERS_SLOTS_PER_BUCKET; index++)
+		{
+			if(BIT_IS_CLEAR(g_bucket[USERS_META_INDEX], index) && (USERS_record(index) == USERS_RECORD(code, distance)))
+			{
+				*bucket_Ptr = bucket;
+				*index_Ptr = index;
+				*distance_Ptr = distance;
+				return USERS_OK;
+			}
+		}
+
+		if(g_bucket[USERS_OVERFLOWS_INDEX] == 0xFF)
+			break;
+
+		bucket = (bucket + step) % USERS_BUCKETS;
+	}
+	return USERS_NOT_FOUND;
+}
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Check the header and count the codes from the meta bytes of the buckets. A damaged header copy
+ * is rewritten from the other one, a new header is written only over empty buckets. A table with
+ * content but no valid header or with more than USERS_MAX_COUNT codes is reported as USERS_ERROR,
+ * it is never cleared.
+ */
+uint8 USERS_init(void)
+{
+	uint8 page[USERS_BUCKET_SIZE];
+	uint8 header[USERS_HEADER_SIZE];
+	boolean valid[2];
+	boolean clean;
+	uint16 count;
+
+	if(EEPROM_readBlock(USERS_HEADER_ADDRESS, page, USERS_BUCKET_SIZE) != SUCCESS)
+		return USERS_ERROR;
+	if(USERS_countCodes(&count, &clean) != USERS_OK)
+		return USERS_ERROR;
+
+	valid[0] = USERS_isHeader(&page[0]);
+	valid[1] = USERS_isHeader(&page[USERS_HEADER_COPY_OFFSET]);
+	if((valid[0] == FALSE) && (valid[1] == FALSE) && (clean == FALSE))
+		return USERS_ERROR;
+	if(count > USERS_MAX_COUNT)
+		return USERS_ERROR;
+
+	/* A new memory gets both copies, a damaged copy is written again from the good one */
+	USERS_buildHeader(header);
+	if((valid[0] == FALSE) && (USERS_write(USERS_HEADER_ADDRESS, header, USERS_HEADER_SIZE) != USERS_OK))
+		return USERS_ERROR;
+	if((valid[1] == FALSE) &&
+	   (USERS_write(USERS_HEADER_ADDRESS + USERS_HEADER_COPY_OFFSET, header, USERS_HEADER_SIZE) != USERS_OK))
+		return USERS_ERROR;
+
+	g_usersCount = count;
+	return USERS_OK;
+}
+
+/*
+ * Description :
+ * Return the number of codes in the table
+ */
+uint16 USERS_count(void)
+{
+	return g_usersCount;
+}
+
+/*
+ * Description :
+ * Return the value of a code given as digits
+ */
+uint32 USERS_code(const uint8 *digits_Ptr, uint8 length)
+{
+	uint32 code = 0;
+	uint8 counter;
+
+	for(counter = 0; counter < length; counter++)
+	{
+		code = (code * 10) + digits_Ptr[counter];
+	}
+	return code;
+}
+
+/*
+ * Description :
+ * Look for the code, returns USERS_OK and its slot number if it is in the table
+ */
+uint8 USERS_find(uint32 code, uint16 *slot_Ptr)
+{
+	uint8 bucket;
+	uint8 index;
+	uint8 distance;
+	uint8 result;
+
+	result = USERS_probe(code, &bucket, &index, &distance);
+	if(result == USERS_OK)
+		*slot_Ptr = ((uint16)bucket * USERS_SLOTS_PER_BUCKET) + index;
+	return result;
+}
+
+/*
+ * Description :
+ * Store the code in a free slot, returns USERS_OK and the slot number,
+ * USERS_DUPLICATE if the code is already there or USERS_FULL.
+ */
+uint8 USERS_add(uint32 code, uint16 *slot_Ptr)
+{
+	uint8 bucket;
+	uint8 step = USERS_PROBE_STEP(code);
+	uint8 distance;
+	uint8 index;
+	uint8 result;
+	uint16 record;
+
+	result = USERS_probe(code, &bucket, &index, &distance);
+	if(result != USERS_NOT_FOUND)
+		return (result == USERS_OK) ? USERS_DUPLICATE : result;
+	if(g_usersCount >= USERS_MAX_COUNT)
+		return USERS_FULL;
+
+	bucket = USERS_HOME_BUCKET(code);
+	for(distance = 0; distance <= USERS_MAX_DISTANCE; distance++)
+	{
+		if(EEPROM_readBlock(USERS_BUCKET_ADDRESS(bucket), g_bucket, USERS_BUCKET_SIZE) != SUCCESS)
+			return USERS_ERROR;
+
+		for(index = 0; index < USERS_SLOTS_PER_BUCKET; index++)
+		{
+			if(BIT_IS_SET(g_bucket[USERS_META_INDEX], index))
+				break;
+		}
+
+		if(index < USERS_SLOTS_PER_BUCKET)
+		{
+			/* The lookups of the codes hashed to the full buckets before must go on to this one,
+			 * the counts go up first so a cut write leaves them too high, never too low */
+			if(USERS_updateOverflows(code, distance, 1) != USERS_OK)
+				return USERS_ERROR;
+
+			/* The record and its used flag go in one page write */
+			record = USERS_RECORD(code, distance);
+			g_bucket[index * USERS_RECORD_SIZE] = (uint8)record;
+			g_bucket[(index * USERS_RECORD_SIZE) + 1] = (uint8)(record >> 8);
+			CLEAR_BIT(g_bucket[USERS_META_INDEX], index);
+			if(USERS_write(USERS_BUCKET_ADDRESS(bucket), g_bucket, USERS_BUCKET_SIZE) != USERS_OK)
+				return USERS_ERROR;
+
+			g_usersCount++;
+			*slot_Ptr = ((uint16)bucket * USERS_SLOTS_PER_BUCKET) + index;
+			return USERS_OK;
+		}
+		bucket = (bucket + step) % USERS_BUCKETS;
+	}
+	return USERS_FULL;
+}
+
+/*
+ * Description :
+ * Free the slot of the code, returns USERS_OK and the freed slot number or USERS_NOT_FOUND
+ */
+uint8 USERS_remove(uint32 code, uint16 *slot_Ptr)
+{
+	uint8 bucket;
+	uint8 index;
+	uint8 distance;
+	uint8 result;
+
+	result = USERS_probe(code, &bucket, &index, &distance);
+	if(result != USERS_OK)
+		return result;
+
+	SET_BIT(g_bucket[USERS_META_INDEX], index);
+	if(USERS_write(USERS_BUCKET_ADDRESS(bucket) + USERS_META_INDEX, &g_bucket[USERS_META_INDEX], 1) != USERS_OK)
+		return USERS_ERROR;
+	g_usersCount--;
+	*slot_Ptr = ((uint16)bucket * USERS_SLOTS_PER_BUCKET) + index;
+
+	/* The buckets passed on the way no longer send this code on, a lookup ends again where no other code went past */
+	return USERS_updateOverflows(code, distance, -1);
+}
+
+/*
+ * Description :
+ * Copy up to max_slots used slot numbers from first_slot on, reading only the meta bytes.
+ * next_Ptr gets the slot to start the next call from, USERS_LIST_END after the last bucket.
+ */
+uint8 USERS_list(uint16 first_slot, uint16 *slots_Ptr, uint8 max_slots, uint8 *count_Ptr, uint16 *next_Ptr)
+{
+	uint8 bucket;
+	uint8 index;
+	uint8 meta;
+
+	*count_Ptr = 0;
+	*next_Ptr = USERS_LIST_END;
+	if(first_slot >= (USERS_BUCKETS * USERS_SLOTS_PER_BUCKET))
+		return USERS_OK;
+
+	bucket = first_slot / USERS_SLOTS_PER_BUCKET;
+	index = first_slot % USERS_SLOTS_PER_BUCKET;
+	for(; bucket < USERS_BUCKETS; bucket++)
+	{
+		if(EEPROM_readByte(USERS_BUCKET_ADDRESS(bucket) + USERS_META_INDEX, &meta) != SUCCESS)
+			return USERS_ERROR;
+
+		for(; index < USERS_SLOTS_PER_BUCKET; index++)
+		{
+			if(BIT_IS_SET(meta, index))
+				continue;
+
+			if(*count_Ptr == max_slots)
+			{
+				*next_Ptr = ((uint16)bucket * USERS_SLOTS_PER_BUCKET) + index;
+				return USERS_OK;
+			}
+			slots_Ptr[*count_Ptr] = ((uint16)bucket * USERS_SLOTS_PER_BUCKET) + index;
+			(*count_Ptr)++;
+		}
+		index = 0;
+	}
+	return USERS_OK;
+}
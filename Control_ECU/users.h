@@ -0,0 +1,129 @@
+/*
+ ================================================================================================
+ File Name: users.h
+ Name        : Door Locker Security System
+ Author      : Omar Muhammad
+ Description : Header file of the user codes table kept in the external EEPROM.
+               The table is a header page followed by USERS_BUCKETS bucket pages, a bucket is one
+               EEPROM page holding USERS_SLOTS_PER_BUCKET records, an overflow count and a meta byte:
+               | record 0 (2 bytes) | ... | record 6 (2 bytes) | overflows | meta |
+               meta bits 0..6 are set while the slot is free and the overflows byte is the complement
+               of the number of codes that went past the full bucket, so the erased memory (0xFF) is
+               an empty table. A code is stored in the first bucket with a free slot along its probe
+               sequence (double hashing on the code value) and a lookup stops at a bucket no code went
+               past, so it reads one page most of the time.
+               The home bucket is the code modulo USERS_BUCKETS, a record keeps the quotient and the
+               number of steps taken from the home bucket: | quotient (10 bits) | distance (6 bits) |.
+               The users count is not stored, it is counted from the meta bytes at the power up.
+ Date        : 17/10/2026
+ ================================================================================================
+ */
+
+#ifndef USERS_H_
+#define USERS_H_
+
+#include "MCAL/std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define USERS_MAX_COUNT                 500
+#define USERS_CODE_LIMIT                100000UL /* Codes of PASSWORD_SIZE digits */
+#define USERS_BUCKETS                   103  /* Prime so every probe step visits all the buckets, 69 % full at USERS_MAX_COUNT */
+#define USERS_SLOTS_PER_BUCKET          7
+#define USERS_RECORD_SIZE               2    /* Quotient and distance, LSB first */
+#define USERS_BUCKET_SIZE               16   /* One EEPROM page */
+#define USERS_OVERFLOWS_INDEX           14
+#define USERS_META_INDEX                15
+#define USERS_META_FREE_MASK            0x7F
+#define USERS_OVERFLOWS_SATURATED       0x00 /* Stored value once 255 codes went past, it never goes down again */
+
+/*Record*/
+#define USERS_QUOTIENT_BITS             10
+#define USERS_QUOTIENT_MASK             0x03FF
+#define USERS_MAX_DISTANCE              63   /* Probes past the home bucket, a longer sequence is a full table */
+#define USERS_RECORD(code, distance)    ((uint16)(((code) / USERS_BUCKETS) | ((uint16)(distance) << USERS_QUOTIENT_BITS)))
+
+/*Header page, two copies of | magic (2 bytes) | buckets | slots per bucket | CRC-8 | so a damaged one is rewritten from the other*/
+#define USERS_HEADER_ADDRESS            0x0000
+#define USERS_HEADER_COPY_OFFSET        8
+#define USERS_MAGIC_0                   'U'
+#define USERS_MAGIC_1                   'S'
+#define USERS_HEADER_SIZE               5
+#define USERS_HEADER_CRC_INDEX          4
+
+/*The buckets follow the header page and skip the page of the password saved by the older firmware (0x0310)*/
+#define USERS_RESERVED_PAGE             0x31
+#define USERS_BUCKET_PAGE(bucket)       ((bucket) + 1 + (((bucket) + 1) >= USERS_RESERVED_PAGE))
+#define USERS_BUCKET_ADDRESS(bucket)    ((uint16)USERS_BUCKET_PAGE(bucket) * USERS_BUCKET_SIZE)
+#define USERS_END_ADDRESS               USERS_BUCKET_ADDRESS(USERS_BUCKETS) /* First byte after the table */
+
+/*Probe sequence of a code: home bucket then steps of USERS_PROBE_STEP buckets*/
+#define USERS_HOME_BUCKET(code)         ((uint8)((code) % USERS_BUCKETS))
+#define USERS_PROBE_STEP(code)          ((uint8)(1 + (((code) / USERS_BUCKETS) % (USERS_BUCKETS - 1))))
+
+#if (((USERS_CODE_LIMIT - 1) / USERS_BUCKETS) > USERS_QUOTIENT_MASK)
+#error "The quotient of a code by USERS_BUCKETS should fit in USERS_QUOTIENT_BITS"
+#endif
+
+/*Results, sent as they are in MSG_USER_RESULT (see protocol.h)*/
+#define USERS_OK                        0
+#define USERS_NOT_FOUND                 1
+#define USERS_DUPLICATE                 2
+#define USERS_FULL                      3
+#define USERS_ERROR                     4    /* The EEPROM access failed or the table is damaged */
+
+#define USERS_LIST_END                  0xFFFF
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Check the header and count the codes from the meta bytes of the buckets. A damaged header copy
+ * is rewritten from the other one, a new header is written only over empty buckets. A table with
+ * content but no valid header or with more than USERS_MAX_COUNT codes is reported as USERS_ERROR,
+ * it is never cleared.
+ */
+uint8 USERS_init(void);
+
+/*
+ * Description :
+ * Return the number of codes in the table
+ */
+uint16 USERS_count(void);
+
+/*
+ * Description :
+ * Return the value of a code given as digits
+ */
+uint32 USERS_code(const uint8 *digits_Ptr, uint8 length);
+
+/*
+ * Description :
+ * Look for the code, returns USERS_OK and its slot number if it is in the table
+ */
+uint8 USERS_find(uint32 code, uint16 *slot_Ptr);
+
+/*
+ * Description :
+ * Store the code in a free slot, returns USERS_OK and the slot number,
+ * USERS_DUPLICATE if the code is already there or USERS_FULL.
+ */
+uint8 USERS_add(uint32 code, uint16 *slot_Ptr);
+
+/*
+ * Description :
+ * Free the slot of the code, returns USERS_OK and the freed slot number or USERS_NOT_FOUND
+ */
+uint8 USERS_remove(uint32 code, uint16 *slot_Ptr);
+
+/*
+ * Description :
+ * Copy up to max_slots used slot numbers from first_slot on, reading only the meta bytes.
+ * next_Ptr gets the slot to start the next call from, USERS_LIST_END after the last bucket.
+ */
+uint8 USERS_list(uint16 first_slot, uint16 *slots_Ptr, uint8 max_slots, uint8 *count_Ptr, uint16 *next_Ptr);
+
+#endif /* USERS_H_ */
@@ -4,13 +4,19 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
-../app.c 
+../app.c \
+../protocol.c \
+../scheduler.c 
 
 OBJS += \
-./app.o 
+./app.o \
+./protocol.o \
+./scheduler.o 
 
 C_DEPS += \
-./app.d 
+./app.d \
+./protocol.d \
+./scheduler.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -1,169 +1,302 @@
- /******************************************************************************
- *
- * Module: KEYPAD
- *
- * File Name: keypad.c
- *
- * Description: Source file for the Keypad driver
- *
- * Author: Mohamed Tarek
- *
- *******************************************************************************/
-#include "keypad.h"
-#include "../MCAL/gpio.h"
-#include <util/delay.h>
-
-/*******************************************************************************
- *                      Functions Prototypes(Private)                          *
- *******************************************************************************/
-
-#ifndef STANDARD_KEYPAD
-
-#if (KEYPAD_NUM_COLS == 3)
-/*
- * Function responsible for mapping the switch number in the keypad to
- * its corresponding functional number in the proteus for 4x3 keypad
- */
-static uint8 KEYPAD_4x3_adjustKeyNumber(uint8 button_number);
-#elif (KEYPAD_NUM_COLS == 4)
-/*
- * Function responsible for mapping the switch number in the keypad to
- * its corresponding functional number in the proteus for 4x4 keypad
- */
-static uint8 KEYPAD_4x4_adjustKeyNumber(uint8 button_number);
-#endif
-
-#endif /* STANDARD_KEYPAD */
-
-/*******************************************************************************
- *                      Functions Definitions                                  *
- *******************************************************************************/
-
-uint8 KEYPAD_getPressedKey(void)
-{
-	uint8 col,row;
-	GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID, PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+1, PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+2, PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+3, PIN_INPUT);
-
-	GPIO_setupPinDirection(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID, PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID+1, PIN_INPUT);
-	GPIO_setupPinDirection(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID+2, PIN_INPUT);
-#if(KEYPAD_NUM_COLS == 4)
-	GPIO_setupPinDirection(KEYPAD_COL_PORT_ID, KEYPAD_FIRST_COL_PIN_ID+3, PIN_INPUT);
-#endif
-	while(1)
-	{
-		for(row=0 ; row<KEYPAD_NUM_ROWS ; row++) /* loop for rows */
-		{
-			/* 
-			 * Each time setup the direction for all keypad port as input pins,
-			 * except this row will be output pin
-			 */
-			GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID,KEYPAD_FIRST_ROW_PIN_ID+row,PIN_OUTPUT);
-
-			/* Set/Clear the row output pin */
-			GPIO_writePin(KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID+row, KEYPAD_BUTTON_PRESSED);
-
-			for(col=0 ; col<KEYPAD_NUM_COLS ; col++) /* loop for columns */
-			{
-				/* Check if the switch is pressed in this column */
-				if(GPIO_readPin(KEYPAD_COL_PORT_ID,KEYPAD_FIRST_COL_PIN_ID+col) == KEYPAD_BUTTON_PRESSED)
-				{
-					#if (KEYPAD_NUM_COLS == 3)
-						#ifdef STANDARD_KEYPAD
-							return ((row*KEYPAD_NUM_COLS)+col+1);
-						#else
-							return KEYPAD_4x3_adjustKeyNumber((row*KEYPAD_NUM_COLS)+col+1);
-						#endif
-					#elif (KEYPAD_NUM_COLS == 4)
-						#ifdef STANDARD_KEYPAD
-							return ((row*KEYPAD_NUM_COLS)+col+1);
-						#else
-							return KEYPAD_4x4_adjustKeyNumber((row*KEYPAD_NUM_COLS)+col+1);
-						#endif
-					#endif
-				}
-			}
-			GPIO_setupPinDirection(KEYPAD_ROW_PORT_ID,KEYPAD_FIRST_ROW_PIN_ID+row,PIN_INPUT);
-		}
-	}	
-}
-
-#ifndef STANDARD_KEYPAD
-
-#if (KEYPAD_NUM_COLS == 3)
-/*
- * Description :
- * Update the keypad pressed button value with the correct one in keypad 4x3 shape
- */
-static uint8 KEYPAD_4x3_adjustKeyNumber(uint8 button_number)
-{
-	uint8 keypad_button = 0;
-	switch(button_number)
-	{
-		case 10: keypad_button = '*'; // ASCII Code of *
-				 break;
-		case 11: keypad_button = 0;
-				 break;		
-		case 12: keypad_button = '#'; // ASCII Code of #
-				 break;
-		default: keypad_button = button_number;
-				break;
-	}
-	return keypad_button;
-} 
-
-#elif (KEYPAD_NUM_COLS == 4)
-
-/*
- * Description :
- * Update the keypad pressed button value with the correct one in keypad 4x4 shape
- */
-static uint8 KEYPAD_4x4_adjustKeyNumber(uint8 button_number)
-{
-	uint8 keypad_button = 0;
-	switch(button_number)
-	{
-		case 1: keypad_button = 7;
-				break;
-		case 2: keypad_button = 8;
-				break;
-		case 3: keypad_button = 9;
-				break;
-		case 4: keypad_button = '%'; // ASCII Code of %
-				break;
-		case 5: keypad_button = 4;
-				break;
-		case 6: keypad_button = 5;
-				break;
-		case 7: keypad_button = 6;
-				break;
-		case 8: keypad_button = '*'; /* ASCII Code of '*' */
-				break;		
-		case 9: keypad_button = 1;
-				break;
-		case 10: keypad_button = 2;
-				break;
-		case 11: keypad_button = 3;
-				break;
-		case 12: keypad_button = '-'; /* ASCII Code of '-' */
-				break;
-		case 13: keypad_button = 13;  /* ASCII of Enter */
-				break;			
-		case 14: keypad_button = 0;
-				break;
-		case 15: keypad_button = '='; /* ASCII Code of '=' */
-				break;
-		case 16: keypad_button = '+'; /* ASCII Code of '+' */
-				break;
-		default: keypad_button = button_number;
-				break;
-	}
-	return keypad_button;
-} 
-
-#endif
-
-#endif /* STANDARD_KEYPAD */
+ /******************************************************************************
+ *
+ * Module: KEYPAD
+ *
+ * File Name: keypad.c
+ *
+ * Description: Source file for the Keypad driver
+ *
+ * Author: Mohamed Tarek
+ *
+ *******************************************************************************/
+#include "keypad.h"
+#include "../MCAL/gpio.h"
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Registers of the keypad ports, the whole matrix is scanned with one access per row */
+#if (KEYPAD_ROW_PORT_ID == PORTA_ID)
+#define KEYPAD_ROW_DDR                    DDRA
+#define KEYPAD_ROW_PORT                   PORTA
+#elif (KEYPAD_ROW_PORT_ID == PORTB_ID)
+#define KEYPAD_ROW_DDR                    DDRB
+#define KEYPAD_ROW_PORT                   PORTB
+#elif (KEYPAD_ROW_PORT_ID == PORTC_ID)
+#define KEYPAD_ROW_DDR                    DDRC
+#define KEYPAD_ROW_PORT                   PORTC
+#elif (KEYPAD_ROW_PORT_ID == PORTD_ID)
+#define KEYPAD_ROW_DDR                    DDRD
+#define KEYPAD_ROW_PORT                   PORTD
+#endif
+
+#if (KEYPAD_COL_PORT_ID == PORTA_ID)
+#define KEYPAD_COL_DDR                    DDRA
+#define KEYPAD_COL_PIN                    PINA
+#elif (KEYPAD_COL_PORT_ID == PORTB_ID)
+#define KEYPAD_COL_DDR                    DDRB
+#define KEYPAD_COL_PIN                    PINB
+#elif (KEYPAD_COL_PORT_ID == PORTC_ID)
+#define KEYPAD_COL_DDR                    DDRC
+#define KEYPAD_COL_PIN                    PINC
+#elif (KEYPAD_COL_PORT_ID == PORTD_ID)
+#define KEYPAD_COL_DDR                    DDRD
+#define KEYPAD_COL_PIN                    PIND
+#endif
+
+/* Pins of the rows and the columns in their ports */
+#define KEYPAD_ROWS_MASK                  ((uint8)(((1u << KEYPAD_NUM_ROWS) - 1) << KEYPAD_FIRST_ROW_PIN_ID))
+#define KEYPAD_COLS_MASK                  ((uint8)(((1u << KEYPAD_NUM_COLS) - 1) << KEYPAD_FIRST_COL_PIN_ID))
+
+#if ((KEYPAD_FIRST_ROW_PIN_ID + KEYPAD_NUM_ROWS) > NUM_OF_PINS_PER_PORT) || \
+    ((KEYPAD_FIRST_COL_PIN_ID + KEYPAD_NUM_COLS) > NUM_OF_PINS_PER_PORT)
+#error "The keypad rows and columns should fit in their ports"
+#endif
+
+#if (KEYPAD_ROW_PORT_ID == KEYPAD_COL_PORT_ID) && \
+    ((KEYPAD_FIRST_ROW_PIN_ID + KEYPAD_NUM_ROWS) > KEYPAD_FIRST_COL_PIN_ID) && \
+    ((KEYPAD_FIRST_COL_PIN_ID + KEYPAD_NUM_COLS) > KEYPAD_FIRST_ROW_PIN_ID)
+#error "The keypad rows and columns should not share pins"
+#endif
+
+/* Columns of the port value that read a pressed button, as set bits */
+#if (KEYPAD_BUTTON_PRESSED == LOGIC_LOW)
+#define KEYPAD_PRESSED_COLS(value)        ((uint8)(~(value)) & KEYPAD_COLS_MASK)
+#else
+#define KEYPAD_PRESSED_COLS(value)        ((uint8)(value) & KEYPAD_COLS_MASK)
+#endif
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Return the value of the button with the given number, counted row by row from 0
+ */
+static uint8 KEYPAD_buttonValue(uint8 button);
+
+/*
+ * Description :
+ * Add an event to the queue, the event is dropped if the queue is full
+ */
+static void KEYPAD_pushEvent(uint8 key, KEYPAD_EventState state);
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+#ifndef STANDARD_KEYPAD
+/* Value of every button, row by row, as its corresponding functional number in the proteus */
+static const uint8 g_keypadButtons[KEYPAD_NUM_ROWS * KEYPAD_NUM_COLS] PROGMEM =
+{
+#if (KEYPAD_NUM_COLS == 3)
+	1,   2,   3,
+	4,   5,   6,
+	7,   8,   9,
+	'*', 0,   '#'          /* ASCII Code of '*' and '#' */
+#elif (KEYPAD_NUM_COLS == 4)
+	7,   8,   9,   '%',
+	4,   5,   6,   '*',
+	1,   2,   3,   '-',
+	13,  0,   '=', '+'     /* ASCII of Enter, '=' and '+' */
+#endif
+};
+#endif /* STANDARD_KEYPAD */
+
+/* Integrator of every button: counts up while it reads pressed and down while it reads released */
+static uint8 g_keypadIntegrator[KEYPAD_NUM_ROWS * KEYPAD_NUM_COLS];
+
+/* Debounced state of every button, one bit per button set while it is pressed */
+static uint16 g_keypadPressed = 0;
+
+/* Buttons whose integrator is between its limits, one bit per button */
+static uint16 g_keypadSettling = 0;
+
+/* Events written by KEYPAD_scan and read by KEYPAD_getEvent */
+static volatile KEYPAD_EventType g_keypadEvents[KEYPAD_EVENT_QUEUE_SIZE];
+static volatile uint8 g_keypadEventsHead = 0;
+static volatile uint8 g_keypadEventsTail = 0;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Setup the keypad pins as inputs and clear the debounce state and the events queue
+ */
+void KEYPAD_init(void)
+{
+	uint8 button;
+
+	/* The rows are driven by their DDR bits only, their PORT bits stay at the pressed level */
+	KEYPAD_ROW_DDR &= (uint8)~KEYPAD_ROWS_MASK;
+#if (KEYPAD_BUTTON_PRESSED == LOGIC_LOW)
+	KEYPAD_ROW_PORT &= (uint8)~KEYPAD_ROWS_MASK;
+#else
+	KEYPAD_ROW_PORT |= KEYPAD_ROWS_MASK;
+#endif
+	KEYPAD_COL_DDR &= (uint8)~KEYPAD_COLS_MASK;
+
+	for(button = 0; button < (KEYPAD_NUM_ROWS * KEYPAD_NUM_COLS); button++)
+	{
+		g_keypadIntegrator[button] = 0;
+	}
+	g_keypadPressed = 0;
+	g_keypadSettling = 0;
+	g_keypadEventsHead = 0;
+	g_keypadEventsTail = 0;
+}
+
+/*
+ * Description :
+ * Scan the whole keypad once and debounce every button, a button that changes its state
+ * adds a press or release event to the queue. To be called every KEYPAD_SCAN_PERIOD_MS,
+ * it can be called from an ISR.
+ * Every row costs one DDR write and one PIN read, then only the buttons that read different
+ * from their debounced state or are still settling go through their integrators.
+ */
+void KEYPAD_scan(void)
+{
+	uint8 row;
+	uint8 button;
+	uint8 ddr = KEYPAD_ROW_DDR & (uint8)~KEYPAD_ROWS_MASK;
+	uint16 sample = 0;
+	uint16 changing;
+	uint16 buttonMask;
+
+	for(row=0 ; row<KEYPAD_NUM_ROWS ; row++) /* loop for rows */
+	{
+		/* Only this row is an output pin, it drives its pressed level to the columns */
+		KEYPAD_ROW_DDR = ddr | (uint8)(1u << (KEYPAD_FIRST_ROW_PIN_ID + row));
+
+		/* Give the input synchronizer one cycle before reading the columns */
+		__asm__ __volatile__ ("nop");
+
+		sample |= (uint16)(KEYPAD_PRESSED_COLS(KEYPAD_COL_PIN) >> KEYPAD_FIRST_COL_PIN_ID) << (row * KEYPAD_NUM_COLS);
+	}
+	KEYPAD_ROW_DDR = ddr;
+
+	/* Integrate the readings of the buttons, the state changes only at the limits */
+	changing = (sample ^ g_keypadPressed) | g_keypadSettling;
+	for(button = 0, buttonMask = 1 ; changing != 0 ; button++, buttonMask <<= 1)
+	{
+		if(!(changing & buttonMask))
+		{
+			continue;
+		}
+		changing &= ~buttonMask;
+
+		if(sample & buttonMask)
+		{
+			if(g_keypadIntegrator[button] < KEYPAD_DEBOUNCE_SAMPLES)
+			{
+				g_keypadIntegrator[button]++;
+			}
+			if((g_keypadIntegrator[button] == KEYPAD_DEBOUNCE_SAMPLES) && !(g_keypadPressed & buttonMask))
+			{
+				g_keypadPressed |= buttonMask;
+				KEYPAD_pushEvent(KEYPAD_buttonValue(button), KEYPAD_PRESS);
+			}
+		}
+		else
+		{
+			if(g_keypadIntegrator[button] > 0)
+			{
+				g_keypadIntegrator[button]--;
+			}
+			if((g_keypadIntegrator[button] == 0) && (g_keypadPressed & buttonMask))
+			{
+				g_keypadPressed &= ~buttonMask;
+				KEYPAD_pushEvent(KEYPAD_buttonValue(button), KEYPAD_RELEASE);
+			}
+		}
+
+		if((g_keypadIntegrator[button] == 0) || (g_keypadIntegrator[button] == KEYPAD_DEBOUNCE_SAMPLES))
+		{
+			g_keypadSettling &= ~buttonMask;
+		}
+		else
+		{
+			g_keypadSettling |= buttonMask;
+		}
+	}
+}
+
+/*
+ * Description :
+ * Get the oldest press or release event without waiting.
+ * Returns FALSE if there is no event.
+ */
+boolean KEYPAD_getEvent(KEYPAD_EventType *event_Ptr)
+{
+	uint8 head = g_keypadEventsHead;
+
+	if(head == g_keypadEventsTail)
+	{
+		return FALSE;
+	}
+	event_Ptr->key = g_keypadEvents[head].key;
+	event_Ptr->state = g_keypadEvents[head].state;
+	g_keypadEventsHead = (head + 1) & (KEYPAD_EVENT_QUEUE_SIZE - 1);
+
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Drop the events that are not read yet
+ */
+void KEYPAD_clearEvents(void)
+{
+	g_keypadEventsHead = g_keypadEventsTail;
+}
+
+/*
+ * Description :
+ * Wait for the next key press event and return the pressed button
+ */
+uint8 KEYPAD_getPressedKey(void)
+{
+	KEYPAD_EventType event;
+
+	do
+	{
+		while(KEYPAD_getEvent(&event) == FALSE){}
+	}while(event.state != KEYPAD_PRESS);
+
+	return event.key;
+}
+
+/*
+ * Description :
+ * Return the value of the button with the given number, counted row by row from 0
+ */
+static uint8 KEYPAD_buttonValue(uint8 button)
+{
+	#ifdef STANDARD_KEYPAD
+		return (button+1);
+	#else
+		return pgm_read_byte(&g_keypadButtons[button]);
+	#endif
+}
+
+/*
+ * Description :
+ * Add an event to the queue, the event is dropped if the queue is full
+ */
+static void KEYPAD_pushEvent(uint8 key, KEYPAD_EventState state)
+{
+	uint8 tail = g_keypadEventsTail;
+	uint8 next = (tail + 1) & (KEYPAD_EVENT_QUEUE_SIZE - 1);
+
+	if(next != g_keypadEventsHead)
+	{
+		g_keypadEvents[tail].key = key;
+		g_keypadEvents[tail].state = state;
+		g_keypadEventsTail = next;
+	}
+}
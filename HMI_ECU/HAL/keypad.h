@@ -1,50 +1,103 @@
- /******************************************************************************
- *
- * Module: KEYPAD
- *
- * File Name: keypad.h
- *
- * Description: Header file for the Keypad driver
- *
- * Author: Mohamed Tarek
- *
- *******************************************************************************/
-
-#ifndef KEYPAD_H_
-#define KEYPAD_H_
-
-#include "../MCAL/std_types.h"
-
-/*******************************************************************************
- *                                Definitions                                  *
- *******************************************************************************/
-
-/* Use Standard keypad type */
-/*#define STANDARD_KEYPAD*/
-
-/* Keypad configurations for number of rows and columns */
-#define KEYPAD_NUM_COLS                   4
-#define KEYPAD_NUM_ROWS                   4
-
-/* Keypad Port Configurations */
-#define KEYPAD_ROW_PORT_ID                PORTB_ID
-#define KEYPAD_FIRST_ROW_PIN_ID           PIN0_ID
-
-#define KEYPAD_COL_PORT_ID                PORTB_ID
-#define KEYPAD_FIRST_COL_PIN_ID           PIN4_ID
-
-/* Keypad button logic configurations */
-#define KEYPAD_BUTTON_PRESSED            LOGIC_LOW
-#define KEYPAD_BUTTON_RELEASED           LOGIC_HIGH
-
-/*******************************************************************************
- *                      Functions Prototypes                                   *
- *******************************************************************************/
-
-/*
- * Description :
- * Get the Keypad pressed button
- */
-uint8 KEYPAD_getPressedKey(void);
-
-#endif /* KEYPAD_H_ */
+ /******************************************************************************
+ *
+ * Module: KEYPAD
+ *
+ * File Name: keypad.h
+ *
+ * Description: Header file for the Keypad driver
+ *
+ * Author: Mohamed Tarek
+ *
+ *******************************************************************************/
+
+#ifndef KEYPAD_H_
+#define KEYPAD_H_
+
+#include "../MCAL/std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* Use Standard keypad type */
+/*#define STANDARD_KEYPAD*/
+
+/* Keypad configurations for number of rows and columns */
+#define KEYPAD_NUM_COLS                   4
+#define KEYPAD_NUM_ROWS                   4
+
+/* Keypad Port Configurations */
+#define KEYPAD_ROW_PORT_ID                PORTB_ID
+#define KEYPAD_FIRST_ROW_PIN_ID           PIN0_ID
+
+#define KEYPAD_COL_PORT_ID                PORTB_ID
+#define KEYPAD_FIRST_COL_PIN_ID           PIN4_ID
+
+/* Keypad button logic configurations */
+#define KEYPAD_BUTTON_PRESSED            LOGIC_LOW
+#define KEYPAD_BUTTON_RELEASED           LOGIC_HIGH
+
+/*
+ * KEYPAD_scan is called every KEYPAD_SCAN_PERIOD_MS, a button changes its state after
+ * KEYPAD_DEBOUNCE_SAMPLES scans agree (10 ms) so the contact bounce is filtered out.
+ */
+#define KEYPAD_SCAN_PERIOD_MS             2
+#define KEYPAD_DEBOUNCE_SAMPLES           5
+
+/* Number of press and release events kept until they are read, should be a power of 2 */
+#define KEYPAD_EVENT_QUEUE_SIZE           8
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef enum
+{
+	KEYPAD_PRESS, KEYPAD_RELEASE
+}KEYPAD_EventState;
+
+typedef struct
+{
+	uint8 key;                /* the button value as returned by KEYPAD_getPressedKey */
+	KEYPAD_EventState state;
+}KEYPAD_EventType;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Setup the keypad pins as inputs and clear the debounce state and the events queue
+ */
+void KEYPAD_init(void);
+
+/*
+ * Description :
+ * Scan the whole keypad once and debounce every button, a button that changes its state
+ * adds a press or release event to the queue. To be called every KEYPAD_SCAN_PERIOD_MS,
+ * it can be called from an ISR.
+ * Every row costs one DDR write and one PIN read, then only the buttons that read different
+ * from their debounced state or are still settling go through their integrators.
+ */
+void KEYPAD_scan(void);
+
+/*
+ * Description :
+ * Get the oldest press or release event without waiting.
+ * Returns FALSE if there is no event.
+ */
+boolean KEYPAD_getEvent(KEYPAD_EventType *event_Ptr);
+
+/*
+ * Description :
+ * Drop the events that are not read yet
+ */
+void KEYPAD_clearEvents(void);
+
+/*
+ * Description :
+ * Wait for the next key press event and return the pressed button
+ */
+uint8 KEYPAD_getPressedKey(void);
+
+#endif /* KEYPAD_H_ */
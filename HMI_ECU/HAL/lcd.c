@@ -1,220 +1,536 @@
- /******************************************************************************
- *
- * Module: LCD
- *
- * File Name: lcd.c
- *
- * Description: Source file for the LCD driver
- *
- * Author: Mohamed Tarek
- *
- *******************************************************************************/
-
-#include <util/delay.h> /* For the delay functions */
-#include "../MCAL/common_macros.h" /* For GET_BIT Macro */
-#include "lcd.h"
-#include "../MCAL/gpio.h"
-
-/*******************************************************************************
- *                      Functions Definitions                                  *
- *******************************************************************************/
-
-/*
- * Description :
- * Initialize the LCD:
- * 1. Setup the LCD pins directions by use the GPIO driver.
- * 2. Setup the LCD Data Mode 4-bits or 8-bits.
- */
-void LCD_init(void)
-{
-	/* Configure the direction for RS and E pins as output pins */
-	GPIO_setupPinDirection(LCD_RS_PORT_ID,LCD_RS_PIN_ID,PIN_OUTPUT);
-	GPIO_setupPinDirection(LCD_E_PORT_ID,LCD_E_PIN_ID,PIN_OUTPUT);
-
-	_delay_ms(20);		/* LCD Power ON delay always > 15ms */
-
-#if(LCD_DATA_BITS_MODE == 4)
-	/* Configure 4 pins in the data port as output pins */
-	GPIO_setupPinDirection(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,PIN_OUTPUT);
-	GPIO_setupPinDirection(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,PIN_OUTPUT);
-	GPIO_setupPinDirection(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,PIN_OUTPUT);
-	GPIO_setupPinDirection(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,PIN_OUTPUT);
-
-	/* Send for 4 bit initialization of LCD  */
-	LCD_sendCommand(LCD_TWO_LINES_FOUR_BITS_MODE_INIT1);
-	LCD_sendCommand(LCD_TWO_LINES_FOUR_BITS_MODE_INIT2);
-
-	/* use 2-lines LCD + 4-bits Data Mode + 5*7 dot display Mode */
-	LCD_sendCommand(LCD_TWO_LINES_FOUR_BITS_MODE);
-
-#elif(LCD_DATA_BITS_MODE == 8)
-	/* Configure the data port as output port */
-	GPIO_setupPortDirection(LCD_DATA_PORT_ID,PORT_OUTPUT);
-
-	/* use 2-lines LCD + 8-bits Data Mode + 5*7 dot display Mode */
-	LCD_sendCommand(LCD_TWO_LINES_EIGHT_BITS_MODE);
-
-#endif
-
-	LCD_sendCommand(LCD_CURSOR_OFF); /* cursor off */
-	LCD_sendCommand(LCD_CLEAR_COMMAND); /* clear LCD at the beginning */
-}
-
-/*
- * Description :
- * Send the required command to the screen
- */
-void LCD_sendCommand(uint8 command)
-{
-	GPIO_writePin(LCD_RS_PORT_ID,LCD_RS_PIN_ID,LOGIC_LOW); /* Instruction Mode RS=0 */
-	_delay_ms(1); /* delay for processing Tas = 50ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E=1 */
-	_delay_ms(1); /* delay for processing Tpw - Tdws = 190ns */
-
-#if(LCD_DATA_BITS_MODE == 4)
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,GET_BIT(command,4));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,GET_BIT(command,5));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,GET_BIT(command,6));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,GET_BIT(command,7));
-
-	_delay_ms(1); /* delay for processing Tdsw = 100ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
-	_delay_ms(1); /* delay for processing Th = 13ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E=1 */
-	_delay_ms(1); /* delay for processing Tpw - Tdws = 190ns */
-
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,GET_BIT(command,0));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,GET_BIT(command,1));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,GET_BIT(command,2));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,GET_BIT(command,3));
-
-	_delay_ms(1); /* delay for processing Tdsw = 100ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
-	_delay_ms(1); /* delay for processing Th = 13ns */
-
-#elif(LCD_DATA_BITS_MODE == 8)
-	GPIO_writePort(LCD_DATA_PORT_ID,command); /* out the required command to the data bus D0 --> D7 */
-	_delay_ms(1); /* delay for processing Tdsw = 100ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
-	_delay_ms(1); /* delay for processing Th = 13ns */
-#endif
-}
-
-/*
- * Description :
- * Display the required character on the screen
- */
-void LCD_displayCharacter(uint8 data)
-{
-	GPIO_writePin(LCD_RS_PORT_ID,LCD_RS_PIN_ID,LOGIC_HIGH); /* Data Mode RS=1 */
-	_delay_ms(1); /* delay for processing Tas = 50ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E=1 */
-	_delay_ms(1); /* delay for processing Tpw - Tdws = 190ns */
-
-#if(LCD_DATA_BITS_MODE == 4)
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,GET_BIT(data,4));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,GET_BIT(data,5));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,GET_BIT(data,6));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,GET_BIT(data,7));
-
-	_delay_ms(1); /* delay for processing Tdsw = 100ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
-	_delay_ms(1); /* delay for processing Th = 13ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E=1 */
-	_delay_ms(1); /* delay for processing Tpw - Tdws = 190ns */
-
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,GET_BIT(data,0));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,GET_BIT(data,1));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,GET_BIT(data,2));
-	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,GET_BIT(data,3));
-
-	_delay_ms(1); /* delay for processing Tdsw = 100ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
-	_delay_ms(1); /* delay for processing Th = 13ns */
-
-#elif(LCD_DATA_BITS_MODE == 8)
-	GPIO_writePort(LCD_DATA_PORT_ID,data); /* out the required command to the data bus D0 --> D7 */
-	_delay_ms(1); /* delay for processing Tdsw = 100ns */
-	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
-	_delay_ms(1); /* delay for processing Th = 13ns */
-#endif
-}
-
-/*
- * Description :
- * Display the required string on the screen
- */
-void LCD_displayString(const char *Str)
-{
-	uint8 i = 0;
-	while(Str[i] != '\0')
-	{
-		LCD_displayCharacter(Str[i]);
-		i++;
-	}
-	/***************** Another Method ***********************
-	while((*Str) != '\0')
-	{
-		LCD_displayCharacter(*Str);
-		Str++;
-	}		
-	*********************************************************/
-}
-
-/*
- * Description :
- * Move the cursor to a specified row and column index on the screen
- */
-void LCD_moveCursor(uint8 row,uint8 col)
-{
-	uint8 lcd_memory_address;
-	
-	/* Calculate the required address in the LCD DDRAM */
-	switch(row)
-	{
-		case 0:
-			lcd_memory_address=col;
-				break;
-		case 1:
-			lcd_memory_address=col+0x40;
-				break;
-		case 2:
-			lcd_memory_address=col+0x10;
-				break;
-		case 3:
-			lcd_memory_address=col+0x50;
-				break;
-	}					
-	/* Move the LCD cursor to this specific address */
-	LCD_sendCommand(lcd_memory_address | LCD_SET_CURSOR_LOCATION);
-}
-
-/*
- * Description :
- * Display the required string in a specified row and column index on the screen
- */
-void LCD_displayStringRowColumn(uint8 row,uint8 col,const char *Str)
-{
-	LCD_moveCursor(row,col); /* go to to the required LCD position */
-	LCD_displayString(Str); /* display the string */
-}
-
-/*
- * Description :
- * Display the required decimal value on the screen
- */
-void LCD_intgerToString(int data)
-{
-   char buff[16]; /* String to hold the ascii result */
-   itoa(data,buff,10); /* Use itoa C function to convert the data to its corresponding ASCII value, 10 for decimal */
-   LCD_displayString(buff); /* Display the string */
-}
-
-/*
- * Description :
- * Send the clear screen command
- */
-void LCD_clearScreen(void)
-{
-	LCD_sendCommand(LCD_CLEAR_COMMAND); /* Send clear display command */
-}
+ /******************************************************************************
+ *
+ * Module: LCD
+ *
+ * File Name: lcd.c
+ *
+ * Description: Source file for the LCD driver
+ *
+ * Author: Mohamed Tarek
+ *
+ *******************************************************************************/
+
+#include <util/delay.h> /* For the delay functions */
+#include <avr/io.h> /* For the I-bit in SREG */
+#include "../MCAL/common_macros.h" /* For GET_BIT Macro */
+#include "lcd.h"
+#include "../MCAL/gpio.h"
+#include "../MCAL/timer.h"
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+
+#if(LCD_RW_CONNECTED == 1)
+/*
+ * Description :
+ * Read the busy flag of the LCD, returns LOGIC_HIGH while the last instruction is executed.
+ */
+static uint8 LCD_readBusyFlag(void);
+#endif
+
+#if(LCD_DATA_BITS_MODE == 4)
+/*
+ * Description :
+ * Write the low 4 bits of the given value on DB4..DB7 with one E pulse.
+ */
+static void LCD_writeNibble(uint8 nibble);
+#endif
+
+/*
+ * Description :
+ * Add one instruction (RS=0) or one data byte (RS=1) to the queue sent by the Timer2 tick.
+ */
+static void LCD_enqueue(uint8 rs, uint8 value);
+
+/*
+ * Description :
+ * Timer2 call back, send the next part of the instruction at the head of the queue.
+ */
+static void LCD_tick(void);
+
+/*
+ * Description :
+ * Keep the shadow buffer and the cursor address in step with a character written to the DDRAM.
+ */
+static void LCD_storeCharacter(uint8 data);
+
+/*******************************************************************************
+ *                           Global variables                                  *
+ *******************************************************************************/
+
+/* What the screen shows and what it should show after the next LCD_flush */
+static uint8 g_lcdScreen[LCD_ROWS][LCD_COLUMNS];
+static uint8 g_lcdBuffer[LCD_ROWS][LCD_COLUMNS];
+
+/* DDRAM address of the LCD cursor, LCD_ADDRESS_UNKNOWN after a shift or a CGRAM access */
+#define LCD_ADDRESS_UNKNOWN 0xFF
+static uint8 g_lcdAddress = LCD_ADDRESS_UNKNOWN;
+
+static const uint8 g_lcdRowAddress[4] = {LCD_ROW0_ADDRESS,LCD_ROW1_ADDRESS,LCD_ROW2_ADDRESS,LCD_ROW3_ADDRESS};
+
+/* Instructions and characters waiting to be sent, written by the application and read by the tick */
+static volatile uint8 g_lcdQueueValue[LCD_QUEUE_SIZE];
+static volatile uint8 g_lcdQueueRs[LCD_QUEUE_SIZE];
+static volatile uint8 g_lcdQueueHead = 0;
+static volatile uint8 g_lcdQueueTail = 0;
+
+static volatile boolean g_lcdTickRunning = FALSE;
+#if(LCD_DATA_BITS_MODE == 4)
+static boolean g_lcdLowNibblePending = FALSE; /* the high nibble of the head entry is sent */
+#endif
+#if(LCD_RW_CONNECTED == 0)
+static uint8 g_lcdWaitTicks = 0; /* ticks left until the clear or home instruction is executed */
+#endif
+
+static const Timer2_ConfigType g_lcdTickConfig = {0, LCD_TICK_COMPARE_VALUE, TIMER2_F_CPU_8};
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Initialize the LCD:
+ * 1. Setup the LCD pins directions by use the GPIO driver.
+ * 2. Setup the LCD Data Mode 4-bits or 8-bits.
+ * 3. Queue the display setup, it is sent by the Timer2 tick once the interrupts are enabled.
+ */
+void LCD_init(void)
+{
+	g_lcdQueueHead = 0;
+	g_lcdQueueTail = 0;
+	g_lcdTickRunning = FALSE;
+	Timer2_setCallBack(LCD_tick);
+
+	/* Configure the direction for RS and E pins as output pins */
+	GPIO_setupPinDirection(LCD_RS_PORT_ID,LCD_RS_PIN_ID,PIN_OUTPUT);
+	GPIO_setupPinDirection(LCD_E_PORT_ID,LCD_E_PIN_ID,PIN_OUTPUT);
+
+#if(LCD_RW_CONNECTED == 1)
+	/* RW is kept low (write) except while the busy flag is read */
+	GPIO_setupPinDirection(LCD_RW_PORT_ID,LCD_RW_PIN_ID,PIN_OUTPUT);
+	GPIO_writePin(LCD_RW_PORT_ID,LCD_RW_PIN_ID,LOGIC_LOW);
+#endif
+
+	_delay_ms(20);		/* LCD Power ON delay always > 15ms */
+
+#if(LCD_DATA_BITS_MODE == 4)
+	/* Configure 4 pins in the data port as output pins */
+	GPIO_setupPinDirection(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,PIN_OUTPUT);
+	GPIO_setupPinDirection(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,PIN_OUTPUT);
+	GPIO_setupPinDirection(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,PIN_OUTPUT);
+	GPIO_setupPinDirection(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,PIN_OUTPUT);
+
+	/*
+	 * Reset the interface by instruction then switch to 4 bit mode,
+	 * the busy flag can not be read before so the datasheet times are waited.
+	 */
+	GPIO_writePin(LCD_RS_PORT_ID,LCD_RS_PIN_ID,LOGIC_LOW); /* Instruction Mode RS=0 */
+	LCD_writeNibble(LCD_EIGHT_BITS_MODE_NIBBLE);
+	_delay_us(4100);
+	LCD_writeNibble(LCD_EIGHT_BITS_MODE_NIBBLE);
+	_delay_us(100);
+	LCD_writeNibble(LCD_EIGHT_BITS_MODE_NIBBLE);
+	_delay_us(LCD_EXECUTION_TIME_US);
+	LCD_writeNibble(LCD_FOUR_BITS_MODE_NIBBLE);
+	_delay_us(LCD_EXECUTION_TIME_US);
+
+	/* use 2-lines LCD + 4-bits Data Mode + 5*7 dot display Mode */
+	LCD_sendCommand(LCD_TWO_LINES_FOUR_BITS_MODE);
+
+#elif(LCD_DATA_BITS_MODE == 8)
+	/* Configure the data port as output port */
+	GPIO_setupPortDirection(LCD_DATA_PORT_ID,PORT_OUTPUT);
+
+	/* use 2-lines LCD + 8-bits Data Mode + 5*7 dot display Mode */
+	LCD_sendCommand(LCD_TWO_LINES_EIGHT_BITS_MODE);
+
+#endif
+
+	LCD_sendCommand(LCD_CURSOR_OFF); /* cursor off */
+	LCD_sendCommand(LCD_CLEAR_COMMAND); /* clear LCD at the beginning */
+}
+
+#if(LCD_RW_CONNECTED == 1)
+/*
+ * Description :
+ * Read the busy flag of the LCD, returns LOGIC_HIGH while the last instruction is executed.
+ * The data pins are released and read with RW=1 while E is high, in 4-bit mode
+ * the second nibble (low bits of the address counter) is clocked out and ignored.
+ */
+static uint8 LCD_readBusyFlag(void)
+{
+	uint8 busy;
+
+#if(LCD_DATA_BITS_MODE == 4)
+	GPIO_setupPinDirection(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,PIN_INPUT);
+	GPIO_setupPinDirection(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,PIN_INPUT);
+	GPIO_setupPinDirection(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,PIN_INPUT);
+	GPIO_setupPinDirection(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,PIN_INPUT);
+#elif(LCD_DATA_BITS_MODE == 8)
+	GPIO_setupPortDirection(LCD_DATA_PORT_ID,PORT_INPUT);
+#endif
+	GPIO_writePin(LCD_RS_PORT_ID,LCD_RS_PIN_ID,LOGIC_LOW); /* Instruction Mode RS=0 */
+	GPIO_writePin(LCD_RW_PORT_ID,LCD_RW_PIN_ID,LOGIC_HIGH); /* Read Mode RW=1 */
+
+	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E=1 */
+	_delay_us(1); /* delay for the data output Tddr = 360ns */
+	busy = GPIO_readPin(LCD_DATA_PORT_ID,LCD_BUSY_FLAG_PIN_ID);
+	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
+	_delay_us(1); /* delay for the enable cycle Tcyce = 500ns */
+#if(LCD_DATA_BITS_MODE == 4)
+	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E=1 */
+	_delay_us(1);
+	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0 */
+	_delay_us(1);
+#endif
+
+	GPIO_writePin(LCD_RW_PORT_ID,LCD_RW_PIN_ID,LOGIC_LOW); /* Write Mode RW=0 */
+#if(LCD_DATA_BITS_MODE == 4)
+	GPIO_setupPinDirection(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,PIN_OUTPUT);
+	GPIO_setupPinDirection(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,PIN_OUTPUT);
+	GPIO_setupPinDirection(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,PIN_OUTPUT);
+	GPIO_setupPinDirection(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,PIN_OUTPUT);
+#elif(LCD_DATA_BITS_MODE == 8)
+	GPIO_setupPortDirection(LCD_DATA_PORT_ID,PORT_OUTPUT);
+#endif
+
+	return busy;
+}
+#endif
+
+#if(LCD_DATA_BITS_MODE == 4)
+/*
+ * Description :
+ * Write the low 4 bits of the given value on DB4..DB7 with one E pulse.
+ */
+static void LCD_writeNibble(uint8 nibble)
+{
+	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E=1 */
+	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB4_PIN_ID,GET_BIT(nibble,0));
+	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB5_PIN_ID,GET_BIT(nibble,1));
+	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB6_PIN_ID,GET_BIT(nibble,2));
+	GPIO_writePin(LCD_DATA_PORT_ID,LCD_DB7_PIN_ID,GET_BIT(nibble,3));
+	_delay_us(1); /* delay for processing Tpw = 230ns and Tdsw = 80ns */
+	GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0, the LCD latches the data */
+	_delay_us(1); /* delay for the enable cycle Tcyce = 500ns */
+}
+#endif
+
+/*
+ * Description :
+ * Add one instruction (RS=0) or one data byte (RS=1) to the queue sent by the Timer2 tick,
+ * the tick is started if it was stopped on an empty queue. A full queue is waited for.
+ */
+static void LCD_enqueue(uint8 rs, uint8 value)
+{
+	uint8 next = (g_lcdQueueTail + 1) & (LCD_QUEUE_SIZE - 1);
+
+	while(next == g_lcdQueueHead)
+	{
+		if(BIT_IS_CLEAR(SREG,7))
+		{
+			/* The tick can not interrupt, clock the queue from here */
+			_delay_us(LCD_TICK_US);
+			LCD_tick();
+		}
+	}
+
+	g_lcdQueueValue[g_lcdQueueTail] = value;
+	g_lcdQueueRs[g_lcdQueueTail] = rs;
+	g_lcdQueueTail = next;
+
+	/* The tick stops only after it finds the queue empty, so the new entry is never missed */
+	if(g_lcdTickRunning == FALSE)
+	{
+		g_lcdTickRunning = TRUE;
+		Timer2_init(&g_lcdTickConfig);
+	}
+}
+
+/*
+ * Description :
+ * Timer2 call back, send the next part of the instruction at the head of the queue:
+ * one nibble per tick in 4-bit mode so the interrupt stays short. The tick period covers
+ * the execution time of an instruction, the clear and home instructions are waited for
+ * by reading the busy flag, or by skipping ticks when the RW pin is not connected.
+ * The timer is stopped once the queue is empty.
+ */
+static void LCD_tick(void)
+{
+	uint8 head = g_lcdQueueHead;
+	uint8 value;
+
+#if(LCD_RW_CONNECTED == 0)
+	if(g_lcdWaitTicks != 0)
+	{
+		g_lcdWaitTicks--;
+		return;
+	}
+#endif
+
+#if(LCD_DATA_BITS_MODE == 4)
+	if(g_lcdLowNibblePending == TRUE)
+	{
+		LCD_writeNibble(g_lcdQueueValue[head]);
+		g_lcdLowNibblePending = FALSE;
+	}
+	else
+#endif
+	{
+		if(head == g_lcdQueueTail)
+		{
+			Timer2_deInit();
+			g_lcdTickRunning = FALSE;
+			return;
+		}
+
+#if(LCD_RW_CONNECTED == 1)
+		if(LCD_readBusyFlag() == LOGIC_HIGH)
+		{
+			return; /* check again on the next tick */
+		}
+#endif
+
+		value = g_lcdQueueValue[head];
+		GPIO_writePin(LCD_RS_PORT_ID,LCD_RS_PIN_ID,g_lcdQueueRs[head]); /* Tas = 40ns is covered by the next instructions */
+
+#if(LCD_DATA_BITS_MODE == 4)
+		LCD_writeNibble(value >> 4);
+		g_lcdLowNibblePending = TRUE;
+		return;
+
+#elif(LCD_DATA_BITS_MODE == 8)
+		GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_HIGH); /* Enable LCD E=1 */
+		GPIO_writePort(LCD_DATA_PORT_ID,value); /* out the required value to the data bus D0 --> D7 */
+		_delay_us(1); /* delay for processing Tpw = 230ns and Tdsw = 80ns */
+		GPIO_writePin(LCD_E_PORT_ID,LCD_E_PIN_ID,LOGIC_LOW); /* Disable LCD E=0, the LCD latches the data */
+		_delay_us(1); /* delay for the enable cycle Tcyce = 500ns */
+#endif
+	}
+
+	/* The whole entry is sent */
+#if(LCD_RW_CONNECTED == 0)
+	value = g_lcdQueueValue[head];
+	if((g_lcdQueueRs[head] == LOGIC_LOW) && ((value == LCD_CLEAR_COMMAND) || ((value & 0xFE) == LCD_GO_TO_HOME)))
+	{
+		g_lcdWaitTicks = LCD_CLEAR_WAIT_TICKS;
+	}
+#endif
+	g_lcdQueueHead = (head + 1) & (LCD_QUEUE_SIZE - 1);
+}
+
+/*
+ * Description :
+ * Queue the required command to be sent to the screen
+ */
+void LCD_sendCommand(uint8 command)
+{
+	LCD_enqueue(LOGIC_LOW,command); /* Instruction Mode RS=0 */
+
+	/* Follow the address counter so the cursor is moved only when needed */
+	if(command & LCD_SET_CURSOR_LOCATION)
+	{
+		g_lcdAddress = command & (~LCD_SET_CURSOR_LOCATION);
+	}
+	else if(command == LCD_CLEAR_COMMAND)
+	{
+		uint8 row,col;
+
+		for(row = 0; row < LCD_ROWS; row++)
+		{
+			for(col = 0; col < LCD_COLUMNS; col++)
+			{
+				g_lcdScreen[row][col] = ' ';
+				g_lcdBuffer[row][col] = ' ';
+			}
+		}
+		g_lcdAddress = 0;
+	}
+	else if((command & 0xFE) == LCD_GO_TO_HOME)
+	{
+		g_lcdAddress = 0;
+	}
+	else if(((command & 0xF0) == 0x10) || ((command & 0xC0) == 0x40))
+	{
+		/* Cursor or display shift and CGRAM address commands */
+		g_lcdAddress = LCD_ADDRESS_UNKNOWN;
+	}
+}
+
+/*
+ * Description :
+ * Queue the required character to be displayed on the screen
+ */
+void LCD_displayCharacter(uint8 data)
+{
+	LCD_enqueue(LOGIC_HIGH,data); /* Data Mode RS=1 */
+	LCD_storeCharacter(data);
+}
+
+/*
+ * Description :
+ * Display the required string on the screen
+ */
+void LCD_displayString(const char *Str)
+{
+	uint8 i = 0;
+	while(Str[i] != '\0')
+	{
+		LCD_displayCharacter(Str[i]);
+		i++;
+	}
+	/***************** Another Method ***********************
+	while((*Str) != '\0')
+	{
+		LCD_displayCharacter(*Str);
+		Str++;
+	}		
+	*********************************************************/
+}
+
+/*
+ * Description :
+ * Move the cursor to a specified row and column index on the screen
+ */
+void LCD_moveCursor(uint8 row,uint8 col)
+{
+	/* Calculate the required address in the LCD DDRAM */
+	uint8 lcd_memory_address = g_lcdRowAddress[row & 0x03] + col;
+
+	/* Move the LCD cursor to this specific address unless it is already there */
+	if(lcd_memory_address != g_lcdAddress)
+	{
+		LCD_sendCommand(lcd_memory_address | LCD_SET_CURSOR_LOCATION);
+	}
+}
+
+/*
+ * Description :
+ * Display the required string in a specified row and column index on the screen
+ */
+void LCD_displayStringRowColumn(uint8 row,uint8 col,const char *Str)
+{
+	LCD_moveCursor(row,col); /* go to to the required LCD position */
+	LCD_displayString(Str); /* display the string */
+}
+
+/*
+ * Description :
+ * Display the required decimal value on the screen
+ */
+void LCD_intgerToString(int data)
+{
+   char buff[16]; /* String to hold the ascii result */
+   itoa(data,buff,10); /* Use itoa C function to convert the data to its corresponding ASCII value, 10 for decimal */
+   LCD_displayString(buff); /* Display the string */
+}
+
+/*
+ * Description :
+ * Send the clear screen command
+ */
+void LCD_clearScreen(void)
+{
+	LCD_sendCommand(LCD_CLEAR_COMMAND); /* Send clear display command */
+}
+
+/*
+ * Description :
+ * Keep the shadow buffer and the cursor address in step with a character written to the DDRAM.
+ */
+static void LCD_storeCharacter(uint8 data)
+{
+	uint8 row;
+	uint8 col;
+
+	if(g_lcdAddress == LCD_ADDRESS_UNKNOWN)
+	{
+		return;
+	}
+
+	for(row = 0; row < LCD_ROWS; row++)
+	{
+		col = g_lcdAddress - g_lcdRowAddress[row];
+		if(col < LCD_COLUMNS)
+		{
+			g_lcdScreen[row][col] = data;
+			g_lcdBuffer[row][col] = data;
+			break;
+		}
+	}
+
+	/* The address counter goes from the end of the first line to the second line and back */
+	g_lcdAddress++;
+	if(g_lcdAddress == 0x28)
+	{
+		g_lcdAddress = LCD_ROW1_ADDRESS;
+	}
+	else if(g_lcdAddress == 0x68)
+	{
+		g_lcdAddress = LCD_ROW0_ADDRESS;
+	}
+}
+
+/*
+ * Description :
+ * Write the required string in the shadow buffer at the specified row and column index,
+ * the string is cut at the end of the row. Nothing is sent to the screen before LCD_flush.
+ */
+void LCD_bufferWrite(uint8 row,uint8 col,const char *Str)
+{
+	if(row >= LCD_ROWS)
+	{
+		return;
+	}
+
+	while((*Str != '\0') && (col < LCD_COLUMNS))
+	{
+		g_lcdBuffer[row][col] = *Str;
+		Str++;
+		col++;
+	}
+}
+
+/*
+ * Description :
+ * Fill the shadow buffer with spaces, the next LCD_flush erases only the cells that
+ * are not blank on the screen instead of sending the slow clear screen command.
+ */
+void LCD_bufferClear(void)
+{
+	uint8 row;
+	uint8 col;
+
+	for(row = 0; row < LCD_ROWS; row++)
+	{
+		for(col = 0; col < LCD_COLUMNS; col++)
+		{
+			g_lcdBuffer[row][col] = ' ';
+		}
+	}
+}
+
+/*
+ * Description :
+ * Send the cells of the shadow buffer that differ from the screen, the cursor is moved
+ * only when the next changed cell does not follow the last written one.
+ */
+void LCD_flush(void)
+{
+	uint8 row;
+	uint8 col;
+
+	for(row = 0; row < LCD_ROWS; row++)
+	{
+		for(col = 0; col < LCD_COLUMNS; col++)
+		{
+			if(g_lcdScreen[row][col] != g_lcdBuffer[row][col])
+			{
+				LCD_moveCursor(row,col); /* no command when the cursor is already there */
+				LCD_displayCharacter(g_lcdBuffer[row][col]); /* updates the shadow of the screen */
+			}
+		}
+	}
+}
@@ -1,114 +1,194 @@
- /******************************************************************************
- *
- * Module: LCD
- *
- * File Name: lcd.h
- *
- * Description: Header file for the LCD driver
- *
- * Author: Mohamed Tarek
- *
- *******************************************************************************/
-
-#ifndef LCD_H_
-#define LCD_H_
-
-#include "../MCAL/std_types.h"
-
-/*******************************************************************************
- *                                Definitions                                  *
- *******************************************************************************/
-
-/* LCD Data bits mode configuration, its value should be 4 or 8*/
-#define LCD_DATA_BITS_MODE 4
-
-#if((LCD_DATA_BITS_MODE != 4) && (LCD_DATA_BITS_MODE != 8))
-
-#error "Number of Data bits should be equal to 4 or 8"
-
-#endif
-
-/* LCD HW Ports and Pins Ids */
-#define LCD_RS_PORT_ID                 PORTA_ID
-#define LCD_RS_PIN_ID                  PIN7_ID
-
-#define LCD_E_PORT_ID                  PORTA_ID
-#define LCD_E_PIN_ID                   PIN5_ID
-
-#define LCD_DATA_PORT_ID               PORTA_ID
-
-#if (LCD_DATA_BITS_MODE == 4)
-
-#define LCD_DB4_PIN_ID                 PIN0_ID
-#define LCD_DB5_PIN_ID                 PIN1_ID
-#define LCD_DB6_PIN_ID                 PIN2_ID
-#define LCD_DB7_PIN_ID                 PIN3_ID
-
-#endif
-
-/* LCD Commands */
-#define LCD_CLEAR_COMMAND                    0x01
-#define LCD_GO_TO_HOME                       0x02
-#define LCD_TWO_LINES_EIGHT_BITS_MODE        0x38
-#define LCD_TWO_LINES_FOUR_BITS_MODE         0x28
-#define LCD_TWO_LINES_FOUR_BITS_MODE_INIT1   0x33
-#define LCD_TWO_LINES_FOUR_BITS_MODE_INIT2   0x32
-#define LCD_CURSOR_OFF                       0x0C
-#define LCD_CURSOR_ON                        0x0E
-#define LCD_SET_CURSOR_LOCATION              0x80
-
-/*******************************************************************************
- *                      Functions Prototypes                                   *
- *******************************************************************************/
-
-/*
- * Description :
- * Initialize the LCD:
- * 1. Setup the LCD pins directions by use the GPIO driver.
- * 2. Setup the LCD Data Mode 4-bits or 8-bits.
- */
-void LCD_init(void);
-
-/*
- * Description :
- * Send the required command to the screen
- */
-void LCD_sendCommand(uint8 command);
-
-/*
- * Description :
- * Display the required character on the screen
- */
-void LCD_displayCharacter(uint8 data);
-
-/*
- * Description :
- * Display the required string on the screen
- */
-void LCD_displayString(const char *Str);
-
-/*
- * Description :
- * Move the cursor to a specified row and column index on the screen
- */
-void LCD_moveCursor(uint8 row,uint8 col);
-
-/*
- * Description :
- * Display the required string in a specified row and column index on the screen
- */
-void LCD_displayStringRowColumn(uint8 row,uint8 col,const char *Str);
-
-/*
- * Description :
- * Display the required decimal value on the screen
- */
-void LCD_intgerToString(int data);
-
-/*
- * Description :
- * Send the clear screen command
- */
-void LCD_clearScreen(void);
-
-#endif /* LCD_H_ */
+ /******************************************************************************
+ *
+ * Module: LCD
+ *
+ * File Name: lcd.h
+ *
+ * Description: Header file for the LCD driver
+ *
+ * Author: Mohamed Tarek
+ *
+ *******************************************************************************/
+
+#ifndef LCD_H_
+#define LCD_H_
+
+#include "../MCAL/std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* LCD Data bits mode configuration, its value should be 4 or 8*/
+#define LCD_DATA_BITS_MODE 4
+
+#if((LCD_DATA_BITS_MODE != 4) && (LCD_DATA_BITS_MODE != 8))
+
+#error "Number of Data bits should be equal to 4 or 8"
+
+#endif
+
+/* LCD HW Ports and Pins Ids */
+#define LCD_RS_PORT_ID                 PORTA_ID
+#define LCD_RS_PIN_ID                  PIN7_ID
+
+#define LCD_E_PORT_ID                  PORTA_ID
+#define LCD_E_PIN_ID                   PIN5_ID
+
+/*
+ * Set to 1 when the LCD RW pin is connected to the MCU so the busy flag can be read on DB7,
+ * set to 0 when RW is tied to ground and the datasheet execution times are waited instead.
+ */
+#define LCD_RW_CONNECTED               1
+
+#if (LCD_RW_CONNECTED == 1)
+
+#define LCD_RW_PORT_ID                 PORTA_ID
+#define LCD_RW_PIN_ID                  PIN6_ID
+
+/* Busy flag polls before giving up, one poll takes a few us so the limit is above the clear time */
+#define LCD_BUSY_POLL_MAX              500
+
+#endif
+
+#define LCD_DATA_PORT_ID               PORTA_ID
+
+#if (LCD_DATA_BITS_MODE == 4)
+
+#define LCD_DB4_PIN_ID                 PIN0_ID
+#define LCD_DB5_PIN_ID                 PIN1_ID
+#define LCD_DB6_PIN_ID                 PIN2_ID
+#define LCD_DB7_PIN_ID                 PIN3_ID
+
+#define LCD_BUSY_FLAG_PIN_ID           LCD_DB7_PIN_ID
+
+#elif (LCD_DATA_BITS_MODE == 8)
+
+#define LCD_BUSY_FLAG_PIN_ID           PIN7_ID
+
+#endif
+
+/* HD44780 execution times in us, used when the busy flag can not be read */
+#define LCD_CLEAR_EXECUTION_TIME_US    1530
+#define LCD_EXECUTION_TIME_US          43   /* 37 us plus the address counter update */
+
+/*
+ * The instructions and characters are queued and clocked out by the Timer2 tick, one nibble
+ * per tick in 4-bit mode, so drawing never blocks the application. The tick period has to
+ * cover the execution time of one instruction. The queue size should be a power of 2.
+ */
+#define LCD_QUEUE_SIZE                 64
+#define LCD_TICK_US                    50
+#define LCD_TICK_COMPARE_VALUE         (((F_CPU / 8UL / 1000000UL) * LCD_TICK_US) - 1) /* F_CPU/8 clock */
+#define LCD_CLEAR_WAIT_TICKS           (((LCD_CLEAR_EXECUTION_TIME_US + LCD_TICK_US - 1) / LCD_TICK_US) - 1)
+
+#if(LCD_TICK_US < LCD_EXECUTION_TIME_US)
+
+#error "The LCD tick should be longer than the execution time of an instruction"
+
+#endif
+
+/* LCD Commands */
+#define LCD_CLEAR_COMMAND                    0x01
+#define LCD_GO_TO_HOME                       0x02
+#define LCD_TWO_LINES_EIGHT_BITS_MODE        0x38
+#define LCD_TWO_LINES_FOUR_BITS_MODE         0x28
+#define LCD_EIGHT_BITS_MODE_NIBBLE           0x03 /* sent 3 times to reset the interface */
+#define LCD_FOUR_BITS_MODE_NIBBLE            0x02
+#define LCD_CURSOR_OFF                       0x0C
+#define LCD_CURSOR_ON                        0x0E
+#define LCD_SET_CURSOR_LOCATION              0x80
+
+/* Size of the display kept in the shadow buffer, up to 4 rows of 20 columns */
+#define LCD_ROWS                       2
+#define LCD_COLUMNS                    16
+
+#if((LCD_ROWS < 1) || (LCD_ROWS > 4) || (LCD_COLUMNS < 1) || (LCD_COLUMNS > 20))
+
+#error "The LCD should have 1 to 4 rows of 1 to 20 columns"
+
+#endif
+
+/* DDRAM address of the first column of each row, rows 2 and 3 continue rows 0 and 1 */
+#define LCD_ROW0_ADDRESS               0x00
+#define LCD_ROW1_ADDRESS               0x40
+#define LCD_ROW2_ADDRESS               (LCD_ROW0_ADDRESS + LCD_COLUMNS)
+#define LCD_ROW3_ADDRESS               (LCD_ROW1_ADDRESS + LCD_COLUMNS)
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Initialize the LCD:
+ * 1. Setup the LCD pins directions by use the GPIO driver.
+ * 2. Setup the LCD Data Mode 4-bits or 8-bits.
+ * 3. Queue the display setup, it is sent by the Timer2 tick once the interrupts are enabled.
+ */
+void LCD_init(void);
+
+/*
+ * Description :
+ * Queue the required command to be sent to the screen
+ */
+void LCD_sendCommand(uint8 command);
+
+/*
+ * Description :
+ * Queue the required character to be displayed on the screen
+ */
+void LCD_displayCharacter(uint8 data);
+
+/*
+ * Description :
+ * Display the required string on the screen
+ */
+void LCD_displayString(const char *Str);
+
+/*
+ * Description :
+ * Move the cursor to a specified row and column index on the screen
+ */
+void LCD_moveCursor(uint8 row,uint8 col);
+
+/*
+ * Description :
+ * Display the required string in a specified row and column index on the screen
+ */
+void LCD_displayStringRowColumn(uint8 row,uint8 col,const char *Str);
+
+/*
+ * Description :
+ * Display the required decimal value on the screen
+ */
+void LCD_intgerToString(int data);
+
+/*
+ * Description :
+ * Send the clear screen command
+ */
+void LCD_clearScreen(void);
+
+/*
+ * Description :
+ * Write the required string in the shadow buffer at the specified row and column index,
+ * the string is cut at the end of the row. Nothing is sent to the screen before LCD_flush.
+ */
+void LCD_bufferWrite(uint8 row,uint8 col,const char *Str);
+
+/*
+ * Description :
+ * Fill the shadow buffer with spaces, the next LCD_flush erases only the cells that
+ * are not blank on the screen instead of sending the slow clear screen command.
+ */
+void LCD_bufferClear(void);
+
+/*
+ * Description :
+ * Send the cells of the shadow buffer that differ from the screen, the cursor is moved
+ * only when the next changed cell does not follow the last written one.
+ */
+void LCD_flush(void);
+
+#endif /* LCD_H_ */
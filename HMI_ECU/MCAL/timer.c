@@ -1,104 +1,224 @@
-/******************************************************************************
- *
- * Module: TIMER
- *
- * File Name: timer.c
- *
- * Description: Source file for the AVR atmega32 timers driver
- *
- * Author: Omar Muhammad
- *
- *******************************************************************************/
-
-#include"timer.h"
-#include <avr/io.h>
-#include<avr/interrupt.h>
-
-/*******************************************************************************
- *                           Global Variables                                  *
- *******************************************************************************/
-/* Global variables to hold the address of the call back function in the application */
-static volatile void (*g_callBackPtr)(void) = NULL_PTR;
-
-/*******************************************************************************
- *                       Interrupt Service Routines                            *
- *******************************************************************************/
-
-ISR(TIMER1_OVF_vect)
-{
-	if(g_callBackPtr != NULL_PTR)
-	{
-		/* Call the Call Back function in the application after the edge is detected */
-		(*g_callBackPtr)();
-	}
-}
-
-ISR(TIMER1_COMPA_vect)
-{
-	if(g_callBackPtr != NULL_PTR)
-	{
-		/* Call the Call Back function in the application after the edge is detected */
-		(*g_callBackPtr)();
-	}
-}
-
-/*******************************************************************************
- *                      Functions Definitions                                  *
- *******************************************************************************/
-/*
- * Description :
- * Function to initialize the Timer driver
- * 1. Set the required clock.
- * 2. Set the required mode (normal or CTC).
- * 3. Enable Timer Module interrupt
- * 4. Initialize Timer1 Registers
- */
-void Timer1_init(const Timer1_ConfigType * Config_Ptr)
-{
-	/* Set timer1 initial count to the configured value */
-		TCNT1 = Config_Ptr->initial_value;
-
-		/* Set the Compare value to configured compare value */
-		OCR1A = Config_Ptr->compare_value;
-
-		TCCR1A = (1<<FOC1A) | (1<<FOC1B);
-
-		/*Set overflow or CTC Mode*/
-		TCCR1B = (TCCR1B & 0xF7) | (Config_Ptr->mode << 3);
-
-		/*Set the Timer1 Prescaler*/
-		TCCR1B = (TCCR1B & 0xF8) | (Config_Ptr->prescaler & 0x07);
-
-		if(Config_Ptr->mode == NORMAL)
-		{
-			/* Enable Timer1 Overflow Interrupt */
-			TIMSK |= (1<<TOIE1);
-		}
-		else
-		{
-			/* Enable Timer1 Compare A Interrupt */
-			TIMSK |= (1<<OCIE1A);
-		}
-}
-
-/*
- * Description :
- * Function to disable the Timer1.
- */
-void Timer1_deInit(void)
-{
-	/* Clear All Timer1 Registers */
-	TCCR1A = 0;
-	TCCR1B = 0;
-	TCNT1 = 0;
-	ICR1 = 0;
-}
-
-/*
- * Description :
- * Function to set the Call Back function address.
- */
-void Timer1_setCallBack(void(*a_ptr)(void))
-{
-	g_callBackPtr = (volatile void (*)(void))a_ptr;
-}
+/******************************************************************************
+ *
+ * Module: TIMER
+ *
+ * File Name: timer.c
+ *
+ * Description: Source file for the AVR atmega32 timers driver
+ *
+ * Author: Omar Muhammad
+ *
+ *******************************************************************************/
+
+#include"timer.h"
+#include <avr/io.h>
+#include<avr/interrupt.h>
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+/* Global variables to hold the address of the call back function in the application */
+static void (*volatile g_callBackPtr)(void) = NULL_PTR;
+
+/* Number of compare matches, one per ms when the system tick is used */
+static volatile uint32 g_ticks = 0;
+
+/* Call back function of the Timer2 compare match */
+static void (*volatile g_timer2CallBackPtr)(void) = NULL_PTR;
+
+/*******************************************************************************
+ *                       Interrupt Service Routines                            *
+ *******************************************************************************/
+
+ISR(TIMER1_OVF_vect)
+{
+	if(g_callBackPtr != NULL_PTR)
+	{
+		/* Call the Call Back function in the application after the edge is detected */
+		(*g_callBackPtr)();
+	}
+}
+
+ISR(TIMER1_COMPA_vect)
+{
+	g_ticks++;
+
+	if(g_callBackPtr != NULL_PTR)
+	{
+		/* Call the Call Back function in the application after the edge is detected */
+		(*g_callBackPtr)();
+	}
+}
+
+ISR(TIMER2_COMP_vect)
+{
+	if(g_timer2CallBackPtr != NULL_PTR)
+	{
+		(*g_timer2CallBackPtr)();
+	}
+}
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+/*
+ * Description :
+ * Function to initialize the Timer driver
+ * 1. Set the required clock.
+ * 2. Set the required mode (normal or CTC).
+ * 3. Enable Timer Module interrupt
+ * 4. Initialize Timer1 Registers
+ */
+void Timer1_init(const Timer1_ConfigType * Config_Ptr)
+{
+	/* Set timer1 initial count to the configured value */
+		TCNT1 = Config_Ptr->initial_value;
+
+		/* Set the Compare value to configured compare value */
+		OCR1A = Config_Ptr->compare_value;
+
+		TCCR1A = (1<<FOC1A) | (1<<FOC1B);
+
+		/*Set overflow or CTC Mode*/
+		TCCR1B = (TCCR1B & 0xF7) | (Config_Ptr->mode << 3);
+
+		/*Set the Timer1 Prescaler*/
+		TCCR1B = (TCCR1B & 0xF8) | (Config_Ptr->prescaler & 0x07);
+
+		if(Config_Ptr->mode == NORMAL)
+		{
+			/* Enable Timer1 Overflow Interrupt */
+			TIMSK |= (1<<TOIE1);
+		}
+		else
+		{
+			/* Enable Timer1 Compare A Interrupt */
+			TIMSK |= (1<<OCIE1A);
+		}
+}
+
+/*
+ * Description :
+ * Function to disable the Timer1.
+ */
+void Timer1_deInit(void)
+{
+	/* Clear All Timer1 Registers */
+	TCCR1A = 0;
+	TCCR1B = 0;
+	TCNT1 = 0;
+	ICR1 = 0;
+}
+
+/*
+ * Description :
+ * Function to set the Call Back function address.
+ */
+void Timer1_setCallBack(void(*a_ptr)(void))
+{
+	g_callBackPtr = a_ptr;
+}
+
+/*
+ * Description :
+ * Start Timer1 in CTC mode as a 1 ms system tick.
+ * The Call Back function, if any, is called from the ISR on every tick.
+ */
+void Timer1_startSystemTick(void)
+{
+	Timer1_ConfigType tickConfig = {0, TIMER1_TICK_COMPARE_VALUE, F_CPU_64, CTC};
+
+	g_ticks = 0;
+	Timer1_init(&tickConfig);
+}
+
+/*
+ * Description :
+ * Return the number of Timer1 compare matches, in ms when the system tick is used.
+ */
+uint32 Timer1_getTicks(void)
+{
+	uint32 ticks;
+	/* The 32-bit counter is updated by the ISR so read it atomically */
+	uint8 sreg = SREG;
+
+	cli();
+	ticks = g_ticks;
+	SREG = sreg;
+
+	return ticks;
+}
+
+/*
+ * Description :
+ * Start (or restart) a software timer to expire after period_ms.
+ */
+void Timer1_startSoftTimer(Timer1_SoftTimerType * Timer_Ptr, uint32 period_ms)
+{
+	Timer_Ptr->deadline = Timer1_getTicks() + (period_ms / TIMER1_TICK_MS);
+	Timer_Ptr->running = TRUE;
+}
+
+/*
+ * Description :
+ * Stop a software timer so it never reports expiry.
+ */
+void Timer1_stopSoftTimer(Timer1_SoftTimerType * Timer_Ptr)
+{
+	Timer_Ptr->running = FALSE;
+}
+
+/*
+ * Description :
+ * Return TRUE once when the software timer expires, then the timer is stopped.
+ */
+boolean Timer1_softTimerExpired(Timer1_SoftTimerType * Timer_Ptr)
+{
+	/* The signed difference keeps working when the tick counter wraps around */
+	if((Timer_Ptr->running == TRUE) && ((sint32)(Timer1_getTicks() - Timer_Ptr->deadline) >= 0))
+	{
+		Timer_Ptr->running = FALSE;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/*
+ * Description :
+ * Function to start Timer2 in CTC mode
+ * 1. Initialize Timer2 Registers
+ * 2. Set the required clock.
+ * 3. Enable Timer2 Compare Interrupt
+ */
+void Timer2_init(const Timer2_ConfigType * Config_Ptr)
+{
+	TCNT2 = Config_Ptr->initial_value;
+	OCR2 = Config_Ptr->compare_value;
+
+	/* Clear a compare match left from the last run before enabling its interrupt */
+	TIFR = (1<<OCF2);
+	TIMSK |= (1<<OCIE2);
+
+	/* Non PWM CTC mode, OC2 disconnected, the prescaler starts the counter */
+	TCCR2 = (1<<FOC2) | (1<<WGM21) | (Config_Ptr->prescaler & 0x07);
+}
+
+/*
+ * Description :
+ * Function to stop Timer2 and disable its interrupt.
+ */
+void Timer2_deInit(void)
+{
+	TCCR2 = 0;
+	TIMSK &= ~(1<<OCIE2);
+	TCNT2 = 0;
+}
+
+/*
+ * Description :
+ * Function to set the Call Back function address called on every Timer2 compare match.
+ */
+void Timer2_setCallBack(void(*a_ptr)(void))
+{
+	g_timer2CallBackPtr = a_ptr;
+}
@@ -1,64 +1,144 @@
-/******************************************************************************
- *
- * Module: TIMER
- *
- * File Name: timer.h
- *
- * Description: header file for the AVR atmega32 timers driver
- *
- * Author: Omar Muhammad
- *
- *******************************************************************************/
-
-#ifndef TIMER_H_
-#define TIMER_H_
-
-#include "std_types.h"
-
-/*******************************************************************************
- *                         Types Declaration                                   *
- *******************************************************************************/
-
-typedef enum
-{
-	NOCLOCK, F_CPU_CLK, F_CPU_8 , F_CPU_64 , F_CPU_256 , F_CPU_1024
-}Timer1_Prescaler;
-
-typedef enum
-{
-	NORMAL, CTC
-}Timer1_Mode;
-
-typedef struct {
-	uint16 initial_value;
-	uint16 compare_value; // it will be used in compare mode only.
-	Timer1_Prescaler prescaler;
-	Timer1_Mode mode;
-} Timer1_ConfigType;
-
-/*******************************************************************************
- *                      Functions Prototypes                                   *
- *******************************************************************************/
-/*
- * Description :
- * Function to initialize the Timer driver
- * 1. Set the required clock.
- * 2. Set the required mode (normal or CTC).
- * 3. Enable Timer Module interrupt
- * 4. Initialize Timer1 Registers
- */
-void Timer1_init(const Timer1_ConfigType * Config_Ptr);
-
-/*
- * Description :
- * Function to disable the Timer1.
- */
-void Timer1_deInit(void);
-
-/*
- * Description :
- * Function to set the Call Back function address.
- */
-void Timer1_setCallBack(void(*a_ptr)(void));
-
-#endif /* TIMER_H_ */
+/******************************************************************************
+ *
+ * Module: TIMER
+ *
+ * File Name: timer.h
+ *
+ * Description: header file for the AVR atmega32 timers driver
+ *
+ * Author: Omar Muhammad
+ *
+ *******************************************************************************/
+
+#ifndef TIMER_H_
+#define TIMER_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/* System tick: F_CPU/64 and a compare match every 1 ms */
+#define TIMER1_TICK_MS                 1
+#define TIMER1_TICK_COMPARE_VALUE      ((F_CPU / 64UL / 1000UL) - 1)
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+
+typedef enum
+{
+	NOCLOCK, F_CPU_CLK, F_CPU_8 , F_CPU_64 , F_CPU_256 , F_CPU_1024
+}Timer1_Prescaler;
+
+typedef enum
+{
+	NORMAL, CTC
+}Timer1_Mode;
+
+typedef struct {
+	uint16 initial_value;
+	uint16 compare_value; // it will be used in compare mode only.
+	Timer1_Prescaler prescaler;
+	Timer1_Mode mode;
+} Timer1_ConfigType;
+
+typedef enum
+{
+	TIMER2_NOCLOCK, TIMER2_F_CPU_CLK, TIMER2_F_CPU_8, TIMER2_F_CPU_32, TIMER2_F_CPU_64,
+	TIMER2_F_CPU_128, TIMER2_F_CPU_256, TIMER2_F_CPU_1024
+}Timer2_Prescaler;
+
+/* Timer2 always runs in CTC mode, it is used as a fast tick for drivers */
+typedef struct {
+	uint8 initial_value;
+	uint8 compare_value;
+	Timer2_Prescaler prescaler;
+} Timer2_ConfigType;
+
+/* Software timer driven by the system tick, the owner keeps its storage */
+typedef struct {
+	uint32 deadline;  // tick at which the timer expires
+	boolean running;
+} Timer1_SoftTimerType;
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+/*
+ * Description :
+ * Function to initialize the Timer driver
+ * 1. Set the required clock.
+ * 2. Set the required mode (normal or CTC).
+ * 3. Enable Timer Module interrupt
+ * 4. Initialize Timer1 Registers
+ */
+void Timer1_init(const Timer1_ConfigType * Config_Ptr);
+
+/*
+ * Description :
+ * Function to disable the Timer1.
+ */
+void Timer1_deInit(void);
+
+/*
+ * Description :
+ * Function to set the Call Back function address.
+ */
+void Timer1_setCallBack(void(*a_ptr)(void));
+
+/*
+ * Description :
+ * Start Timer1 in CTC mode as a 1 ms system tick.
+ * The Call Back function, if any, is called from the ISR on every tick.
+ */
+void Timer1_startSystemTick(void);
+
+/*
+ * Description :
+ * Return the number of Timer1 compare matches, in ms when the system tick is used.
+ */
+uint32 Timer1_getTicks(void);
+
+/*
+ * Description :
+ * Start (or restart) a software timer to expire after period_ms.
+ */
+void Timer1_startSoftTimer(Timer1_SoftTimerType * Timer_Ptr, uint32 period_ms);
+
+/*
+ * Description :
+ * Stop a software timer so it never reports expiry.
+ */
+void Timer1_stopSoftTimer(Timer1_SoftTimerType * Timer_Ptr);
+
+/*
+ * Description :
+ * Return TRUE once when the software timer expires, then the timer is stopped.
+ */
+boolean Timer1_softTimerExpired(Timer1_SoftTimerType * Timer_Ptr);
+
+/*
+ * Description :
+ * Function to start Timer2 in CTC mode
+ * 1. Initialize Timer2 Registers
+ * 2. Set the required clock.
+ * 3. Enable Timer2 Compare Interrupt
+ */
+void Timer2_init(const Timer2_ConfigType * Config_Ptr);
+
+/*
+ * Description :
+ * Function to stop Timer2 and disable its interrupt.
+ */
+void Timer2_deInit(void);
+
+/*
+ * Description :
+ * Function to set the Call Back function address called on every Timer2 compare match.
+ */
+void Timer2_setCallBack(void(*a_ptr)(void));
+
+
+#endif /* TIMER_H_ */
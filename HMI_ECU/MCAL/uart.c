@@ -1,165 +1,591 @@
- /******************************************************************************
- *
- * Module: UART
- *
- * File Name: uart.c
- *
- * Description: Source file for the UART AVR driver
- *
- * Author: Mohamed Tarek
- *
- *******************************************************************************/
-
-#include "uart.h"
-#include <avr/io.h> /* To use the UART Registers */
-#include "common_macros.h" /* To use the macros like SET_BIT */
-
-/*******************************************************************************
- *                      Functions Definitions                                  *
- *******************************************************************************/
-
-/*
- * Description :
- * Functional responsible for Initialize the UART device by:
- * 1. Setup the Frame format like number of data bits, parity bit type and number of stop bits.
- * 2. Enable the UART.
- * 3. Setup the UART baud rate.
- */
-void UART_init(const UART_ConfigType * Config_Ptr)
-{
-	uint16 ubrr_value = 0;
-
-	/* U2X = 1 for double transmission speed */
-	UCSRA = (1<<U2X);
-
-	/************************** UCSRB Description **************************
-	 * RXCIE = 0 Disable USART RX Complete Interrupt Enable
-	 * TXCIE = 0 Disable USART Tx Complete Interrupt Enable
-	 * UDRIE = 0 Disable USART Data Register Empty Interrupt Enable
-	 * RXEN  = 1 Receiver Enable
-	 * RXEN  = 1 Transmitter Enable
-	 * UCSZ2 = 0 For 8-bit data mode
-	 * RXB8 & TXB8 not used for 8-bit data mode
-	 ***********************************************************************/ 
-	UCSRB = (1<<RXEN) | (1<<TXEN);
-	
-	/************************** UCSRC Description **************************
-	 * URSEL   = 1 The URSEL must be one when writing the UCSRC
-	 * UMSEL   = 0 Asynchronous Operation
-	 *
-	 * UPM1:0  = Config_Ptr->parity_status
-	 *           00 Disable parity bit
-	 *           10 Enable parity bit, even
-	 *           11 Enable parity bit, odd
-	 *
-	 * USBS    = Config_Ptr->stop_bit_selection, 0 One stop bit 1 Two stop bits
-	 *
-	 * UCSZ1:0 = Config_Ptr->char_size to configure character size
-	 *
-	 * UCPOL   = 0 Used with the Synchronous operation only
-	 ***********************************************************************/ 	
-	UCSRC = (1<<URSEL);
-
-	/*Setup of parity bit*/
-	UCSRC = (UCSRC & 0xCF) | ((Config_Ptr->parity & 0x03) << UPM0);
-
-	/*Setup of stop bit*/
-	UCSRC = (UCSRC & 0xF7) | ((Config_Ptr->stop_bit & 0x01) << USBS);
-
-	/* Setup of Data Bits , character size */
-	UCSRC = (UCSRC & 0xF9) | ((((Config_Ptr->bit_data) & 0x03))<<UCSZ0);
-
-
-	/* Calculate the UBRR register value */
-	ubrr_value = (uint16)(((F_CPU / (Config_Ptr->baud_rate * 8UL))) - 1);
-
-	/* First 8 bits from the BAUD_PRESCALE inside UBRRL and last 4 bits in UBRRH*/
-	UBRRH = ubrr_value>>8;
-	UBRRL = ubrr_value;
-}
-
-/*
- * Description :
- * Functional responsible for send byte to another UART device.
- */
-void UART_sendByte(const uint8 data)
-{
-	/*
-	 * UDRE flag is set when the Tx buffer (UDR) is empty and ready for
-	 * transmitting a new byte so wait until this flag is set to one
-	 */
-	while(BIT_IS_CLEAR(UCSRA,UDRE)){}
-
-	/*
-	 * Put the required data in the UDR register and it also clear the UDRE flag as
-	 * the UDR register is not empty now
-	 */
-	UDR = data;
-
-	/************************* Another Method *************************
-	UDR = data;
-	while(BIT_IS_CLEAR(UCSRA,TXC)){} // Wait until the transmission is complete TXC = 1
-	SET_BIT(UCSRA,TXC); // Clear the TXC flag
-	*******************************************************************/
-}
-
-/*
- * Description :
- * Functional responsible for receive byte from another UART device.
- */
-uint8 UART_recieveByte(void)
-{
-	/* RXC flag is set when the UART receive data so wait until this flag is set to one */
-	while(BIT_IS_CLEAR(UCSRA,RXC)){}
-
-	/*
-	 * Read the received data from the Rx buffer (UDR)
-	 * The RXC flag will be cleared after read the data
-	 */
-    return UDR;		
-}
-
-/*
- * Description :
- * Send the required string through UART to the other UART device.
- */
-void UART_sendString(const uint8 *Str)
-{
-	uint8 i = 0;
-
-	/* Send the whole string */
-	while(Str[i] != '\0')
-	{
-		UART_sendByte(Str[i]);
-		i++;
-	}
-	/************************* Another Method *************************
-	while(*Str != '\0')
-	{
-		UART_sendByte(*Str);
-		Str++;
-	}		
-	*******************************************************************/
-}
-
-/*
- * Description :
- * Receive the required string until the '#' symbol through UART from the other UART device.
- */
-void UART_receiveString(uint8 *Str)
-{
-	uint8 i = 0;
-
-	/* Receive the first byte */
-	Str[i] = UART_recieveByte();
-
-	/* Receive the whole string until the '#' */
-	while(Str[i] != '#')
-	{
-		i++;
-		Str[i] = UART_recieveByte();
-	}
-
-	/* After receiving the whole string plus the '#', replace the '#' with '\0' */
-	Str[i] = '\0';
-}
+ /******************************************************************************
+ *
+ * Module: UART
+ *
+ * File Name: uart.c
+ *
+ * Description: Source file for the UART AVR driver
+ *
+ * Author: Mohamed Tarek
+ *
+ *******************************************************************************/
+
+#include "uart.h"
+#include <avr/io.h> /* To use the UART Registers */
+#include <avr/interrupt.h> /* For the UART ISRs */
+#include "common_macros.h" /* To use the macros like SET_BIT */
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Writing one to TXC clears it, the flag is set again once the shift register is empty.
+ * UCSRA is written as a whole as its other flags must be written to zero, U2X is always set.
+ */
+#define UART_CLEAR_TXC()               (UCSRA = (1<<U2X) | (1<<TXC))
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+
+static UART_Mode g_uartMode = UART_POLLING_MODE;
+
+/*
+ * Single-producer/single-consumer ring buffers:
+ * Rx : the RXC ISR is the only writer of g_rxHead and the application the only writer of g_rxTail.
+ * Tx : the application is the only writer of g_txHead and the UDRE ISR the only writer of g_txTail.
+ * One slot is always left empty to distinguish the full buffer from the empty one.
+ */
+static volatile uint8 g_rxBuffer[UART_RX_BUFFER_SIZE];
+static volatile uint8 g_rxHead = 0;
+static volatile uint8 g_rxTail = 0;
+
+static volatile uint8 g_txBuffer[UART_TX_BUFFER_SIZE];
+static volatile uint8 g_txHead = 0;
+static volatile uint8 g_txTail = 0;
+
+static volatile UART_ErrorCountersType g_errorCounters = {0, 0};
+
+/* A byte was written to UDR since the last baud rate change so TXC is meaningful */
+static boolean g_txActive = FALSE;
+
+/* Caller buffers of UART_sendBuffer and UART_receiveInto, NULL_PTR when there is none */
+static const uint8 * volatile g_txBlock_Ptr = NULL_PTR;
+static volatile uint8 g_txBlockRemaining;
+static uint8 g_txBlockLength;
+static UART_CallbackType g_txBlockCallback;
+
+static uint8 * volatile g_rxBlock_Ptr = NULL_PTR;
+static volatile uint8 g_rxBlockCount;
+static uint8 g_rxBlockSize;
+static uint16 g_rxBlockTerminator;
+static UART_CallbackType g_rxBlockCallback;
+
+/*******************************************************************************
+ *                      Functions Definitions(Private)                         *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Store one received byte in the buffer of UART_receiveInto and end the transfer
+ * on the terminator or when the buffer is full
+ */
+static void UART_blockReceive(uint8 data)
+{
+	UART_CallbackType callback;
+
+	if(data != g_rxBlockTerminator)
+	{
+		g_rxBlock_Ptr[g_rxBlockCount] = data;
+		g_rxBlockCount++;
+		if(g_rxBlockCount < g_rxBlockSize)
+			return;
+	}
+
+	callback = g_rxBlockCallback;
+	g_rxBlock_Ptr = NULL_PTR;
+	if(callback != NULL_PTR)
+		callback(g_rxBlockCount);
+}
+
+/*
+ * Description :
+ * UBRR value of the baud rate with U2X = 1, rounded to the nearest divisor
+ */
+static uint16 UART_divisor(uint32 baud_rate)
+{
+	return (uint16)(((F_CPU + (baud_rate * 4UL)) / (baud_rate * 8UL)) - 1);
+}
+
+/*******************************************************************************
+ *                       Interrupt Service Routines                            *
+ *******************************************************************************/
+
+ISR(USART_RXC_vect)
+{
+	/* The error flags are valid only before reading UDR */
+	uint8 status = UCSRA;
+	uint8 data = UDR;
+	uint8 next_head;
+
+	if(BIT_IS_SET(status,DOR))
+	{
+		/* At least one byte was lost in the hardware before this one */
+		g_errorCounters.overrun++;
+	}
+
+	if(BIT_IS_SET(status,FE))
+	{
+		/* Stop bit was not found, the byte is corrupted so drop it */
+		g_errorCounters.framing++;
+		return;
+	}
+
+	if(g_rxBlock_Ptr != NULL_PTR)
+	{
+		/* Straight into the buffer of UART_receiveInto */
+		UART_blockReceive(data);
+		return;
+	}
+
+	next_head = (g_rxHead + 1) & (UART_RX_BUFFER_SIZE - 1);
+	if(next_head == g_rxTail)
+	{
+		/* The application did not empty the buffer in time */
+		g_errorCounters.overrun++;
+	}
+	else
+	{
+		g_rxBuffer[g_rxHead] = data;
+		g_rxHead = next_head;
+	}
+}
+
+ISR(USART_UDRE_vect)
+{
+	UART_CallbackType callback;
+
+	if(g_txHead != g_txTail)
+	{
+		UART_CLEAR_TXC();
+		UDR = g_txBuffer[g_txTail];
+		g_txTail = (g_txTail + 1) & (UART_TX_BUFFER_SIZE - 1);
+	}
+	else if(g_txBlock_Ptr != NULL_PTR)
+	{
+		/* Straight from the buffer of UART_sendBuffer */
+		UART_CLEAR_TXC();
+		UDR = *g_txBlock_Ptr;
+		g_txBlock_Ptr++;
+		g_txBlockRemaining--;
+		if(g_txBlockRemaining == 0)
+		{
+			g_txBlock_Ptr = NULL_PTR;
+			callback = g_txBlockCallback;
+			if(callback != NULL_PTR)
+				callback(g_txBlockLength);
+		}
+	}
+
+	if((g_txHead == g_txTail) && (g_txBlock_Ptr == NULL_PTR))
+	{
+		/* Nothing left to send, disable the interrupt until new data is queued */
+		CLEAR_BIT(UCSRB,UDRIE);
+	}
+}
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Functional responsible for Initialize the UART device by:
+ * 1. Setup the Frame format like number of data bits, parity bit type and number of stop bits.
+ * 2. Enable the UART.
+ * 3. Setup the UART baud rate.
+ */
+void UART_init(const UART_ConfigType * Config_Ptr)
+{
+	uint16 ubrr_value = 0;
+
+	/* U2X = 1 for double transmission speed */
+	UCSRA = (1<<U2X);
+
+	/* Reset the ring buffers and the error counters */
+	g_uartMode = Config_Ptr->mode;
+	g_rxHead = 0;
+	g_rxTail = 0;
+	g_txHead = 0;
+	g_txTail = 0;
+	g_errorCounters.overrun = 0;
+	g_errorCounters.framing = 0;
+	g_txActive = FALSE;
+	g_txBlock_Ptr = NULL_PTR;
+	g_rxBlock_Ptr = NULL_PTR;
+
+	/************************** UCSRB Description **************************
+	 * RXCIE = Config_Ptr->mode, 1 Enable USART RX Complete Interrupt in the interrupt mode
+	 * TXCIE = 0 Disable USART Tx Complete Interrupt Enable
+	 * UDRIE = 0 Disable USART Data Register Empty Interrupt Enable
+	 *           (enabled later only while the Tx buffer has data)
+	 * RXEN  = 1 Receiver Enable
+	 * RXEN  = 1 Transmitter Enable
+	 * UCSZ2 = 0 For 8-bit data mode
+	 * RXB8 & TXB8 not used for 8-bit data mode
+	 ***********************************************************************/ 
+	UCSRB = (1<<RXEN) | (1<<TXEN);
+	if(Config_Ptr->mode == UART_INTERRUPT_MODE)
+	{
+		SET_BIT(UCSRB,RXCIE);
+	}
+	
+	/************************** UCSRC Description **************************
+	 * URSEL   = 1 The URSEL must be one when writing the UCSRC
+	 * UMSEL   = 0 Asynchronous Operation
+	 *
+	 * UPM1:0  = Config_Ptr->parity_status
+	 *           00 Disable parity bit
+	 *           10 Enable parity bit, even
+	 *           11 Enable parity bit, odd
+	 *
+	 * USBS    = Config_Ptr->stop_bit_selection, 0 One stop bit 1 Two stop bits
+	 *
+	 * UCSZ1:0 = Config_Ptr->char_size to configure character size
+	 *
+	 * UCPOL   = 0 Used with the Synchronous operation only
+	 ***********************************************************************/ 	
+	UCSRC = (1<<URSEL);
+
+	/*Setup of parity bit*/
+	UCSRC = (UCSRC & 0xCF) | ((Config_Ptr->parity & 0x03) << UPM0);
+
+	/*Setup of stop bit*/
+	UCSRC = (UCSRC & 0xF7) | ((Config_Ptr->stop_bit & 0x01) << USBS);
+
+	/* Setup of Data Bits , character size */
+	UCSRC = (UCSRC & 0xF9) | ((((Config_Ptr->bit_data) & 0x03))<<UCSZ0);
+
+
+	/* Calculate the UBRR register value */
+	ubrr_value = UART_divisor(Config_Ptr->baud_rate);
+
+	/* First 8 bits from the BAUD_PRESCALE inside UBRRL and last 4 bits in UBRRH*/
+	UBRRH = ubrr_value>>8;
+	UBRRL = ubrr_value;
+}
+
+/*
+ * Description :
+ * Functional responsible for send byte to another UART device.
+ */
+void UART_sendByte(const uint8 data)
+{
+	if(g_uartMode == UART_INTERRUPT_MODE)
+	{
+		/* Wait only if the Tx buffer is full, the UDRE ISR will drain it */
+		while(UART_write(&data, 1) == 0){}
+		return;
+	}
+
+	/*
+	 * UDRE flag is set when the Tx buffer (UDR) is empty and ready for
+	 * transmitting a new byte so wait until this flag is set to one
+	 */
+	while(BIT_IS_CLEAR(UCSRA,UDRE)){}
+
+	/*
+	 * Put the required data in the UDR register and it also clear the UDRE flag as
+	 * the UDR register is not empty now
+	 */
+	UART_CLEAR_TXC();
+	UDR = data;
+	g_txActive = TRUE;
+
+	/************************* Another Method *************************
+	UDR = data;
+	while(BIT_IS_CLEAR(UCSRA,TXC)){} // Wait until the transmission is complete TXC = 1
+	SET_BIT(UCSRA,TXC); // Clear the TXC flag
+	*******************************************************************/
+}
+
+/*
+ * Description :
+ * Functional responsible for receive byte from another UART device.
+ */
+uint8 UART_recieveByte(void)
+{
+	uint8 data;
+
+	if(g_uartMode == UART_INTERRUPT_MODE)
+	{
+		/* Wait until the RXC ISR puts a byte in the Rx buffer */
+		while(UART_tryReceive(&data) == FALSE){}
+		return data;
+	}
+
+	/* RXC flag is set when the UART receive data so wait until this flag is set to one */
+	while(BIT_IS_CLEAR(UCSRA,RXC)){}
+
+	/*
+	 * Read the received data from the Rx buffer (UDR)
+	 * The RXC flag will be cleared after read the data
+	 */
+    return UDR;		
+}
+
+/*
+ * Description :
+ * Send the required string through UART to the other UART device.
+ */
+void UART_sendString(const uint8 *Str)
+{
+	uint8 i = 0;
+
+	/* Send the whole string */
+	while(Str[i] != '\0')
+	{
+		UART_sendByte(Str[i]);
+		i++;
+	}
+	/************************* Another Method *************************
+	while(*Str != '\0')
+	{
+		UART_sendByte(*Str);
+		Str++;
+	}		
+	*******************************************************************/
+}
+
+/*
+ * Description :
+ * Receive the required string until the '#' symbol through UART from the other UART device.
+ */
+void UART_receiveString(uint8 *Str)
+{
+	uint8 i = 0;
+
+	/* Receive the first byte */
+	Str[i] = UART_recieveByte();
+
+	/* Receive the whole string until the '#' */
+	while(Str[i] != '#')
+	{
+		i++;
+		Str[i] = UART_recieveByte();
+	}
+
+	/* After receiving the whole string plus the '#', replace the '#' with '\0' */
+	Str[i] = '\0';
+}
+
+/*
+ * Description :
+ * Get one received byte without waiting.
+ * Returns TRUE and stores the byte in data_Ptr if a byte was available, otherwise returns FALSE.
+ */
+boolean UART_tryReceive(uint8 *data_Ptr)
+{
+	uint8 status;
+
+	if(g_uartMode == UART_INTERRUPT_MODE)
+	{
+		if(g_rxHead == g_rxTail)
+		{
+			/* Rx buffer is empty */
+			return FALSE;
+		}
+		*data_Ptr = g_rxBuffer[g_rxTail];
+		g_rxTail = (g_rxTail + 1) & (UART_RX_BUFFER_SIZE - 1);
+		return TRUE;
+	}
+
+	status = UCSRA;
+	if(BIT_IS_CLEAR(status,RXC))
+	{
+		return FALSE;
+	}
+
+	if(BIT_IS_SET(status,DOR))
+	{
+		g_errorCounters.overrun++;
+	}
+
+	*data_Ptr = UDR;
+
+	if(BIT_IS_SET(status,FE))
+	{
+		g_errorCounters.framing++;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Queue up to length bytes for transmission without waiting.
+ * Returns the number of bytes accepted, which is less than length if the Tx buffer is full.
+ */
+uint8 UART_write(const uint8 *data_Ptr, uint8 length)
+{
+	uint8 count = 0;
+	uint8 next_head;
+
+	if(g_uartMode == UART_INTERRUPT_MODE)
+	{
+		if(g_txBlock_Ptr != NULL_PTR)
+		{
+			/* Sent after the buffer of UART_sendBuffer to keep the order */
+			return 0;
+		}
+		while(count < length)
+		{
+			next_head = (g_txHead + 1) & (UART_TX_BUFFER_SIZE - 1);
+			if(next_head == g_txTail)
+			{
+				/* Tx buffer is full */
+				break;
+			}
+			g_txBuffer[g_txHead] = data_Ptr[count];
+			g_txHead = next_head;
+			count++;
+		}
+
+		if(count != 0)
+		{
+			/* Let the UDRE ISR start draining the Tx buffer */
+			g_txActive = TRUE;
+			SET_BIT(UCSRB,UDRIE);
+		}
+		return count;
+	}
+
+	/* In the polling mode write only while UDR is free */
+	while((count < length) && BIT_IS_SET(UCSRA,UDRE))
+	{
+		UART_CLEAR_TXC();
+		UDR = data_Ptr[count];
+		g_txActive = TRUE;
+		count++;
+	}
+	return count;
+}
+
+/*
+ * Description :
+ * Change the baud rate once the bytes queued for transmission are completely sent,
+ * the frame format, the mode and the received bytes are kept.
+ */
+void UART_setBaudRate(uint32 baud_rate)
+{
+	uint16 ubrr_value = UART_divisor(baud_rate);
+
+	if(g_txActive == TRUE)
+	{
+		/* The UDRE ISR empties the Tx buffers then TXC is set once the last stop bit is out */
+		while(BIT_IS_CLEAR(UCSRA,UDRE) || (g_txHead != g_txTail) || (g_txBlock_Ptr != NULL_PTR)){}
+		while(BIT_IS_CLEAR(UCSRA,TXC)){}
+		g_txActive = FALSE;
+	}
+
+	UBRRH = ubrr_value>>8;
+	UBRRL = ubrr_value;
+}
+
+/*
+ * Description :
+ * Return the error of the real baud rate against the asked one in 0.1 % units, see the table above.
+ */
+sint16 UART_getBaudRateError(uint32 baud_rate)
+{
+	uint32 real_rate = F_CPU / (8UL * (UART_divisor(baud_rate) + 1UL));
+
+	return (sint16)((((sint32)real_rate - (sint32)baud_rate) * 1000L) / (sint32)baud_rate);
+}
+
+/*
+ * Description :
+ * Copy the overrun and framing error counters into counters_Ptr.
+ */
+void UART_getErrorCounters(UART_ErrorCountersType *counters_Ptr)
+{
+	/* The counters are 16-bit and updated by the RXC ISR so read them atomically */
+	uint8 sreg = SREG;
+	cli();
+	counters_Ptr->overrun = g_errorCounters.overrun;
+	counters_Ptr->framing = g_errorCounters.framing;
+	SREG = sreg;
+}
+
+/*
+ * Description :
+ * Send length bytes straight from the caller buffer, the UDRE ISR moves them to UDR and calls
+ * callback (if not NULL_PTR) once the last one is in UDR, then the buffer may be changed.
+ * The bytes of UART_write wait until the buffer is sent. Interrupt mode only.
+ * Returns FALSE if another buffer is being sent.
+ */
+boolean UART_sendBuffer(const uint8 *data_Ptr, uint8 length, UART_CallbackType callback)
+{
+	uint8 sreg = SREG;
+
+	if((g_uartMode != UART_INTERRUPT_MODE) || (length == 0))
+		return FALSE;
+
+	cli();
+	if(g_txBlock_Ptr != NULL_PTR)
+	{
+		SREG = sreg;
+		return FALSE;
+	}
+	g_txBlockLength = length;
+	g_txBlockRemaining = length;
+	g_txBlockCallback = callback;
+	g_txBlock_Ptr = data_Ptr;
+	g_txActive = TRUE;
+	SET_BIT(UCSRB,UDRIE);
+	SREG = sreg;
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Return TRUE while the buffer of UART_sendBuffer is being sent.
+ */
+boolean UART_sendBusy(void)
+{
+	return (g_txBlock_Ptr != NULL_PTR) ? TRUE : FALSE;
+}
+
+/*
+ * Description :
+ * Receive straight into the caller buffer: the bytes already in the Rx buffer first, then the
+ * RXC ISR stores the next ones until terminator (not stored) or max_length bytes, and calls
+ * callback with the number of stored bytes. The bytes after it go to the Rx buffer again.
+ * terminator is a byte value or UART_NO_TERMINATOR. Interrupt mode only.
+ * Returns FALSE if another buffer is being received.
+ */
+boolean UART_receiveInto(uint8 *buffer_Ptr, uint8 max_length, uint16 terminator, UART_CallbackType callback)
+{
+	uint8 sreg = SREG;
+	uint8 data;
+
+	if((g_uartMode != UART_INTERRUPT_MODE) || (max_length == 0))
+		return FALSE;
+
+	cli();
+	if(g_rxBlock_Ptr != NULL_PTR)
+	{
+		SREG = sreg;
+		return FALSE;
+	}
+	g_rxBlockCount = 0;
+	g_rxBlockSize = max_length;
+	g_rxBlockTerminator = terminator;
+	g_rxBlockCallback = callback;
+	g_rxBlock_Ptr = buffer_Ptr;
+
+	/* The bytes received before the call come first */
+	while((g_rxBlock_Ptr != NULL_PTR) && (g_rxHead != g_rxTail))
+	{
+		data = g_rxBuffer[g_rxTail];
+		g_rxTail = (g_rxTail + 1) & (UART_RX_BUFFER_SIZE - 1);
+		UART_blockReceive(data);
+	}
+	SREG = sreg;
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Stop the transfer of UART_receiveInto without calling its callback, the next bytes go to the Rx buffer.
+ */
+void UART_cancelReceive(void)
+{
+	uint8 sreg = SREG;
+
+	/* The pointer is two bytes, the RXC ISR must not see half of it */
+	cli();
+	g_rxBlock_Ptr = NULL_PTR;
+	SREG = sreg;
+}
@@ -1,83 +1,206 @@
- /******************************************************************************
- *
- * Module: UART
- *
- * File Name: uart.h
- *
- * Description: Header file for the UART AVR driver
- *
- * Author: Omar Muhammad
- *
- *******************************************************************************/
-
-#ifndef UART_H_
-#define UART_H_
-
-#include "std_types.h"
-
-/*******************************************************************************
- *                         Types Declaration                                   *
- *******************************************************************************/
-typedef enum
-{
-	PARITY_OFF,PARITY_EVEN = 2, PARITY_ODD
-}UART_Parity;
-
-typedef enum
-{
-	ONEBIT,TWOBIT
-}UART_StopBit;
-
-typedef enum
-{
-	FIVE_BIT, SIX_BIT, SEVEN_BIT, EIGHT_BIT, NINE_BIT = 7
-}UART_BitData;
-
-typedef struct
-{
-	UART_BitData bit_data;
-	UART_Parity parity;
-	UART_StopBit stop_bit;
-	uint32 baud_rate;
-
-}UART_ConfigType;
-
-
-/*******************************************************************************
- *                      Functions Prototypes                                   *
- *******************************************************************************/
-
-/*
- * Description :
- * Functional responsible for Initialize the UART device by:
- * 1. Setup the Frame format like number of data bits, parity bit type and number of stop bits.
- * 2. Enable the UART.
- * 3. Setup the UART baud rate.
- */
-void UART_init(const UART_ConfigType * Config_Ptr);
-
-/*
- * Description :
- * Functional responsible for send byte to another UART device.
- */
-void UART_sendByte(const uint8 data);
-
-/*
- * Description :
- * Functional responsible for receive byte from another UART device.
- */
-uint8 UART_recieveByte(void);
-
-/*
- * Description :
- * Send the required string through UART to the other UART device.
- */
-void UART_sendString(const uint8 *Str);
-
-/*
- * Description :
- * Receive the required string until the '#' symbol through UART from the other UART device.
- */
-void UART_receiveString(uint8 *Str); // Receive until #
-
-#endif /* UART_H_ */
+ /******************************************************************************
+ *
+ * Module: UART
+ *
+ * File Name: uart.h
+ *
+ * Description: Header file for the UART AVR driver
+ *
+ * Author: Omar Muhammad
+ *
+ *******************************************************************************/
+
+#ifndef UART_H_
+#define UART_H_
+
+#include "std_types.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Size of the software Rx/Tx ring buffers used in the interrupt mode,
+ * it must be a power of two as the indexes are wrapped by masking
+ */
+#define UART_RX_BUFFER_SIZE            32
+#define UART_TX_BUFFER_SIZE            32
+
+#if((UART_RX_BUFFER_SIZE & (UART_RX_BUFFER_SIZE - 1)) || (UART_TX_BUFFER_SIZE & (UART_TX_BUFFER_SIZE - 1)))
+
+#error "UART ring buffers size should be a power of two"
+
+#endif
+
+/*
+ * Baud rates with U2X = 1: UBRR = F_CPU / (8 * baud) - 1 rounded to the nearest divisor.
+ * At F_CPU = 8 MHz the divisor is exact down to 250000 baud:
+ *
+ *    baud      UBRR    real baud    error
+ *    1000000      0      1000000     0.0 %
+ *     500000      1       500000     0.0 %
+ *     250000      3       250000     0.0 %
+ *     115200      8       111111    -3.5 %
+ *      57600     16        58824    +2.1 %
+ *      38400     25        38462    +0.2 %
+ *      19200     51        19231    +0.2 %
+ *       9600    103         9615    +0.2 %
+ *
+ * The receiver samples the stop bit correctly with up to about 2 % of total error on the link.
+ */
+#define UART_MAX_BAUD_ERROR            20   /* in 0.1 % */
+
+/* Terminator of UART_receiveInto that fills the whole buffer */
+#define UART_NO_TERMINATOR             0x100
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef enum
+{
+	PARITY_OFF,PARITY_EVEN = 2, PARITY_ODD
+}UART_Parity;
+
+typedef enum
+{
+	ONEBIT,TWOBIT
+}UART_StopBit;
+
+typedef enum
+{
+	FIVE_BIT, SIX_BIT, SEVEN_BIT, EIGHT_BIT, NINE_BIT = 7
+}UART_BitData;
+
+/*
+ * UART_POLLING_MODE   : every call spins on the RXC/UDRE flags
+ * UART_INTERRUPT_MODE : the RXC/UDRE interrupts move the bytes through the ring buffers
+ */
+typedef enum
+{
+	UART_POLLING_MODE, UART_INTERRUPT_MODE
+}UART_Mode;
+
+typedef struct
+{
+	UART_BitData bit_data;
+	UART_Parity parity;
+	UART_StopBit stop_bit;
+	uint32 baud_rate;
+	UART_Mode mode;
+
+}UART_ConfigType;
+
+typedef struct
+{
+	uint16 overrun; /* Bytes lost because UDR or the Rx ring buffer was full */
+	uint16 framing; /* Bytes dropped because they were received with a framing error */
+
+}UART_ErrorCountersType;
+
+/* End of a buffer transfer, called from the UART ISR with the number of bytes moved */
+typedef void (*UART_CallbackType)(uint8 length);
+
+
+/*******************************************************************************
+ *                      Functions Prototypes                                   *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Functional responsible for Initialize the UART device by:
+ * 1. Setup the Frame format like number of data bits, parity bit type and number of stop bits.
+ * 2. Enable the UART.
+ * 3. Setup the UART baud rate.
+ */
+void UART_init(const UART_ConfigType * Config_Ptr);
+
+/*
+ * Description :
+ * Change the baud rate once the bytes queued for transmission are completely sent,
+ * the frame format, the mode and the received bytes are kept.
+ */
+void UART_setBaudRate(uint32 baud_rate);
+
+/*
+ * Description :
+ * Return the error of the real baud rate against the asked one in 0.1 % units, see the table above.
+ */
+sint16 UART_getBaudRateError(uint32 baud_rate);
+
+/*
+ * Description :
+ * Functional responsible for send byte to another UART device.
+ */
+void UART_sendByte(const uint8 data);
+
+/*
+ * Description :
+ * Functional responsible for receive byte from another UART device.
+ */
+uint8 UART_recieveByte(void);
+
+/*
+ * Description :
+ * Send the required string through UART to the other UART device.
+ */
+void UART_sendString(const uint8 *Str);
+
+/*
+ * Description :
+ * Receive the required string until the '#' symbol through UART from the other UART device.
+ * The length is not bounded, UART_receiveInto is the bounded receive.
+ */
+void UART_receiveString(uint8 *Str); // Receive until #
+
+/*
+ * Description :
+ * Get one received byte without waiting.
+ * Returns TRUE and stores the byte in data_Ptr if a byte was available, otherwise returns FALSE.
+ */
+boolean UART_tryReceive(uint8 *data_Ptr);
+
+/*
+ * Description :
+ * Queue up to length bytes for transmission without waiting.
+ * Returns the number of bytes accepted, which is less than length if the Tx buffer is full.
+ */
+uint8 UART_write(const uint8 *data_Ptr, uint8 length);
+
+/*
+ * Description :
+ * Copy the overrun and framing error counters into counters_Ptr.
+ */
+void UART_getErrorCounters(UART_ErrorCountersType *counters_Ptr);
+
+/*
+ * Description :
+ * Send length bytes straight from the caller buffer, the UDRE ISR moves them to UDR and calls
+ * callback (if not NULL_PTR) once the last one is in UDR, then the buffer may be changed.
+ * The bytes of UART_write wait until the buffer is sent. Interrupt mode only.
+ * Returns FALSE if another buffer is being sent.
+ */
+boolean UART_sendBuffer(const uint8 *data_Ptr, uint8 length, UART_CallbackType callback);
+
+/*
+ * Description :
+ * Return TRUE while the buffer of UART_sendBuffer is being sent.
+ */
+boolean UART_sendBusy(void);
+
+/*
+ * Description :
+ * Receive straight into the caller buffer: the bytes already in the Rx buffer first, then the
+ * RXC ISR stores the next ones until terminator (not stored) or max_length bytes, and calls
+ * callback with the number of stored bytes. The bytes after it go to the Rx buffer again.
+ * terminator is a byte value or UART_NO_TERMINATOR. Interrupt mode only.
+ * Returns FALSE if another buffer is being received.
+ */
+boolean UART_receiveInto(uint8 *buffer_Ptr, uint8 max_length, uint16 terminator, UART_CallbackType callback);
+
+/*
+ * Description :
+ * Stop the transfer of UART_receiveInto without calling its callback, the next bytes go to the Rx buffer.
+ */
+void UART_cancelReceive(void);
+
+#endif /* UART_H_ */
@@ -0,0 +1,27 @@
+################################################################################
+# Automatically-generated file. Do not edit!
+################################################################################
+
+# Add inputs and outputs from these tool invocations to the build variables 
+C_SRCS += \
+../HAL/keypad.c \
+../HAL/lcd.c 
+
+OBJS += \
+./HAL/keypad.o \
+./HAL/lcd.o 
+
+C_DEPS += \
+./HAL/keypad.d \
+./HAL/lcd.d 
+
+
+# Each subdirectory must supply rules for building sources it contributes
+HAL/%.o: ../HAL/%.c HAL/subdir.mk
+	@echo 'Building file: $<'
+	@echo 'Invoking: AVR Compiler'
+	avr-gcc -Wall -g2 -Os -flto -fpack-struct -fshort-enums -ffunction-sections -fdata-sections -std=gnu99 -funsigned-char -funsigned-bitfields -mmcu=atmega32 -DF_CPU=8000000UL -MMD -MP -MF"$(@:%.o=%.d)" -MT"$@" -c -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
+
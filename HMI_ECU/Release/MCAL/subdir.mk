@@ -0,0 +1,30 @@
+################################################################################
+# Automatically-generated file. Do not edit!
+################################################################################
+
+# Add inputs and outputs from these tool invocations to the build variables 
+C_SRCS += \
+../MCAL/gpio.c \
+../MCAL/timer.c \
+../MCAL/uart.c 
+
+OBJS += \
+./MCAL/gpio.o \
+./MCAL/timer.o \
+./MCAL/uart.o 
+
+C_DEPS += \
+./MCAL/gpio.d \
+./MCAL/timer.d \
+./MCAL/uart.d 
+
+
+# Each subdirectory must supply rules for building sources it contributes
+MCAL/%.o: ../MCAL/%.c MCAL/subdir.mk
+	@echo 'Building file: $<'
+	@echo 'Invoking: AVR Compiler'
+	avr-gcc -Wall -g2 -Os -flto -fpack-struct -fshort-enums -ffunction-sections -fdata-sections -std=gnu99 -funsigned-char -funsigned-bitfields -mmcu=atmega32 -DF_CPU=8000000UL -MMD -MP -MF"$(@:%.o=%.d)" -MT"$@" -c -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
+
@@ -1,354 +1,710 @@
-/*
- ================================================================================================
- File Name: app.c
- Name        : Door Locker Security System
- Author      : Omar Muhammad
- Description : Source file of HMI_ECU (Human Machine Interface) is just responsible interaction with the user
-               just take inputs through keypad and display messages on the LCD.
- Date        : 26/10/2022
- ================================================================================================
- */
-
-#include "app.h"
-#include "HAL/lcd.h"
-#include "HAL/keypad.h"
-#include "MCAL/timer.h"
-#include "MCAL/uart.h"
-#include <util/delay.h>
-#include <avr/io.h> /* To enable I- bit*/
-
-/********************************************************************
- *                           Global variables
- ********************************************************************/
-uint8 g_passArray[PASSWORD_SIZE]; /* Global array to keep the read password*/
-system_state g_systemState;       /* Global variable to keep system state*/
-uint8 g_seconds;                  /* Global variable to count seconds*/
-
-/* Main function*/
-int main(void)
-{
-	UART_ConfigType UART_Config = {EIGHT_BIT,PARITY_OFF,ONEBIT,UART_BAUDRATE};
-
-	LCD_init();              /* Initialize the LCD Module*/
-	UART_init(&UART_Config); /* Initialize the UART Module*/
-
-	SREG |= (1<<7);       /* Enable I-Bit for Interrupts */
-
-	/*Display system name message on the LCD*/
-	LCD_moveCursor(0,3);
-	LCD_displayString("Door locker");
-	LCD_moveCursor(1,1);
-	LCD_displayString("Security system");
-	_delay_ms(SYSTEM_OPENING_DELAY);
-
-	/*Set status*/
-	setSystemState ();
-
-	while(1)
-	{
-		/* calling functions from the array of functions */
-		(*ptr_states[g_systemState])();
-	}
-
-	return 0;
-}
-
-/*******************************************************************************
- *                      Functions Definitions                                  *
- *******************************************************************************/
-
-/*
- * Description :
- *    Set the state of the system whether to create password (as for the first time
- *    or to repeat the creating process as the password wasn't matched)
- *    or to move to main options*/
-
-void setSystemState (void)
-{
-	system_state state;
-
-	/*Sync the two micro-controllers */
-	syncMicroCOntrollers();
-
-	/*----------------------------------------
-	 *  Set the state of the system
-	 *  --------------------------------------*/
-
-	/* Get the next state of the system based on the password state*/
-	UART_sendByte(STATE);
-	while(UART_recieveByte() != SENDING){}
-	state = UART_recieveByte();
-
-	if(state == SETUP)
-		g_systemState = CREATE_SYSTEM;
-	else if (state == ERRORSYSTEM)
-	{
-		g_systemState = ERROR_STATE;
-	}
-	else if (state == STARTUP)
-	{
-		g_systemState = MAIN_OPTION;
-	}
-	else
-	{
-		g_systemState = OPEN_DOOR;
-	}
-}
-
-/*
- * Description :
- * 1. Display messages to guide the user to create password
- * 2. Read the password from the user and send it to the Control_ECU
- *    through the UART Module to save it in memory and to confirm the
- *    password in the second attempt
- */
-void createSystemPassword(void)
-{
-	/* Send command to the Control_Ecu to store two coming passwords */
-	sendCommand (CREATE_TWO_PASSWORD);
-
-	/*Entering the password messages
-	 * -----------------------------------------------------
-	 * 1. Display on the LCD to enter the password*/
-	LCD_clearScreen();
-	LCD_displayString("Plz enter pass:");
-	LCD_moveCursor(1,0);
-	/*2. Reading the password from the user*/
-	ReadPassword();
-	/*3. Send the password to the Control_ECU*/
-	SendPassword(g_passArray);
-
-	/*Confirmation of entered password messages
-	 * --------------------------------------------------
-	 * 1. Display on the LCD to re-enter the password*/
-	LCD_moveCursor(0,0);
-	LCD_displayString("Plz re-enter the");
-	LCD_moveCursor(1,0);
-	LCD_displayString("same pass:");
-	/*2. Read the password again from the user*/
-	ReadPassword ();
-	/*3. Send the password to the Control_ECU*/
-	SendPassword(g_passArray);
-
-	/* Receive from the Control_ECU the next state (action)*/
-	setSystemState ();
-}
-
-/*
- * Description :
- * Read the password from the user and store it in an array
- */
-void ReadPassword (void)
-{
-	uint8 counter;
-	uint8 PasswordDigit;
-
-	/*Loop to get the password correctly from the user*/
-	for(counter = 0; counter<= PASSWORD_SIZE-1; counter++)
-	{
-		/*Loop to ensure that the entered character from the keypad
-		 * is within the accepted range*/
-		do
-		{
-			PasswordDigit = KEYPAD_getPressedKey();
-
-			if((PasswordDigit <= 9) && (PasswordDigit >= 0))
-			{
-				g_passArray[counter] = PasswordDigit;
-				LCD_displayCharacter('*');
-				break;
-			}
-		}while(1);
-		_delay_ms(PRESS_TIME); /* Press time */
-	}
-
-	while(PasswordDigit != '=')
-	{
-		PasswordDigit = KEYPAD_getPressedKey();
-	}
-}
-
-/*
- * Description :
- * Send the password to the Control_ECU through UART
- */
-void SendPassword (const uint8 *password_Ptr)
-{
-	uint8 counter;
-
-	/*Send the password*/
-	for(counter = 0; counter <= (PASSWORD_SIZE-1); counter++)
-	{
-		UART_sendByte(password_Ptr[counter]);
-	}
-	while(UART_recieveByte() != RECEIVED){}
-}
-
-/*
- * Description :
- * 1. Display main option message
- * 2. Read the desired decision from the user
- * 3. Read and check password with Contol_ECU
- * 4. Set the state of the system to open door or change password
- */
-
-void mainOptions(void)
-{
-	uint8 option;
-	LCD_moveCursor(0,0);
-	LCD_displayString("+ : Open Door   ");
-	LCD_moveCursor(1,0);
-	LCD_displayString("- : Change Pass ");
-
-	do
-	{
-		option = KEYPAD_getPressedKey();
-	}while(option != '+' && option != '-');
-
-	/* Check authority by entering first the correct saved passwordS*/
-	checkAuthority();
-
-	if(option == '-')
-	{
-		/* Change password command*/
-		/* Send command to the Control_Ecu to store one coming passwords */
-		sendCommand (CHANGE);
-	}
-	else if (option == '+')
-	{
-		/*Open door command*/
-		/* Send command to the Control_Ecu to store one coming passwords */
-		sendCommand (OPEN);
-	}
-
-	/*Get the next state of the system*/
-	setSystemState ();
-
-	if(g_systemState == OPEN_DOOR)
-	{
-		openDoorScreen();
-		/*Get the next state of the system*/
-		setSystemState ();
-	}
-}
-
-/*
- * Description :
- * 1. Read password from the user
- * 2. communicate with the Control_ECU to check if the
- * entered password is like that saved in the memory or not
- */
-void checkAuthority(void)
-{
-	/* Send command to the Control_Ecu to store one coming passwords */
-	sendCommand (CHECK_PASSWORD);
-
-	do{
-		/* 1. Display on the LCD to enter the password*/
-		LCD_clearScreen();
-		LCD_displayString("Plz enter pass:");
-		LCD_moveCursor(1,0);
-		/*2. Read the password from the user*/
-		ReadPassword ();
-		/*3. Send the password to the Control_ECU*/
-		SendPassword(g_passArray);
-
-	}while(UART_recieveByte() == READ_AGAIN);
-}
-
-/*
- * Description :
- * Display the state of the door
- */
-void openDoorScreen(void)
-{
-	LCD_clearScreen();
-	LCD_displayString("    Door is ");
-	LCD_moveCursor(1,0);
-	LCD_displayString(" 	 Unlocking");
-	delaySeconds(15);
-
-	LCD_clearScreen();
-	LCD_displayString("  Door opened");
-	delaySeconds(3);
-
-	LCD_clearScreen();
-	LCD_displayString(" Door is locking");
-	delaySeconds(15);
-}
-
-/*
- * Description :
- * Callback function of the timer
- */
-void countSec(void)
-{
-	g_seconds++;
-}
-
-/*
- * Description :
- * Delay function by seconds operates with Timer1
- */
-void delaySeconds(uint8 sec)
-{
-	/* setting the callBack function to count seconds */
-	Timer1_setCallBack(countSec);
-
-	/* timer1 configurations to count sec per interrupt */
-	Timer1_ConfigType timer1Config = {0,31250,F_CPU_256,CTC};
-
-	Timer1_init(&timer1Config); /* Initialize the TIMER1 Module*/
-
-	while(g_seconds < sec){}
-	g_seconds = 0;
-
-	Timer1_deInit();           /* Disable the TIMER1 Module*/
-
-}
-
-/*
- * Description :
- * 1. Display error message on the LCD
- * 2. Hold the keypad response for one minute
- */
-void errorState (void)
-{
-	sendCommand (FalsePassword);
-
-	/* Display on the LCD Error message*/
-	LCD_clearScreen();
-	LCD_moveCursor(ERROR_MESSAGEO_ROW,ERROR_MESSAGEO_COLUMN);
-	LCD_displayString("ERROR!");
-
-	LCD_moveCursor(1,0);
-	LCD_displayString("Wrong  Password");
-;
-
-	/* Delay for one minute*/
-	delaySeconds(DELAY_MINUTE);
-
-	g_systemState = MAIN_OPTION;
-}
-
-/*
- * Description :
- * UART send command to Control_ECU
- */
-void sendCommand (uint8 a_command)
-{
-	UART_sendByte(a_command);
-	while(UART_recieveByte() != FINISHED){}
-}
-
-/*
- * Description :
- * Sync the two micro-controllers
- */
-void syncMicroCOntrollers(void)
-{
-	UART_sendByte(GET_READY);
-	while(UART_recieveByte() != READY){}
-}
-
-
+/*
+ ================================================================================================
+ File Name: app.c
+ Name        : Door Locker Security System
+ Author      : Omar Muhammad
+ Description : Source file of HMI_ECU (Human Machine Interface) is just responsible interaction with the user
+               just take inputs through keypad and display messages on the LCD.
+ Date        : 26/10/2022
+ ================================================================================================
+ */
+
+#include "app.h"
+#include "scheduler.h"
+#include "HAL/lcd.h"
+#include "HAL/keypad.h"
+#include "MCAL/uart.h"
+#include "MCAL/timer.h"
+#include <avr/io.h> /* To enable I- bit*/
+#include <stdlib.h> /* For itoa and utoa*/
+#include <string.h> /* For memcpy and strcat*/
+
+/********************************************************************
+ *                           Global variables
+ ********************************************************************/
+system_state g_systemState;       /* Global variable to keep system state*/
+
+/* Main function*/
+int main(void)
+{
+	UART_ConfigType UART_Config = {EIGHT_BIT,PARITY_OFF,ONEBIT,UART_BAUDRATE,UART_INTERRUPT_MODE};
+	uint32 baud_rate;
+
+	LCD_init();              /* Initialize the LCD Module*/
+	KEYPAD_init();           /* Initialize the Keypad Module*/
+	UART_init(&UART_Config); /* Initialize the UART Module*/
+	PROTOCOL_init();         /* Initialize the frame receiver*/
+	SCHEDULER_init();        /* Start the 1 ms system tick*/
+	Timer1_setCallBack(systemTick); /* Scan the keypad from the tick*/
+
+	SREG |= (1<<7);       /* Enable I-Bit for Interrupts */
+
+	/*Display system name message on the LCD*/
+	LCD_bufferWrite(0,3,"Door locker");
+	LCD_bufferWrite(1,1,"Security system");
+	LCD_flush();
+	SCHEDULER_delayMs(SYSTEM_OPENING_DELAY);
+
+	/*Agree with the Control_ECU on the fastest UART rate then ask for the saved status*/
+	baud_rate = PROTOCOL_negotiateBaud();
+	sendCommand(MSG_GET_STATE, NULL_PTR, 0);
+
+	/*Set status*/
+	setSystemState ();
+
+	/*The Control_ECU was still busy with its boot when the rates were offered, it answers now*/
+	if(baud_rate == PROTOCOL_BASE_BAUD_RATE)
+		PROTOCOL_negotiateBaud();
+
+	while(1)
+	{
+		/* calling functions from the array of functions */
+		(*ptr_states[g_systemState])();
+	}
+
+	return 0;
+}
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ *Description :
+ *    Wait for the MSG_STATE frame from the Control_ECU and set the state of the system
+ *    whether to create password (as for the first time or to repeat the creating process
+ *    as the password wasn't matched) or to move to main options.
+ *    Asks again while the Control_ECU reports a memory error or does not answer, the request
+ *    is lost while the Control_ECU is busy at another rate.
+ *    Returns the received state code.
+ */
+uint8 setSystemState (void)
+{
+	PROTOCOL_Frame reply;
+	uint8 state;
+
+	/* Get the next state of the system based on the password state*/
+	while(1)
+	{
+		do
+		{
+			while(PROTOCOL_waitReply(&reply, MSG_STATE, STATE_REQUEST_TIMEOUT) == FALSE)
+			{
+				sendCommand(MSG_GET_STATE, NULL_PTR, 0);
+			}
+		}while(reply.length != 1);
+		state = reply.payload[0];
+
+		if(state != MEMORY_ERROR)
+			break;
+
+		/* The Control_ECU could not access its memory, keep asking until it recovers*/
+		LCD_bufferClear();
+		LCD_bufferWrite(0,1,"Memory error!");
+		LCD_flush();
+		SCHEDULER_delayMs(MEMORY_ERROR_DELAY);
+		sendCommand(MSG_GET_STATE, NULL_PTR, 0);
+	}
+
+	if(state == SETUP)
+		g_systemState = CREATE_SYSTEM;
+	else if (state == ERRORSYSTEM)
+	{
+		g_systemState = ERROR_STATE;
+	}
+	else if (state == STARTUP)
+	{
+		g_systemState = MAIN_OPTION;
+	}
+	else if (state == USERS_MENU)
+	{
+		g_systemState = USERS_STATE;
+	}
+
+	return state;
+}
+
+/*
+ * Description :
+ * 1. Display messages to guide the user to create password
+ * 2. Stream the password and its confirmation to the Control_ECU as they are typed
+ *    then ask it to check and save the password in memory
+ */
+void createSystemPassword(void)
+{
+	/*Entering the password messages
+	 * -----------------------------------------------------
+	 * 1. Display on the LCD to enter the password*/
+	LCD_bufferClear();
+	LCD_bufferWrite(0,0,"Plz enter pass:");
+	LCD_flush();
+	LCD_moveCursor(1,0);
+	/*2. Reading the password from the user, the state is still CREATE_SYSTEM so a link error starts it again*/
+	if(ReadPassword(0) == FALSE)
+		return;
+
+	/*Confirmation of entered password messages
+	 * --------------------------------------------------
+	 * 1. Display on the LCD to re-enter the password*/
+	LCD_bufferWrite(0,0,"Plz re-enter the");
+	LCD_bufferWrite(1,0,"same pass:");
+	LCD_flush();
+	LCD_moveCursor(1,10); /* after "same pass:" */
+	/*2. Read the password again from the user, the Control_ECU checks every digit against the first password*/
+	if(ReadPassword (PASSWORD_SIZE) == FALSE)
+		return;
+
+	/*3. Ask the Control_ECU for the verdict of the two passwords*/
+	sendCommand (MSG_CREATE_PASSWORD, NULL_PTR, 0);
+
+	/* Receive from the Control_ECU the next state (action)*/
+	setSystemState ();
+}
+
+/*
+ * Description :
+ * Read the password from the user and send every digit to the Control_ECU as it is typed,
+ * the digits are numbered from a_firstIndex. Returns TRUE when '=' is pressed, or FALSE when a digit
+ * could not be delivered: the link error is shown and the entry has to be typed again.
+ */
+boolean ReadPassword (uint8 a_firstIndex)
+{
+	uint8 counter;
+	/*The digit index followed by the digit*/
+	uint8 digitFrame[2];
+
+	/*Loop to get the password correctly from the user*/
+	for(counter = 0; counter<= PASSWORD_SIZE-1; counter++)
+	{
+		/*Loop to ensure that the entered character from the keypad
+		 * is within the accepted range*/
+		do
+		{
+			digitFrame[1] = readKey();
+
+			if((digitFrame[1] <= 9) && (digitFrame[1] >= 0))
+			{
+				/*The Control_ECU checks the digit now, only the verdict waits for '='*/
+				digitFrame[0] = a_firstIndex + counter;
+				if(sendDigit(digitFrame) == FALSE)
+				{
+					/*Not a wrong password, nothing is checked until every digit is delivered*/
+					LCD_bufferClear();
+					LCD_bufferWrite(0,2,"Link error!");
+					LCD_flush();
+					SCHEDULER_delayMs(LINK_ERROR_DELAY);
+					KEYPAD_clearEvents();
+					return FALSE;
+				}
+				LCD_displayCharacter('*');
+				break;
+			}
+		}while(1);
+	}
+
+	while(digitFrame[1] != '=')
+	{
+		digitFrame[1] = readKey();
+	}
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Send a digit frame until the Control_ECU acknowledges its index, a NACK re-sends it too.
+ * The late acknowledgements of the previous digit are dropped.
+ * Returns FALSE if no acknowledgement came after DIGIT_SEND_ATTEMPTS.
+ */
+boolean sendDigit (const uint8 *a_digitFrame)
+{
+	PROTOCOL_Frame reply;
+	uint8 attempt;
+
+	for(attempt = 0; attempt < DIGIT_SEND_ATTEMPTS; attempt++)
+	{
+		sendCommand(MSG_PASSWORD_DIGIT, a_digitFrame, 2);
+		while(PROTOCOL_waitReply(&reply, MSG_DIGIT_ACK, DIGIT_ACK_TIMEOUT) == TRUE)
+		{
+			if((reply.length == 1) && (reply.payload[0] == a_digitFrame[0]))
+				return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/*
+ * Description :
+ * Wait for the next key press, meanwhile answer the NACK of a late frame
+ */
+uint8 readKey (void)
+{
+	KEYPAD_EventType event;
+	PROTOCOL_Frame frame;
+
+	do
+	{
+		while(KEYPAD_getEvent(&event) == FALSE)
+		{
+			/*Every digit is acknowledged already, only a NACK can come and it is handled inside*/
+			PROTOCOL_receiveFrame(&frame);
+		}
+	}while(event.state != KEYPAD_PRESS);
+
+	return event.key;
+}
+
+/*
+ * Description :
+ * 1. Display main option message
+ * 2. Read the desired decision from the user, '*' opens the user codes management
+ * 3. Read and check password with Contol_ECU
+ * 4. Set the state of the system to open door, change password or manage the users
+ */
+
+void mainOptions(void)
+{
+	uint8 option;
+	uint8 state;
+	LCD_bufferWrite(0,0,"+ : Open Door   ");
+	LCD_bufferWrite(1,0,"- : Change Pass ");
+	LCD_flush();
+
+	do
+	{
+		option = KEYPAD_getPressedKey();
+	}while(option != '+' && option != '-' && option != '*');
+
+	/* Check authority by entering first the correct saved password with the required action*/
+	if(option == '-')
+	{
+		/* Change password command*/
+		state = checkAuthority(CHANGE);
+	}
+	else if(option == '*')
+	{
+		/* Manage the user codes, the master password only opens the users menu*/
+		state = checkAuthority(MANAGE_USERS);
+	}
+	else
+	{
+		/*Open door command*/
+		state = checkAuthority(OPEN);
+	}
+
+	if(state == OPEN_DOOR)
+	{
+		openDoorScreen();
+		/*Get the next state of the system after the door is locked*/
+		setSystemState ();
+	}
+}
+
+/*
+ * Description :
+ * 1. Read password from the user, the digits are streamed to the Control_ECU
+ * 2. send the required action to the Control_ECU to check if the
+ * entered password is like that saved in the memory or not
+ * Returns the state replied by the Control_ECU
+ */
+uint8 checkAuthority(uint8 a_action)
+{
+	uint8 state;
+
+	do{
+		/* 1. Display on the LCD to enter the password*/
+		LCD_bufferClear();
+		LCD_bufferWrite(0,0,"Plz enter pass:");
+		LCD_flush();
+		LCD_moveCursor(1,0);
+		/*2. Read the password from the user, nothing is checked after a link error*/
+		if(ReadPassword (0) == FALSE)
+		{
+			state = READ_AGAIN;
+			continue;
+		}
+		/*3. Send the action, the Control_ECU already checked the digits*/
+		sendCommand(MSG_CHECK_PASSWORD, &a_action, 1);
+
+		state = setSystemState();
+	}while(state == READ_AGAIN);
+
+	return state;
+}
+
+/*
+ * Description :
+ * Display the state of the door
+ */
+void openDoorScreen(void)
+{
+	LCD_bufferClear();
+	LCD_bufferWrite(0,0,"    Door is ");
+	LCD_bufferWrite(1,0," 	 Unlocking");
+	LCD_flush();
+	delaySeconds(15);
+
+	LCD_bufferClear();
+	LCD_bufferWrite(0,0,"  Door opened");
+	LCD_flush();
+	delaySeconds(3);
+
+	LCD_bufferClear();
+	LCD_bufferWrite(0,0," Door is locking");
+	LCD_flush();
+	delaySeconds(15);
+}
+
+/*
+ * Description :
+ * Users menu, opened by the master password:
+ * add or remove a user code, list the used slots or go back to the main options
+ */
+void usersMenu(void)
+{
+	uint8 option;
+	uint8 code[PASSWORD_SIZE];
+	PROTOCOL_Frame reply;
+
+	LCD_bufferClear();
+	LCD_bufferWrite(0,0,"+Add -Del =End");
+	LCD_bufferWrite(1,0,"*List %Log");
+	LCD_flush();
+
+	do
+	{
+		option = KEYPAD_getPressedKey();
+	}while(option != '+' && option != '-' && option != '*' && option != '%' && option != '=');
+
+	if(option == '=')
+	{
+		/* The Control_ECU leaves the users menu when asked for its state*/
+		sendCommand(MSG_GET_STATE, NULL_PTR, 0);
+		setSystemState ();
+		return;
+	}
+
+	if(option == '*')
+	{
+		listUsers();
+		return;
+	}
+
+	if(option == '%')
+	{
+		showAuditLog();
+		return;
+	}
+
+	LCD_bufferClear();
+	LCD_bufferWrite(0,0,"User code:");
+	LCD_flush();
+	LCD_moveCursor(1,0);
+	ReadUserCode(code);
+	sendCommand((option == '+') ? MSG_ADD_USER : MSG_REMOVE_USER, code, PASSWORD_SIZE);
+
+	if(waitUserReply(&reply, MSG_USER_RESULT) == TRUE)
+		showUserResult(&reply);
+}
+
+/*
+ * Description :
+ * Read a user code of PASSWORD_SIZE digits ended by '=' in the given array
+ */
+void ReadUserCode(uint8 *code_Ptr)
+{
+	uint8 counter;
+	uint8 key;
+
+	for(counter = 0; counter<= PASSWORD_SIZE-1; counter++)
+	{
+		do
+		{
+			key = KEYPAD_getPressedKey();
+		}while(key > 9);
+
+		code_Ptr[counter] = key;
+		LCD_displayCharacter('*');
+	}
+
+	while(key != '=')
+	{
+		key = KEYPAD_getPressedKey();
+	}
+}
+
+/*
+ * Description :
+ * Page through the used slots of the user codes table, '=' leaves the list
+ */
+void listUsers(void)
+{
+	PROTOCOL_Frame reply;
+	uint16 first = 0;
+	uint8 request[2];
+	uint8 counter;
+	char text[6];
+
+	do
+	{
+		request[0] = (uint8)first;
+		request[1] = (uint8)(first >> 8);
+		sendCommand(MSG_LIST_USERS, request, 2);
+		if(waitUserReply(&reply, MSG_USER_LIST) == FALSE)
+			return;
+		if(reply.type != MSG_USER_LIST)
+		{
+			showUserResult(&reply);
+			return;
+		}
+
+		/* Users count on the first row then up to USER_LIST_SLOTS slot numbers*/
+		LCD_bufferClear();
+		LCD_bufferWrite(0,0,"Users:");
+		itoa(reply.payload[0] | ((uint16)reply.payload[1] << 8), text, 10);
+		LCD_bufferWrite(0,7,text);
+		for(counter = 4; (counter + 1) < reply.length; counter += 2)
+		{
+			itoa(reply.payload[counter] | ((uint16)reply.payload[counter + 1] << 8), text, 10);
+			LCD_bufferWrite(1,2*(counter - 4),text);
+		}
+		LCD_flush();
+		first = reply.payload[2] | ((uint16)reply.payload[3] << 8);
+	}while((KEYPAD_getPressedKey() != '=') && (first != USER_LIST_END));
+}
+
+/*
+ * Description :
+ * Wait for the reply of the given type to a users menu request, or for MSG_USER_RESULT that
+ * reports its failure. If the Control_ECU left the users menu it answers with its state,
+ * the state is applied and FALSE is returned.
+ */
+boolean waitUserReply(PROTOCOL_Frame *reply_Ptr, uint8 type)
+{
+	do
+	{
+		PROTOCOL_waitFrame(reply_Ptr);
+	}while((reply_Ptr->type != type) && (reply_Ptr->type != MSG_USER_RESULT) && (reply_Ptr->type != MSG_STATE));
+
+	if(reply_Ptr->type != MSG_STATE)
+		return TRUE;
+
+	sendCommand(MSG_GET_STATE, NULL_PTR, 0);
+	setSystemState ();
+	return FALSE;
+}
+
+/*
+ * Description :
+ * Ask the Control_ECU for the audit log one page at a time, newest first, and show the
+ * received entries newest first. Any key shows the one before and '=' leaves the log.
+ */
+void showAuditLog(void)
+{
+	PROTOCOL_Frame reply;
+	uint8 page = 0;
+	uint8 count;
+
+	do
+	{
+		sendCommand(MSG_DUMP_LOG, &page, 1);
+
+		/* A late reply to another page is dropped*/
+		do
+		{
+			if(waitUserReply(&reply, MSG_LOG_DATA) == FALSE)
+				return;
+			if(reply.type == MSG_USER_RESULT)
+			{
+				showUserResult(&reply);
+				return;
+			}
+		}while((reply.length == 0) || (reply.payload[0] != page));
+
+		count = (reply.length - 1) / LOG_ENTRY_SIZE;
+		if((count == 0) && (page == 0))
+		{
+			LCD_bufferClear();
+			LCD_bufferWrite(0,0,"Log is empty");
+			LCD_flush();
+			SCHEDULER_delayMs(USER_RESULT_DELAY);
+			return;
+		}
+
+		while(count != 0)
+		{
+			count--;
+			showLogEntry(&reply.payload[1 + count*LOG_ENTRY_SIZE]);
+			if(KEYPAD_getPressedKey() == '=')
+				return;
+		}
+		page++;
+	}while(reply.length > 1);
+}
+
+/*
+ * Description :
+ * Display one audit log entry: event and result, boot count and seconds since that power up,
+ * then the user slot or the number of dropped entries
+ */
+void showLogEntry(const uint8 *entry_Ptr)
+{
+	uint16 slot = entry_Ptr[1] | ((uint16)entry_Ptr[2] << 8);
+	uint32 seconds = entry_Ptr[4] | ((uint16)entry_Ptr[5] << 8) | ((uint32)entry_Ptr[6] << 16);
+	char text[16];
+
+	LCD_bufferClear();
+	switch(entry_Ptr[0] >> 4)
+	{
+	case LOG_POWER_UP:
+		LCD_bufferWrite(0,0,"Power up");
+		break;
+	case LOG_OPEN:
+		LCD_bufferWrite(0,0,"Open");
+		break;
+	case LOG_CHANGE:
+		LCD_bufferWrite(0,0,"Change");
+		break;
+	case LOG_USERS:
+		LCD_bufferWrite(0,0,"Users");
+		break;
+	case LOG_SAVE_PASSWORD:
+		LCD_bufferWrite(0,0,"New pass");
+		break;
+	case LOG_ADD_USER:
+		LCD_bufferWrite(0,0,"Add user");
+		break;
+	case LOG_DROPPED:
+		LCD_bufferWrite(0,0,"Dropped");
+		break;
+	default:
+		LCD_bufferWrite(0,0,"Del user");
+		break;
+	}
+
+	switch(entry_Ptr[0] & 0x0F)
+	{
+	case LOG_OK:
+		LCD_bufferWrite(0,9,"ok");
+		break;
+	case LOG_DENIED:
+		LCD_bufferWrite(0,9,"denied");
+		break;
+	case LOG_LOCKOUT:
+		LCD_bufferWrite(0,9,"lockout");
+		break;
+	default:
+		LCD_bufferWrite(0,9,"failed");
+		break;
+	}
+
+	/* Boot count then the seconds since that power up of the Control_ECU*/
+	utoa(entry_Ptr[3], text, 10);
+	strcat(text, ".");
+	ultoa(seconds, &text[strlen(text)], 10);
+	strcat(text, "s");
+	LCD_bufferWrite(1,0,text);
+	if(slot != LOG_NO_SLOT)
+	{
+		/* The count of a LOG_DROPPED entry in place of the slot*/
+		text[0] = '#';
+		utoa(slot, &text[1], 10);
+		LCD_bufferWrite(1,LCD_COLUMNS - strlen(text),text);
+	}
+	LCD_flush();
+}
+
+/*
+ * Description :
+ * Display the result of a MSG_USER_RESULT frame for USER_RESULT_DELAY
+ */
+void showUserResult(const PROTOCOL_Frame *reply_Ptr)
+{
+	char text[6];
+
+	LCD_bufferClear();
+	switch(reply_Ptr->payload[0])
+	{
+	case USER_ADDED:
+		LCD_bufferWrite(0,0,"User added");
+		break;
+	case USER_REMOVED:
+		LCD_bufferWrite(0,0,"User removed");
+		break;
+	case USER_EXISTS:
+		LCD_bufferWrite(0,0,"Already saved");
+		break;
+	case USER_UNKNOWN:
+		LCD_bufferWrite(0,0,"Unknown code");
+		break;
+	case USER_TABLE_FULL:
+		LCD_bufferWrite(0,0,"Table is full");
+		break;
+	default:
+		LCD_bufferWrite(0,0,"Memory error!");
+		break;
+	}
+
+	if((reply_Ptr->payload[0] == USER_ADDED) || (reply_Ptr->payload[0] == USER_REMOVED))
+	{
+		LCD_bufferWrite(1,0,"Slot:");
+		itoa(reply_Ptr->payload[1] | ((uint16)reply_Ptr->payload[2] << 8), text, 10);
+		LCD_bufferWrite(1,6,text);
+	}
+	LCD_flush();
+	SCHEDULER_delayMs(USER_RESULT_DELAY);
+}
+
+/*
+ * Description :
+ * Delay function by seconds operates with the system tick,
+ * the scheduler tasks keep running meanwhile
+ */
+void delaySeconds(uint8 sec)
+{
+	SCHEDULER_delayMs(sec * 1000UL);
+}
+
+/*
+ * Description :
+ * Called by the Timer1 system tick ISR every 1 ms, scans the keypad every KEYPAD_SCAN_PERIOD_MS
+ */
+void systemTick(void)
+{
+	static uint8 ticks = 0;
+
+	ticks++;
+	if(ticks >= (KEYPAD_SCAN_PERIOD_MS / TIMER1_TICK_MS))
+	{
+		ticks = 0;
+		KEYPAD_scan();
+	}
+}
+
+/*
+ * Description :
+ * 1. Display error message on the LCD
+ * 2. Hold the keypad response until the Control_ECU ends the alarm
+ */
+void errorState (void)
+{
+	/* Display on the LCD Error message*/
+	LCD_bufferClear();
+	LCD_bufferWrite(ERROR_MESSAGEO_ROW,ERROR_MESSAGEO_COLUMN,"ERROR!");
+	LCD_bufferWrite(1,0,"Wrong  Password");
+	LCD_flush();
+
+	/* The Control_ECU sends the next state after the one minute alarm*/
+	setSystemState ();
+
+	/* The keys pressed during the alarm are ignored*/
+	KEYPAD_clearEvents();
+}
+
+/*
+ * Description :
+ * Send a request frame to Control_ECU
+ */
+void sendCommand (uint8 a_command, const uint8 *payload_Ptr, uint8 length)
+{
+	PROTOCOL_sendFrame(a_command, payload_Ptr, length);
+}
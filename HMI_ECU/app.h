@@ -1,146 +1,182 @@
-/*
- ================================================================================================
- File Name: app.h
- Name        : Door Locker Security System
- Author      : Omar Muhammad
- Description : Header file of HMI_ECU (Human Machine Interface) is just responsible interaction with the user
-               just take inputs through keypad and display messages on the LCD.
- Date        : 26/10/2022
- ================================================================================================
- */
-
-#ifndef APP_H_
-#define APP_H_
-
-#include "MCAL/std_types.h"
-
-#define UART_BAUDRATE                    9600
-#define SYSTEM_OPENING_DELAY             1000
-#define PASSWORD_SIZE                    5
-#define PRESS_TIME                       500
-#define FUNCTIONS_ARRAY_OF_POINTERS_SIZE 3
-
-/*UART Commands and keywords*/
-#define GET_READY                       0x00F1
-#define READY                           0x00F2
-#define STATE                           0x00F3
-#define SENDING                         0x00F4
-#define RECEIVED                        105
-#define FINISHED                        107
-
-/*Error state*/
-#define ERROR_MESSAGEO_ROW               0
-#define ERROR_MESSAGEO_COLUMN            4
-#define DELAY_MINUTE                     60
-
-/*Control_ECU States codes*/
-#define CREATE_TWO_PASSWORD             0
-#define CHECK_PASSWORD                  1
-#define FalsePassword                   2
-
-#define SETUP                           109
-#define STARTUP                         110
-#define ERRORSYSTEM                     111
-#define READ_AGAIN                      114
-#define CHANGE                          115
-#define OPEN                            116
-#define MATCHED                         117
-#define OPEN_DOOR                       118
-
-/*******************************************************************************
- *                         Types Declaration                                   *
- *******************************************************************************/
-typedef enum
-{
-	CREATE_SYSTEM , MAIN_OPTION , ERROR_STATE
-}system_state;
-
-/*******************************************************************************
- *                      Functions Definitions                                  *
- *******************************************************************************/
-/*
- *Description :
- *    Set the state of the system whether to create password (as for the first time
- *    or to repeat the creating process as the password wasn't matched)
- *    or to move to main options
- */
-void setSystemState (void);
-
-/*
- * Description :
- * UART send command to Control_ECU
- */
-void sendCommand (uint8 a_command);
-
-/*
- * Description :
- * 1. Display messages to guide the user to create password
- * 2. Read the password from the user and send it to the Control_ECU
- *    through the UART Module to save it in memory and to confirm the
- *    password in the second attempt
- */
-void createSystemPassword(void);
-
-/*
- * Description :
- * Read the password from the user and store it in an array
- */
-void ReadPassword (void);
-
-/*
- * Description :
- * Send the password to the Control_ECU through UART
- */
-void SendPassword (const uint8 *password_Ptr);
-
-/*
- * Description :
- * 1. Display main option message
- * 2. Read the desired decision from the user
- * 3. Read and check password with Contol_ECU
- * 4. Set the state of the system to open door or change password
- */
-void mainOptions(void);
-
-/* Description :
-* 1. Read password from the user
-* 2. communicate with the Control_ECU to check if the
-* entered password is like that saved in the memory or not
-*/
-void checkAuthority(void);
-
-/*
- * Description :
- * Display the state of the door
- */
-void openDoorScreen(void);
-
-/*
- * Description :
- * 1. Display error message on the LCD
- * 2. Hold the keypad response for one minute
- */
-void errorState (void);
-
-/*
- * Description :
- * Callback function of the timer
- */
-void countSec(void);
-
-/*
- * Description :
- * Delay function by seconds operates with Timer1
- */
-void delaySeconds(uint8 sec);
-
-/*
- * Description :
- * Sync the two micro-controllers
- */
-void syncMicroCOntrollers(void);
-
-/* Array of pointers to the three main function  */
-void (*ptr_states[FUNCTIONS_ARRAY_OF_POINTERS_SIZE])(void) = {createSystemPassword, mainOptions, errorState};
-
-#endif /* APP_H_ */
+/*
+ ================================================================================================
+ File Name: app.h
+ Name        : Door Locker Security System
+ Author      : Omar Muhammad
+ Description : Header file of HMI_ECU (Human Machine Interface) is just responsible interaction with the user
+               just take inputs through keypad and display messages on the LCD.
+ Date        : 26/10/2022
+ ================================================================================================
+ */
+
+#ifndef APP_H_
+#define APP_H_
+
+#include "MCAL/std_types.h"
+#include "protocol.h"
+
+#define UART_BAUDRATE                    PROTOCOL_BASE_BAUD_RATE /* Raised by PROTOCOL_negotiateBaud */
+#define SYSTEM_OPENING_DELAY             1000
+#define MEMORY_ERROR_DELAY               1000
+#define STATE_REQUEST_TIMEOUT            1000 /* More than the Control_ECU boot, then asked again */
+#define USER_RESULT_DELAY                1000
+#define LINK_ERROR_DELAY                 1000
+#define DIGIT_ACK_TIMEOUT                100  /* More than a page write of the Control_ECU, then the digit is sent again */
+#define DIGIT_SEND_ATTEMPTS              3
+#define PASSWORD_SIZE                    5
+#define FUNCTIONS_ARRAY_OF_POINTERS_SIZE 4
+
+/*Error state*/
+#define ERROR_MESSAGEO_ROW               0
+#define ERROR_MESSAGEO_COLUMN            4
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef enum
+{
+	CREATE_SYSTEM , MAIN_OPTION , ERROR_STATE , USERS_STATE
+}system_state;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+/*
+ *Description :
+ *    Wait for the MSG_STATE frame from the Control_ECU and set the state of the system
+ *    whether to create password (as for the first time or to repeat the creating process
+ *    as the password wasn't matched) or to move to main options.
+ *    Asks again while the Control_ECU reports a memory error.
+ *    Returns the received state code.
+ */
+uint8 setSystemState (void);
+
+/*
+ * Description :
+ * Send a request frame to Control_ECU
+ */
+void sendCommand (uint8 a_command, const uint8 *payload_Ptr, uint8 length);
+
+/*
+ * Description :
+ * 1. Display messages to guide the user to create password
+ * 2. Stream the password and its confirmation to the Control_ECU as they are typed
+ *    then ask it to check and save the password in memory
+ */
+void createSystemPassword(void);
+
+/*
+ * Description :
+ * Read the password from the user and send every digit to the Control_ECU as it is typed,
+ * the digits are numbered from a_firstIndex. Returns TRUE when '=' is pressed, or FALSE when a digit
+ * could not be delivered: the link error is shown and the entry has to be typed again.
+ */
+boolean ReadPassword (uint8 a_firstIndex);
+
+/*
+ * Description :
+ * Send a digit frame until the Control_ECU acknowledges its index.
+ * Returns FALSE if no acknowledgement came after DIGIT_SEND_ATTEMPTS.
+ */
+boolean sendDigit (const uint8 *a_digitFrame);
+
+/*
+ * Description :
+ * Wait for the next key press, meanwhile answer the NACK of a late frame
+ */
+uint8 readKey (void);
+
+/*
+ * Description :
+ * 1. Display main option message
+ * 2. Read the desired decision from the user, '*' opens the user codes management
+ * 3. Read and check password with Contol_ECU
+ * 4. Set the state of the system to open door, change password or manage the users
+ */
+void mainOptions(void);
+
+/* Description :
+* 1. Read password from the user, the digits are streamed to the Control_ECU
+* 2. send the required action to the Control_ECU to check if the
+* entered password is like that saved in the memory or not
+* Returns the state replied by the Control_ECU
+*/
+uint8 checkAuthority(uint8 a_action);
+
+/*
+ * Description :
+ * Display the state of the door
+ */
+void openDoorScreen(void);
+
+/*
+ * Description :
+ * Users menu, opened by the master password:
+ * add or remove a user code, list the used slots, show the audit log or go back to the main options
+ */
+void usersMenu(void);
+
+/*
+ * Description :
+ * Read a user code of PASSWORD_SIZE digits ended by '=' in the given array
+ */
+void ReadUserCode(uint8 *code_Ptr);
+
+/*
+ * Description :
+ * Page through the used slots of the user codes table, '=' leaves the list
+ */
+void listUsers(void);
+
+/*
+ * Description :
+ * Wait for the reply of the given type to a users menu request, or for MSG_USER_RESULT that
+ * reports its failure. If the Control_ECU left the users menu it answers with its state,
+ * the state is applied and FALSE is returned.
+ */
+boolean waitUserReply(PROTOCOL_Frame *reply_Ptr, uint8 type);
+
+/*
+ * Description :
+ * Ask the Control_ECU for the audit log one page at a time, newest first, and show the
+ * received entries newest first. Any key shows the one before and '=' leaves the log.
+ */
+void showAuditLog(void);
+
+/*
+ * Description :
+ * Display one audit log entry: event and result, boot count and seconds since that power up,
+ * then the user slot or the number of dropped entries
+ */
+void showLogEntry(const uint8 *entry_Ptr);
+
+/*
+ * Description :
+ * Display the result of a MSG_USER_RESULT frame for USER_RESULT_DELAY
+ */
+void showUserResult(const PROTOCOL_Frame *reply_Ptr);
+
+/*
+ * Description :
+ * 1. Display error message on the LCD
+ * 2. Hold the keypad response until the Control_ECU ends the alarm
+ */
+void errorState (void);
+
+/*
+ * Description :
+ * Delay function by seconds operates with the system tick,
+ * the scheduler tasks keep running meanwhile
+ */
+void delaySeconds(uint8 sec);
+
+/*
+ * Description :
+ * Called by the Timer1 system tick ISR every 1 ms, scans the keypad every KEYPAD_SCAN_PERIOD_MS
+ */
+void systemTick(void);
+
+/* Array of pointers to the three main function  */
+void (*ptr_states[FUNCTIONS_ARRAY_OF_POINTERS_SIZE])(void) = {createSystemPassword, mainOptions, errorState, usersMenu};
+
+#endif /* APP_H_ */
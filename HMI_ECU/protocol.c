@@ -0,0 +1,496 @@
+/*
+ ================================================================================================
+ File Name: protocol.c
+ Name        : Door Locker Security System
+ Author      : Omar Muhammad
+ Description : Source file of the framed message protocol shared by HMI_ECU and Control_ECU.
+ Date        : 17/10/2026
+ ================================================================================================
+ */
+
+#include "protocol.h"
+#include "MCAL/uart.h"
+#include "MCAL/timer.h"
+#include <avr/pgmspace.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define PROTOCOL_BAUD_RATES_COUNT       (sizeof(g_baudRates) / sizeof(g_baudRates[0]))
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef enum
+{
+	WAIT_START, WAIT_TYPE, WAIT_LENGTH, WAIT_BODY
+}PROTOCOL_ReceiverState;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+static PROTOCOL_ReceiverState g_receiverState = WAIT_START;
+/* Frame under reception, the body is the payload followed by the CRC */
+static uint8 g_receivedType;
+static uint8 g_receivedLength;
+static uint8 g_frameBody[PROTOCOL_MAX_PAYLOAD + 1];
+static uint8 g_bodyIndex;
+static volatile boolean g_bodyReceived = FALSE;
+static uint8 g_crc;                      /* CRC of the type and the length */
+
+/* Copy of the last sent frame to answer a MSG_NACK */
+static uint8 g_lastFrame[PROTOCOL_MAX_PAYLOAD + PROTOCOL_FRAME_OVERHEAD];
+static uint8 g_lastFrameLength = 0;
+static uint8 g_retries = 0;
+
+static uint16 g_errorCount = 0;
+
+/*
+ * Rates offered by PROTOCOL_negotiateBaud, the fastest first, see the divisor table in uart.h.
+ * 115200 and 57600 have no close divisor at 8 MHz so they are not offered.
+ */
+static const uint32 g_baudRates[] PROGMEM = {1000000, 500000, 250000, 38400, 19200};
+
+/* Every bit transition, runs of ones and zeros and the start byte inside the payload */
+static const uint8 g_testPattern[PROTOCOL_TEST_PATTERN_SIZE] PROGMEM =
+{
+	0x55, 0xAA, 0x00, 0xFF, 0x0F, 0xF0, 0x33, 0xCC,
+	PROTOCOL_START_BYTE, 0x81, 0x01, 0x80, 0xFE, 0x7F, 0x5A, 0xA5
+};
+
+static uint32 g_baudRate = PROTOCOL_BASE_BAUD_RATE;
+static uint16 g_framingErrors = 0;       /* UART framing errors when the last valid frame came */
+static Timer1_SoftTimerType g_baudTimer; /* The test pattern must come before it expires */
+
+/*******************************************************************************
+ *                      Functions Definitions(Private)                         *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Update the CRC-8 (polynomial x^8 + x^2 + x + 1) with one byte
+ */
+static uint8 PROTOCOL_crc8Update(uint8 crc, uint8 data)
+{
+	uint8 bit;
+
+	crc ^= data;
+	for(bit = 0; bit < 8; bit++)
+	{
+		if(crc & 0x80)
+			crc = (crc << 1) ^ 0x07;
+		else
+			crc <<= 1;
+	}
+	return crc;
+}
+
+/*
+ * Description :
+ * Queue the whole frame in the UART, waiting only while the Tx buffer is full
+ */
+static void PROTOCOL_transmit(const uint8 *frame_Ptr, uint8 length)
+{
+	uint8 sent = 0;
+
+	while(sent < length)
+	{
+		sent += UART_write(&frame_Ptr[sent], length - sent);
+	}
+}
+
+/*
+ * Description :
+ * Send the last built frame straight from g_lastFrame, the UART copies it to its Tx buffer
+ * only in the polling mode or while the previous frame is still going out
+ */
+static void PROTOCOL_transmitLastFrame(void)
+{
+	if(UART_sendBuffer(g_lastFrame, g_lastFrameLength, NULL_PTR) == FALSE)
+		PROTOCOL_transmit(g_lastFrame, g_lastFrameLength);
+}
+
+/*
+ * Description :
+ * Ask the other ECU to re-send its last frame, the last sent frame is kept untouched
+ */
+static void PROTOCOL_sendNack(void)
+{
+	uint8 nack[PROTOCOL_FRAME_OVERHEAD];
+
+	nack[0] = PROTOCOL_START_BYTE;
+	nack[1] = MSG_NACK;
+	nack[2] = 0;
+	nack[3] = PROTOCOL_crc8Update(PROTOCOL_crc8Update(0, MSG_NACK), 0);
+	PROTOCOL_transmit(nack, PROTOCOL_FRAME_OVERHEAD);
+}
+
+/*
+ * Description :
+ * Switch the UART to the rate once the queued frames are sent, a frame under reception
+ * and the last sent frame belong to the old rate so they are dropped
+ */
+static void PROTOCOL_setBaudRate(uint32 baud_rate)
+{
+	UART_ErrorCountersType counters;
+
+	UART_setBaudRate(baud_rate);
+	g_baudRate = baud_rate;
+	UART_cancelReceive();
+	g_receiverState = WAIT_START;
+	g_lastFrameLength = 0;
+	UART_getErrorCounters(&counters);
+	g_framingErrors = counters.framing;
+}
+
+/*
+ * Description :
+ * Go back to the base rate if the test pattern did not come in time or if the bytes of the
+ * other ECU stopped making sense, it went back to the base rate itself
+ */
+static void PROTOCOL_superviseBaudRate(void)
+{
+	UART_ErrorCountersType counters;
+
+	if(g_baudRate == PROTOCOL_BASE_BAUD_RATE)
+		return;
+
+	UART_getErrorCounters(&counters);
+	if((Timer1_softTimerExpired(&g_baudTimer) == TRUE) ||
+	   ((uint16)(counters.framing - g_framingErrors) >= PROTOCOL_BAUD_FALLBACK_ERRORS))
+	{
+		PROTOCOL_setBaudRate(PROTOCOL_BASE_BAUD_RATE);
+	}
+}
+
+/*
+ * Description :
+ * Check that the payload is the whole test pattern
+ */
+static boolean PROTOCOL_isTestPattern(const uint8 *payload_Ptr, uint8 length)
+{
+	uint8 counter;
+
+	if(length != PROTOCOL_TEST_PATTERN_SIZE)
+		return FALSE;
+
+	for(counter = 0; counter < PROTOCOL_TEST_PATTERN_SIZE; counter++)
+	{
+		if(payload_Ptr[counter] != pgm_read_byte(&g_testPattern[counter]))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Rate of the negotiation table if the UART divisor makes it close enough, else 0
+ */
+static uint32 PROTOCOL_usableBaudRate(uint8 index)
+{
+	uint32 baud_rate;
+	sint16 error;
+
+	if(index >= PROTOCOL_BAUD_RATES_COUNT)
+		return 0;
+
+	baud_rate = pgm_read_dword(&g_baudRates[index]);
+	error = UART_getBaudRateError(baud_rate);
+	if((error > UART_MAX_BAUD_ERROR) || (error < -UART_MAX_BAUD_ERROR))
+		return 0;
+
+	return baud_rate;
+}
+
+/*
+ * Description :
+ * Answer the link control frames of the baud rate negotiation:
+ * MSG_SET_BAUD is accepted then the new rate is used until the test pattern is late,
+ * MSG_BAUD_TEST is echoed and the new rate is kept.
+ */
+static void PROTOCOL_answerBaudFrame(void)
+{
+	uint32 baud_rate;
+
+	if(g_receivedType == MSG_SET_BAUD)
+	{
+		baud_rate = (g_receivedLength == 1) ? PROTOCOL_usableBaudRate(g_frameBody[0]) : 0;
+
+		/* Offers come at the base rate only, the others were queued while busy before a switch */
+		if((baud_rate == 0) || (g_baudRate != PROTOCOL_BASE_BAUD_RATE))
+			return;
+
+		PROTOCOL_sendFrame(MSG_BAUD_ACK, g_frameBody, 1);
+		PROTOCOL_setBaudRate(baud_rate);
+		Timer1_startSoftTimer(&g_baudTimer, PROTOCOL_BAUD_TIMEOUT_MS);
+	}
+	else if(PROTOCOL_isTestPattern(g_frameBody, g_receivedLength) == TRUE)
+	{
+		Timer1_stopSoftTimer(&g_baudTimer);
+		PROTOCOL_sendFrame(MSG_BAUD_ECHO, g_frameBody, g_receivedLength);
+	}
+}
+
+/*
+ * Description :
+ * Called by the UART ISR once the body of the frame is in g_frameBody
+ */
+static void PROTOCOL_bodyReceived(uint8 length)
+{
+	(void)length;
+	g_bodyReceived = TRUE;
+}
+
+/*
+ * Description :
+ * Check the CRC of the received frame then handle the link control frames here.
+ * Returns TRUE when the frame is copied to frame_Ptr for the application.
+ */
+static boolean PROTOCOL_acceptFrame(PROTOCOL_Frame *frame_Ptr)
+{
+	uint8 counter;
+	uint8 crc = g_crc;
+	UART_ErrorCountersType counters;
+
+	for(counter = 0; counter < g_receivedLength; counter++)
+	{
+		crc = PROTOCOL_crc8Update(crc, g_frameBody[counter]);
+	}
+	if(crc != g_frameBody[g_receivedLength])
+	{
+		/* Corrupted frame, ask the other ECU to send it again */
+		g_errorCount++;
+		PROTOCOL_sendNack();
+		return FALSE;
+	}
+
+	if(g_receivedType == MSG_NACK)
+	{
+		/* The other ECU did not get our last frame correctly */
+		if((g_lastFrameLength != 0) && (g_retries < PROTOCOL_MAX_RETRIES))
+		{
+			g_retries++;
+			PROTOCOL_transmitLastFrame();
+		}
+		return FALSE;
+	}
+
+	if(g_baudRate != PROTOCOL_BASE_BAUD_RATE)
+	{
+		/* The link works, only the framing errors from now on count for the fallback */
+		UART_getErrorCounters(&counters);
+		g_framingErrors = counters.framing;
+	}
+
+	if((g_receivedType == MSG_SET_BAUD) || (g_receivedType == MSG_BAUD_TEST))
+	{
+		PROTOCOL_answerBaudFrame();
+		return FALSE;
+	}
+
+	frame_Ptr->type = g_receivedType;
+	frame_Ptr->length = g_receivedLength;
+	for(counter = 0; counter < g_receivedLength; counter++)
+	{
+		frame_Ptr->payload[counter] = g_frameBody[counter];
+	}
+	return TRUE;
+}
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Reset the frame receiver and the error counter
+ */
+void PROTOCOL_init(void)
+{
+	g_receiverState = WAIT_START;
+	g_lastFrameLength = 0;
+	g_retries = 0;
+	g_errorCount = 0;
+	g_baudRate = PROTOCOL_BASE_BAUD_RATE;
+	Timer1_stopSoftTimer(&g_baudTimer);
+}
+
+/*
+ * Description :
+ * Build a frame of the given type and payload and queue it in the UART
+ */
+void PROTOCOL_sendFrame(uint8 type, const uint8 *payload_Ptr, uint8 length)
+{
+	uint8 counter;
+	uint8 crc;
+
+	if(length > PROTOCOL_MAX_PAYLOAD)
+		return;
+
+	/* g_lastFrame is sent in place, wait until the previous frame is out of it */
+	while(UART_sendBusy() == TRUE){}
+
+	g_lastFrame[0] = PROTOCOL_START_BYTE;
+	g_lastFrame[1] = type;
+	g_lastFrame[2] = length;
+	crc = PROTOCOL_crc8Update(0, type);
+	crc = PROTOCOL_crc8Update(crc, length);
+
+	for(counter = 0; counter < length; counter++)
+	{
+		g_lastFrame[3 + counter] = payload_Ptr[counter];
+		crc = PROTOCOL_crc8Update(crc, payload_Ptr[counter]);
+	}
+	g_lastFrame[3 + length] = crc;
+	g_lastFrameLength = length + PROTOCOL_FRAME_OVERHEAD;
+	g_retries = 0;
+
+	PROTOCOL_transmitLastFrame();
+}
+
+/*
+ * Description :
+ * Feed the received UART bytes to the frame receiver without waiting.
+ * Returns TRUE when a complete frame with a valid CRC is stored in frame_Ptr.
+ * Corrupted frames are answered with MSG_NACK and a received MSG_NACK
+ * re-sends the last frame, both are handled here and never returned.
+ */
+boolean PROTOCOL_receiveFrame(PROTOCOL_Frame *frame_Ptr)
+{
+	uint8 data;
+
+	PROTOCOL_superviseBaudRate();
+
+	for(;;)
+	{
+		if((g_receiverState == WAIT_BODY) && (g_bodyReceived == TRUE))
+		{
+			g_receiverState = WAIT_START;
+			if(PROTOCOL_acceptFrame(frame_Ptr) == TRUE)
+				return TRUE;
+		}
+
+		if(UART_tryReceive(&data) == FALSE)
+			return FALSE;
+
+		switch(g_receiverState)
+		{
+		case WAIT_START:
+			if(data == PROTOCOL_START_BYTE)
+				g_receiverState = WAIT_TYPE;
+			break;
+
+		case WAIT_TYPE:
+			g_receivedType = data;
+			g_crc = PROTOCOL_crc8Update(0, data);
+			g_receiverState = WAIT_LENGTH;
+			break;
+
+		case WAIT_LENGTH:
+			if(data > PROTOCOL_MAX_PAYLOAD)
+			{
+				/* Impossible length, look for the next start byte */
+				g_errorCount++;
+				g_receiverState = WAIT_START;
+				break;
+			}
+			g_receivedLength = data;
+			g_crc = PROTOCOL_crc8Update(g_crc, data);
+			g_bodyIndex = 0;
+			g_bodyReceived = FALSE;
+			g_receiverState = WAIT_BODY;
+			/* The payload and the CRC go straight to g_frameBody, the UART ISR stores them */
+			UART_receiveInto(g_frameBody, data + 1, UART_NO_TERMINATOR, PROTOCOL_bodyReceived);
+			break;
+
+		case WAIT_BODY:
+			/* Only in the polling mode, else the bytes of the body never come here */
+			g_frameBody[g_bodyIndex++] = data;
+			if(g_bodyIndex == (g_receivedLength + 1))
+				g_bodyReceived = TRUE;
+			break;
+		}
+	}
+}
+
+/*
+ * Description :
+ * Wait until a complete valid frame is received
+ */
+void PROTOCOL_waitFrame(PROTOCOL_Frame *frame_Ptr)
+{
+	while(PROTOCOL_receiveFrame(frame_Ptr) == FALSE){}
+}
+
+/*
+ * Description :
+ * Wait for a frame of the given type for at most timeout_ms, the other frames are dropped
+ */
+boolean PROTOCOL_waitReply(PROTOCOL_Frame *frame_Ptr, uint8 type, uint16 timeout_ms)
+{
+	Timer1_SoftTimerType timeout;
+
+	Timer1_startSoftTimer(&timeout, timeout_ms);
+	while(Timer1_softTimerExpired(&timeout) == FALSE)
+	{
+		if((PROTOCOL_receiveFrame(frame_Ptr) == TRUE) && (frame_Ptr->type == type))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/*
+ * Description :
+ * Return the number of frames dropped because of a wrong CRC or length
+ */
+uint16 PROTOCOL_getErrorCount(void)
+{
+	return g_errorCount;
+}
+
+/*
+ * Description :
+ * Agree with the other ECU on the fastest rate of the negotiation table that carries the test
+ * pattern both ways, starting from PROTOCOL_BASE_BAUD_RATE. Called by one ECU only, the other
+ * answers from PROTOCOL_receiveFrame. Blocks for at most PROTOCOL_BAUD_TIMEOUT_MS per step.
+ * Returns the rate in use.
+ */
+uint32 PROTOCOL_negotiateBaud(void)
+{
+	PROTOCOL_Frame reply;
+	uint8 pattern[PROTOCOL_TEST_PATTERN_SIZE];
+	uint8 index;
+	uint32 baud_rate;
+	Timer1_SoftTimerType settle;
+
+	for(index = 0; index < PROTOCOL_TEST_PATTERN_SIZE; index++)
+	{
+		pattern[index] = pgm_read_byte(&g_testPattern[index]);
+	}
+
+	for(index = 0; index < PROTOCOL_BAUD_RATES_COUNT; index++)
+	{
+		baud_rate = PROTOCOL_usableBaudRate(index);
+		if(baud_rate == 0)
+			continue;
+
+		/* Offer the rate at the base rate, an ECU without negotiation never answers */
+		PROTOCOL_sendFrame(MSG_SET_BAUD, &index, 1);
+		if((PROTOCOL_waitReply(&reply, MSG_BAUD_ACK, PROTOCOL_BAUD_TIMEOUT_MS) == FALSE) ||
+		   (reply.length != 1) || (reply.payload[0] != index))
+			continue;
+
+		/* Both ways at the new rate: the pattern and its echo */
+		PROTOCOL_setBaudRate(baud_rate);
+		PROTOCOL_sendFrame(MSG_BAUD_TEST, pattern, PROTOCOL_TEST_PATTERN_SIZE);
+		if((PROTOCOL_waitReply(&reply, MSG_BAUD_ECHO, PROTOCOL_BAUD_TIMEOUT_MS) == TRUE) &&
+		   (PROTOCOL_isTestPattern(reply.payload, reply.length) == TRUE))
+			return baud_rate;
+
+		/* Let the other ECU give up the rate too before the next offer */
+		PROTOCOL_setBaudRate(PROTOCOL_BASE_BAUD_RATE);
+		Timer1_startSoftTimer(&settle, PROTOCOL_BAUD_TIMEOUT_MS);
+		while(Timer1_softTimerExpired(&settle) == FALSE){}
+	}
+	return PROTOCOL_BASE_BAUD_RATE;
+}
@@ -0,0 +1,98 @@
+/*
+ ================================================================================================
+ File Name: scheduler.c
+ Name        : Door Locker Security System
+ Author      : Omar Muhammad
+ Description : Source file of the cooperative task scheduler running on the Timer1 1 ms system tick.
+ Date        : 17/10/2026
+ ================================================================================================
+ */
+
+#include "scheduler.h"
+#include "MCAL/timer.h"
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef struct
+{
+	SCHEDULER_TaskType task;
+	uint16 period;
+	uint32 lastRun;
+	boolean running;   /* Set while the task is executing to avoid re-entering it */
+}SCHEDULER_TaskEntry;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+static SCHEDULER_TaskEntry g_tasks[SCHEDULER_MAX_TASKS];
+static uint8 g_tasksCount = 0;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+
+/*
+ * Description :
+ * Empty the task table and start the 1 ms system tick
+ */
+void SCHEDULER_init(void)
+{
+	g_tasksCount = 0;
+	Timer1_startSystemTick();
+}
+
+/*
+ * Description :
+ * Add a task to be called every period_ms, a zero period calls it on every dispatch.
+ * Returns FALSE if the task table is full.
+ */
+boolean SCHEDULER_addTask(SCHEDULER_TaskType task, uint16 period_ms)
+{
+	if(g_tasksCount >= SCHEDULER_MAX_TASKS)
+		return FALSE;
+
+	g_tasks[g_tasksCount].task = task;
+	g_tasks[g_tasksCount].period = period_ms / TIMER1_TICK_MS;
+	g_tasks[g_tasksCount].lastRun = Timer1_getTicks();
+	g_tasks[g_tasksCount].running = FALSE;
+	g_tasksCount++;
+
+	return TRUE;
+}
+
+/*
+ * Description :
+ * Call once every task that is due, a task that is already running is skipped
+ */
+void SCHEDULER_dispatch(void)
+{
+	uint8 index;
+	uint32 now = Timer1_getTicks();
+
+	for(index = 0; index < g_tasksCount; index++)
+	{
+		if((g_tasks[index].running == FALSE) && ((now - g_tasks[index].lastRun) >= g_tasks[index].period))
+		{
+			g_tasks[index].lastRun = now;
+			g_tasks[index].running = TRUE;
+			(*g_tasks[index].task)();
+			g_tasks[index].running = FALSE;
+		}
+	}
+}
+
+/*
+ * Description :
+ * Wait for period_ms while keeping the other tasks running
+ */
+void SCHEDULER_delayMs(uint32 period_ms)
+{
+	Timer1_SoftTimerType delayTimer;
+
+	Timer1_startSoftTimer(&delayTimer, period_ms);
+	while(Timer1_softTimerExpired(&delayTimer) == FALSE)
+	{
+		SCHEDULER_dispatch();
+	}
+}
@@ -0,0 +1,58 @@
+################################################################################
+# Size of every function and variable of an image with its change since the previous build
+#
+# Usage: awk -f size_report.awk <previous sizes file> <sizes file>
+# A sizes file has one "<size> <type> <symbol>" line per symbol, largest first, see size-report
+# in makefile.targets. The code symbols (nm types T, t, W and w) are in flash, the others in RAM.
+################################################################################
+
+function memory(type)
+{
+	return (type ~ /^[TtWw]$/) ? "flash" : "RAM"
+}
+
+FILENAME == ARGV[1] {
+	previous[$3] = $1
+	previousMemory[$3] = memory($2)
+	hasPrevious = 1
+	next
+}
+
+FNR == 1 {
+	printf("%7s %8s  %-6s %s\n", "size", "change", "memory", "symbol")
+}
+
+{
+	total[memory($2)] += $1
+	delta = hasPrevious ? "new" : ""
+	if($3 in previous)
+	{
+		delta = ($1 == previous[$3]) ? "" : sprintf("%+d", $1 - previous[$3])
+		changes[memory($2)] += $1 - previous[$3]
+		delete previous[$3]
+	}
+	else
+	{
+		changes[memory($2)] += $1
+	}
+	printf("%7d %8s  %-6s %s\n", $1, delta, memory($2), $3)
+}
+
+END {
+	for(symbol in previous)
+	{
+		changes[previousMemory[symbol]] -= previous[symbol]
+		printf("%7s %8s  %-6s %s (removed)\n", "-", sprintf("%+d", -previous[symbol]), previousMemory[symbol], symbol)
+	}
+	printf("\nsymbols in flash: %d bytes", total["flash"])
+	if(hasPrevious)
+	{
+		printf(" (%+d)", changes["flash"])
+	}
+	printf("\nsymbols in RAM  : %d bytes", total["RAM"])
+	if(hasPrevious)
+	{
+		printf(" (%+d)", changes["RAM"])
+	}
+	printf("\n")
+}
@@ -0,0 +1,21 @@
+/*
+ ================================================================================================
+ File Name: interrupt.h
+ Name        : Door Locker Security System
+ Author      : Omar Muhammad
+ Description : Interrupt definitions of the host simulator, the ISRs are plain functions found by
+               the vectors table of each ECU (sim_vectors.c).
+ Date        : 17/10/2026
+ ================================================================================================
+ */
+
+#ifndef SIM_AVR_INTERRUPT_H_
+#define SIM_AVR_INTERRUPT_H_
+
+#include "sim.h"
+
+#define ISR(vector, ...)  void vector(void); void vector(void)
+#define sei()             SIM_sei()
+#define cli()             SIM_cli()
+
+#endif /* SIM_AVR_INTERRUPT_H_ */
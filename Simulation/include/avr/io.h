@@ -0,0 +1,200 @@
+/*
+ ================================================================================================
+ File Name: io.h
+ Name        : Door Locker Security System
+ Author      : Omar Muhammad
+ Description : ATmega32 register definitions of the host simulator, every register access goes through
+               SIM_reg so the simulator sees it, the bit names are the same as avr-libc ones.
+ Date        : 17/10/2026
+ ================================================================================================
+ */
+
+#ifndef SIM_AVR_IO_H_
+#define SIM_AVR_IO_H_
+
+#include <stdint.h>
+#include "sim.h"
+
+#define _SFR_MEM8(address)  (*SIM_reg(address))
+#define _SFR_MEM16(address) (*(volatile uint16_t *)SIM_reg(address))
+#define _BV(bit)            (1 << (bit))
+
+/*******************************************************************************
+ *                    Registers (data space addresses)                         *
+ *******************************************************************************/
+#define TWBR    _SFR_MEM8(0x20)
+#define TWSR    _SFR_MEM8(0x21)
+#define TWAR    _SFR_MEM8(0x22)
+#define TWDR    _SFR_MEM8(0x23)
+#define ADCL    _SFR_MEM8(0x24)
+#define ADCH    _SFR_MEM8(0x25)
+#define ADCW    _SFR_MEM16(0x24)
+#define ADCSRA  _SFR_MEM8(0x26)
+#define ADMUX   _SFR_MEM8(0x27)
+#define ACSR    _SFR_MEM8(0x28)
+#define UBRRL   _SFR_MEM8(0x29)
+#define UCSRB   _SFR_MEM8(0x2A)
+/* 16-bit on the host so the simulator tells a write from a read, the firmware uses them as 8-bit (see sim.c) */
+#define UCSRA   _SFR_MEM16(0x2B)
+#define UDR     _SFR_MEM16(0x2C)
+#define SPCR    _SFR_MEM8(0x2D)
+#define SPSR    _SFR_MEM8(0x2E)
+#define SPDR    _SFR_MEM8(0x2F)
+#define PIND    _SFR_MEM8(0x30)
+#define DDRD    _SFR_MEM8(0x31)
+#define PORTD   _SFR_MEM8(0x32)
+#define PINC    _SFR_MEM8(0x33)
+#define DDRC    _SFR_MEM8(0x34)
+#define PORTC   _SFR_MEM8(0x35)
+#define PINB    _SFR_MEM8(0x36)
+#define DDRB    _SFR_MEM8(0x37)
+#define PORTB   _SFR_MEM8(0x38)
+#define PINA    _SFR_MEM8(0x39)
+#define DDRA    _SFR_MEM8(0x3A)
+#define PORTA   _SFR_MEM8(0x3B)
+#define EECR    _SFR_MEM8(0x3C)
+#define EEDR    _SFR_MEM8(0x3D)
+#define EEARL   _SFR_MEM8(0x3E)
+#define EEARH   _SFR_MEM8(0x3F)
+#define UBRRH   _SFR_MEM8(0x40)
+#define UCSRC   _SFR_MEM8(0x40)
+#define WDTCR   _SFR_MEM8(0x41)
+#define ASSR    _SFR_MEM8(0x42)
+#define OCR2    _SFR_MEM8(0x43)
+#define TCNT2   _SFR_MEM8(0x44)
+#define TCCR2   _SFR_MEM8(0x45)
+#define ICR1    _SFR_MEM16(0x46)
+#define ICR1L   _SFR_MEM8(0x46)
+#define ICR1H   _SFR_MEM8(0x47)
+#define OCR1B   _SFR_MEM16(0x48)
+#define OCR1BL  _SFR_MEM8(0x48)
+#define OCR1BH  _SFR_MEM8(0x49)
+#define OCR1A   _SFR_MEM16(0x4A)
+#define OCR1AL  _SFR_MEM8(0x4A)
+#define OCR1AH  _SFR_MEM8(0x4B)
+#define TCNT1   _SFR_MEM16(0x4C)
+#define TCNT1L  _SFR_MEM8(0x4C)
+#define TCNT1H  _SFR_MEM8(0x4D)
+#define TCCR1B  _SFR_MEM8(0x4E)
+#define TCCR1A  _SFR_MEM8(0x4F)
+#define SFIOR   _SFR_MEM8(0x50)
+#define OSCCAL  _SFR_MEM8(0x51)
+#define TCNT0   _SFR_MEM8(0x52)
+#define TCCR0   _SFR_MEM8(0x53)
+#define MCUCSR  _SFR_MEM8(0x54)
+#define MCUCR   _SFR_MEM8(0x55)
+#define TWCR    _SFR_MEM8(0x56)
+#define SPMCR   _SFR_MEM8(0x57)
+#define TIFR    _SFR_MEM8(0x58)
+#define TIMSK   _SFR_MEM8(0x59)
+#define GIFR    _SFR_MEM8(0x5A)
+#define GICR    _SFR_MEM8(0x5B)
+#define OCR0    _SFR_MEM8(0x5C)
+#define SPL     _SFR_MEM8(0x5D)
+#define SPH     _SFR_MEM8(0x5E)
+#define SREG    _SFR_MEM8(0x5F)
+
+/*******************************************************************************
+ *                                Bit names                                    *
+ *******************************************************************************/
+/* TWCR */
+#define TWINT   7
+#define TWEA    6
+#define TWSTA   5
+#define TWSTO   4
+#define TWWC    3
+#define TWEN    2
+#define TWIE    0
+/* TWSR */
+#define TWPS1   1
+#define TWPS0   0
+/* TWAR */
+#define TWGCE   0
+/* UCSRA */
+#define RXC     7
+#define TXC     6
+#define UDRE    5
+#define FE      4
+#define DOR     3
+#define PE      2
+#define U2X     1
+#define MPCM    0
+/* UCSRB */
+#define RXCIE   7
+#define TXCIE   6
+#define UDRIE   5
+#define RXEN    4
+#define TXEN    3
+#define UCSZ2   2
+#define RXB8    1
+#define TXB8    0
+/* UCSRC */
+#define URSEL   7
+#define UMSEL   6
+#define UPM1    5
+#define UPM0    4
+#define USBS    3
+#define UCSZ1   2
+#define UCSZ0   1
+#define UCPOL   0
+/* TCCR1A */
+#define COM1A1  7
+#define COM1A0  6
+#define COM1B1  5
+#define COM1B0  4
+#define FOC1A   3
+#define FOC1B   2
+#define WGM11   1
+#define WGM10   0
+/* TCCR1B */
+#define ICNC1   7
+#define ICES1   6
+#define WGM13   4
+#define WGM12   3
+#define CS12    2
+#define CS11    1
+#define CS10    0
+/* TCCR0 */
+#define FOC0    7
+#define WGM00   6
+#define COM01   5
+#define COM00   4
+#define WGM01   3
+#define CS02    2
+#define CS01    1
+#define CS00    0
+/* TCCR2 */
+#define FOC2    7
+#define WGM20   6
+#define COM21   5
+#define COM20   4
+#define WGM21   3
+#define CS22    2
+#define CS21    1
+#define CS20    0
+/* TIMSK */
+#define OCIE2   7
+#define TOIE2   6
+#define TICIE1  5
+#define OCIE1A  4
+#define OCIE1B  3
+#define TOIE1   2
+#define OCIE0   1
+#define TOIE0   0
+/* TIFR */
+#define OCF2    7
+#define TOV2    6
+#define ICF1    5
+#define OCF1A   4
+#define OCF1B   3
+#define TOV1    2
+#define OCF0    1
+#define TOV0    0
+/* GICR */
+#define INT1    7
+#define INT0    6
+#define INT2    5
+/* SREG */
+#define SREG_I  7
+
+#endif /* SIM_AVR_IO_H_ */
@@ -0,0 +1,28 @@
+/*
+ ================================================================================================
+ File Name: pgmspace.h
+ Name        : Door Locker Security System
+ Author      : Omar Muhammad
+ Description : Program memory definitions of the host simulator, the host has one address space
+               so the flash data is read like any other constant.
+ Date        : 17/10/2026
+ ================================================================================================
+ */
+
+#ifndef SIM_AVR_PGMSPACE_H_
+#define SIM_AVR_PGMSPACE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s)                 (s)
+#define pgm_read_byte(address)  (*(const uint8_t *)(address))
+#define pgm_read_word(address)  (*(const uint16_t *)(address))
+#define pgm_read_dword(address) (*(const uint32_t *)(address))
+#define pgm_read_ptr(address)   (*(void * const *)(address))
+#define memcpy_P                memcpy
+#define strcpy_P                strcpy
+#define strlen_P                strlen
+
+#endif /* SIM_AVR_PGMSPACE_H_ */
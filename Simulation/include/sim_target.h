@@ -0,0 +1,45 @@
+/*
+ ================================================================================================
+ File Name: sim_target.h
+ Name        : Door Locker Security System
+ Author      : Omar Muhammad
+ Description : Included before every firmware source of the host build.
+               1. Gives the types of std_types.h the AVR widths, long is 64-bit on the host.
+               2. Declares the avr-libc functions missing from the host C library.
+ Date        : 17/10/2026
+ ================================================================================================
+ */
+
+#ifndef SIM_TARGET_H_
+#define SIM_TARGET_H_
+
+#include <stdint.h>
+
+/* Same guard as MCAL/std_types.h so the firmware copy is skipped */
+#define STD_TYPES_H_
+
+typedef unsigned char boolean;
+
+#define FALSE       (0u)
+#define TRUE        (1u)
+#define LOGIC_HIGH  (1u)
+#define LOGIC_LOW   (0u)
+#define NULL_PTR    ((void*)0)
+
+typedef uint8_t   uint8;
+typedef int8_t    sint8;
+typedef uint16_t  uint16;
+typedef int16_t   sint16;
+typedef uint32_t  uint32;
+typedef int32_t   sint32;
+typedef uint64_t  uint64;
+typedef int64_t   sint64;
+typedef float     float32;
+typedef double    float64;
+
+/* avr-libc stdlib.h extensions */
+char *itoa(int value, char *string_Ptr, int radix);
+char *utoa(unsigned int value, char *string_Ptr, int radix);
+char *ultoa(unsigned long value, char *string_Ptr, int radix);
+
+#endif /* SIM_TARGET_H_ */
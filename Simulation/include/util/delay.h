@@ -0,0 +1,26 @@
+/*
+ ================================================================================================
+ File Name: delay.h
+ Name        : Door Locker Security System
+ Author      : Omar Muhammad
+ Description : Busy wait functions of the host simulator, the wait is done in simulated time.
+ Date        : 17/10/2026
+ ================================================================================================
+ */
+
+#ifndef SIM_UTIL_DELAY_H_
+#define SIM_UTIL_DELAY_H_
+
+#include "sim.h"
+
+static inline void _delay_us(double us)
+{
+	SIM_delayCycles((uint64_t)(us * (F_CPU / 1000000.0)));
+}
+
+static inline void _delay_ms(double ms)
+{
+	SIM_delayCycles((uint64_t)(ms * (F_CPU / 1000.0)));
+}
+
+#endif /* SIM_UTIL_DELAY_H_ */
@@ -0,0 +1,1580 @@
+/*
+ ================================================================================================
+ File Name: sim.c
+ Name        : Door Locker Security System
+ Author      : Omar Muhammad
+ Description : Source file of the host simulator core.
+               1. Runs every ECU firmware as a coroutine with its own simulated clock.
+               2. Keeps the register file of every ECU and models the GPIO ports, Timer1, Timer2, the TWI
+                  master, the USART and the interrupts.
+               3. Connects the USARTs of the two ECUs by a virtual link.
+               The ECUs are kept in step conservatively: an ECU never runs further ahead of the other one
+               than the time of one UART frame of the other, the only way they can affect each other.
+ Date        : 17/10/2026
+ ================================================================================================
+ */
+
+#define _GNU_SOURCE
+#include <ucontext.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "sim.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define SIM_STACK_SIZE            (256UL * 1024UL)
+#define SIM_F_CPU                 8000000UL
+#define SIM_NS_PER_CYCLE          (1000000000UL / SIM_F_CPU)
+
+/*
+ * Idle detection: the ECU is waiting for an event when the same synchronization point (a register
+ * access or a function call) comes back SIM_IDLE_REPEATS times with the same GPIO state and nothing
+ * else progressed. A point not reached again after SIM_IDLE_ANCHOR_SYNCS is replaced by the current one.
+ */
+#define SIM_IDLE_REPEATS          3
+#define SIM_IDLE_ANCHOR_SYNCS     256
+
+/* Longest run of one ECU before the host checks the run condition again */
+#define SIM_MAX_SLICE             SIM_MS(1)
+
+/* Lookahead used until the UART of the other ECU is configured */
+#define SIM_DEFAULT_LOOKAHEAD     SIM_US(50)
+
+#define SIM_UART_QUEUE_SIZE       64
+#define SIM_NEVER                 ((SIM_TimeType)-1)
+
+/* Registers used by the models */
+#define SIM_REG_TCNT1L            0x4C
+#define SIM_REG_TCNT1H            0x4D
+#define SIM_REG_OCR1AL            0x4A
+#define SIM_REG_TCCR1B            0x4E
+#define SIM_REG_OCR2              0x43
+#define SIM_REG_TCNT2             0x44
+#define SIM_REG_TCCR2             0x45
+#define SIM_REG_TIFR              0x58
+#define SIM_REG_TIMSK             0x59
+#define SIM_REG_SREG              0x5F
+#define SIM_SREG_I                0x80
+#define SIM_WGM12                 3
+#define SIM_WGM13                 4
+#define SIM_TOV1                  2
+#define SIM_OCF1A                 4
+#define SIM_WGM20                 6
+#define SIM_WGM21                 3
+#define SIM_TOV2                  6
+#define SIM_OCF2                  7
+#define SIM_REG_TWBR              0x20
+#define SIM_REG_TWSR              0x21
+#define SIM_REG_TWDR              0x23
+#define SIM_REG_TWCR              0x56
+#define SIM_TWINT                 7
+#define SIM_TWEA                  6
+#define SIM_TWSTA                 5
+#define SIM_TWSTO                 4
+#define SIM_TWEN                  2
+#define SIM_TWIE                  0
+#define SIM_TWI_VECTOR            19
+#define SIM_USART_RXC_VECTOR      13
+#define SIM_USART_UDRE_VECTOR     14
+#define SIM_REG_UBRRL             0x29
+#define SIM_REG_UCSRB             0x2A
+#define SIM_REG_UCSRA             0x2B
+#define SIM_REG_UDR               0x2C
+#define SIM_REG_UBRRH             0x40     /* UCSRC when written with URSEL set */
+#define SIM_RXC                   7
+#define SIM_TXC                   6
+#define SIM_UDRE                  5
+#define SIM_FE                    4
+#define SIM_DOR                   3
+#define SIM_U2X                   1
+#define SIM_RXCIE                 7
+#define SIM_UDRIE                 5
+#define SIM_RXEN                  4
+#define SIM_TXEN                  3
+#define SIM_UCSZ2                 2
+#define SIM_URSEL                 7
+#define SIM_UPM1                  5
+#define SIM_USBS                  3
+#define SIM_UCSZ0                 1
+#define SIM_UCSRC_RESET           0x86     /* 8 data bits, no parity, one stop bit */
+
+/*
+ * UCSRA and UDR are 16-bit on the host (see avr/io.h), an access gets this marker in the high byte
+ * and a write of the firmware, always 8-bit, clears it so the write is told from a read.
+ */
+#define SIM_UART_UNWRITTEN        0x100
+
+/* USART registers accessed since the last synchronization */
+#define SIM_UART_TOUCHED_UCSRA    0x01
+#define SIM_UART_TOUCHED_UDR      0x02
+#define SIM_UART_TOUCHED_FORMAT   0x04     /* UCSRB, UBRRL or UBRRH/UCSRC */
+
+/* Two-level receive FIFO of the USART, UDR holds one byte while the shift register sends the previous one */
+#define SIM_UART_RX_FIFO          2
+#define SIM_UART_TX_BUFFER        1
+
+/*
+ * TWCR bit 1 is reserved and reads 0 on the AVR, the simulator sets it in the value an access returns
+ * so a write of the firmware, which assigns the whole register, is told from a read by its clearing.
+ */
+#define SIM_TWCR_UNWRITTEN        0x02
+
+/* Operations of the TWI master on the bus */
+#define SIM_TWI_OP_NONE           0
+#define SIM_TWI_OP_START          1
+#define SIM_TWI_OP_STOP           2
+#define SIM_TWI_OP_STOP_START     3
+#define SIM_TWI_OP_WRITE          4
+#define SIM_TWI_OP_READ           5
+
+/* PINx, DDRx and PORTx of port 0 (A) to 3 (D) */
+#define SIM_PIN_ADDRESS(port)     (0x39 - (3 * (port)))
+#define SIM_DDR_ADDRESS(port)     (SIM_PIN_ADDRESS(port) + 1)
+#define SIM_PORT_ADDRESS(port)    (SIM_PIN_ADDRESS(port) + 2)
+#define SIM_PORTS                 4
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+/* Counter of a timer, counted from base in units of the prescaler */
+typedef struct
+{
+	uint64_t base;
+	uint16_t count;
+	uint8_t touched;          /* TCNTn was accessed by the firmware, take its value as the new count */
+}SIM_TimerType;
+
+/* Settings of a timer read from its registers */
+typedef struct
+{
+	uint16_t prescaler;       /* 0 when the timer is stopped */
+	uint16_t top;             /* compare value */
+	uint16_t max;             /* 0xFFFF for Timer1, 0xFF for Timer2 */
+	uint8_t ctc;              /* cleared on the compare match */
+	uint8_t ocf;              /* TIFR flags */
+	uint8_t tov;
+}SIM_TimerSetupType;
+
+/* TWI master, the operation started by a TWCR write ends after its SCL periods */
+typedef struct
+{
+	uint8_t twcr;             /* TWCR held by the hardware, TWINT is the interrupt flag */
+	uint8_t touched;          /* TWCR was accessed by the firmware, see SIM_TWCR_UNWRITTEN */
+	uint8_t operation;        /* SIM_TWI_OP_xxx on the bus */
+	uint8_t receiving;        /* SLA+R was ACKed so the data operations read */
+	uint8_t queued;           /* a TWCR write done during the operation, applied at its end */
+	uint8_t queued_twcr;
+	uint8_t held;             /* a START was sent and no STOP yet */
+	uint8_t hung;             /* the operation never ends, see SIM_twiHang */
+	uint64_t end;             /* cycles at the end of the operation */
+}SIM_TwiType;
+
+typedef struct
+{
+	uint8_t data;
+	uint8_t frame_bits;       /* frame format and bit time of the sender, checked by the receiver */
+	SIM_TimeType bit_ns;
+	SIM_TimeType arrival;     /* end of the stop bit */
+}SIM_UartFrameType;
+
+/* USART, the frame format and the bit time are read from its registers */
+typedef struct
+{
+	uint8_t configured;       /* the receiver or the transmitter is enabled */
+	uint8_t frame_bits;
+	SIM_TimeType bit_ns;
+	SIM_TimeType frame_ns;
+	SIM_TimeType tx_free;     /* end of the last frame queued for transmission */
+	uint8_t txc_armed;        /* a byte was written to UDR since TXC was cleared */
+	/* Frames sent by the other ECU, in arrival order */
+	SIM_UartFrameType incoming[SIM_UART_QUEUE_SIZE];
+	uint8_t incoming_head;
+	uint8_t incoming_count;
+	/* Receive FIFO, every byte with its FE and DOR flags */
+	uint8_t rx[SIM_UART_RX_FIFO];
+	uint8_t rx_flags[SIM_UART_RX_FIFO];
+	uint8_t rx_head;
+	uint8_t rx_count;
+	/* Registers held by the model, see SIM_UART_UNWRITTEN */
+	uint16_t ucsra;
+	uint16_t udr;
+	uint8_t u2x;
+	uint8_t ubrrh;
+	uint8_t ucsrc;
+	uint8_t touched;          /* SIM_UART_TOUCHED_xxx */
+	uint8_t losses;           /* bytes still lost on the line, see SIM_uartLose */
+}SIM_UartType;
+
+typedef struct
+{
+	const char *name;
+	int (*main)(void);
+	void (* const *vectors)(void);
+	const SIM_ProfileEntryType *profiled;
+	uint8_t *data_start;
+	uint8_t *data_end;
+	uint8_t *bss_start;
+	uint8_t *bss_end;
+	uint8_t *data_image;      /* .data content at power up */
+	uint8_t *stack;
+	ucontext_t context;
+
+	uint64_t cycles;
+	SIM_TimeType limit;       /* the ECU gives the host its turn once its time reaches limit */
+	uint8_t halted;
+	uint8_t in_isr;
+	uint64_t busy_cycles;     /* busy wait started once the interrupts are enabled, see SIM_busy */
+	uint8_t activity;         /* an interrupt, a delay or a driver operation progressed */
+	const void *idle_site;    /* synchronization point watched by the idle detection */
+	uint64_t idle_ports;      /* GPIO state when it was last reached */
+	uint16_t idle_syncs;
+	uint8_t idle_hits;
+
+	uint8_t regs[SIM_REG_FILE_SIZE];
+	uint8_t ddr_seen[SIM_PORTS];
+	uint8_t port_seen[SIM_PORTS];
+
+	SIM_TimerType timer1;
+	SIM_TimerType timer2;
+	SIM_TwiType twi;
+
+	SIM_UartType uart;
+
+	SIM_ProfileType profile[SIM_PROFILE_COUNT];
+	uint64_t profile_entry[SIM_PROFILE_COUNT];   /* cycles when the running call entered the function */
+}SIM_EcuType;
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+/* Firmware images, see the Makefile: main renamed, .data and .bss renamed to keep them apart */
+extern int hmi_main(void);
+extern int control_main(void);
+extern void (* const hmi_vectors[])(void);
+extern void (* const control_vectors[])(void);
+extern const SIM_ProfileEntryType hmi_profiled[], control_profiled[];
+extern uint8_t __start_hmi_data[], __stop_hmi_data[], __start_hmi_bss[], __stop_hmi_bss[];
+extern uint8_t __start_control_data[], __stop_control_data[], __start_control_bss[], __stop_control_bss[];
+
+static SIM_EcuType g_ecus[SIM_ECU_COUNT] =
+{
+	{"HMI_ECU", hmi_main, hmi_vectors, hmi_profiled, __start_hmi_data, __stop_hmi_data,
+	 __start_hmi_bss, __stop_hmi_bss},
+	{"Control_ECU", control_main, control_vectors, control_profiled, __start_control_data, __stop_control_data,
+	 __start_control_bss, __stop_control_bss}
+};
+
+static ucontext_t g_hostContext;
+static SIM_EcuType *g_current = NULL;
+static SIM_ObserverType g_observer = NULL;
+static uint8_t g_twiHangs;
+
+static const uint16_t g_timer1Prescaler[8] = {0, 1, 8, 64, 256, 1024, 0, 0};
+static const uint16_t g_timer2Prescaler[8] = {0, 1, 8, 32, 64, 128, 256, 1024};
+
+/*******************************************************************************
+ *                      Functions Prototypes(Private)                          *
+ *******************************************************************************/
+static void SIM_sync(SIM_EcuType *e, const void *site);
+static SIM_TimeType SIM_peerLimit(const SIM_EcuType *e);
+
+/*******************************************************************************
+ *                      Functions Definitions(Private)                         *
+ *******************************************************************************/
+static inline SIM_TimeType SIM_ecuTime(const SIM_EcuType *e)
+{
+	return e->cycles * SIM_NS_PER_CYCLE;
+}
+
+static inline uint8_t SIM_ecuIndex(const SIM_EcuType *e)
+{
+	return (uint8_t)(e - g_ecus);
+}
+
+static void SIM_yield(SIM_EcuType *e)
+{
+	swapcontext(&e->context, &g_hostContext);
+}
+
+static void SIM_ecuEntry(void)
+{
+	SIM_EcuType *e = g_current;
+
+	e->main();
+	/* The firmware main loops forever, returning from it stops the ECU like a sleeping AVR */
+	e->halted = 1;
+	for(;;)
+	{
+		SIM_yield(e);
+	}
+}
+
+/*
+ * Description :
+ * Read the settings of Timer1 (normal mode or CTC mode with OCR1A as top) or Timer2 (normal or CTC mode).
+ */
+static void SIM_timerSetup(const SIM_EcuType *e, uint8_t timer, SIM_TimerSetupType *setup_Ptr)
+{
+	uint8_t tccr;
+
+	if(timer == 1)
+	{
+		tccr = e->regs[SIM_REG_TCCR1B];
+		setup_Ptr->prescaler = g_timer1Prescaler[tccr & 0x07];
+		setup_Ptr->top = (uint16_t)(e->regs[SIM_REG_OCR1AL] | (e->regs[SIM_REG_OCR1AL + 1] << 8));
+		setup_Ptr->max = 0xFFFF;
+		setup_Ptr->ctc = ((tccr & ((1 << SIM_WGM12) | (1 << SIM_WGM13))) == (1 << SIM_WGM12));
+		setup_Ptr->ocf = (1 << SIM_OCF1A);
+		setup_Ptr->tov = (1 << SIM_TOV1);
+	}
+	else
+	{
+		tccr = e->regs[SIM_REG_TCCR2];
+		setup_Ptr->prescaler = g_timer2Prescaler[tccr & 0x07];
+		setup_Ptr->top = e->regs[SIM_REG_OCR2];
+		setup_Ptr->max = 0xFF;
+		setup_Ptr->ctc = ((tccr & ((1 << SIM_WGM20) | (1 << SIM_WGM21))) == (1 << SIM_WGM21));
+		setup_Ptr->ocf = (1 << SIM_OCF2);
+		setup_Ptr->tov = (1 << SIM_TOV2);
+	}
+}
+
+/*
+ * Description :
+ * Advance a timer counter to the ECU time and set the overflow and compare flags it passed.
+ * The clock is the prescaled CPU clock.
+ */
+static void SIM_timerUpdate(SIM_EcuType *e, SIM_TimerType *timer_Ptr, const SIM_TimerSetupType *setup_Ptr)
+{
+	uint16_t top = setup_Ptr->top;
+	uint16_t max = setup_Ptr->max;
+	uint8_t ctc = setup_Ptr->ctc;
+	uint16_t count;
+	uint64_t ticks;
+	uint64_t distance;
+
+	if(setup_Ptr->prescaler == 0)
+	{
+		/* Stopped, the count starts from now once a clock is selected */
+		timer_Ptr->base = e->cycles;
+		return;
+	}
+
+	ticks = (e->cycles - timer_Ptr->base) / setup_Ptr->prescaler;
+	if(ticks == 0)
+	{
+		return;
+	}
+	timer_Ptr->base += ticks * setup_Ptr->prescaler;
+	count = timer_Ptr->count;
+
+	while(ticks != 0)
+	{
+		if(ctc && (count < top))
+		{
+			distance = top - count;
+			if(ticks < distance)
+			{
+				count += (uint16_t)ticks;
+				break;
+			}
+			ticks -= distance;
+			count = top;
+			e->regs[SIM_REG_TIFR] |= setup_Ptr->ocf;
+		}
+		else if(ctc && (count == top))
+		{
+			/* Cleared on the tick after the compare match */
+			ticks--;
+			count = 0;
+			if(ticks > top)
+			{
+				/* Whole periods, each one ends with a compare match */
+				e->regs[SIM_REG_TIFR] |= setup_Ptr->ocf;
+				ticks %= ((uint64_t)top + 1);
+			}
+		}
+		else
+		{
+			/* Normal mode, or CTC mode above top counting up to the overflow */
+			distance = max - count;
+			if(!ctc && (top > count) && ((uint64_t)(top - count) <= ticks))
+			{
+				e->regs[SIM_REG_TIFR] |= setup_Ptr->ocf;
+			}
+			if(ticks <= distance)
+			{
+				count += (uint16_t)ticks;
+				break;
+			}
+			ticks -= distance + 1;
+			count = 0;
+			e->regs[SIM_REG_TIFR] |= setup_Ptr->tov;
+			if(!ctc && (top == 0))
+			{
+				e->regs[SIM_REG_TIFR] |= setup_Ptr->ocf;
+			}
+			if(ticks > max)
+			{
+				e->regs[SIM_REG_TIFR] |= setup_Ptr->tov | (ctc ? 0 : setup_Ptr->ocf);
+				ticks %= ((uint64_t)max + 1);
+			}
+		}
+	}
+	timer_Ptr->count = count;
+}
+
+/*
+ * Description :
+ * Time of the next flag of a timer, SIM_NEVER if the timer is stopped.
+ */
+static SIM_TimeType SIM_timerNextEvent(const SIM_TimerType *timer_Ptr, const SIM_TimerSetupType *setup_Ptr)
+{
+	uint16_t top = setup_Ptr->top;
+	uint16_t count = timer_Ptr->count;
+	uint64_t ticks;
+
+	if(setup_Ptr->prescaler == 0)
+	{
+		return SIM_NEVER;
+	}
+
+	if(setup_Ptr->ctc && (count < top))
+	{
+		ticks = top - count;
+	}
+	else if(setup_Ptr->ctc && (count == top))
+	{
+		ticks = (uint64_t)top + 1;
+	}
+	else
+	{
+		ticks = (uint64_t)setup_Ptr->max + 1 - count;
+		if(!setup_Ptr->ctc && (top > count))
+		{
+			ticks = top - count;
+		}
+	}
+	return (timer_Ptr->base + (ticks * setup_Ptr->prescaler)) * SIM_NS_PER_CYCLE;
+}
+
+/*
+ * Description :
+ * Advance Timer1 and Timer2 to the ECU time.
+ */
+static void SIM_timersUpdate(SIM_EcuType *e)
+{
+	SIM_TimerSetupType setup;
+
+	if(e->timer1.touched)
+	{
+		/* Written or read by the firmware, the register holds the count either way */
+		e->timer1.count = (uint16_t)(e->regs[SIM_REG_TCNT1L] | (e->regs[SIM_REG_TCNT1H] << 8));
+		e->timer1.base = e->cycles;
+		e->timer1.touched = 0;
+	}
+	if(e->timer2.touched)
+	{
+		e->timer2.count = e->regs[SIM_REG_TCNT2];
+		e->timer2.base = e->cycles;
+		e->timer2.touched = 0;
+	}
+	SIM_timerSetup(e, 1, &setup);
+	SIM_timerUpdate(e, &e->timer1, &setup);
+	SIM_timerSetup(e, 2, &setup);
+	SIM_timerUpdate(e, &e->timer2, &setup);
+}
+
+/*
+ * Description :
+ * Time of the next flag of Timer1 or Timer2, SIM_NEVER if both are stopped.
+ */
+static SIM_TimeType SIM_timersNextEvent(const SIM_EcuType *e)
+{
+	SIM_TimerSetupType setup;
+	SIM_TimeType next;
+	SIM_TimeType t;
+
+	SIM_timerSetup(e, 1, &setup);
+	next = SIM_timerNextEvent(&e->timer1, &setup);
+	SIM_timerSetup(e, 2, &setup);
+	t = SIM_timerNextEvent(&e->timer2, &setup);
+	return (t < next) ? t : next;
+}
+
+/*
+ * Description :
+ * Start the bus operation asked by a TWCR write: writing TWINT to one clears the flag and starts
+ * START, STOP or the transfer of one byte, the other bits are only stored.
+ */
+static void SIM_twiControl(SIM_EcuType *e, uint8_t value)
+{
+	SIM_TwiType *t = &e->twi;
+	uint8_t twsr = e->regs[SIM_REG_TWSR];
+	uint64_t scl;
+
+	if(!(value & (1 << SIM_TWEN)))
+	{
+		/* Disabling the TWI aborts the operation and releases the bus, the devices see a STOP */
+		if(t->held || (t->operation != SIM_TWI_OP_NONE))
+		{
+			SIM_twiStop();
+		}
+		t->operation = SIM_TWI_OP_NONE;
+		t->queued = 0;
+		t->held = 0;
+		t->hung = 0;
+		t->receiving = 0;
+		t->twcr = 0;
+		return;
+	}
+	if(t->operation != SIM_TWI_OP_NONE)
+	{
+		/* Like a STOP followed by a START, the write takes effect once the bus is free */
+		t->queued = 1;
+		t->queued_twcr = value;
+		return;
+	}
+
+	t->twcr = (uint8_t)((value & (uint8_t)~(1 << SIM_TWINT)) | (t->twcr & (1 << SIM_TWINT)));
+	if(!(value & (1 << SIM_TWINT)))
+	{
+		return;
+	}
+	t->twcr &= (uint8_t)~(1 << SIM_TWINT);
+	/* No relevant state information while the operation runs */
+	e->regs[SIM_REG_TWSR] = (uint8_t)(0xF8 | (twsr & 0x03));
+	if(g_twiHangs != 0)
+	{
+		/* A slave stretching SCL for ever */
+		t->hung = 1;
+		if(g_twiHangs != SIM_FAULT_PERSISTENT)
+		{
+			g_twiHangs--;
+		}
+	}
+
+	/* SCL = F_CPU / (16 + 2 * TWBR * 4^TWPS) */
+	scl = 16 + (2ULL * e->regs[SIM_REG_TWBR] << (2 * (twsr & 0x03)));
+	if((value & (1 << SIM_TWSTO)) && (value & (1 << SIM_TWSTA)))
+	{
+		t->operation = SIM_TWI_OP_STOP_START;
+		t->end = e->cycles + 2 * scl;
+	}
+	else if(value & (1 << SIM_TWSTO))
+	{
+		t->operation = SIM_TWI_OP_STOP;
+		t->end = e->cycles + scl;
+	}
+	else if(value & (1 << SIM_TWSTA))
+	{
+		t->operation = SIM_TWI_OP_START;
+		t->end = e->cycles + scl;
+	}
+	else
+	{
+		/* 8 data bits and the acknowledge */
+		t->operation = t->receiving ? SIM_TWI_OP_READ : SIM_TWI_OP_WRITE;
+		t->end = e->cycles + 9 * scl;
+	}
+}
+
+/*
+ * Description :
+ * Take the TWCR writes of the firmware and end the bus operation when its time is reached:
+ * the devices on the bus answer, TWSR gets the status and TWINT is set, except after a STOP.
+ */
+static void SIM_twiUpdate(SIM_EcuType *e)
+{
+	SIM_TwiType *t = &e->twi;
+	uint8_t status = 0xF8;
+	uint8_t data;
+
+	if(t->touched)
+	{
+		t->touched = 0;
+		if(!(e->regs[SIM_REG_TWCR] & SIM_TWCR_UNWRITTEN))
+		{
+			SIM_twiControl(e, e->regs[SIM_REG_TWCR]);
+		}
+		e->regs[SIM_REG_TWCR] = t->twcr;
+	}
+	if((t->operation == SIM_TWI_OP_NONE) || t->hung || (e->cycles < t->end))
+	{
+		return;
+	}
+
+	switch(t->operation)
+	{
+	case SIM_TWI_OP_STOP_START:
+		SIM_twiStop();
+		status = SIM_twiStart();
+		t->held = 1;
+		break;
+	case SIM_TWI_OP_STOP:
+		SIM_twiStop();
+		t->held = 0;
+		break;
+	case SIM_TWI_OP_START:
+		status = SIM_twiStart();
+		t->held = 1;
+		break;
+	case SIM_TWI_OP_WRITE:
+		status = SIM_twiWrite(e->regs[SIM_REG_TWDR]);
+		break;
+	default:
+		status = SIM_twiRead((t->twcr >> SIM_TWEA) & 1, &data);
+		e->regs[SIM_REG_TWDR] = data;
+		break;
+	}
+	t->twcr &= (uint8_t)~((1 << SIM_TWSTO) | (1 << SIM_TWSTA));
+	if(t->operation != SIM_TWI_OP_STOP)
+	{
+		t->twcr |= (1 << SIM_TWINT);
+	}
+	/* After SLA+R ACK (0x40) or a byte ACKed by the master (0x50) the slave goes on sending */
+	t->receiving = (status == 0x40) || (status == 0x50);
+	e->regs[SIM_REG_TWSR] = (uint8_t)(status | (e->regs[SIM_REG_TWSR] & 0x03));
+	e->regs[SIM_REG_TWCR] = t->twcr;
+	t->operation = SIM_TWI_OP_NONE;
+	e->activity = 1;
+
+	if(t->queued)
+	{
+		t->queued = 0;
+		SIM_twiControl(e, t->queued_twcr);
+		e->regs[SIM_REG_TWCR] = t->twcr;
+	}
+}
+
+/*
+ * Description :
+ * Time of the end of the TWI operation, SIM_NEVER if the bus is idle.
+ */
+static SIM_TimeType SIM_twiNextEvent(const SIM_EcuType *e)
+{
+	if((e->twi.operation == SIM_TWI_OP_NONE) || e->twi.hung)
+	{
+		return SIM_NEVER;
+	}
+	return e->twi.end * SIM_NS_PER_CYCLE;
+}
+
+/*
+ * Description :
+ * Report the PORT and DDR changes done by the firmware since the last synchronization to the devices.
+ */
+static void SIM_gpioUpdate(SIM_EcuType *e)
+{
+	uint8_t port;
+	uint8_t ddr;
+	uint8_t value;
+
+	for(port = 0; port < SIM_PORTS; port++)
+	{
+		ddr = e->regs[SIM_DDR_ADDRESS(port)];
+		value = e->regs[SIM_PORT_ADDRESS(port)];
+		if((ddr != e->ddr_seen[port]) || (value != e->port_seen[port]))
+		{
+			e->ddr_seen[port] = ddr;
+			e->port_seen[port] = value;
+			SIM_devicesPortChanged(SIM_ecuIndex(e), port, ddr, value);
+		}
+	}
+}
+
+/*
+ * Description :
+ * The transmitter takes one more byte now (UDRE): the frames waiting for the shift register
+ * leave room in UDR and the link to the other ECU is not full.
+ */
+static uint8_t SIM_uartTxRoom(const SIM_EcuType *e)
+{
+	const SIM_UartType *u = &e->uart;
+	const SIM_UartType *peer = &g_ecus[(SIM_ecuIndex(e) + 1) % SIM_ECU_COUNT].uart;
+	SIM_TimeType now = SIM_ecuTime(e);
+	uint64_t waiting = 0;
+
+	if(!(e->regs[SIM_REG_UCSRB] & (1 << SIM_TXEN)))
+	{
+		return 0;
+	}
+	/* Frames not started yet, the one in the shift register is not counted */
+	if(u->tx_free > now)
+	{
+		waiting = ((u->tx_free - now) + u->frame_ns - 1) / u->frame_ns - 1;
+	}
+	return (waiting < SIM_UART_TX_BUFFER) && (peer->incoming_count != SIM_UART_QUEUE_SIZE);
+}
+
+/*
+ * Description :
+ * UCSRA as read by the firmware: RXC and the error flags of the first byte of the receive FIFO,
+ * TXC once the last frame is out and UDRE.
+ */
+static uint8_t SIM_uartStatus(const SIM_EcuType *e)
+{
+	const SIM_UartType *u = &e->uart;
+	uint8_t status = (uint8_t)(u->u2x << SIM_U2X);
+
+	if(u->rx_count != 0)
+	{
+		status |= (uint8_t)((1 << SIM_RXC) | u->rx_flags[u->rx_head]);
+	}
+	if(u->txc_armed && (u->tx_free <= SIM_ecuTime(e)))
+	{
+		status |= (1 << SIM_TXC);
+	}
+	if(SIM_uartTxRoom(e))
+	{
+		status |= (1 << SIM_UDRE);
+	}
+	return status;
+}
+
+/*
+ * Description :
+ * Read the frame format and the bit time from UCSRB, UCSRC, UBRR and U2X.
+ */
+static void SIM_uartFormat(SIM_EcuType *e)
+{
+	SIM_UartType *u = &e->uart;
+	uint8_t ucsrb = e->regs[SIM_REG_UCSRB];
+	uint16_t ubrr = (uint16_t)(((u->ubrrh & 0x0F) << 8) | e->regs[SIM_REG_UBRRL]);
+	uint8_t size = (uint8_t)((((ucsrb >> SIM_UCSZ2) & 1) << 2) | ((u->ucsrc >> SIM_UCSZ0) & 3));
+	uint8_t data_bits = (size == 7) ? 9 : (uint8_t)(5 + (size & 3));
+
+	u->configured = (ucsrb & ((1 << SIM_RXEN) | (1 << SIM_TXEN))) != 0;
+	/* Start bit, data bits, parity bit and stop bits */
+	u->frame_bits = (uint8_t)(1 + data_bits + ((u->ucsrc >> SIM_UPM1) & 1) + 1 + ((u->ucsrc >> SIM_USBS) & 1));
+	u->bit_ns = (SIM_TimeType)(u->u2x ? 8 : 16) * (ubrr + 1U) * SIM_NS_PER_CYCLE;
+	u->frame_ns = u->bit_ns * u->frame_bits;
+}
+
+/*
+ * Description :
+ * Start the transmission of a byte written to UDR, it is lost if UDR was not empty.
+ */
+static void SIM_uartTransmit(SIM_EcuType *e, uint8_t data)
+{
+	SIM_UartType *u = &e->uart;
+	SIM_UartType *peer = &g_ecus[(SIM_ecuIndex(e) + 1) % SIM_ECU_COUNT].uart;
+	SIM_TimeType now = SIM_ecuTime(e);
+	SIM_UartFrameType *frame;
+
+	if(!SIM_uartTxRoom(e))
+	{
+		return;
+	}
+	u->tx_free = ((u->tx_free > now) ? u->tx_free : now) + u->frame_ns;
+	u->txc_armed = 1;
+
+	if(u->losses != 0)
+	{
+		/* Sent but never received */
+		if(u->losses != SIM_FAULT_PERSISTENT)
+		{
+			u->losses--;
+		}
+	}
+	else
+	{
+		frame = &peer->incoming[(peer->incoming_head + peer->incoming_count) % SIM_UART_QUEUE_SIZE];
+		frame->data = data;
+		frame->frame_bits = u->frame_bits;
+		frame->bit_ns = u->bit_ns;
+		frame->arrival = u->tx_free;
+		peer->incoming_count++;
+	}
+
+	if(g_observer != NULL)
+	{
+		g_observer(SIM_EV_UART_WRITE, SIM_ecuIndex(e), now, data);
+		g_observer(SIM_EV_UART_TX, SIM_ecuIndex(e), u->tx_free, data);
+	}
+	e->activity = 1;
+}
+
+/*
+ * Description :
+ * Move the frames arrived until now to the receive FIFO. A frame sent with another format or a bit time
+ * too far from the receiver one gets FE, a frame arriving with a full FIFO is lost and sets DOR.
+ */
+static void SIM_uartReceive(SIM_EcuType *e)
+{
+	SIM_UartType *u = &e->uart;
+	SIM_UartFrameType *frame;
+	SIM_TimeType now = SIM_ecuTime(e);
+	SIM_TimeType error;
+	uint8_t flags;
+
+	while((u->incoming_count != 0) && (u->incoming[u->incoming_head].arrival <= now))
+	{
+		frame = &u->incoming[u->incoming_head];
+		u->incoming_head = (u->incoming_head + 1) % SIM_UART_QUEUE_SIZE;
+		u->incoming_count--;
+
+		if(!(e->regs[SIM_REG_UCSRB] & (1 << SIM_RXEN)))
+		{
+			continue;
+		}
+		if(u->rx_count == SIM_UART_RX_FIFO)
+		{
+			u->rx_flags[(u->rx_head + u->rx_count - 1) % SIM_UART_RX_FIFO] |= (1 << SIM_DOR);
+			continue;
+		}
+		/* The stop bit is sampled correctly while the accumulated bit time error stays under half a bit */
+		error = (frame->bit_ns > u->bit_ns) ? (frame->bit_ns - u->bit_ns) : (u->bit_ns - frame->bit_ns);
+		flags = 0;
+		if((frame->frame_bits != u->frame_bits) || ((error * (2 * u->frame_bits - 1)) >= u->bit_ns))
+		{
+			flags = (1 << SIM_FE);
+		}
+		u->rx[(u->rx_head + u->rx_count) % SIM_UART_RX_FIFO] = frame->data;
+		u->rx_flags[(u->rx_head + u->rx_count) % SIM_UART_RX_FIFO] = flags;
+		u->rx_count++;
+		e->activity = 1;
+	}
+}
+
+/*
+ * Description :
+ * Take the USART register accesses of the firmware since the last synchronization, then receive
+ * the frames arrived until now: a UDR write is transmitted, a UDR read takes the first byte of the FIFO,
+ * a UCSRA write sets U2X and clears TXC with a one, UBRRH and UCSRC share their address.
+ */
+static void SIM_uartUpdate(SIM_EcuType *e)
+{
+	SIM_UartType *u = &e->uart;
+	SIM_TimeType limit;
+	uint8_t value;
+
+	if(u->touched)
+	{
+		if((u->touched & SIM_UART_TOUCHED_UCSRA) && !(u->ucsra & SIM_UART_UNWRITTEN))
+		{
+			u->u2x = (uint8_t)((u->ucsra >> SIM_U2X) & 1);
+			if(u->ucsra & (1 << SIM_TXC))
+			{
+				u->txc_armed = 0;
+			}
+		}
+		if(u->touched & SIM_UART_TOUCHED_FORMAT)
+		{
+			value = e->regs[SIM_REG_UBRRH];
+			if(value & (1 << SIM_URSEL))
+			{
+				u->ucsrc = value;
+			}
+			else
+			{
+				u->ubrrh = value;
+			}
+		}
+		SIM_uartFormat(e);
+		/* A faster rate lets the other ECU send sooner than the slice allows */
+		limit = SIM_peerLimit(e);
+		if(limit < e->limit)
+		{
+			e->limit = limit;
+		}
+
+		if((u->touched & SIM_UART_TOUCHED_UDR) && !(u->udr & SIM_UART_UNWRITTEN))
+		{
+			SIM_uartTransmit(e, (uint8_t)u->udr);
+		}
+		else if((u->touched & SIM_UART_TOUCHED_UDR) && (u->rx_count != 0))
+		{
+			value = u->rx[u->rx_head];
+			u->rx_head = (u->rx_head + 1) % SIM_UART_RX_FIFO;
+			u->rx_count--;
+			e->activity = 1;
+			SIM_emit(SIM_EV_UART_RX, SIM_ecuIndex(e), value);
+		}
+		u->touched = 0;
+	}
+	SIM_uartReceive(e);
+}
+
+/*
+ * Description :
+ * Run the ISRs of the pending and enabled timer, USART and TWI interrupts while the I-bit is set.
+ * The timer vectors follow the TIFR and TIMSK bits: bit 7 is vector 4 down to bit 0 vector 11.
+ */
+static void SIM_serviceInterrupts(SIM_EcuType *e)
+{
+	uint8_t pending;
+	uint8_t bit;
+	void (*isr)(void);
+
+	while(!e->in_isr && (e->regs[SIM_REG_SREG] & SIM_SREG_I))
+	{
+		/* The TWCR write that clears TWINT or the UDR access may be the last thing the previous ISR did */
+		SIM_twiUpdate(e);
+		SIM_uartUpdate(e);
+		pending = e->regs[SIM_REG_TIFR] & e->regs[SIM_REG_TIMSK];
+		if(pending != 0)
+		{
+			for(bit = 7; (pending & (1 << bit)) == 0; bit--)
+			{
+			}
+			/* The flag is cleared by the hardware when the vector is executed */
+			e->regs[SIM_REG_TIFR] &= (uint8_t)~(1 << bit);
+			isr = e->vectors[SIM_TIMER2_COMP_VECTOR + (7 - bit)];
+		}
+		else if((e->regs[SIM_REG_UCSRB] & (1 << SIM_RXCIE)) && (e->uart.rx_count != 0))
+		{
+			isr = e->vectors[SIM_USART_RXC_VECTOR];
+		}
+		else if((e->regs[SIM_REG_UCSRB] & (1 << SIM_UDRIE)) && SIM_uartTxRoom(e))
+		{
+			isr = e->vectors[SIM_USART_UDRE_VECTOR];
+		}
+		else if((e->twi.twcr & ((1 << SIM_TWINT) | (1 << SIM_TWIE))) == ((1 << SIM_TWINT) | (1 << SIM_TWIE)))
+		{
+			/* TWINT is cleared only by the firmware writing it */
+			isr = e->vectors[SIM_TWI_VECTOR];
+		}
+		else
+		{
+			break;
+		}
+
+		e->in_isr = 1;
+		e->regs[SIM_REG_SREG] &= (uint8_t)~SIM_SREG_I;
+		e->cycles += SIM_CYCLES_PER_ISR;
+		if(isr != NULL)
+		{
+			isr();
+		}
+		e->regs[SIM_REG_SREG] |= SIM_SREG_I;
+		e->in_isr = 0;
+		/* Marked after the ISR so the idle detection watches the interrupted code, not the ISR */
+		e->activity = 1;
+	}
+}
+
+/*
+ * Description :
+ * Time of the next frame arrival on the USART of the ECU, of the next free Tx slot or of TXC.
+ */
+static SIM_TimeType SIM_uartNextEvent(const SIM_EcuType *e)
+{
+	const SIM_UartType *u = &e->uart;
+	SIM_TimeType next = SIM_NEVER;
+	SIM_TimeType now = SIM_ecuTime(e);
+
+	if(u->incoming_count != 0)
+	{
+		next = u->incoming[u->incoming_head].arrival;
+	}
+	if(u->configured && (u->tx_free > now))
+	{
+		SIM_TimeType slot = now + ((u->tx_free - now) % u->frame_ns);
+		if(slot == now)
+		{
+			slot += u->frame_ns;
+		}
+		if(slot < next)
+		{
+			next = slot;
+		}
+	}
+	return next;
+}
+
+static SIM_TimeType SIM_nextEvent(const SIM_EcuType *e)
+{
+	SIM_TimeType next = SIM_timersNextEvent(e);
+	SIM_TimeType t = SIM_uartNextEvent(e);
+
+	if(t < next)
+	{
+		next = t;
+	}
+	t = SIM_devicesNextEvent(SIM_ecuIndex(e));
+	if(t < next)
+	{
+		next = t;
+	}
+	t = SIM_twiNextEvent(e);
+	if(t < next)
+	{
+		next = t;
+	}
+	return next;
+}
+
+/*
+ * Description :
+ * Move the ECU clock forward to the next event, or to its limit, as the firmware is only waiting.
+ */
+static void SIM_skipToNextEvent(SIM_EcuType *e)
+{
+	SIM_TimeType target = SIM_nextEvent(e);
+	uint64_t cycles;
+
+	if(target > e->limit)
+	{
+		target = e->limit;
+	}
+	cycles = (target + SIM_NS_PER_CYCLE - 1) / SIM_NS_PER_CYCLE;
+	if(cycles > e->cycles)
+	{
+		e->cycles = cycles;
+		SIM_timersUpdate(e);
+		SIM_twiUpdate(e);
+		SIM_uartUpdate(e);
+		SIM_serviceInterrupts(e);
+	}
+}
+
+/*
+ * Description :
+ * Synchronization point of the running ECU, done on every register access and function call:
+ * update the timer and the devices, take the interrupts, skip the waiting time and give the
+ * host its turn at the limit.
+ */
+static void SIM_sync(SIM_EcuType *e, const void *site)
+{
+	uint64_t ports = 0;
+	uint64_t busy_cycles;
+	uint8_t port;
+
+	SIM_timersUpdate(e);
+	SIM_twiUpdate(e);
+	SIM_uartUpdate(e);
+	SIM_gpioUpdate(e);
+	SIM_devicesUpdate(SIM_ecuIndex(e));
+	SIM_serviceInterrupts(e);
+
+	if((e->busy_cycles != 0) && !e->in_isr && (e->regs[SIM_REG_SREG] & SIM_SREG_I))
+	{
+		/* Like a long routine of the firmware, the interrupts are taken meanwhile */
+		busy_cycles = e->busy_cycles;
+		e->busy_cycles = 0;
+		SIM_delayCycles(busy_cycles);
+	}
+
+	for(port = 0; port < SIM_PORTS; port++)
+	{
+		ports = (ports << 16) | ((uint64_t)e->ddr_seen[port] << 8) | e->port_seen[port];
+	}
+	if(e->in_isr)
+	{
+		/* An ISR never waits, the interrupted code is watched */
+	}
+	else if(e->activity || (++e->idle_syncs > SIM_IDLE_ANCHOR_SYNCS) || ((site == e->idle_site) && (ports != e->idle_ports)))
+	{
+		/* Progress, or no loop around the watched point: watch this point from now on */
+		e->activity = 0;
+		e->idle_site = site;
+		e->idle_ports = ports;
+		e->idle_syncs = 0;
+		e->idle_hits = 0;
+	}
+	else if(site == e->idle_site)
+	{
+		e->idle_syncs = 0;
+		if(++e->idle_hits >= SIM_IDLE_REPEATS)
+		{
+			e->idle_hits = 0;
+			SIM_skipToNextEvent(e);
+		}
+	}
+
+	if(SIM_ecuTime(e) >= e->limit)
+	{
+		SIM_yield(e);
+	}
+}
+/*
+ * Description :
+ * Time the ECU may run to without missing a byte of the other one: one UART frame after the other,
+ * at the faster rate of the two since a byte sent at a third rate is received as garbage anyway.
+ */
+static SIM_TimeType SIM_peerLimit(const SIM_EcuType *e)
+{
+	const SIM_EcuType *other = &g_ecus[(SIM_ecuIndex(e) + 1) % SIM_ECU_COUNT];
+	SIM_TimeType lookahead = other->uart.configured ? other->uart.frame_ns : SIM_DEFAULT_LOOKAHEAD;
+
+	if(other->halted)
+	{
+		return UINT64_MAX;
+	}
+	if(e->uart.configured && (e->uart.frame_ns < lookahead))
+	{
+		lookahead = e->uart.frame_ns;
+	}
+	return SIM_ecuTime(other) + lookahead;
+}
+
+/*
+ * Description :
+ * Give the turn to the ECU that is behind, until it passes the other one by the lookahead.
+ */
+static void SIM_step(void)
+{
+	SIM_EcuType *e = NULL;
+	SIM_TimeType limit;
+	SIM_TimeType peer_limit;
+	uint8_t i;
+
+	for(i = 0; i < SIM_ECU_COUNT; i++)
+	{
+		if(!g_ecus[i].halted && ((e == NULL) || (SIM_ecuTime(&g_ecus[i]) < SIM_ecuTime(e))))
+		{
+			e = &g_ecus[i];
+		}
+	}
+	if(e == NULL)
+	{
+		return;
+	}
+
+	limit = SIM_ecuTime(e) + SIM_MAX_SLICE;
+	peer_limit = SIM_peerLimit(e);
+	e->limit = (peer_limit < limit) ? peer_limit : limit;
+
+	g_current = e;
+	swapcontext(&g_hostContext, &e->context);
+	g_current = NULL;
+}
+
+static void SIM_powerUp(SIM_EcuType *e)
+{
+	memcpy(e->data_start, e->data_image, (size_t)(e->data_end - e->data_start));
+	memset(e->bss_start, 0, (size_t)(e->bss_end - e->bss_start));
+	memset(e->regs, 0, sizeof(e->regs));
+	memset(e->ddr_seen, 0, sizeof(e->ddr_seen));
+	memset(e->port_seen, 0, sizeof(e->port_seen));
+	memset(&e->uart, 0, sizeof(e->uart));
+	e->uart.ucsrc = SIM_UCSRC_RESET;
+	SIM_uartFormat(e);
+	e->cycles = 0;
+	e->limit = 0;
+	e->halted = 0;
+	e->in_isr = 0;
+	e->busy_cycles = 0;
+	e->activity = 0;
+	e->idle_site = NULL;
+	e->idle_syncs = 0;
+	e->idle_hits = 0;
+	memset(&e->timer1, 0, sizeof(e->timer1));
+	memset(&e->timer2, 0, sizeof(e->timer2));
+	memset(&e->twi, 0, sizeof(e->twi));
+	e->regs[SIM_REG_TWSR] = 0xF8;
+
+	getcontext(&e->context);
+	e->context.uc_stack.ss_sp = e->stack;
+	e->context.uc_stack.ss_size = SIM_STACK_SIZE;
+	e->context.uc_link = &g_hostContext;
+	makecontext(&e->context, SIM_ecuEntry, 0);
+}
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+volatile uint8_t *SIM_reg(uint8_t address)
+{
+	SIM_EcuType *e = g_current;
+	uint8_t port;
+	uint8_t ddr;
+
+	e->cycles += SIM_CYCLES_PER_REG_ACCESS;
+	SIM_sync(e, __builtin_return_address(0));
+
+	if((address >= SIM_PIN_ADDRESS(SIM_PORTS - 1)) && (address <= SIM_PORT_ADDRESS(0)) &&
+	   (((SIM_PIN_ADDRESS(0) - address) % 3) == 0))
+	{
+		/* PINx: the output pins read back PORTx, the input pins what the devices drive */
+		port = (uint8_t)((SIM_PIN_ADDRESS(0) - address) / 3);
+		ddr = e->regs[SIM_DDR_ADDRESS(port)];
+		e->regs[address] = SIM_devicesReadPort(SIM_ecuIndex(e), port, ddr, e->regs[SIM_PORT_ADDRESS(port)]);
+	}
+	else if((address == SIM_REG_TCNT1L) || (address == SIM_REG_TCNT1H))
+	{
+		e->regs[SIM_REG_TCNT1L] = (uint8_t)e->timer1.count;
+		e->regs[SIM_REG_TCNT1H] = (uint8_t)(e->timer1.count >> 8);
+		e->timer1.touched = 1;
+	}
+	else if(address == SIM_REG_TCNT2)
+	{
+		e->regs[SIM_REG_TCNT2] = (uint8_t)e->timer2.count;
+		e->timer2.touched = 1;
+	}
+	else if(address == SIM_REG_TWCR)
+	{
+		e->regs[SIM_REG_TWCR] = e->twi.twcr | SIM_TWCR_UNWRITTEN;
+		e->twi.touched = 1;
+	}
+	else if(address == SIM_REG_UCSRA)
+	{
+		e->uart.ucsra = SIM_UART_UNWRITTEN | SIM_uartStatus(e);
+		e->uart.touched |= SIM_UART_TOUCHED_UCSRA;
+		return (volatile uint8_t *)&e->uart.ucsra;
+	}
+	else if(address == SIM_REG_UDR)
+	{
+		/* A read gets the first byte of the receive FIFO */
+		e->uart.udr = SIM_UART_UNWRITTEN | ((e->uart.rx_count != 0) ? e->uart.rx[e->uart.rx_head] : 0);
+		e->uart.touched |= SIM_UART_TOUCHED_UDR;
+		return (volatile uint8_t *)&e->uart.udr;
+	}
+	else if((address == SIM_REG_UCSRB) || (address == SIM_REG_UBRRL) || (address == SIM_REG_UBRRH))
+	{
+		/* Read back as written, UCSRC is taken from the UBRRH address by its URSEL bit */
+		e->uart.touched |= SIM_UART_TOUCHED_FORMAT;
+	}
+	return &e->regs[address];
+}
+
+void SIM_delayCycles(uint64_t cycles)
+{
+	SIM_EcuType *e = g_current;
+	uint64_t end = e->cycles + cycles;
+	uint64_t target;
+	uint64_t before;
+
+	while(e->cycles < end)
+	{
+		target = (SIM_nextEvent(e) + SIM_NS_PER_CYCLE - 1) / SIM_NS_PER_CYCLE;
+		if(target > (e->limit + SIM_NS_PER_CYCLE - 1) / SIM_NS_PER_CYCLE)
+		{
+			target = (e->limit + SIM_NS_PER_CYCLE - 1) / SIM_NS_PER_CYCLE;
+		}
+		if(target > end)
+		{
+			target = end;
+		}
+		if(target <= e->cycles)
+		{
+			target = e->cycles + 1;
+		}
+		e->cycles = target;
+
+		SIM_timersUpdate(e);
+		SIM_twiUpdate(e);
+		SIM_uartUpdate(e);
+		SIM_gpioUpdate(e);
+		/* The ISRs run inside the busy loop so they make it longer */
+		before = e->cycles;
+		SIM_serviceInterrupts(e);
+		end += e->cycles - before;
+
+		if(SIM_ecuTime(e) >= e->limit)
+		{
+			SIM_yield(e);
+		}
+	}
+	e->activity = 1;
+}
+
+void SIM_cli(void)
+{
+	SIM_EcuType *e = g_current;
+
+	e->cycles++;
+	e->regs[SIM_REG_SREG] &= (uint8_t)~SIM_SREG_I;
+}
+
+void SIM_sei(void)
+{
+	SIM_EcuType *e = g_current;
+
+	e->cycles++;
+	e->regs[SIM_REG_SREG] |= SIM_SREG_I;
+	SIM_sync(e, __builtin_return_address(0));
+}
+
+SIM_TimeType SIM_now(void)
+{
+	return SIM_ecuTime(g_current);
+}
+
+uint32_t SIM_nsPerCycle(void)
+{
+	return SIM_NS_PER_CYCLE;
+}
+
+uint8_t SIM_currentEcu(void)
+{
+	return SIM_ecuIndex(g_current);
+}
+
+uint8_t SIM_peek(uint8_t ecu, uint8_t address)
+{
+	return g_ecus[ecu].regs[address];
+}
+
+void SIM_portState(uint8_t ecu, uint8_t port, uint8_t *ddr_Ptr, uint8_t *value_Ptr)
+{
+	*ddr_Ptr = g_ecus[ecu].regs[SIM_DDR_ADDRESS(port)];
+	*value_Ptr = g_ecus[ecu].regs[SIM_PORT_ADDRESS(port)];
+}
+
+void SIM_emit(SIM_EventType event, uint8_t ecu, uint32_t value)
+{
+	if(g_observer != NULL)
+	{
+		g_observer(event, ecu, (g_current != NULL) ? SIM_ecuTime(g_current) : SIM_time(), value);
+	}
+}
+
+void SIM_setObserver(SIM_ObserverType observer)
+{
+	g_observer = observer;
+}
+
+/*
+ * Description :
+ * Function instrumentation hooks (-finstrument-functions) of the firmware: every call
+ * costs cycles and is a synchronization point, so loops without register accesses progress.
+ * The calls of the profiled functions are measured from their call to their return.
+ */
+void __cyg_profile_func_enter(void *function, void *call_site)
+{
+	SIM_EcuType *e = g_current;
+	uint8_t i;
+
+	(void)call_site;
+	if(e != NULL)
+	{
+		for(i = 0; i < SIM_PROFILE_COUNT; i++)
+		{
+			if(e->profiled[i].function == function)
+			{
+				e->profile_entry[i] = e->cycles;
+			}
+		}
+		e->cycles += SIM_CYCLES_PER_CALL;
+		SIM_sync(e, function);
+	}
+}
+
+void __cyg_profile_func_exit(void *function, void *call_site)
+{
+	SIM_EcuType *e = g_current;
+	SIM_ProfileType *p;
+	uint64_t cycles;
+	uint8_t i;
+
+	(void)call_site;
+	if(e == NULL)
+	{
+		return;
+	}
+	for(i = 0; i < SIM_PROFILE_COUNT; i++)
+	{
+		if(e->profiled[i].function == function)
+		{
+			p = &e->profile[i];
+			cycles = e->cycles - e->profile_entry[i];
+			if((p->calls == 0) || (cycles < p->min_cycles))
+			{
+				p->min_cycles = cycles;
+			}
+			if(cycles > p->max_cycles)
+			{
+				p->max_cycles = cycles;
+			}
+			p->cycles += cycles;
+			p->calls++;
+		}
+	}
+}
+
+/*******************************************************************************
+ *                          Host side control                                  *
+ *******************************************************************************/
+void SIM_init(void)
+{
+	uint8_t i;
+	SIM_EcuType *e;
+
+	for(i = 0; i < SIM_ECU_COUNT; i++)
+	{
+		e = &g_ecus[i];
+		if(e->stack == NULL)
+		{
+			/* Keep the .data image before the first run changes it */
+			e->stack = malloc(SIM_STACK_SIZE);
+			e->data_image = malloc((size_t)(e->data_end - e->data_start) + 1);
+			if((e->stack == NULL) || (e->data_image == NULL))
+			{
+				fprintf(stderr, "sim: out of memory\n");
+				exit(1);
+			}
+			memcpy(e->data_image, e->data_start, (size_t)(e->data_end - e->data_start));
+		}
+	}
+	SIM_devicesReset(1);
+	g_twiHangs = 0;
+	for(i = 0; i < SIM_ECU_COUNT; i++)
+	{
+		memset(g_ecus[i].profile, 0, sizeof(g_ecus[i].profile));
+		SIM_powerUp(&g_ecus[i]);
+	}
+}
+
+void SIM_reset(void)
+{
+	uint8_t i;
+
+	SIM_devicesReset(0);
+	for(i = 0; i < SIM_ECU_COUNT; i++)
+	{
+		SIM_powerUp(&g_ecus[i]);
+	}
+}
+
+void SIM_twiHang(uint8_t count)
+{
+	g_twiHangs = count;
+}
+
+void SIM_uartLose(uint8_t ecu, uint8_t count)
+{
+	g_ecus[ecu].uart.losses = count;
+}
+
+void SIM_busy(uint8_t ecu, SIM_TimeType duration)
+{
+	g_ecus[ecu].busy_cycles = duration / SIM_NS_PER_CYCLE;
+}
+
+uint32_t SIM_uartBaudRate(uint8_t ecu)
+{
+	const SIM_UartType *u = &g_ecus[ecu].uart;
+
+	if(!u->configured)
+	{
+		return 0;
+	}
+	return (uint32_t)((1000000000ULL + (u->bit_ns / 2)) / u->bit_ns);
+}
+
+int SIM_runUntil(int (*condition)(void *), void *arg, SIM_TimeType timeout)
+{
+	SIM_TimeType deadline = SIM_time() + timeout;
+
+	for(;;)
+	{
+		if((condition != NULL) && condition(arg))
+		{
+			return 1;
+		}
+		if(SIM_time() >= deadline)
+		{
+			return (condition == NULL);
+		}
+		SIM_step();
+	}
+}
+
+SIM_TimeType SIM_time(void)
+{
+	SIM_TimeType t = SIM_NEVER;
+	uint8_t i;
+
+	for(i = 0; i < SIM_ECU_COUNT; i++)
+	{
+		/* A stopped ECU does not hold the time back */
+		if(!g_ecus[i].halted && (SIM_ecuTime(&g_ecus[i]) < t))
+		{
+			t = SIM_ecuTime(&g_ecus[i]);
+		}
+	}
+	return t;
+}
+
+uint64_t SIM_cycles(uint8_t ecu)
+{
+	return g_ecus[ecu].cycles;
+}
+
+int SIM_profile(uint8_t ecu, const char *name_Ptr, SIM_ProfileType *profile_Ptr)
+{
+	const SIM_EcuType *e = &g_ecus[ecu];
+	uint8_t i;
+
+	for(i = 0; i < SIM_PROFILE_COUNT; i++)
+	{
+		if((e->profiled[i].function != NULL) && (strcmp(e->profiled[i].name, name_Ptr) == 0))
+		{
+			*profile_Ptr = e->profile[i];
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*******************************************************************************
+ *             avr-libc functions missing from the host C library              *
+ *******************************************************************************/
+char *itoa(int value, char *string_Ptr, int radix)
+{
+	char digits[sizeof(int) * 8 + 1];
+	unsigned int magnitude = (value < 0 && radix == 10) ? (unsigned int)(-value) : (unsigned int)value;
+	int length = 0;
+	int i = 0;
+
+	do
+	{
+		digits[length++] = "0123456789abcdefghijklmnopqrstuvwxyz"[magnitude % (unsigned int)radix];
+		magnitude /= (unsigned int)radix;
+	}while(magnitude != 0);
+
+	if(value < 0 && radix == 10)
+	{
+		string_Ptr[i++] = '-';
+	}
+	while(length > 0)
+	{
+		string_Ptr[i++] = digits[--length];
+	}
+	string_Ptr[i] = '\0';
+	return string_Ptr;
+}
+
+char *utoa(unsigned int value, char *string_Ptr, int radix)
+{
+	char digits[sizeof(int) * 8 + 1];
+	int length = 0;
+	int i = 0;
+
+	do
+	{
+		digits[length++] = "0123456789abcdefghijklmnopqrstuvwxyz"[value % (unsigned int)radix];
+		value /= (unsigned int)radix;
+	}while(value != 0);
+
+	while(length > 0)
+	{
+		string_Ptr[i++] = digits[--length];
+	}
+	string_Ptr[i] = '\0';
+	return string_Ptr;
+}
+
+char *ultoa(unsigned long value, char *string_Ptr, int radix)
+{
+	char digits[sizeof(long) * 8 + 1];
+	int length = 0;
+	int i = 0;
+
+	do
+	{
+		digits[length++] = "0123456789abcdefghijklmnopqrstuvwxyz"[value % (unsigned long)radix];
+		value /= (unsigned long)radix;
+	}while(value != 0);
+
+	while(length > 0)
+	{
+		string_Ptr[i++] = digits[--length];
+	}
+	string_Ptr[i] = '\0';
+	return string_Ptr;
+}
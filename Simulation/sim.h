@@ -0,0 +1,259 @@
+/*
+ ================================================================================================
+ File Name: sim.h
+ Name        : Door Locker Security System
+ Author      : Omar Muhammad
+ Description : Header file of the host simulator running HMI_ECU and Control_ECU firmware on Linux.
+               GPIO, timers, TWI and USART are simulated at the register level so the real drivers run on top.
+               The ECUs run as coroutines in simulated time, connected by a virtual UART link.
+ Date        : 17/10/2026
+ ================================================================================================
+ */
+
+#ifndef SIM_H_
+#define SIM_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+/* The register file is indexed by the ATmega32 data space address of the I/O registers */
+#define SIM_REG_FILE_SIZE           0x60
+
+/* Estimated cost, in CPU cycles, of the firmware operations the simulator can see */
+#define SIM_CYCLES_PER_CALL         6    /* call, return and a short prologue */
+#define SIM_CYCLES_PER_REG_ACCESS   2    /* in/out or lds/sts plus the bit logic around it */
+#define SIM_CYCLES_PER_ISR          20   /* vector jump, register saving and reti */
+
+/* Interrupt vectors of the ATmega32, the lower number has the higher priority */
+#define SIM_VECTOR_COUNT            21
+#define SIM_TIMER2_COMP_VECTOR      4    /* the timer vectors follow the TIFR bits from bit 7 down to bit 0 */
+
+/* Firmware functions whose cycles are measured, listed in sim_vectors.c */
+#define SIM_PROFILE_COUNT           5
+
+/* ECU indexes */
+#define SIM_HMI_ECU                 0
+#define SIM_CONTROL_ECU             1
+#define SIM_ECU_COUNT               2
+
+/* Time conversions, the simulated time is counted in ns */
+#define SIM_US(t)                   ((SIM_TimeType)(t) * 1000ULL)
+#define SIM_MS(t)                   ((SIM_TimeType)(t) * 1000000ULL)
+#define SIM_SECONDS(t)              ((SIM_TimeType)(t) * 1000000000ULL)
+
+/* Motor states reported by SIM_motorState */
+#define SIM_MOTOR_STOP              0
+#define SIM_MOTOR_CW                1
+#define SIM_MOTOR_A_CW              2
+
+/* Geometry of the virtual character LCD */
+#define SIM_LCD_ROWS                2
+#define SIM_LCD_COLS                16
+
+/* Size of the virtual 24C16 EEPROM */
+#define SIM_EEPROM_SIZE             2048
+#define SIM_EEPROM_PAGE_SIZE        16
+
+/* Count of SIM_twiHang and SIM_eepromNack that never runs out */
+#define SIM_FAULT_PERSISTENT        255
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef uint64_t SIM_TimeType;
+
+/* Events reported to the observer installed by SIM_setObserver */
+typedef enum
+{
+	SIM_EV_KEY_PRESS,      /* value: the key character */
+	SIM_EV_KEY_RELEASE,    /* value: the key character */
+	SIM_EV_LCD_COMMAND,    /* value: the command byte */
+	SIM_EV_LCD_DATA,       /* value: the character */
+	SIM_EV_UART_WRITE,     /* value: the byte, time is when the firmware gave it to the UART */
+	SIM_EV_UART_TX,        /* value: the byte, time is the end of its stop bit on the sending ECU */
+	SIM_EV_UART_RX,        /* value: the byte, time is when the firmware took it */
+	SIM_EV_MOTOR,          /* value: SIM_MOTOR_xxx */
+	SIM_EV_BUZZER,         /* value: 1 on, 0 off */
+	SIM_EV_EEPROM_WRITE,   /* value: first address of the committed write */
+	SIM_EV_EEPROM_READ,    /* value: address of the byte read */
+	SIM_EV_TWI_START,      /* value: 0, time is the end of the start condition */
+	SIM_EV_TWI_STOP        /* value: 0, time is the end of the stop condition */
+}SIM_EventType;
+
+typedef void (*SIM_ObserverType)(SIM_EventType event, uint8_t ecu, SIM_TimeType time, uint32_t value);
+
+/* Profiled firmware function, the function is NULL if the ECU does not have it */
+typedef struct
+{
+	const char *name;
+	void *function;
+}SIM_ProfileEntryType;
+
+/* Cycles of the calls of a profiled function, its nested calls and interrupts included */
+typedef struct
+{
+	uint32_t calls;
+	uint64_t cycles;
+	uint64_t min_cycles;
+	uint64_t max_cycles;
+}SIM_ProfileType;
+
+/*******************************************************************************
+ *             Functions used by the firmware side (shims and drivers)         *
+ *******************************************************************************/
+/*
+ * Description :
+ * Account one register access of the running ECU and return its storage.
+ * PINx and TCNTx are refreshed before returning, every access is a point where
+ * pending interrupts are taken and the ECU may give the host its turn.
+ */
+volatile uint8_t *SIM_reg(uint8_t address);
+
+/*
+ * Description :
+ * Busy wait of the running ECU, interrupts are taken meanwhile and extend the wait like on the AVR.
+ */
+void SIM_delayCycles(uint64_t cycles);
+
+/*
+ * Description :
+ * Clear or set the global interrupt enable bit of the running ECU.
+ */
+void SIM_cli(void);
+void SIM_sei(void);
+
+/*
+ * Description :
+ * Return the simulated time of the running ECU in ns and its CPU clock period.
+ */
+SIM_TimeType SIM_now(void);
+uint32_t SIM_nsPerCycle(void);
+
+/*******************************************************************************
+ *                 Functions used by the tests and benchmarks                  *
+ *******************************************************************************/
+/*
+ * Description :
+ * Power up both ECUs with an erased EEPROM, no pending keys and no injected faults.
+ */
+void SIM_init(void);
+
+/*
+ * Description :
+ * Power cycle both ECUs, the EEPROM keeps its content.
+ */
+void SIM_reset(void);
+
+/*
+ * Description :
+ * Run both ECUs until condition returns non zero or timeout ns of simulated time pass.
+ * Returns 1 if the condition was met. A NULL condition just runs for timeout.
+ */
+int SIM_runUntil(int (*condition)(void *), void *arg, SIM_TimeType timeout);
+
+/*
+ * Description :
+ * Simulated time reached by both ECUs, and the cycles executed by one ECU since power up.
+ */
+SIM_TimeType SIM_time(void);
+uint64_t SIM_cycles(uint8_t ecu);
+
+/*
+ * Description :
+ * Cycles spent by one ECU in a profiled firmware function since SIM_init, the power cycles keep them.
+ * Returns 0 if the ECU does not have a profiled function with that name.
+ */
+int SIM_profile(uint8_t ecu, const char *name_Ptr, SIM_ProfileType *profile_Ptr);
+
+/*
+ * Description :
+ * Install the observer of the simulated events, NULL removes it.
+ */
+void SIM_setObserver(SIM_ObserverType observer);
+
+/* Virtual keypad: the keys are pressed one by one when the firmware scans the keypad */
+void SIM_keypadType(const char *keys_Ptr);
+void SIM_keypadSetTiming(SIM_TimeType hold, SIM_TimeType gap);
+int SIM_keypadIdle(void);
+
+/* Virtual LCD */
+const char *SIM_lcdRow(uint8_t row);
+int SIM_lcdContains(const char *text_Ptr);
+uint32_t SIM_lcdTimingViolations(void);
+
+/* Door motor and buzzer */
+uint8_t SIM_motorState(void);
+uint8_t SIM_motorDuty(void);
+uint8_t SIM_buzzerState(void);
+
+/* Virtual 24C16 EEPROM */
+uint8_t *SIM_eepromData(void);
+void SIM_eepromErase(void);
+uint32_t SIM_eepromPageWrites(uint8_t page);
+
+/*
+ * Description :
+ * Inject bus faults in the next count operations, SIM_FAULT_PERSISTENT until cleared with 0:
+ * SIM_twiHang: the TWI operation never ends until the firmware disables the TWI.
+ * SIM_eepromNack: the EEPROM does not acknowledge its address.
+ */
+void SIM_twiHang(uint8_t count);
+void SIM_eepromNack(uint8_t count);
+
+/*
+ * Description :
+ * Bit rate of the USART of an ECU, 0 while its receiver and transmitter are disabled.
+ */
+uint32_t SIM_uartBaudRate(uint8_t ecu);
+
+/*
+ * Description :
+ * Lose the next count bytes sent by the ECU on the line, SIM_FAULT_PERSISTENT until cleared with 0.
+ * The power cycles clear it.
+ */
+void SIM_uartLose(uint8_t ecu, uint8_t count);
+
+/*
+ * Description :
+ * Keep the firmware of the ECU busy for duration once it enabled the interrupts, like a long blocking
+ * routine: the ISRs run meanwhile. The power cycles clear it.
+ */
+void SIM_busy(uint8_t ecu, SIM_TimeType duration);
+
+/*
+ * Description :
+ * Cut the power during the next page write: only its first bytes are programmed,
+ * the test power cycles the ECUs with SIM_reset afterwards.
+ */
+void SIM_eepromPowerFail(uint8_t bytes);
+
+/*******************************************************************************
+ *                  Functions shared between the simulator modules             *
+ *******************************************************************************/
+/* Emit an event to the observer */
+void SIM_emit(SIM_EventType event, uint8_t ecu, uint32_t value);
+
+/* Index of the ECU running now */
+uint8_t SIM_currentEcu(void);
+
+/* Read a register of an ECU without accounting an access, and the DDR and PORT values of its port */
+uint8_t SIM_peek(uint8_t ecu, uint8_t address);
+void SIM_portState(uint8_t ecu, uint8_t port, uint8_t *ddr_Ptr, uint8_t *value_Ptr);
+
+/* Devices (sim_devices.c) */
+void SIM_devicesReset(int erase_eeprom);
+void SIM_devicesPortChanged(uint8_t ecu, uint8_t port, uint8_t ddr, uint8_t value);
+uint8_t SIM_devicesReadPort(uint8_t ecu, uint8_t port, uint8_t ddr, uint8_t value);
+void SIM_devicesUpdate(uint8_t ecu);
+SIM_TimeType SIM_devicesNextEvent(uint8_t ecu);
+
+/* TWI bus of the Control_ECU, called by the TWI master model at the end of every operation,
+ * they return the TWSR status of the operation */
+uint8_t SIM_twiStart(void);
+uint8_t SIM_twiWrite(uint8_t data);
+uint8_t SIM_twiRead(uint8_t ack, uint8_t *data_Ptr);
+void SIM_twiStop(void);
+
+#endif /* SIM_H_ */
@@ -0,0 +1,471 @@
+/*
+ ================================================================================================
+ File Name: sim_bench.c
+ Name        : Door Locker Security System
+ Author      : Omar Muhammad
+ Description : Latency benchmark of the HMI_ECU to Control_ECU transactions on the host simulator.
+               Every transaction starts when the '=' key that completes it is pressed and is split
+               in phases from the simulator events:
+               keypad   : '=' pressed until the HMI_ECU gives the first request byte to the UART,
+                          the digit frames sent while typing are not counted
+               request  : first request byte until the Control_ECU takes the last one
+               eeprom   : first TWI start until the last TWI stop of the Control_ECU
+               decision : the rest of the Control_ECU processing until it sends the first reply byte
+               reply    : first reply byte until the HMI_ECU takes the last one
+               motor    : '=' pressed until the door motor starts, for the unlock transactions
+               The user code transactions are run with 10, 100 and 500 codes in the table, "unknown"
+               looks up a code that is not there and "user" the last added one.
+               The cycles are CPU cycles at F_CPU elapsed in each phase. The profiled firmware functions
+               follow with their average and worst cycles per call over all the transactions, as counted
+               by the simulator cost model (calls and register accesses). The simulation is deterministic
+               so the results can be compared exactly with a baseline saved before a driver change.
+ Date        : 17/10/2026
+ ================================================================================================
+ */
+
+#include "sim.h"
+#include "../Control_ECU/users.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define BENCH_F_CPU               8000000ULL
+#define BENCH_PROTOCOL_OVERHEAD   4      /* START + TYPE + LENGTH + CRC, see protocol.h */
+#define BENCH_LENGTH_INDEX        2      /* LENGTH byte of the frame */
+#define BENCH_MAX_RESULTS         16
+#define BENCH_NAME_SIZE           24
+
+#define MAIN_OPTIONS_TEXT         "+ : Open Door"
+
+/* User codes of the lookup transactions: USER_CODE(i) for i = 0, 1, ... are all different */
+#define USER_CODE(i)              ((13579UL + (uint32_t)(i) * 7919UL) % 100000UL)
+#define ENTER_PASSWORD_TEXT       "Plz enter pass:"
+
+/*******************************************************************************
+ *                         Types Declaration                                   *
+ *******************************************************************************/
+typedef enum
+{
+	BENCH_KEYPAD, BENCH_REQUEST, BENCH_EEPROM, BENCH_DECISION, BENCH_REPLY, BENCH_TOTAL, BENCH_MOTOR,
+	BENCH_PHASES
+}BENCH_PhaseType;
+
+typedef enum
+{
+	BENCH_IDLE, BENCH_IN_REQUEST, BENCH_IN_DECISION, BENCH_IN_REPLY, BENCH_DONE
+}BENCH_StateType;
+
+typedef struct
+{
+	char name[BENCH_NAME_SIZE];
+	uint8_t valid[BENCH_PHASES];
+	SIM_TimeType time[BENCH_PHASES];
+}BENCH_ResultType;
+
+/*******************************************************************************
+ *                           Global variables                                  *
+ *******************************************************************************/
+static const char *const g_phaseNames[BENCH_PHASES] =
+{
+	"keypad", "request", "eeprom", "decision", "reply", "total", "motor"
+};
+
+/* Transaction tracked by the observer */
+static struct
+{
+	BENCH_StateType state;
+	uint8_t bytes;            /* bytes of the current frame taken by the receiver */
+	uint8_t length;           /* expected bytes of the current frame */
+	SIM_TimeType confirm;     /* last '=' press */
+	SIM_TimeType request;
+	SIM_TimeType request_end;
+	SIM_TimeType eeprom_start;
+	SIM_TimeType eeprom_end;
+	SIM_TimeType reply;
+	SIM_TimeType reply_end;
+	SIM_TimeType motor;
+}g_bench;
+
+/* Profiled firmware functions reported after the transactions, see SIM_profile */
+static const struct
+{
+	uint8_t ecu;
+	const char *name;
+}g_profiled[] =
+{
+	{SIM_HMI_ECU, "KEYPAD_scan"},
+	{SIM_HMI_ECU, "TIMER2_COMP_vect"},      /* the LCD instructions queue */
+	{SIM_CONTROL_ECU, "DcMotor_Rotate"},
+	{SIM_CONTROL_ECU, "createSystemPassword"},
+	{SIM_CONTROL_ECU, "TWI_vect"}           /* the TWI transactions */
+};
+
+static BENCH_ResultType g_results[BENCH_MAX_RESULTS];
+static uint8_t g_resultsCount;
+static int g_failures;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+/* Count the bytes of a frame taken by the receiver, returns 1 on its last byte */
+static int BENCH_frameByte(uint32_t value)
+{
+	if(g_bench.bytes == BENCH_LENGTH_INDEX)
+	{
+		g_bench.length = (uint8_t)value + BENCH_PROTOCOL_OVERHEAD;
+	}
+	g_bench.bytes++;
+	return (g_bench.bytes > BENCH_LENGTH_INDEX) && (g_bench.bytes == g_bench.length);
+}
+
+static void BENCH_observer(SIM_EventType event, uint8_t ecu, SIM_TimeType time, uint32_t value)
+{
+	switch(event)
+	{
+	case SIM_EV_KEY_PRESS:
+		/* The digits are streamed as they are typed, only a frame sent after '=' is the request */
+		g_bench.confirm = (value == '=') ? time : 0;
+		break;
+	case SIM_EV_UART_WRITE:
+		if((ecu == SIM_HMI_ECU) && (g_bench.state == BENCH_IDLE) && (g_bench.confirm != 0))
+		{
+			g_bench.state = BENCH_IN_REQUEST;
+			g_bench.request = time;
+			g_bench.bytes = 0;
+		}
+		else if((ecu == SIM_CONTROL_ECU) && (g_bench.state == BENCH_IN_DECISION))
+		{
+			g_bench.state = BENCH_IN_REPLY;
+			g_bench.reply = time;
+			g_bench.bytes = 0;
+		}
+		break;
+	case SIM_EV_UART_RX:
+		if((ecu == SIM_CONTROL_ECU) && (g_bench.state == BENCH_IN_REQUEST) && BENCH_frameByte(value))
+		{
+			g_bench.state = BENCH_IN_DECISION;
+			g_bench.request_end = time;
+		}
+		else if((ecu == SIM_HMI_ECU) && (g_bench.state == BENCH_IN_REPLY) && BENCH_frameByte(value))
+		{
+			g_bench.state = BENCH_DONE;
+			g_bench.reply_end = time;
+		}
+		break;
+	case SIM_EV_TWI_START:
+		if((g_bench.state == BENCH_IN_DECISION) && (g_bench.eeprom_start == 0))
+		{
+			g_bench.eeprom_start = time;
+		}
+		break;
+	case SIM_EV_TWI_STOP:
+		if(g_bench.state == BENCH_IN_DECISION)
+		{
+			g_bench.eeprom_end = time;
+		}
+		break;
+	case SIM_EV_MOTOR:
+		if((value == SIM_MOTOR_CW) && (g_bench.motor == 0))
+		{
+			g_bench.motor = time;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+static int BENCH_transactionDone(void *wait_motor_Ptr)
+{
+	return (g_bench.state == BENCH_DONE) && (!*(int *)wait_motor_Ptr || (g_bench.motor != 0));
+}
+
+static int BENCH_lcdShows(void *text_Ptr)
+{
+	return SIM_lcdContains((const char *)text_Ptr);
+}
+
+static void BENCH_waitLcd(const char *text_Ptr, SIM_TimeType timeout)
+{
+	if(!SIM_runUntil(BENCH_lcdShows, (void *)text_Ptr, timeout))
+	{
+		g_failures++;
+		printf("FAIL: \"%s\" is not shown\n", text_Ptr);
+	}
+}
+
+/* Fill the user codes table of the simulated EEPROM with count codes the way USERS_add does */
+static void BENCH_fillUsers(uint16_t count)
+{
+	uint8_t *eeprom = SIM_eepromData();
+	uint8_t *bucket_Ptr;
+	uint16_t record;
+	uint32_t code;
+	uint8_t bucket;
+	uint8_t distance;
+	uint8_t index;
+	uint16_t i;
+
+	for(bucket = 0; bucket < USERS_BUCKETS; bucket++)
+	{
+		eeprom[USERS_BUCKET_ADDRESS(bucket) + USERS_OVERFLOWS_INDEX] = 0xFF;
+		eeprom[USERS_BUCKET_ADDRESS(bucket) + USERS_META_INDEX] = 0xFF;
+	}
+	for(i = 0; i < count; i++)
+	{
+		code = USER_CODE(i);
+		bucket = USERS_HOME_BUCKET(code);
+		for(distance = 0; (eeprom[USERS_BUCKET_ADDRESS(bucket) + USERS_META_INDEX] & USERS_META_FREE_MASK) == 0; distance++)
+		{
+			eeprom[USERS_BUCKET_ADDRESS(bucket) + USERS_OVERFLOWS_INDEX]--;
+			bucket = (bucket + USERS_PROBE_STEP(code)) % USERS_BUCKETS;
+		}
+		bucket_Ptr = &eeprom[USERS_BUCKET_ADDRESS(bucket)];
+		for(index = 0; !(bucket_Ptr[USERS_META_INDEX] & (1 << index)); index++)
+		{
+		}
+		record = USERS_RECORD(code, distance);
+		bucket_Ptr[index * USERS_RECORD_SIZE] = (uint8_t)record;
+		bucket_Ptr[index * USERS_RECORD_SIZE + 1] = (uint8_t)(record >> 8);
+		bucket_Ptr[USERS_META_INDEX] &= ~(1 << index);
+	}
+}
+
+/* Type the keys of one transaction and keep its phases under name */
+static void BENCH_transaction(const char *name_Ptr, const char *keys_Ptr, int wait_motor)
+{
+	BENCH_ResultType *result = &g_results[g_resultsCount];
+	SIM_TimeType eeprom = 0;
+
+	memset(&g_bench, 0, sizeof(g_bench));
+	SIM_keypadType(keys_Ptr);
+	if(!SIM_runUntil(BENCH_transactionDone, &wait_motor, SIM_SECONDS(15)))
+	{
+		g_failures++;
+		printf("FAIL: %s is not completed\n", name_Ptr);
+		return;
+	}
+
+	memset(result, 0, sizeof(*result));
+	snprintf(result->name, sizeof(result->name), "%s", name_Ptr);
+	if(g_bench.eeprom_start != 0)
+	{
+		eeprom = g_bench.eeprom_end - g_bench.eeprom_start;
+	}
+	result->time[BENCH_KEYPAD] = g_bench.request - g_bench.confirm;
+	result->time[BENCH_REQUEST] = g_bench.request_end - g_bench.request;
+	result->time[BENCH_EEPROM] = eeprom;
+	result->time[BENCH_DECISION] = (g_bench.reply - g_bench.request_end) - eeprom;
+	result->time[BENCH_REPLY] = g_bench.reply_end - g_bench.reply;
+	result->time[BENCH_TOTAL] = g_bench.reply_end - g_bench.confirm;
+	result->time[BENCH_MOTOR] = g_bench.motor - g_bench.confirm;
+	memset(result->valid, 1, BENCH_MOTOR);
+	result->valid[BENCH_MOTOR] = (uint8_t)wait_motor;
+	g_resultsCount++;
+}
+
+/* Look up a missing code then open with the last added one, with count codes in the table */
+static void BENCH_users(uint16_t count)
+{
+	char name[BENCH_NAME_SIZE];
+	char keys[8];
+
+	BENCH_fillUsers(count);
+	SIM_reset();
+	BENCH_waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(3));
+
+	snprintf(name, sizeof(name), "unknown %u", count);
+	snprintf(keys, sizeof(keys), "+%05lu=", (unsigned long)USER_CODE(count));
+	BENCH_transaction(name, keys, 0);
+	snprintf(name, sizeof(name), "user %u", count);
+	snprintf(keys, sizeof(keys), "%05lu=", (unsigned long)USER_CODE(count - 1));
+	BENCH_transaction(name, keys, 1);
+}
+
+static void BENCH_runScenarios(void)
+{
+	SIM_setObserver(BENCH_observer);
+
+	/* First time setup, the password and its confirmation are saved */
+	SIM_init();
+	BENCH_waitLcd(ENTER_PASSWORD_TEXT, SIM_SECONDS(3));
+	BENCH_transaction("setup", "12345=12345=", 0);
+	BENCH_waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(2));
+
+	/* Correct password, measured after a power cycle as well */
+	BENCH_transaction("correct", "+12345=", 1);
+	SIM_reset();
+	BENCH_waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(3));
+	BENCH_transaction("correct after boot", "+12345=", 1);
+	SIM_runUntil(NULL, NULL, SIM_SECONDS(35));
+	BENCH_waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(2));
+
+	/* Wrong password three times, the last one starts the alarm */
+	BENCH_transaction("wrong 1", "+11111=", 0);
+	BENCH_transaction("wrong 2", "11111=", 0);
+	BENCH_transaction("wrong 3", "11111=", 0);
+	SIM_runUntil(NULL, NULL, SIM_SECONDS(61));
+	BENCH_waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(2));
+
+	/* Change password: authority check then the new password */
+	BENCH_transaction("change check", "-12345=", 0);
+	BENCH_waitLcd(ENTER_PASSWORD_TEXT, SIM_SECONDS(2));
+	BENCH_transaction("change save", "54321=54321=", 0);
+	BENCH_waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(2));
+
+	/* User code lookups, the Control_ECU counts the codes of the table at boot */
+	BENCH_users(10);
+	BENCH_users(100);
+	BENCH_users(500);
+
+	SIM_setObserver(NULL);
+}
+
+/* Baseline file: one "<transaction>;<phase>;<cycles>" line per result, "<function>;<average|max>;<cycles>" per function */
+static int BENCH_baselineCycles(FILE *file_Ptr, const char *name_Ptr, const char *phase_Ptr, uint64_t *cycles_Ptr)
+{
+	char line[128];
+	char key[96];
+	size_t length;
+
+	if(file_Ptr == NULL)
+	{
+		return 0;
+	}
+	snprintf(key, sizeof(key), "%s;%s;", name_Ptr, phase_Ptr);
+	length = strlen(key);
+	rewind(file_Ptr);
+	while(fgets(line, sizeof(line), file_Ptr) != NULL)
+	{
+		if(strncmp(line, key, length) == 0)
+		{
+			*cycles_Ptr = strtoull(line + length, NULL, 10);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Change of the cycles against the baseline, "-" if the baseline does not have them */
+static void BENCH_delta(FILE *baseline_Ptr, const char *name_Ptr, const char *phase_Ptr, uint64_t cycles,
+		char *delta_Ptr, size_t size)
+{
+	uint64_t base;
+
+	snprintf(delta_Ptr, size, "-");
+	if(BENCH_baselineCycles(baseline_Ptr, name_Ptr, phase_Ptr, &base))
+	{
+		if(base == 0)
+		{
+			snprintf(delta_Ptr, size, (cycles == 0) ? "=" : "new");
+		}
+		else
+		{
+			snprintf(delta_Ptr, size, "%+.1f%%", ((double)cycles - (double)base) * 100.0 / (double)base);
+		}
+	}
+}
+
+static void BENCH_reportProfile(FILE *baseline_Ptr, FILE *save_Ptr)
+{
+	SIM_ProfileType profile;
+	uint64_t average;
+	char averageDelta[16];
+	char maxDelta[16];
+	size_t i;
+
+	printf("\n%-20s %8s %10s %9s %10s %9s\n", "function", "calls", "average", "baseline", "max", "baseline");
+	for(i = 0; i < sizeof(g_profiled) / sizeof(g_profiled[0]); i++)
+	{
+		if(!SIM_profile(g_profiled[i].ecu, g_profiled[i].name, &profile) || (profile.calls == 0))
+		{
+			g_failures++;
+			printf("FAIL: %s is not profiled\n", g_profiled[i].name);
+			continue;
+		}
+		average = (profile.cycles + profile.calls / 2) / profile.calls;
+		BENCH_delta(baseline_Ptr, g_profiled[i].name, "average", average, averageDelta, sizeof(averageDelta));
+		BENCH_delta(baseline_Ptr, g_profiled[i].name, "max", profile.max_cycles, maxDelta, sizeof(maxDelta));
+		printf("%-20s %8lu %10llu %9s %10llu %9s\n", g_profiled[i].name, (unsigned long)profile.calls,
+				(unsigned long long)average, averageDelta, (unsigned long long)profile.max_cycles, maxDelta);
+		if(save_Ptr != NULL)
+		{
+			fprintf(save_Ptr, "%s;average;%llu\n", g_profiled[i].name, (unsigned long long)average);
+			fprintf(save_Ptr, "%s;max;%llu\n", g_profiled[i].name, (unsigned long long)profile.max_cycles);
+		}
+	}
+}
+
+static void BENCH_report(FILE *baseline_Ptr, FILE *save_Ptr)
+{
+	uint8_t i;
+	uint8_t phase;
+	uint64_t cycles;
+	char delta[16];
+
+	printf("%-20s %-9s %10s %12s %9s\n", "transaction", "phase", "cycles", "time (us)", "baseline");
+	for(i = 0; i < g_resultsCount; i++)
+	{
+		for(phase = 0; phase < BENCH_PHASES; phase++)
+		{
+			if(!g_results[i].valid[phase])
+			{
+				continue;
+			}
+			cycles = g_results[i].time[phase] * BENCH_F_CPU / SIM_SECONDS(1);
+			BENCH_delta(baseline_Ptr, g_results[i].name, g_phaseNames[phase], cycles, delta, sizeof(delta));
+			printf("%-20s %-9s %10llu %12.1f %9s\n", (phase == 0) ? g_results[i].name : "", g_phaseNames[phase],
+					(unsigned long long)cycles, (double)g_results[i].time[phase] / SIM_US(1), delta);
+			if(save_Ptr != NULL)
+			{
+				fprintf(save_Ptr, "%s;%s;%llu\n", g_results[i].name, g_phaseNames[phase], (unsigned long long)cycles);
+			}
+		}
+	}
+}
+
+/*
+ * Usage: sim_bench [baseline file] [--save file]
+ * The baseline column shows the change of the cycles against the given baseline file.
+ */
+int main(int argc, char *argv[])
+{
+	FILE *baseline = NULL;
+	FILE *save = NULL;
+	int i;
+
+	for(i = 1; i < argc; i++)
+	{
+		if((strcmp(argv[i], "--save") == 0) && (i + 1 < argc))
+		{
+			save = fopen(argv[++i], "w");
+			if(save == NULL)
+			{
+				perror(argv[i]);
+				return EXIT_FAILURE;
+			}
+		}
+		else
+		{
+			/* A missing baseline only leaves the baseline column empty */
+			baseline = fopen(argv[i], "r");
+		}
+	}
+
+	BENCH_runScenarios();
+	BENCH_report(baseline, save);
+	BENCH_reportProfile(baseline, save);
+
+	if(baseline != NULL)
+	{
+		fclose(baseline);
+	}
+	if(save != NULL)
+	{
+		fclose(save);
+	}
+	return (g_failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,767 @@
+/*
+ ================================================================================================
+ File Name: sim_devices.c
+ Name        : Door Locker Security System
+ Author      : Omar Muhammad
+ Description : Source file of the devices around the ECUs in the host simulator:
+               HMI_ECU  : 4x4 keypad and HD44780 character LCD on the GPIO ports.
+               Control_ECU : door motor and buzzer on the GPIO ports, 24C16 EEPROM on the TWI bus.
+               The wiring is taken from the HAL headers so it follows the firmware configuration.
+ Date        : 17/10/2026
+ ================================================================================================
+ */
+
+#include <string.h>
+#include "sim.h"
+#include "../HMI_ECU/MCAL/gpio.h"
+#include "../HMI_ECU/HAL/lcd.h"
+#include "../HMI_ECU/HAL/keypad.h"
+#include "../Control_ECU/HAL/dcmotor.h"
+#include "../Control_ECU/HAL/buzzer.h"
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define SIM_NEVER                  ((SIM_TimeType)-1)
+#define SIM_KEYPAD_QUEUE_SIZE      128
+#define SIM_NO_KEY                 0xFF
+
+/* HD44780 execution times */
+#define SIM_LCD_CLEAR_TIME         SIM_US(1520)
+#define SIM_LCD_COMMAND_TIME       SIM_US(37)
+#define SIM_LCD_DDRAM_SIZE         0x80
+
+/* 24C16 write cycle time */
+#define SIM_EEPROM_WRITE_TIME      SIM_MS(5)
+#define SIM_EEPROM_PAGES           (SIM_EEPROM_SIZE / SIM_EEPROM_PAGE_SIZE)
+
+/* TWI bus states of the EEPROM */
+#define SIM_TWI_IDLE               0
+#define SIM_TWI_ADDRESS            1    /* START sent, waiting for SLA+R/W */
+#define SIM_TWI_WORD_ADDRESS       2
+#define SIM_TWI_WRITING            3
+#define SIM_TWI_READING            4
+#define SIM_TWI_NOT_ADDRESSED      5
+
+/* TWSR status codes */
+#define SIM_TWI_START              0x08
+#define SIM_TWI_REP_START          0x10
+#define SIM_TWI_MT_SLA_W_ACK       0x18
+#define SIM_TWI_MT_SLA_W_NACK      0x20
+#define SIM_TWI_MT_DATA_ACK        0x28
+#define SIM_TWI_MT_DATA_NACK       0x30
+#define SIM_TWI_MR_SLA_R_ACK       0x40
+#define SIM_TWI_MR_SLA_R_NACK      0x48
+#define SIM_TWI_MR_DATA_ACK        0x50
+#define SIM_TWI_MR_DATA_NACK       0x58
+#define SIM_TWI_BUS_ERROR          0x00
+
+/*******************************************************************************
+ *                           Global Variables                                  *
+ *******************************************************************************/
+/* Face of the keypad as the firmware maps the buttons (g_keypadButtons in keypad.c), '\r' is Enter */
+static const char g_keypadFace[KEYPAD_NUM_ROWS][KEYPAD_NUM_COLS] =
+{
+	{'7', '8', '9', '%'},
+	{'4', '5', '6', '*'},
+	{'1', '2', '3', '-'},
+	{'\r', '0', '=', '+'}
+};
+
+static struct
+{
+	char queue[SIM_KEYPAD_QUEUE_SIZE];
+	uint8_t head;
+	uint8_t count;
+	uint8_t row;              /* pressed button, SIM_NO_KEY when released */
+	uint8_t col;
+	SIM_TimeType release;
+	SIM_TimeType next_press;
+	SIM_TimeType hold;
+	SIM_TimeType gap;
+}g_keypad;
+
+static struct
+{
+	uint8_t e;
+	uint8_t four_bits;
+	uint8_t low_nibble;       /* next strobe carries the low nibble in the 4 bits mode */
+	uint8_t high_nibble;
+	uint8_t address;
+	uint8_t cgram;
+	uint8_t ddram[SIM_LCD_DDRAM_SIZE];
+	SIM_TimeType busy_until;
+	uint32_t violations;
+	char rows[SIM_LCD_ROWS][SIM_LCD_COLS + 1];
+}g_lcd;
+
+static uint8_t g_motorState;
+static uint8_t g_buzzerState;
+
+static struct
+{
+	uint8_t state;
+	uint8_t bus_busy;
+	uint8_t block;            /* A8..A10 from the device address */
+	uint16_t address;
+	uint16_t page;
+	uint8_t latch[SIM_EEPROM_PAGE_SIZE];
+	uint16_t latched;         /* one bit per latched byte of the page */
+	SIM_TimeType write_end;
+	uint8_t memory[SIM_EEPROM_SIZE];
+	uint32_t page_writes[SIM_EEPROM_PAGES];
+	uint8_t nacks;            /* addresses still not acknowledged, see SIM_eepromNack */
+	uint8_t power_fail;       /* the next page write is cut, see SIM_eepromPowerFail */
+	uint8_t power_fail_bytes;
+}g_eeprom;
+
+/*******************************************************************************
+ *                      Functions Definitions(Private)                         *
+ *******************************************************************************/
+static uint8_t SIM_pinLevel(uint8_t ecu, uint8_t port, uint8_t pin)
+{
+	uint8_t ddr;
+	uint8_t value;
+
+	SIM_portState(ecu, port, &ddr, &value);
+	return (value >> pin) & 1;
+}
+
+/* An output pin drives its PORT bit, an input pin is pulled up by the board */
+static uint8_t SIM_wireLevel(uint8_t ecu, uint8_t port, uint8_t pin, uint8_t *driven_Ptr)
+{
+	uint8_t ddr;
+	uint8_t value;
+
+	SIM_portState(ecu, port, &ddr, &value);
+	*driven_Ptr = (ddr >> pin) & 1;
+	return *driven_Ptr ? ((value >> pin) & 1) : 1;
+}
+
+/*
+ * Description :
+ * Release the pressed key when its hold time is over, the firmware does not need to scan for it.
+ */
+static void SIM_keypadRelease(uint8_t ecu)
+{
+	SIM_TimeType now = SIM_now();
+
+	if((g_keypad.row != SIM_NO_KEY) && (now >= g_keypad.release))
+	{
+		SIM_emit(SIM_EV_KEY_RELEASE, ecu, (uint8_t)g_keypadFace[g_keypad.row][g_keypad.col]);
+		g_keypad.row = SIM_NO_KEY;
+		g_keypad.next_press = now + g_keypad.gap;
+	}
+}
+
+/*
+ * Description :
+ * Release the pressed key when its hold time is over and start the next queued one.
+ * A key is pressed only while the firmware scans, that is when a row is driven low.
+ */
+static void SIM_keypadUpdate(uint8_t ecu, uint8_t port)
+{
+	SIM_TimeType now = SIM_now();
+	uint8_t row;
+	uint8_t col;
+	uint8_t scanning = 0;
+	uint8_t driven;
+	char key;
+
+	SIM_keypadRelease(ecu);
+	if((g_keypad.row != SIM_NO_KEY) || (g_keypad.count == 0) || (now < g_keypad.next_press) ||
+	   (port != KEYPAD_COL_PORT_ID))
+	{
+		return;
+	}
+	for(row = 0; row < KEYPAD_NUM_ROWS; row++)
+	{
+		if((SIM_wireLevel(ecu, KEYPAD_ROW_PORT_ID, KEYPAD_FIRST_ROW_PIN_ID + row, &driven) == KEYPAD_BUTTON_PRESSED) && driven)
+		{
+			scanning = 1;
+		}
+	}
+	if(!scanning)
+	{
+		return;
+	}
+
+	key = g_keypad.queue[g_keypad.head];
+	g_keypad.head = (g_keypad.head + 1) % SIM_KEYPAD_QUEUE_SIZE;
+	g_keypad.count--;
+	for(row = 0; row < KEYPAD_NUM_ROWS; row++)
+	{
+		for(col = 0; col < KEYPAD_NUM_COLS; col++)
+		{
+			if(g_keypadFace[row][col] == key)
+			{
+				g_keypad.row = row;
+				g_keypad.col = col;
+				g_keypad.release = now + g_keypad.hold;
+				SIM_emit(SIM_EV_KEY_PRESS, ecu, (uint8_t)key);
+				return;
+			}
+		}
+	}
+}
+
+static void SIM_lcdRefreshRows(void)
+{
+	static const uint8_t rowAddress[4] = {0x00, 0x40, SIM_LCD_COLS, 0x40 + SIM_LCD_COLS};
+	uint8_t row;
+	uint8_t col;
+	uint8_t c;
+
+	for(row = 0; row < SIM_LCD_ROWS; row++)
+	{
+		for(col = 0; col < SIM_LCD_COLS; col++)
+		{
+			c = g_lcd.ddram[(rowAddress[row] + col) % SIM_LCD_DDRAM_SIZE];
+			g_lcd.rows[row][col] = ((c >= 0x20) && (c < 0x7F)) ? (char)c : ' ';
+		}
+		g_lcd.rows[row][SIM_LCD_COLS] = '\0';
+	}
+}
+
+static void SIM_lcdExecute(uint8_t rs, uint8_t byte)
+{
+	SIM_TimeType now = SIM_now();
+	SIM_TimeType duration = SIM_LCD_COMMAND_TIME;
+
+	if(now < g_lcd.busy_until)
+	{
+		/* Written while the controller is still busy, a real LCD may lose it */
+		g_lcd.violations++;
+	}
+
+	if(rs)
+	{
+		SIM_emit(SIM_EV_LCD_DATA, SIM_HMI_ECU, byte);
+		if(!g_lcd.cgram)
+		{
+			g_lcd.ddram[g_lcd.address] = byte;
+			/* Two lines mode: 0x00-0x27 then 0x40-0x67 */
+			g_lcd.address++;
+			if(g_lcd.address == 0x28)
+			{
+				g_lcd.address = 0x40;
+			}
+			else if(g_lcd.address >= 0x68)
+			{
+				g_lcd.address = 0x00;
+			}
+			SIM_lcdRefreshRows();
+		}
+	}
+	else
+	{
+		SIM_emit(SIM_EV_LCD_COMMAND, SIM_HMI_ECU, byte);
+		if(byte & 0x80)
+		{
+			g_lcd.address = byte & 0x7F;
+			g_lcd.cgram = 0;
+		}
+		else if(byte & 0x40)
+		{
+			g_lcd.cgram = 1;
+		}
+		else if(byte & 0x20)
+		{
+			/* Function set, DL selects the interface width */
+			if(!(byte & 0x10) && !g_lcd.four_bits)
+			{
+				g_lcd.four_bits = 1;
+				g_lcd.low_nibble = 0;
+			}
+			else if(byte & 0x10)
+			{
+				g_lcd.four_bits = 0;
+			}
+		}
+		else if(byte & 0x1C)
+		{
+			/* Shift, display control and entry mode do not change the text */
+		}
+		else if(byte & 0x02)
+		{
+			/* Return home */
+			g_lcd.address = 0;
+			duration = SIM_LCD_CLEAR_TIME;
+		}
+		else if(byte & 0x01)
+		{
+			memset(g_lcd.ddram, ' ', sizeof(g_lcd.ddram));
+			g_lcd.address = 0;
+			g_lcd.cgram = 0;
+			duration = SIM_LCD_CLEAR_TIME;
+			SIM_lcdRefreshRows();
+		}
+	}
+	g_lcd.busy_until = now + duration;
+}
+
+/*
+ * Description :
+ * Levels driven by the LCD on its data pins while E is high in a read cycle (RW=1),
+ * the busy flag and the address counter. Returns 0 when the LCD does not drive the bus.
+ */
+static uint8_t SIM_lcdReadBus(uint8_t *levels_Ptr)
+{
+#if(LCD_RW_CONNECTED == 1)
+	uint8_t status;
+
+	if(!g_lcd.e || !SIM_pinLevel(SIM_HMI_ECU, LCD_RW_PORT_ID, LCD_RW_PIN_ID))
+	{
+		return 0;
+	}
+	status = (uint8_t)(((SIM_now() < g_lcd.busy_until) ? 0x80 : 0x00) | g_lcd.address);
+	if(!SIM_pinLevel(SIM_HMI_ECU, LCD_RS_PORT_ID, LCD_RS_PIN_ID))
+	{
+#if(LCD_DATA_BITS_MODE == 4)
+		if(g_lcd.four_bits && g_lcd.low_nibble)
+		{
+			status = (uint8_t)(status << 4);
+		}
+		*levels_Ptr = (uint8_t)((((status >> 4) & 1) << LCD_DB4_PIN_ID) | (((status >> 5) & 1) << LCD_DB5_PIN_ID) |
+		                        (((status >> 6) & 1) << LCD_DB6_PIN_ID) | (((status >> 7) & 1) << LCD_DB7_PIN_ID));
+#else
+		*levels_Ptr = status;
+#endif
+		return 1;
+	}
+#else
+	(void)levels_Ptr;
+#endif
+	return 0;
+}
+
+/*
+ * Description :
+ * Latch the data bus on the falling edge of E.
+ */
+static void SIM_lcdStrobe(void)
+{
+	uint8_t rs = SIM_pinLevel(SIM_HMI_ECU, LCD_RS_PORT_ID, LCD_RS_PIN_ID);
+	uint8_t bus;
+
+#if(LCD_RW_CONNECTED == 1)
+	if(SIM_pinLevel(SIM_HMI_ECU, LCD_RW_PORT_ID, LCD_RW_PIN_ID))
+	{
+		/* Read cycle, the 4 bits interface reads the status in two nibbles too */
+		if(g_lcd.four_bits)
+		{
+			g_lcd.low_nibble = !g_lcd.low_nibble;
+		}
+		return;
+	}
+#endif
+
+#if(LCD_DATA_BITS_MODE == 4)
+	bus = (uint8_t)((SIM_pinLevel(SIM_HMI_ECU, LCD_DATA_PORT_ID, LCD_DB4_PIN_ID) << 4) |
+	                (SIM_pinLevel(SIM_HMI_ECU, LCD_DATA_PORT_ID, LCD_DB5_PIN_ID) << 5) |
+	                (SIM_pinLevel(SIM_HMI_ECU, LCD_DATA_PORT_ID, LCD_DB6_PIN_ID) << 6) |
+	                (SIM_pinLevel(SIM_HMI_ECU, LCD_DATA_PORT_ID, LCD_DB7_PIN_ID) << 7));
+#else
+	uint8_t ddr;
+	SIM_portState(SIM_HMI_ECU, LCD_DATA_PORT_ID, &ddr, &bus);
+#endif
+
+	if(!g_lcd.four_bits)
+	{
+		SIM_lcdExecute(rs, bus);
+	}
+	else if(!g_lcd.low_nibble)
+	{
+		g_lcd.high_nibble = bus & 0xF0;
+		g_lcd.low_nibble = 1;
+	}
+	else
+	{
+		g_lcd.low_nibble = 0;
+		SIM_lcdExecute(rs, (uint8_t)(g_lcd.high_nibble | (bus >> 4)));
+	}
+}
+
+static void SIM_controlPinsChanged(void)
+{
+	uint8_t in1 = SIM_pinLevel(SIM_CONTROL_ECU, DCMOTOR_INT1_PORT_ID, DCMOTOR_INT1_PIN_ID);
+	uint8_t in2 = SIM_pinLevel(SIM_CONTROL_ECU, DCMOTOR_INT2_PORT_ID, DCMOTOR_INT2_PIN_ID);
+	uint8_t motor = SIM_MOTOR_STOP;
+	uint8_t buzzer = SIM_pinLevel(SIM_CONTROL_ECU, BUZZER_PORT_ID, BUZZER_PIN_ID);
+
+	if(in1 && !in2)
+	{
+		motor = SIM_MOTOR_CW;
+	}
+	else if(!in1 && in2)
+	{
+		motor = SIM_MOTOR_A_CW;
+	}
+	if(motor != g_motorState)
+	{
+		g_motorState = motor;
+		SIM_emit(SIM_EV_MOTOR, SIM_CONTROL_ECU, motor);
+	}
+	if(buzzer != g_buzzerState)
+	{
+		g_buzzerState = buzzer;
+		SIM_emit(SIM_EV_BUZZER, SIM_CONTROL_ECU, buzzer);
+	}
+}
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+void SIM_devicesReset(int erase_eeprom)
+{
+	memset(&g_keypad, 0, sizeof(g_keypad));
+	g_keypad.row = SIM_NO_KEY;
+	g_keypad.hold = SIM_MS(30);
+	g_keypad.gap = SIM_MS(30);
+
+	memset(&g_lcd, 0, sizeof(g_lcd));
+	memset(g_lcd.ddram, ' ', sizeof(g_lcd.ddram));
+	SIM_lcdRefreshRows();
+
+	g_motorState = SIM_MOTOR_STOP;
+	g_buzzerState = 0;
+
+	g_eeprom.state = SIM_TWI_IDLE;
+	g_eeprom.bus_busy = 0;
+	g_eeprom.latched = 0;
+	g_eeprom.write_end = 0;
+	if(erase_eeprom)
+	{
+		SIM_eepromErase();
+		g_eeprom.nacks = 0;
+		g_eeprom.power_fail = 0;
+	}
+}
+
+void SIM_devicesPortChanged(uint8_t ecu, uint8_t port, uint8_t ddr, uint8_t value)
+{
+	uint8_t e;
+
+	(void)ddr;
+	if(ecu == SIM_HMI_ECU)
+	{
+		if(port == LCD_E_PORT_ID)
+		{
+			e = (value >> LCD_E_PIN_ID) & 1;
+			if(g_lcd.e && !e)
+			{
+				SIM_lcdStrobe();
+			}
+			g_lcd.e = e;
+		}
+	}
+	else
+	{
+		SIM_controlPinsChanged();
+	}
+}
+
+uint8_t SIM_devicesReadPort(uint8_t ecu, uint8_t port, uint8_t ddr, uint8_t value)
+{
+	/* Output pins read back PORTx, input pins are pulled up by the board */
+	uint8_t levels = (uint8_t)((ddr & value) | (uint8_t)~ddr);
+	uint8_t rowDriven;
+	uint8_t colDriven;
+	uint8_t rowPin;
+	uint8_t colPin;
+	uint8_t level;
+
+	uint8_t lcdLevels;
+	uint8_t lcdPins;
+
+	if(ecu != SIM_HMI_ECU)
+	{
+		return levels;
+	}
+
+	if((port == LCD_DATA_PORT_ID) && SIM_lcdReadBus(&lcdLevels))
+	{
+		/* The LCD drives the data pins the MCU released */
+#if(LCD_DATA_BITS_MODE == 4)
+		lcdPins = (uint8_t)((1 << LCD_DB4_PIN_ID) | (1 << LCD_DB5_PIN_ID) | (1 << LCD_DB6_PIN_ID) | (1 << LCD_DB7_PIN_ID));
+#else
+		lcdPins = 0xFF;
+#endif
+		lcdPins &= (uint8_t)~ddr;
+		levels = (uint8_t)((levels & (uint8_t)~lcdPins) | (lcdLevels & lcdPins));
+	}
+
+	SIM_keypadUpdate(ecu, port);
+	if(g_keypad.row == SIM_NO_KEY)
+	{
+		return levels;
+	}
+
+	/* The pressed button shorts its row and column wires, an output driving low wins */
+	rowPin = KEYPAD_FIRST_ROW_PIN_ID + g_keypad.row;
+	colPin = KEYPAD_FIRST_COL_PIN_ID + g_keypad.col;
+	level = SIM_wireLevel(ecu, KEYPAD_ROW_PORT_ID, rowPin, &rowDriven) &
+	        SIM_wireLevel(ecu, KEYPAD_COL_PORT_ID, colPin, &colDriven);
+	if((port == KEYPAD_ROW_PORT_ID) && !rowDriven && !level)
+	{
+		levels &= (uint8_t)~(1 << rowPin);
+	}
+	if((port == KEYPAD_COL_PORT_ID) && !colDriven && !level)
+	{
+		levels &= (uint8_t)~(1 << colPin);
+	}
+	return levels;
+}
+
+void SIM_devicesUpdate(uint8_t ecu)
+{
+	if(ecu == SIM_HMI_ECU)
+	{
+		SIM_keypadRelease(ecu);
+	}
+}
+
+/*
+ * Description :
+ * Next time a device of the ECU may change what the firmware reads, the waiting time
+ * of the firmware is never skipped past it: the key release, the time the next queued
+ * key may be pressed by a scan and the end of the LCD busy time.
+ */
+SIM_TimeType SIM_devicesNextEvent(uint8_t ecu)
+{
+	SIM_TimeType now = SIM_now();
+	SIM_TimeType next = SIM_NEVER;
+
+	if(ecu != SIM_HMI_ECU)
+	{
+		return next;
+	}
+	if(g_keypad.row != SIM_NO_KEY)
+	{
+		next = g_keypad.release;
+	}
+	else if((g_keypad.count != 0) && (g_keypad.next_press > now))
+	{
+		next = g_keypad.next_press;
+	}
+	if((g_lcd.busy_until > now) && (g_lcd.busy_until < next))
+	{
+		next = g_lcd.busy_until;
+	}
+	return next;
+}
+
+/*******************************************************************************
+ *                               Keypad                                        *
+ *******************************************************************************/
+void SIM_keypadType(const char *keys_Ptr)
+{
+	while((*keys_Ptr != '\0') && (g_keypad.count < SIM_KEYPAD_QUEUE_SIZE))
+	{
+		g_keypad.queue[(g_keypad.head + g_keypad.count) % SIM_KEYPAD_QUEUE_SIZE] = *keys_Ptr;
+		g_keypad.count++;
+		keys_Ptr++;
+	}
+}
+
+void SIM_keypadSetTiming(SIM_TimeType hold, SIM_TimeType gap)
+{
+	g_keypad.hold = hold;
+	g_keypad.gap = gap;
+}
+
+int SIM_keypadIdle(void)
+{
+	return (g_keypad.count == 0) && (g_keypad.row == SIM_NO_KEY);
+}
+
+/*******************************************************************************
+ *                                 LCD                                         *
+ *******************************************************************************/
+const char *SIM_lcdRow(uint8_t row)
+{
+	return g_lcd.rows[row % SIM_LCD_ROWS];
+}
+
+int SIM_lcdContains(const char *text_Ptr)
+{
+	uint8_t row;
+
+	for(row = 0; row < SIM_LCD_ROWS; row++)
+	{
+		if(strstr(g_lcd.rows[row], text_Ptr) != NULL)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+uint32_t SIM_lcdTimingViolations(void)
+{
+	return g_lcd.violations;
+}
+
+/*******************************************************************************
+ *                           Motor and buzzer                                  *
+ *******************************************************************************/
+uint8_t SIM_motorState(void)
+{
+	return g_motorState;
+}
+
+uint8_t SIM_motorDuty(void)
+{
+	/* Timer0 fast PWM, non inverted: duty = OCR0 / 255 */
+	return (uint8_t)((SIM_peek(SIM_CONTROL_ECU, 0x5C) * 100 + 127) / 255);
+}
+
+uint8_t SIM_buzzerState(void)
+{
+	return g_buzzerState;
+}
+
+/*******************************************************************************
+ *                          TWI bus and 24C16                                  *
+ *******************************************************************************/
+uint8_t SIM_twiStart(void)
+{
+	uint8_t status = g_eeprom.bus_busy ? SIM_TWI_REP_START : SIM_TWI_START;
+
+	SIM_emit(SIM_EV_TWI_START, SIM_CONTROL_ECU, 0);
+	/* A repeated start before any data drops the latched bytes */
+	g_eeprom.latched = 0;
+	g_eeprom.bus_busy = 1;
+	g_eeprom.state = SIM_TWI_ADDRESS;
+	return status;
+}
+
+void SIM_twiStop(void)
+{
+	uint8_t i;
+	uint8_t programmed = 0;
+
+	if((g_eeprom.state == SIM_TWI_WRITING) && (g_eeprom.latched != 0))
+	{
+		/* The write cycle programs the latched bytes of the page, only the first ones if the power is lost */
+		for(i = 0; i < SIM_EEPROM_PAGE_SIZE; i++)
+		{
+			if(g_eeprom.latched & (1 << i))
+			{
+				if(g_eeprom.power_fail && (programmed == g_eeprom.power_fail_bytes))
+				{
+					break;
+				}
+				g_eeprom.memory[g_eeprom.page + i] = g_eeprom.latch[i];
+				programmed++;
+			}
+		}
+		g_eeprom.power_fail = 0;
+		g_eeprom.page_writes[g_eeprom.page / SIM_EEPROM_PAGE_SIZE]++;
+		g_eeprom.write_end = SIM_now() + SIM_EEPROM_WRITE_TIME;
+		SIM_emit(SIM_EV_EEPROM_WRITE, SIM_CONTROL_ECU, g_eeprom.page);
+	}
+	g_eeprom.latched = 0;
+	g_eeprom.bus_busy = 0;
+	g_eeprom.state = SIM_TWI_IDLE;
+	SIM_emit(SIM_EV_TWI_STOP, SIM_CONTROL_ECU, 0);
+}
+
+uint8_t SIM_twiWrite(uint8_t data)
+{
+	uint8_t status = SIM_TWI_MT_DATA_NACK;
+
+	switch(g_eeprom.state)
+	{
+	case SIM_TWI_ADDRESS:
+		/* 1010 A10 A9 A8 R/W, no answer during the write cycle (acknowledge polling) */
+		if((g_eeprom.nacks != 0) && (g_eeprom.nacks != SIM_FAULT_PERSISTENT))
+		{
+			g_eeprom.nacks--;
+			g_eeprom.state = SIM_TWI_NOT_ADDRESSED;
+			status = (data & 0x01) ? SIM_TWI_MR_SLA_R_NACK : SIM_TWI_MT_SLA_W_NACK;
+		}
+		else if(((data & 0xF0) == 0xA0) && (SIM_now() >= g_eeprom.write_end) && (g_eeprom.nacks == 0))
+		{
+			g_eeprom.block = (data >> 1) & 0x07;
+			if(data & 0x01)
+			{
+				g_eeprom.state = SIM_TWI_READING;
+				status = SIM_TWI_MR_SLA_R_ACK;
+			}
+			else
+			{
+				g_eeprom.state = SIM_TWI_WORD_ADDRESS;
+				status = SIM_TWI_MT_SLA_W_ACK;
+			}
+		}
+		else
+		{
+			g_eeprom.state = SIM_TWI_NOT_ADDRESSED;
+			status = (data & 0x01) ? SIM_TWI_MR_SLA_R_NACK : SIM_TWI_MT_SLA_W_NACK;
+		}
+		break;
+	case SIM_TWI_WORD_ADDRESS:
+		g_eeprom.address = (uint16_t)((g_eeprom.block << 8) | data);
+		g_eeprom.page = g_eeprom.address & (uint16_t)~(SIM_EEPROM_PAGE_SIZE - 1);
+		g_eeprom.latched = 0;
+		g_eeprom.state = SIM_TWI_WRITING;
+		status = SIM_TWI_MT_DATA_ACK;
+		break;
+	case SIM_TWI_WRITING:
+		/* The address rolls over inside the page */
+		g_eeprom.latch[g_eeprom.address & (SIM_EEPROM_PAGE_SIZE - 1)] = data;
+		g_eeprom.latched |= (uint16_t)(1 << (g_eeprom.address & (SIM_EEPROM_PAGE_SIZE - 1)));
+		g_eeprom.address = (uint16_t)(g_eeprom.page | ((g_eeprom.address + 1) & (SIM_EEPROM_PAGE_SIZE - 1)));
+		status = SIM_TWI_MT_DATA_ACK;
+		break;
+	case SIM_TWI_READING:
+		status = SIM_TWI_BUS_ERROR;
+		break;
+	default:
+		break;
+	}
+	return status;
+}
+
+uint8_t SIM_twiRead(uint8_t ack, uint8_t *data_Ptr)
+{
+	if(g_eeprom.state != SIM_TWI_READING)
+	{
+		/* Nobody drives SDA */
+		*data_Ptr = 0xFF;
+		return ack ? SIM_TWI_MR_DATA_ACK : SIM_TWI_MR_DATA_NACK;
+	}
+	*data_Ptr = g_eeprom.memory[g_eeprom.address];
+	SIM_emit(SIM_EV_EEPROM_READ, SIM_CONTROL_ECU, g_eeprom.address);
+	/* Sequential reads roll over the whole memory */
+	g_eeprom.address = (g_eeprom.address + 1) % SIM_EEPROM_SIZE;
+	return ack ? SIM_TWI_MR_DATA_ACK : SIM_TWI_MR_DATA_NACK;
+}
+
+void SIM_eepromNack(uint8_t count)
+{
+	g_eeprom.nacks = count;
+}
+
+void SIM_eepromPowerFail(uint8_t bytes)
+{
+	g_eeprom.power_fail = 1;
+	g_eeprom.power_fail_bytes = bytes;
+}
+
+uint8_t *SIM_eepromData(void)
+{
+	return g_eeprom.memory;
+}
+
+void SIM_eepromErase(void)
+{
+	memset(g_eeprom.memory, 0xFF, sizeof(g_eeprom.memory));
+	memset(g_eeprom.page_writes, 0, sizeof(g_eeprom.page_writes));
+}
+
+uint32_t SIM_eepromPageWrites(uint8_t page)
+{
+	return g_eeprom.page_writes[page % SIM_EEPROM_PAGES];
+}
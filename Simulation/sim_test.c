@@ -0,0 +1,852 @@
+/*
+ ================================================================================================
+ File Name: sim_test.c
+ Name        : Door Locker Security System
+ Author      : Omar Muhammad
+ Description : Scenarios of the door locker run on the host simulator, the user types on the virtual
+               keypad and the LCD, motor, buzzer and EEPROM are checked. The last scenario measures
+               how many unlock sessions the simulator runs per second of host time.
+ Date        : 17/10/2026
+ ================================================================================================
+ */
+
+#include "sim.h"
+#include "../Control_ECU/password_log.h"
+#include "../Control_ECU/audit_log.h"
+#include "../Control_ECU/users.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*******************************************************************************
+ *                                Definitions                                  *
+ *******************************************************************************/
+#define PASSWORD_SIZE             5
+#define PASSWORD_LOG_FIRST_PAGE   (PASSWORD_LOG_ADDRESS / SIM_EEPROM_PAGE_SIZE)
+#define PASSWORD_CHANGES          (2 * PASSWORD_LOG_PAGES)
+#define AUDIT_FIRST_PAGE          (AUDIT_ADDRESS / SIM_EEPROM_PAGE_SIZE)
+#define USERS_END_PAGE            (USERS_END_ADDRESS / SIM_EEPROM_PAGE_SIZE)
+#define TABLE_BUCKET              5        /* Home bucket of the codes of the user table scenario */
+
+#define MAIN_OPTIONS_TEXT         "+ : Open Door"
+#define ENTER_PASSWORD_TEXT       "Plz enter pass:"
+#define ERROR_TEXT                "ERROR!"
+#define MEMORY_ERROR_TEXT         "Memory error!"
+#define USERS_MENU_TEXT           "+Add"
+#define RE_ENTER_PASSWORD_TEXT    "Plz re-enter the"
+#define LINK_ERROR_TEXT           "Link error!"
+
+#define THROUGHPUT_SESSIONS       20
+#define AUDIT_IDLE_TIME_MS        1500     /* More than AUDIT_IDLE_MS of Control_ECU/app.h */
+#define FASTEST_BAUD_RATE         1000000  /* First rate offered by HMI_ECU/protocol.c */
+#define DIGIT_SEND_ATTEMPTS       3        /* DIGIT_SEND_ATTEMPTS of HMI_ECU/app.h */
+#define BUSY_BOOT_TIME_MS         1500     /* Past the opening delay and all the offers of the HMI_ECU */
+
+/*******************************************************************************
+ *                           Global variables                                  *
+ *******************************************************************************/
+static int g_failures;
+
+/* Simulated time of the last '=' press and of the first motor start after it */
+static SIM_TimeType g_confirmTime;
+static SIM_TimeType g_motorStartTime;
+
+/* Previous byte written by the HMI_ECU and whether the echo of a rate test was made lost */
+static uint32_t g_lastHmiByte;
+static int g_echoLost;
+
+/* Digit frames of the HMI_ECU and their acknowledgements seen so far, and which of them are lost */
+static uint32_t g_lastByte[2];
+static int g_digitFrames;
+static int g_digitAcks;
+static int g_loseDigitFrame;
+static int g_loseDigitAck;
+
+/*******************************************************************************
+ *                      Functions Definitions                                  *
+ *******************************************************************************/
+static void check(int condition, const char *scenario_Ptr, const char *what_Ptr)
+{
+	if(!condition)
+	{
+		g_failures++;
+		printf("  FAIL %s: %s\n", scenario_Ptr, what_Ptr);
+		printf("       LCD |%s|\n           |%s|\n", SIM_lcdRow(0), SIM_lcdRow(1));
+	}
+}
+
+static int lcdShows(void *text_Ptr)
+{
+	return SIM_lcdContains((const char *)text_Ptr);
+}
+
+static int motorIs(void *state_Ptr)
+{
+	return SIM_motorState() == *(uint8_t *)state_Ptr;
+}
+
+static int buzzerIs(void *state_Ptr)
+{
+	return SIM_buzzerState() == *(uint8_t *)state_Ptr;
+}
+
+static int passwordRowWithout(void *character_Ptr)
+{
+	return strchr(SIM_lcdRow(1), *(const char *)character_Ptr) == NULL;
+}
+
+static int keypadIdle(void *arg_Ptr)
+{
+	(void)arg_Ptr;
+	return SIM_keypadIdle();
+}
+
+/* Type the keys and wait until the last one is released */
+static int type(const char *keys_Ptr)
+{
+	SIM_keypadType(keys_Ptr);
+	return SIM_runUntil(keypadIdle, NULL, SIM_SECONDS(10));
+}
+
+static int waitLcd(const char *text_Ptr, SIM_TimeType timeout)
+{
+	return SIM_runUntil(lcdShows, (void *)text_Ptr, timeout);
+}
+
+static int waitMotor(uint8_t state, SIM_TimeType timeout)
+{
+	return SIM_runUntil(motorIs, &state, timeout);
+}
+
+static int waitBuzzer(uint8_t state, SIM_TimeType timeout)
+{
+	return SIM_runUntil(buzzerIs, &state, timeout);
+}
+
+/* The newest tagged record of the password log holds the digits */
+static int passwordSaved(const char *digits_Ptr)
+{
+	const uint8_t *record = NULL;
+	const uint8_t *eeprom;
+	uint16_t sequence = 0;
+	uint16_t newest = 0;
+	uint8_t slot;
+	uint8_t i;
+
+	for(slot = 0; slot < PASSWORD_LOG_PAGES; slot++)
+	{
+		eeprom = SIM_eepromData() + PASSWORD_LOG_ADDRESS + slot * PASSWORD_LOG_RECORD_SIZE;
+		sequence = eeprom[PASSWORD_LOG_SEQUENCE_INDEX] | (eeprom[PASSWORD_LOG_SEQUENCE_INDEX + 1] << 8);
+		if((eeprom[PASSWORD_LOG_TAG_INDEX] == PASSWORD_LOG_TAG) &&
+		   ((record == NULL) || ((int16_t)(sequence - newest) > 0)))
+		{
+			record = eeprom;
+			newest = sequence;
+		}
+	}
+	if(record == NULL)
+	{
+		return 0;
+	}
+	for(i = 0; i < PASSWORD_SIZE; i++)
+	{
+		if(record[PASSWORD_LOG_DIGITS_INDEX + i] != (uint8_t)(digits_Ptr[i] - '0'))
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int passwordLogErased(void)
+{
+	const uint8_t *eeprom = SIM_eepromData() + PASSWORD_LOG_ADDRESS;
+	int i;
+
+	for(i = 0; i < PASSWORD_LOG_PAGES * PASSWORD_LOG_RECORD_SIZE; i++)
+	{
+		if(eeprom[i] != 0xFF)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* Wait for the door to be unlocked, held and locked again */
+static void checkDoorCycle(const char *scenario_Ptr)
+{
+	SIM_TimeType start;
+
+	check(waitMotor(SIM_MOTOR_CW, SIM_SECONDS(2)), scenario_Ptr, "motor does not start unlocking");
+	check(SIM_motorDuty() == 100, scenario_Ptr, "motor is not at full speed");
+	start = SIM_time();
+	check(waitMotor(SIM_MOTOR_STOP, SIM_SECONDS(16)), scenario_Ptr, "motor does not stop after unlocking");
+	check(SIM_time() - start >= SIM_MS(14900), scenario_Ptr, "unlocking is shorter than 15 s");
+	start = SIM_time();
+	check(waitMotor(SIM_MOTOR_A_CW, SIM_SECONDS(4)), scenario_Ptr, "motor does not start locking");
+	check(SIM_time() - start >= SIM_MS(2900), scenario_Ptr, "door hold is shorter than 3 s");
+	check(waitMotor(SIM_MOTOR_STOP, SIM_SECONDS(16)), scenario_Ptr, "motor does not stop after locking");
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(2)), scenario_Ptr, "main options are not shown after locking");
+}
+
+/* Password creation from an erased EEPROM */
+static void scenarioSetup(void)
+{
+	const char *name = "setup";
+
+	SIM_init();
+	check(waitLcd(ENTER_PASSWORD_TEXT, SIM_SECONDS(3)), name, "password creation screen is not shown");
+	check(type("12345=12345="), name, "keys are not scanned");
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(2)), name, "main options are not shown");
+	check(passwordSaved("12345"), name, "password record is not saved in the EEPROM");
+}
+
+/* A hung bus and a NACK are retried, a dead EEPROM is reported until it answers again */
+static void scenarioMemoryError(void)
+{
+	const char *name = "memory error";
+
+	SIM_init();
+	check(waitLcd(ENTER_PASSWORD_TEXT, SIM_SECONDS(3)), name, "password creation screen is not shown");
+	SIM_twiHang(1);
+	SIM_eepromNack(1);
+	check(type("12345=12345="), name, "keys are not scanned");
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(2)), name, "main options are not shown after the retries");
+	check(passwordSaved("12345"), name, "password record is not saved in the EEPROM");
+
+	SIM_eepromNack(SIM_FAULT_PERSISTENT);
+	check(type("-12345="), name, "keys are not scanned");
+	check(waitLcd(ENTER_PASSWORD_TEXT, SIM_SECONDS(2)), name, "password creation screen is not shown");
+	check(type("54321=54321="), name, "keys are not scanned");
+	check(waitLcd(MEMORY_ERROR_TEXT, SIM_SECONDS(2)), name, "memory error is not shown");
+	check(passwordSaved("12345"), name, "EEPROM is changed");
+	SIM_eepromNack(0);
+	check(waitLcd(ENTER_PASSWORD_TEXT, SIM_SECONDS(3)), name, "password creation is not restarted");
+	check(type("12345=12345="), name, "keys are not scanned");
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(2)), name, "main options are not shown");
+
+	SIM_eepromNack(SIM_FAULT_PERSISTENT);
+	SIM_reset();
+	check(waitLcd(MEMORY_ERROR_TEXT, SIM_SECONDS(3)), name, "memory error is not shown after boot");
+	SIM_eepromNack(0);
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(3)), name, "main options are not shown once the EEPROM answers");
+	check(passwordSaved("12345"), name, "password record is lost");
+}
+
+/* A confirmation different from the password is rejected */
+static void scenarioMismatch(void)
+{
+	const char *name = "mismatch";
+
+	SIM_init();
+	check(waitLcd(ENTER_PASSWORD_TEXT, SIM_SECONDS(3)), name, "password creation screen is not shown");
+	check(type("12345=54321="), name, "keys are not scanned");
+	check(waitLcd(ENTER_PASSWORD_TEXT, SIM_SECONDS(2)), name, "password creation is not restarted");
+	check(SIM_runUntil(passwordRowWithout, "*", SIM_MS(50)), name, "password row is not cleared");
+	check(passwordLogErased(), name, "EEPROM is written");
+}
+
+static void lostEchoObserver(SIM_EventType event, uint8_t ecu, SIM_TimeType time, uint32_t value)
+{
+	(void)time;
+	if((event != SIM_EV_UART_WRITE) || (ecu != SIM_HMI_ECU))
+	{
+		return;
+	}
+	if((g_lastHmiByte == PROTOCOL_START_BYTE) && (value == MSG_BAUD_TEST) && !g_echoLost)
+	{
+		SIM_uartLose(SIM_CONTROL_ECU, PROTOCOL_FRAME_OVERHEAD + PROTOCOL_TEST_PATTERN_SIZE);
+		g_echoLost = 1;
+	}
+	g_lastHmiByte = value;
+}
+
+static int sameBaudRate(void)
+{
+	return SIM_uartBaudRate(SIM_HMI_ECU) == SIM_uartBaudRate(SIM_CONTROL_ECU);
+}
+
+/* The fastest rate is agreed at boot, a lost test echo and a busy Control_ECU fall back without a hang */
+static void scenarioBaudRate(void)
+{
+	const char *name = "baud rate";
+
+	SIM_init();
+	check(waitLcd(ENTER_PASSWORD_TEXT, SIM_SECONDS(3)), name, "password creation screen is not shown");
+	check(sameBaudRate() && (SIM_uartBaudRate(SIM_HMI_ECU) == FASTEST_BAUD_RATE), name,
+			"fastest rate is not agreed");
+
+	g_lastHmiByte = 0;
+	g_echoLost = 0;
+	SIM_setObserver(lostEchoObserver);
+	SIM_init();
+	check(waitLcd(ENTER_PASSWORD_TEXT, SIM_SECONDS(3)), name, "password creation screen is not shown after a lost echo");
+	SIM_setObserver(NULL);
+	check(g_echoLost, name, "rate test is not sent");
+	check(sameBaudRate() && (SIM_uartBaudRate(SIM_HMI_ECU) < FASTEST_BAUD_RATE), name,
+			"rate is not lowered after a lost echo");
+	check(type("12345=12345="), name, "keys are not scanned");
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(2)), name, "main options are not shown after a lost echo");
+
+	SIM_init();
+	SIM_busy(SIM_CONTROL_ECU, SIM_MS(BUSY_BOOT_TIME_MS));
+	check(waitLcd(ENTER_PASSWORD_TEXT, SIM_SECONDS(4)), name, "password creation screen is not shown after a busy boot");
+	check(sameBaudRate() && (SIM_uartBaudRate(SIM_HMI_ECU) == FASTEST_BAUD_RATE), name,
+			"rate is not negotiated again after a busy boot");
+	check(type("12345=12345="), name, "keys are not scanned");
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(2)), name, "main options are not shown after a busy boot");
+}
+
+/* Unlock with the right password */
+static void scenarioUnlock(void)
+{
+	const char *name = "unlock";
+
+	check(type("+12345="), name, "keys are not scanned");
+	checkDoorCycle(name);
+}
+
+static void digitLossObserver(SIM_EventType event, uint8_t ecu, SIM_TimeType time, uint32_t value)
+{
+	(void)time;
+	if(event != SIM_EV_UART_WRITE)
+	{
+		return;
+	}
+	if(g_lastByte[ecu] == PROTOCOL_START_BYTE)
+	{
+		/* The rest of the frame after its type: length, payload and CRC */
+		if((ecu == SIM_HMI_ECU) && (value == MSG_PASSWORD_DIGIT) && (++g_digitFrames == g_loseDigitFrame))
+		{
+			SIM_uartLose(SIM_HMI_ECU, 2 + 2);
+		}
+		else if((ecu == SIM_CONTROL_ECU) && (value == MSG_DIGIT_ACK) && (++g_digitAcks == g_loseDigitAck))
+		{
+			SIM_uartLose(SIM_CONTROL_ECU, 2 + 1);
+		}
+	}
+	g_lastByte[ecu] = value;
+}
+
+/* A lost digit frame or acknowledgement is sent again, a dead link is reported without counting a trial */
+static void scenarioDigitLoss(void)
+{
+	const char *name = "digit loss";
+	int attempt;
+
+	memset(g_lastByte, 0, sizeof(g_lastByte));
+	g_digitFrames = 0;
+	g_digitAcks = 0;
+	g_loseDigitFrame = 2;
+	g_loseDigitAck = 4;
+	SIM_setObserver(digitLossObserver);
+	check(type("+12345="), name, "keys are not scanned");
+	checkDoorCycle(name);
+	SIM_setObserver(NULL);
+	check(g_digitFrames > PASSWORD_SIZE, name, "lost digit is not sent again");
+
+	/* Two link errors then a wrong password, the lockout comes at the third false trial */
+	check(type("-"), name, "keys are not scanned");
+	check(waitLcd(ENTER_PASSWORD_TEXT, SIM_SECONDS(1)), name, "password entry is not shown");
+	for(attempt = 0; attempt < 2; attempt++)
+	{
+		SIM_uartLose(SIM_HMI_ECU, SIM_FAULT_PERSISTENT);
+		check(type("12"), name, "keys are not scanned");
+		check(waitLcd(LINK_ERROR_TEXT, SIM_SECONDS(1)), name, "link error is not shown");
+		SIM_uartLose(SIM_HMI_ECU, 0);
+		check(waitLcd(ENTER_PASSWORD_TEXT, SIM_SECONDS(2)), name, "password entry is not restarted after a link error");
+	}
+	check(type("11111="), name, "keys are not scanned");
+	check(SIM_runUntil(NULL, NULL, SIM_MS(500)) && (SIM_buzzerState() == 0) && lcdShows(ENTER_PASSWORD_TEXT), name,
+			"link errors are counted as false trials");
+	check(type("12345="), name, "keys are not scanned");
+	check(waitLcd(ENTER_PASSWORD_TEXT, SIM_SECONDS(2)), name, "password creation screen is not shown");
+	check(type("12345=12345="), name, "keys are not scanned");
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(2)), name, "main options are not shown");
+}
+
+static void firstAckObserver(SIM_EventType event, uint8_t ecu, SIM_TimeType time, uint32_t value)
+{
+	(void)time;
+	if(event != SIM_EV_UART_WRITE)
+	{
+		return;
+	}
+	if((g_lastByte[ecu] == PROTOCOL_START_BYTE) && (ecu == SIM_CONTROL_ECU) && (value == MSG_DIGIT_ACK) &&
+	   (++g_digitAcks <= DIGIT_SEND_ATTEMPTS))
+	{
+		/* Every acknowledgement of the first digit until the HMI_ECU gives up the entry */
+		SIM_uartLose(SIM_CONTROL_ECU, 2 + 1);
+	}
+	g_lastByte[ecu] = value;
+}
+
+/* The first digit is accepted but never acknowledged, the entry started again with another digit
+ * is a new entry and the right password opens the door */
+static void scenarioEntryRestart(void)
+{
+	const char *name = "entry restart";
+
+	memset(g_lastByte, 0, sizeof(g_lastByte));
+	g_digitAcks = 0;
+	SIM_setObserver(firstAckObserver);
+	check(type("+9"), name, "keys are not scanned");
+	check(waitLcd(LINK_ERROR_TEXT, SIM_SECONDS(1)), name, "link error is not shown");
+	check(waitLcd(ENTER_PASSWORD_TEXT, SIM_SECONDS(2)), name, "password entry is not restarted after a link error");
+	check(g_digitAcks == DIGIT_SEND_ATTEMPTS, name, "first digit is not acknowledged");
+	check(type("12345="), name, "keys are not scanned");
+	checkDoorCycle(name);
+	SIM_setObserver(NULL);
+}
+
+/* Three wrong passwords start the alarm for one minute */
+static void scenarioWrongPassword(void)
+{
+	const char *name = "wrong password";
+	SIM_TimeType start;
+
+	check(type("+11111=11111=11111="), name, "keys are not scanned");
+	check(waitBuzzer(1, SIM_SECONDS(2)), name, "buzzer is not turned on");
+	check(waitLcd(ERROR_TEXT, SIM_SECONDS(1)), name, "error message is not shown");
+	start = SIM_time();
+	check(waitBuzzer(0, SIM_SECONDS(62)), name, "buzzer is not turned off");
+	check(SIM_time() - start >= SIM_SECONDS(59), name, "alarm is shorter than one minute");
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(2)), name, "main options are not shown after the alarm");
+	check(SIM_motorState() == SIM_MOTOR_STOP, name, "motor moved");
+}
+
+/* Change the password then unlock with the new one */
+static void scenarioChangePassword(void)
+{
+	const char *name = "change password";
+
+	check(type("-12345="), name, "keys are not scanned");
+	check(waitLcd(ENTER_PASSWORD_TEXT, SIM_SECONDS(2)), name, "password creation screen is not shown");
+	check(type("54321=54321="), name, "keys are not scanned");
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(2)), name, "main options are not shown");
+	check(passwordSaved("54321"), name, "new password is not saved in the EEPROM");
+	check(type("+12345="), name, "keys are not scanned");
+	check(waitLcd(ENTER_PASSWORD_TEXT, SIM_SECONDS(2)), name, "password entry is not restarted");
+	check(SIM_runUntil(NULL, NULL, SIM_MS(500)) && (SIM_motorState() == SIM_MOTOR_STOP), name, "old password is accepted");
+	check(type("54321="), name, "keys are not scanned");
+	checkDoorCycle(name);
+}
+
+/* Add a user code, open the door with it, then remove it */
+static void scenarioUsers(void)
+{
+	const char *name = "users";
+
+	check(type("*54321="), name, "keys are not scanned");
+	check(waitLcd(USERS_MENU_TEXT, SIM_SECONDS(2)), name, "users menu is not shown");
+	check(type("+24680="), name, "keys are not scanned");
+	check(waitLcd("User added", SIM_SECONDS(1)), name, "user code is not added");
+	check(waitLcd(USERS_MENU_TEXT, SIM_SECONDS(2)), name, "users menu is not shown after adding");
+	check(type("+24680="), name, "keys are not scanned");
+	check(waitLcd("Already saved", SIM_SECONDS(1)), name, "user code is added twice");
+	check(waitLcd(USERS_MENU_TEXT, SIM_SECONDS(2)), name, "users menu is not shown");
+	check(type("*"), name, "keys are not scanned");
+	check(waitLcd("Users: 1", SIM_SECONDS(1)), name, "users count is not listed");
+	check(type("="), name, "keys are not scanned");
+	check(waitLcd(USERS_MENU_TEXT, SIM_SECONDS(1)), name, "users menu is not shown after the list");
+	check(type("="), name, "keys are not scanned");
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(1)), name, "main options are not shown");
+
+	/* A user code opens the door but does not change the password */
+	check(type("-24680=54321="), name, "keys are not scanned");
+	check(waitLcd(ENTER_PASSWORD_TEXT, SIM_SECONDS(1)), name, "password creation screen is not shown");
+	check(!SIM_runUntil(lcdShows, RE_ENTER_PASSWORD_TEXT, SIM_MS(500)), name, "user code changes the password");
+	check(type("54321=54321="), name, "keys are not scanned");
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(2)), name, "main options are not shown");
+	check(type("+24680="), name, "keys are not scanned");
+	checkDoorCycle(name);
+
+	check(type("*54321="), name, "keys are not scanned");
+	check(waitLcd(USERS_MENU_TEXT, SIM_SECONDS(2)), name, "users menu is not shown");
+	check(type("-24680="), name, "keys are not scanned");
+	check(waitLcd("User removed", SIM_SECONDS(1)), name, "user code is not removed");
+	check(waitLcd(USERS_MENU_TEXT, SIM_SECONDS(2)), name, "users menu is not shown after removing");
+	check(type("="), name, "keys are not scanned");
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(1)), name, "main options are not shown");
+	check(type("+24680="), name, "keys are not scanned");
+	check(SIM_runUntil(NULL, NULL, SIM_MS(500)) && (SIM_motorState() == SIM_MOTOR_STOP), name, "removed user code is accepted");
+	check(type("54321="), name, "keys are not scanned");
+	checkDoorCycle(name);
+}
+
+static int bucketOverflows(uint8_t bucket)
+{
+	return 0xFF - SIM_eepromData()[USERS_BUCKET_ADDRESS(bucket) + USERS_OVERFLOWS_INDEX];
+}
+
+static uint32_t usersPageWrites(void)
+{
+	uint32_t writes = 0;
+	uint8_t page;
+
+	for(page = 0; page < USERS_END_PAGE; page++)
+	{
+		writes += SIM_eepromPageWrites(page);
+	}
+	return writes;
+}
+
+static int userCommand(char command, uint32_t code, const char *result_Ptr)
+{
+	char keys[8];
+
+	snprintf(keys, sizeof(keys), "%c%05lu=", command, (unsigned long)code);
+	return type(keys) && waitLcd(result_Ptr, SIM_SECONDS(1)) && waitLcd(USERS_MENU_TEXT, SIM_SECONDS(2));
+}
+
+/* A full bucket sends the next code on and a removal takes it back, a damaged header copy is written
+ * again and two damaged copies are a memory error that leaves the table as it is */
+static void scenarioUserTable(void)
+{
+	const char *name = "user table";
+	uint32_t writes;
+	uint8_t i;
+
+	check(type("*54321="), name, "keys are not scanned");
+	check(waitLcd(USERS_MENU_TEXT, SIM_SECONDS(2)), name, "users menu is not shown");
+	for(i = 0; i <= USERS_SLOTS_PER_BUCKET; i++)
+	{
+		check(userCommand('+', TABLE_BUCKET + (i * USERS_BUCKETS), "User added"), name, "user code is not added");
+	}
+	check(bucketOverflows(TABLE_BUCKET) == 1, name, "code past the full bucket is not counted");
+	check(userCommand('+', TABLE_BUCKET + (USERS_SLOTS_PER_BUCKET * USERS_BUCKETS), "Already saved"), name,
+			"code past the full bucket is not found");
+	check(userCommand('-', TABLE_BUCKET + USERS_BUCKETS, "User removed"), name, "user code is not removed");
+	check(bucketOverflows(TABLE_BUCKET) == 1, name, "overflow count is changed by a code of the bucket");
+	check(userCommand('-', TABLE_BUCKET + (USERS_SLOTS_PER_BUCKET * USERS_BUCKETS), "User removed"), name,
+			"code past the full bucket is not removed");
+	check(bucketOverflows(TABLE_BUCKET) == 0, name, "overflow count is not taken back");
+	check(type("="), name, "keys are not scanned");
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(1)), name, "main options are not shown");
+
+	SIM_eepromData()[USERS_HEADER_ADDRESS] ^= 0x01;
+	SIM_reset();
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(3)), name, "main options are not shown after a damaged header copy");
+	check(SIM_eepromData()[USERS_HEADER_ADDRESS] == USERS_MAGIC_0, name, "damaged header copy is not written again");
+	check(type("*54321=*"), name, "keys are not scanned");
+	check(waitLcd("Users: 6", SIM_SECONDS(2)), name, "users count is not counted again at boot");
+	check(type("=="), name, "keys are not scanned");
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(2)), name, "main options are not shown");
+
+	SIM_eepromData()[USERS_HEADER_ADDRESS] ^= 0x01;
+	SIM_eepromData()[USERS_HEADER_ADDRESS + USERS_HEADER_COPY_OFFSET] ^= 0x01;
+	writes = usersPageWrites();
+	SIM_reset();
+	check(waitLcd(MEMORY_ERROR_TEXT, SIM_SECONDS(3)), name, "memory error is not shown without a header");
+	check(usersPageWrites() == writes, name, "table with codes is written without a header");
+	SIM_eepromData()[USERS_HEADER_ADDRESS + USERS_HEADER_COPY_OFFSET] ^= 0x01;
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(3)), name, "main options are not shown once a header copy is back");
+}
+
+/* The saved password survives a power cycle */
+static void scenarioPowerCycle(void)
+{
+	const char *name = "power cycle";
+
+	SIM_reset();
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(3)), name, "main options are not shown after boot");
+	check(type("+54321="), name, "keys are not scanned");
+	check(waitMotor(SIM_MOTOR_CW, SIM_SECONDS(2)), name, "door is not unlocked");
+}
+
+/* The password changes are spread over the pages of the log, and a record of the older firmware is used */
+static void scenarioWearLeveling(void)
+{
+	const char *name = "wear leveling";
+	uint32_t writes;
+	uint32_t fewest = 0xFFFFFFFF;
+	uint32_t most = 0;
+	uint8_t page;
+	int i;
+
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(40)), name, "main options are not shown after the door cycle");
+	for(i = 0; i < PASSWORD_CHANGES; i++)
+	{
+		check(type("-54321="), name, "keys are not scanned");
+		check(waitLcd(ENTER_PASSWORD_TEXT, SIM_SECONDS(2)), name, "password creation screen is not shown");
+		check(type("54321=54321="), name, "keys are not scanned");
+		check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(2)), name, "main options are not shown");
+	}
+	for(page = PASSWORD_LOG_FIRST_PAGE; page < PASSWORD_LOG_FIRST_PAGE + PASSWORD_LOG_PAGES; page++)
+	{
+		writes = SIM_eepromPageWrites(page);
+		fewest = (writes < fewest) ? writes : fewest;
+		most = (writes > most) ? writes : most;
+	}
+	check(fewest >= 2 && most - fewest <= 1, name, "password log pages are not written in turn");
+	check(SIM_eepromPageWrites(PASSWORD_LOG_LEGACY_ADDRESS / SIM_EEPROM_PAGE_SIZE) == 0, name, "old password page is written");
+
+	/* Older firmware: only the flag and the password at 0x0310 */
+	SIM_eepromErase();
+	memcpy(SIM_eepromData() + PASSWORD_LOG_LEGACY_ADDRESS, "\x6C\x05\x04\x03\x02\x01", PASSWORD_SIZE + 1);
+	SIM_reset();
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(3)), name, "old password record is not used");
+	check(type("+54321="), name, "keys are not scanned");
+	check(waitMotor(SIM_MOTOR_CW, SIM_SECONDS(2)), name, "door is not unlocked with the old password");
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(40)), name, "main options are not shown after the door cycle");
+	check(type("-54321="), name, "keys are not scanned");
+	check(waitLcd(ENTER_PASSWORD_TEXT, SIM_SECONDS(2)), name, "password creation screen is not shown");
+	check(type("54321=54321="), name, "keys are not scanned");
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(2)), name, "main options are not shown");
+	check(passwordSaved("54321"), name, "password is not moved to the log");
+}
+
+static int passwordLogWrites(void)
+{
+	uint32_t writes = 0;
+	uint8_t page;
+
+	for(page = PASSWORD_LOG_FIRST_PAGE; page < PASSWORD_LOG_FIRST_PAGE + PASSWORD_LOG_PAGES; page++)
+	{
+		writes += SIM_eepromPageWrites(page);
+	}
+	return (int)writes;
+}
+
+static int passwordLogWritten(void *writes_Ptr)
+{
+	return passwordLogWrites() > *(int *)writes_Ptr;
+}
+
+/* A password change cut by a power loss keeps the previous password */
+static void scenarioPowerFail(void)
+{
+	const char *name = "power fail";
+	int writes;
+
+	check(type("-54321="), name, "keys are not scanned");
+	check(waitLcd(ENTER_PASSWORD_TEXT, SIM_SECONDS(2)), name, "password creation screen is not shown");
+	writes = passwordLogWrites();
+	/* The sequence number, the tag and the digits reach the memory but not the CRC */
+	SIM_eepromPowerFail(PASSWORD_LOG_DIGITS_INDEX + PASSWORD_SIZE);
+	check(type("11111=11111="), name, "keys are not scanned");
+	check(SIM_runUntil(passwordLogWritten, &writes, SIM_SECONDS(1)), name, "new password is not written");
+	SIM_reset();
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(3)), name, "main options are not shown after boot");
+	check(type("+11111="), name, "keys are not scanned");
+	check(SIM_runUntil(NULL, NULL, SIM_MS(500)) && (SIM_motorState() == SIM_MOTOR_STOP), name, "cut password is accepted");
+	check(type("54321="), name, "keys are not scanned");
+	checkDoorCycle(name);
+
+	/* The next change goes over the cut record */
+	check(type("-54321="), name, "keys are not scanned");
+	check(waitLcd(ENTER_PASSWORD_TEXT, SIM_SECONDS(2)), name, "password creation screen is not shown");
+	check(type("54321=54321="), name, "keys are not scanned");
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(2)), name, "main options are not shown");
+	check(passwordSaved("54321"), name, "new password is not saved in the EEPROM");
+}
+
+static int auditLogWrites(void)
+{
+	uint32_t writes = 0;
+	uint8_t page;
+
+	for(page = AUDIT_FIRST_PAGE; page < AUDIT_FIRST_PAGE + AUDIT_PAGES; page++)
+	{
+		writes += SIM_eepromPageWrites(page);
+	}
+	return (int)writes;
+}
+
+static int auditLogWritten(void *writes_Ptr)
+{
+	return auditLogWrites() > *(int *)writes_Ptr;
+}
+
+/* An entry with the event and the result is in one of the pages of the audit log */
+static int auditEntrySaved(uint8_t event, uint8_t result)
+{
+	const uint8_t *page;
+	uint8_t i;
+	uint8_t j;
+
+	for(i = 0; i < AUDIT_PAGES; i++)
+	{
+		page = SIM_eepromData() + AUDIT_ADDRESS + i * AUDIT_PAGE_SIZE;
+		for(j = 0; j < AUDIT_ENTRIES_PER_PAGE; j++)
+		{
+			if(page[AUDIT_ENTRIES_INDEX + j * AUDIT_ENTRY_SIZE] == (uint8_t)((event << 4) | result))
+			{
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+/* Boot count of the newest entry of the audit log, the scenarios never get it to wrap */
+static int auditNewestBoot(void)
+{
+	const uint8_t *entry;
+	int boot = -1;
+	uint8_t i;
+	uint8_t j;
+
+	for(i = 0; i < AUDIT_PAGES; i++)
+	{
+		for(j = 0; j < AUDIT_ENTRIES_PER_PAGE; j++)
+		{
+			entry = SIM_eepromData() + AUDIT_ADDRESS + i * AUDIT_PAGE_SIZE + AUDIT_ENTRIES_INDEX + j * AUDIT_ENTRY_SIZE;
+			if((entry[AUDIT_EVENT_INDEX] != AUDIT_ERASED) && (entry[AUDIT_BOOT_INDEX] > boot))
+			{
+				boot = entry[AUDIT_BOOT_INDEX];
+			}
+		}
+	}
+	return boot;
+}
+
+/* The events are written to the EEPROM once the system is idle and shown newest first in the users menu,
+ * one page at a time. The entries of the next power up have the next boot count and the entries past the
+ * staging are counted in one entry. */
+static void scenarioAuditLog(void)
+{
+	const char *name = "audit log";
+	char text[16];
+	int writes;
+	int boot;
+	int i;
+
+	check(SIM_runUntil(NULL, NULL, SIM_MS(AUDIT_IDLE_TIME_MS)), name, "simulation stopped");
+	check(type("+11111="), name, "keys are not scanned");
+	check(waitLcd(ENTER_PASSWORD_TEXT, SIM_SECONDS(2)), name, "password entry is not restarted");
+	writes = auditLogWrites();
+	check(type("54321="), name, "keys are not scanned");
+	check(waitMotor(SIM_MOTOR_CW, SIM_SECONDS(2)), name, "door is not unlocked");
+	check(auditLogWrites() == writes, name, "audit log is written on the unlock path");
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(40)), name, "main options are not shown after the door cycle");
+	check(SIM_runUntil(auditLogWritten, &writes, SIM_SECONDS(2)), name, "audit log is not written once idle");
+	check(auditEntrySaved(LOG_OPEN, LOG_DENIED) && auditEntrySaved(LOG_OPEN, LOG_OK), name, "unlock entries are not saved");
+
+	check(type("*54321="), name, "keys are not scanned");
+	check(waitLcd(USERS_MENU_TEXT, SIM_SECONDS(2)), name, "users menu is not shown");
+	check(type("%"), name, "keys are not scanned");
+	check(waitLcd("Users    ok", SIM_SECONDS(1)), name, "users menu entry is not shown first");
+	check(type("1"), name, "keys are not scanned");
+	check(waitLcd("Open     ok", SIM_SECONDS(1)), name, "unlock entry is not shown");
+	check(type("1"), name, "keys are not scanned");
+	check(waitLcd("Open     denied", SIM_SECONDS(1)), name, "wrong password entry is not shown");
+	check(type("="), name, "keys are not scanned");
+	check(waitLcd(USERS_MENU_TEXT, SIM_SECONDS(1)), name, "users menu is not shown after the log");
+	check(type("="), name, "keys are not scanned");
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(1)), name, "main options are not shown");
+
+	boot = auditNewestBoot();
+	writes = auditLogWrites();
+	SIM_reset();
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(3)), name, "main options are not shown after boot");
+	check(SIM_runUntil(auditLogWritten, &writes, SIM_SECONDS(2)), name, "power up entry is not written once idle");
+	check(auditNewestBoot() == boot + 1, name, "boot count is not counted up at the power up");
+
+	/* The users menu entry and AUDIT_STAGED_ENTRIES removals, nothing is written in the users menu */
+	check(type("*54321="), name, "keys are not scanned");
+	check(waitLcd(USERS_MENU_TEXT, SIM_SECONDS(2)), name, "users menu is not shown");
+	for(i = 0; i < AUDIT_STAGED_ENTRIES; i++)
+	{
+		check(userCommand('-', 13579, "Unknown code"), name, "unknown user code is removed");
+	}
+	check(type("%"), name, "keys are not scanned");
+	check(waitLcd("Dropped  failed", SIM_SECONDS(1)), name, "dropped entries are not shown first");
+	check(waitLcd("#2", SIM_SECONDS(1)), name, "dropped entries are not counted");
+	snprintf(text, sizeof(text), "%d.", boot + 1);
+	check(strncmp(SIM_lcdRow(1), text, strlen(text)) == 0, name, "boot count is not shown");
+	check(type("1"), name, "keys are not scanned");
+	check(waitLcd("Del user failed", SIM_SECONDS(1)), name, "staged removal is not shown");
+	check(type("="), name, "keys are not scanned");
+	check(waitLcd(USERS_MENU_TEXT, SIM_SECONDS(1)), name, "users menu is not shown after the log");
+	check(type("="), name, "keys are not scanned");
+	check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(1)), name, "main options are not shown");
+}
+
+static void throughputObserver(SIM_EventType event, uint8_t ecu, SIM_TimeType time, uint32_t value)
+{
+	(void)ecu;
+	if((event == SIM_EV_KEY_PRESS) && (value == '='))
+	{
+		g_confirmTime = time;
+	}
+	else if((event == SIM_EV_MOTOR) && (value == SIM_MOTOR_CW) && (g_motorStartTime == 0))
+	{
+		g_motorStartTime = time;
+	}
+}
+
+/* Boot and unlock sessions, measured in host time and simulated time */
+static void scenarioThroughput(void)
+{
+	const char *name = "throughput";
+	struct timespec begin, end;
+	SIM_TimeType latency = 0;
+	SIM_TimeType simulated = 0;
+	SIM_TimeType start;
+	double seconds;
+	int i;
+
+	SIM_setObserver(throughputObserver);
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for(i = 0; i < THROUGHPUT_SESSIONS; i++)
+	{
+		SIM_reset();
+		start = SIM_time();
+		g_motorStartTime = 0;
+		check(waitLcd(MAIN_OPTIONS_TEXT, SIM_SECONDS(3)), name, "main options are not shown after boot");
+		check(type("+54321="), name, "keys are not scanned");
+		check(waitMotor(SIM_MOTOR_CW, SIM_SECONDS(2)), name, "door is not unlocked");
+		latency += g_motorStartTime - g_confirmTime;
+		simulated += SIM_time() - start;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	SIM_setObserver(NULL);
+
+	seconds = (double)(end.tv_sec - begin.tv_sec) + (double)(end.tv_nsec - begin.tv_nsec) / 1e9;
+	printf("  %d sessions in %.3f s: %.1f sessions/s, %.1fx real time\n", THROUGHPUT_SESSIONS, seconds,
+			THROUGHPUT_SESSIONS / seconds, (double)simulated / 1e9 / seconds);
+	printf("  '=' pressed to motor start: %.3f ms simulated\n",
+			(double)latency / THROUGHPUT_SESSIONS / 1e6);
+}
+
+int main(void)
+{
+	static const struct
+	{
+		const char *name;
+		void (*run)(void);
+	}scenarios[] =
+	{
+		{"mismatch", scenarioMismatch},
+		{"baud rate", scenarioBaudRate},
+		{"setup", scenarioSetup},
+		{"memory error", scenarioMemoryError},
+		{"unlock", scenarioUnlock},
+		{"digit loss", scenarioDigitLoss},
+		{"entry restart", scenarioEntryRestart},
+		{"wrong password", scenarioWrongPassword},
+		{"change password", scenarioChangePassword},
+		{"users", scenarioUsers},
+		{"user table", scenarioUserTable},
+		{"power cycle", scenarioPowerCycle},
+		{"wear leveling", scenarioWearLeveling},
+		{"power fail", scenarioPowerFail},
+		{"audit log", scenarioAuditLog},
+		{"throughput", scenarioThroughput}
+	};
+	size_t i;
+	int failures;
+
+	for(i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++)
+	{
+		failures = g_failures;
+		printf("%s\n", scenarios[i].name);
+		scenarios[i].run();
+		printf("  %s\n", (g_failures == failures) ? "ok" : "FAILED");
+	}
+	printf("LCD timing violations: %u\n", SIM_lcdTimingViolations());
+	return (g_failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,68 @@
+/*
+ ================================================================================================
+ File Name: sim_vectors.c
+ Name        : Door Locker Security System
+ Author      : Omar Muhammad
+ Description : Interrupt vectors table of one ECU in the host simulator, compiled once per ECU with
+               SIM_ECU_VECTORS set to the table name. A vector without an ISR in the firmware is NULL.
+               The table of the profiled functions is named by SIM_ECU_PROFILED the same way.
+ Date        : 17/10/2026
+ ================================================================================================
+ */
+
+#include "sim.h"
+
+/* ATmega32 vectors, the names are the same as the ISR names used by the firmware */
+#define SIM_WEAK_VECTOR(name) extern void name(void) __attribute__((weak));
+
+SIM_WEAK_VECTOR(INT0_vect)
+SIM_WEAK_VECTOR(INT1_vect)
+SIM_WEAK_VECTOR(INT2_vect)
+SIM_WEAK_VECTOR(TIMER2_COMP_vect)
+SIM_WEAK_VECTOR(TIMER2_OVF_vect)
+SIM_WEAK_VECTOR(TIMER1_CAPT_vect)
+SIM_WEAK_VECTOR(TIMER1_COMPA_vect)
+SIM_WEAK_VECTOR(TIMER1_COMPB_vect)
+SIM_WEAK_VECTOR(TIMER1_OVF_vect)
+SIM_WEAK_VECTOR(TIMER0_COMP_vect)
+SIM_WEAK_VECTOR(TIMER0_OVF_vect)
+SIM_WEAK_VECTOR(SPI_STC_vect)
+SIM_WEAK_VECTOR(USART_RXC_vect)
+SIM_WEAK_VECTOR(USART_UDRE_vect)
+SIM_WEAK_VECTOR(USART_TXC_vect)
+SIM_WEAK_VECTOR(ADC_vect)
+SIM_WEAK_VECTOR(EE_RDY_vect)
+SIM_WEAK_VECTOR(ANA_COMP_vect)
+SIM_WEAK_VECTOR(TWI_vect)
+SIM_WEAK_VECTOR(SPM_RDY_vect)
+
+/* Profiled firmware functions, see SIM_profile */
+#define SIM_WEAK_FUNCTION(name) extern void name(void) __attribute__((weak));
+
+SIM_WEAK_FUNCTION(KEYPAD_scan)
+SIM_WEAK_FUNCTION(DcMotor_Rotate)
+SIM_WEAK_FUNCTION(createSystemPassword)
+
+/* Keep both sections of the ECU present for the power cycle, see SIM_reset */
+static volatile uint8_t g_dataAnchor __attribute__((used)) = 1;
+static volatile uint8_t g_bssAnchor __attribute__((used));
+
+/* Indexed by the vector number, the lower number has the higher priority */
+void (* const SIM_ECU_VECTORS[SIM_VECTOR_COUNT])(void) =
+{
+	0,
+	INT0_vect, INT1_vect, INT2_vect, TIMER2_COMP_vect, TIMER2_OVF_vect,
+	TIMER1_CAPT_vect, TIMER1_COMPA_vect, TIMER1_COMPB_vect, TIMER1_OVF_vect,
+	TIMER0_COMP_vect, TIMER0_OVF_vect, SPI_STC_vect, USART_RXC_vect, USART_UDRE_vect,
+	USART_TXC_vect, ADC_vect, EE_RDY_vect, ANA_COMP_vect, TWI_vect, SPM_RDY_vect
+};
+
+/* Looked up by name by SIM_profile */
+const SIM_ProfileEntryType SIM_ECU_PROFILED[SIM_PROFILE_COUNT] =
+{
+	{"KEYPAD_scan", (void *)KEYPAD_scan},
+	{"TIMER2_COMP_vect", (void *)TIMER2_COMP_vect},
+	{"DcMotor_Rotate", (void *)DcMotor_Rotate},
+	{"createSystemPassword", (void *)createSystemPassword},
+	{"TWI_vect", (void *)TWI_vect}
+};